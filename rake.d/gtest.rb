@@ -1,6 +1,6 @@
 #!/usr/bin/env ruby
 
-$gtest_apps     = %w{common merge propedit}
+$gtest_apps     = %w{common merge propedit extract}
 $gtest_internal = c(:GTEST_TYPE) == "internal"
 
 namespace :tests do
@@ -33,6 +33,7 @@ $build_system_modules[:gtest] = {
       'common'   => [],
       'propedit' => [ :mtxpropedit ],
       'merge'    => [ :mtxmerge ],
+      'extract'  => [ :mtxextract ],
     }
 
     #
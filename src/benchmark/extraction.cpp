@@ -0,0 +1,175 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   micro benchmarks – extracting tracks on one or several threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <benchmark/benchmark.h>
+
+#include "common/checksums/base.h"
+#include "common/endian.h"
+#include "common/job_queues.h"
+#include "common/mm_null_io.h"
+#include "common/mm_proxy_io.h"
+#include "common/mm_write_buffer_io.h"
+
+// Simulates mkvextract extracting all tracks of a Blu-ray remux: one
+// AVC video track at about 30 MBit/s and eight audio tracks. Frames
+// are handed out in the order they're stored in the clusters.
+//
+// The video extractor converts NALUs with four-byte size fields to
+// start codes like xtr_avc_c does; the audio extractors calculate a
+// CRC of each frame like the Ogg extractors do for their pages. All
+// output is written through the same buffered writer mkvextract uses
+// into files that discard the data.
+//
+// The "single-threaded" variant hands each frame to its extractor
+// directly. The "job queues" variant does what "--engage
+// multi_threaded_extraction" does: one queue per output file, run on
+// a pool of threads.
+
+namespace {
+
+unsigned int constexpr s_num_tracks = 9;
+
+struct frame_t {
+  unsigned int track;
+  memory_cptr data;
+};
+
+std::vector<frame_t> const &
+get_frames() {
+  static std::vector<frame_t> s_frames;
+
+  if (!s_frames.empty())
+    return s_frames;
+
+  auto state = 4711u;
+  auto next  = [&state]() {
+    state = state * 1103515245 + 12345;
+    return state >> 8;
+  };
+
+  // Ten seconds at 24 frames per second; 32 ms audio frames.
+  for (auto ms = 0; ms < 10'000; ms += 42) {
+    auto video_size = 100 * 1024 + next() % (100 * 1024);
+    auto video      = memory_c::alloc(video_size);
+    auto pos        = 0u;
+
+    while ((pos + 5) <= video_size) {
+      auto nalu_size = std::min<unsigned int>(16 * 1024, video_size - pos - 4);
+      put_uint32_be(video->get_buffer() + pos, nalu_size);
+      pos += 4 + nalu_size;
+    }
+
+    video->set_size(pos);
+    s_frames.push_back({ 0, video });
+
+    for (auto audio_ms = ms; audio_ms < (ms + 42); audio_ms += 32)
+      for (auto track = 1u; track < s_num_tracks; ++track)
+        s_frames.push_back({ track, memory_c::alloc(track == 1 ? 4 * 1024 : 1536) });
+  }
+
+  return s_frames;
+}
+
+class extractor_c {
+public:
+  mm_io_cptr m_out;
+
+public:
+  extractor_c()
+    : m_out{std::make_shared<mm_write_buffer_io_c>(std::make_shared<mm_null_io_c>("null"), 5 * 1024 * 1024)}
+  {
+  }
+
+  void
+  handle_video_frame(memory_c const &frame) {
+    static unsigned char const s_start_code[4] = { 0x00, 0x00, 0x00, 0x01 };
+
+    auto buffer = frame.get_buffer();
+    auto size   = frame.get_size();
+    auto pos    = std::size_t{};
+
+    while ((pos + 4) <= size) {
+      auto nalu_size = get_uint32_be(buffer + pos);
+      pos           += 4;
+
+      m_out->write(s_start_code, 4);
+      m_out->write(buffer + pos, nalu_size);
+
+      pos += nalu_size;
+    }
+  }
+
+  void
+  handle_audio_frame(memory_c const &frame) {
+    auto crc = mtx::checksum::calculate_as_uint(mtx::checksum::algorithm_e::crc32_ieee, frame);
+    benchmark::DoNotOptimize(crc);
+
+    m_out->write(frame.get_buffer(), frame.get_size());
+  }
+
+  void
+  handle_frame(frame_t const &frame) {
+    if (0 == frame.track)
+      handle_video_frame(*frame.data);
+    else
+      handle_audio_frame(*frame.data);
+  }
+};
+
+int64_t
+get_total_size() {
+  int64_t size = 0;
+
+  for (auto const &frame : get_frames())
+    size += frame.data->get_size();
+
+  return size;
+}
+
+void
+BM_ExtractionSingleThreaded(benchmark::State &state) {
+  auto const &frames = get_frames();
+
+  for (auto _ : state) {
+    std::vector<extractor_c> extractors(s_num_tracks);
+
+    for (auto const &frame : frames)
+      extractors[frame.track].handle_frame(frame);
+  }
+
+  state.SetBytesProcessed(state.iterations() * get_total_size());
+}
+
+void
+BM_ExtractionJobQueues(benchmark::State &state) {
+  auto const &frames = get_frames();
+
+  for (auto _ : state) {
+    std::vector<extractor_c> extractors(s_num_tracks);
+    mtx::job_queues_c queues{s_num_tracks, 64 * 1024 * 1024};
+
+    for (auto const &frame : frames)
+      queues.add(frame.track, [&extractors, &frame]() { extractors[frame.track].handle_frame(frame); }, frame.data->get_size());
+
+    queues.finish();
+  }
+
+  state.SetBytesProcessed(state.iterations() * get_total_size());
+}
+
+}
+
+BENCHMARK(BM_ExtractionSingleThreaded)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ExtractionJobQueues)->Unit(benchmark::kMillisecond)->UseRealTime();
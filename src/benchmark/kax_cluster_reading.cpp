@@ -0,0 +1,154 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   micro benchmarks – parsing Matroska clusters with & without libebml
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <benchmark/benchmark.h>
+
+#include <ebml/EbmlStream.h>
+#include <matroska/KaxBlock.h>
+#include <matroska/KaxCluster.h>
+#include <matroska/KaxClusterData.h>
+#include <matroska/KaxSegment.h>
+
+#include "common/ebml.h"
+#include "common/endian.h"
+#include "common/kax_raw_cluster.h"
+#include "common/mm_mem_io.h"
+
+// Compares how the Matroska reader gets at the frames of a cluster.
+// The "libebml" variant parses the cluster into libebml elements and
+// copies each frame like the packetizers do when taking ownership of
+// them. The "raw" variant is what the reader does with "--engage
+// fast_matroska_reading": frames are slices of the cluster's content.
+//
+// The cluster contains five seconds of a 25 fps video track with
+// frames of 20–80 KiB and an audio track with 1.5 KiB frames.
+
+using namespace libebml;
+using namespace libmatroska;
+
+namespace {
+
+void
+put_simple_block(std::vector<unsigned char> &buffer,
+                 unsigned int track_number,
+                 int16_t relative_timestamp,
+                 std::size_t frame_size) {
+  auto content_size = 4 + frame_size;
+
+  buffer.push_back(0xa3);
+  buffer.resize(buffer.size() + 8);
+  put_uint64_be(&buffer[buffer.size() - 8], content_size | 0x0100000000000000ull);
+
+  buffer.push_back(0x80 | track_number);
+  buffer.push_back(relative_timestamp >> 8);
+  buffer.push_back(relative_timestamp & 0xff);
+  buffer.push_back(0x80);
+  buffer.resize(buffer.size() + frame_size, static_cast<unsigned char>(frame_size));
+}
+
+memory_cptr const &
+get_cluster_content() {
+  static memory_cptr s_content;
+
+  if (s_content)
+    return s_content;
+
+  std::vector<unsigned char> buffer{ 0xe7, 0x81, 0x00 };
+  auto state = 4711u;
+
+  for (auto ms = 0; ms < 5000; ms += 40) {
+    state = state * 1103515245 + 12345;
+    put_simple_block(buffer, 1, ms, 20 * 1024 + (state >> 8) % (60 * 1024));
+
+    for (auto audio_ms = ms; audio_ms < (ms + 40); audio_ms += 20)
+      put_simple_block(buffer, 2, audio_ms, 1536);
+  }
+
+  s_content = memory_c::clone(buffer.data(), buffer.size());
+
+  return s_content;
+}
+
+void
+BM_KaxClusterReadingLibEbml(benchmark::State &state) {
+  auto const &content = get_cluster_content();
+
+  // A cluster header with an eight-byte size in front of the content.
+  auto cluster = memory_c::alloc(12 + content->get_size());
+  put_uint32_be(cluster->get_buffer(),     EBML_ID_VALUE(EBML_ID(KaxCluster)));
+  put_uint64_be(cluster->get_buffer() + 4, content->get_size() | 0x0100000000000000ull);
+  std::memcpy(cluster->get_buffer() + 12, content->get_buffer(), content->get_size());
+
+  int64_t bytes_processed = 0;
+
+  for (auto _ : state) {
+    mm_mem_io_c in{cluster->get_buffer(), cluster->get_size()};
+    EbmlStream es{in};
+
+    auto upper_lvl_el = 0;
+    auto l2           = static_cast<EbmlElement *>(nullptr);
+    auto element      = std::unique_ptr<EbmlElement>{es.FindNextElement(EBML_CLASS_CONTEXT(KaxSegment), upper_lvl_el, 0xFFFFFFFFL, true)};
+
+    element->Read(es, EBML_CLASS_CONTEXT(KaxCluster), upper_lvl_el, l2, true);
+
+    auto &kcluster = static_cast<KaxCluster &>(*element);
+    kcluster.InitTimecode(FindChildValue<KaxClusterTimecode>(kcluster), 1000000);
+
+    for (auto child : kcluster) {
+      if (!Is<KaxSimpleBlock>(child))
+        continue;
+
+      auto block = static_cast<KaxSimpleBlock *>(child);
+      block->SetParent(kcluster);
+
+      for (auto idx = 0u, num_frames = block->NumberFrames(); idx < num_frames; ++idx) {
+        auto &data_buffer = block->GetBuffer(idx);
+        auto frame        = memory_c::borrow(data_buffer.Buffer(), data_buffer.Size());
+
+        frame->take_ownership();
+        benchmark::DoNotOptimize(frame->get_buffer());
+      }
+    }
+
+    bytes_processed += content->get_size();
+  }
+
+  state.SetBytesProcessed(bytes_processed);
+}
+
+void
+BM_KaxClusterReadingRaw(benchmark::State &state) {
+  auto const &content     = get_cluster_content();
+  int64_t bytes_processed = 0;
+
+  for (auto _ : state) {
+    auto cluster = mtx::kax::parse_raw_cluster(memory_c::borrow(content->get_buffer(), content->get_size(), content), 1000000);
+
+    for (auto &block : cluster->blocks)
+      for (auto &frame : block.frames) {
+        frame->take_ownership();
+        benchmark::DoNotOptimize(frame->get_buffer());
+      }
+
+    bytes_processed += content->get_size();
+  }
+
+  state.SetBytesProcessed(bytes_processed);
+}
+
+}
+
+BENCHMARK(BM_KaxClusterReadingLibEbml);
+BENCHMARK(BM_KaxClusterReadingRaw);
@@ -0,0 +1,196 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   micro benchmarks – reading MPEG transport stream packets
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <benchmark/benchmark.h>
+
+#include "common/mm_mem_io.h"
+#include "common/mm_proxy_io.h"
+#include "common/mm_read_buffer_io.h"
+
+// Simulates how the MPEG transport stream reader gets at the packets
+// of a DVB capture while multiplexing. The capture contains four
+// programs with one video, three audio and one subtitle track each, a
+// couple of PIDs carrying service information and stuffing packets,
+// 32 MiB in total.
+//
+// The "per packet" variant reads each packet from the buffered input
+// and searches the list of tracks for the packet's PID the way the
+// reader used to. The "batched" variant reads 1024 packets at a time
+// and looks the PID up in a table of all 8192 PIDs like it does now.
+// Packets of PIDs without a track are skipped; for all others the
+// continuity counter is checked and the payload size is summed up.
+
+namespace {
+
+unsigned int constexpr s_packet_size = 188;
+
+struct track_t {
+  uint16_t pid;
+  std::size_t file_num;
+  unsigned int expected_continuity_counter{}, num_continuity_errors{};
+  uint64_t payload_size{};
+};
+
+memory_cptr const &
+get_capture() {
+  static memory_cptr s_capture;
+
+  if (s_capture)
+    return s_capture;
+
+  // Most packets belong to the video tracks; the rest to the audio &
+  // subtitle tracks, the service information (NIT, EIT, TDT) and
+  // stuffing.
+  std::vector<std::pair<uint16_t, unsigned int>> pid_weights;
+
+  for (auto program = 0u; program < 4; ++program) {
+    auto base = 0x100 + program * 0x100;
+
+    pid_weights.emplace_back(base,     150);
+    pid_weights.emplace_back(base + 1, 8);
+    pid_weights.emplace_back(base + 2, 8);
+    pid_weights.emplace_back(base + 3, 4);
+    pid_weights.emplace_back(base + 4, 2);
+  }
+
+  pid_weights.emplace_back(0x0010, 4);
+  pid_weights.emplace_back(0x0012, 20);
+  pid_weights.emplace_back(0x0014, 1);
+  pid_weights.emplace_back(0x1fff, 60);
+
+  std::vector<uint16_t> schedule;
+  for (auto const &pid_weight : pid_weights)
+    schedule.insert(schedule.end(), pid_weight.second, pid_weight.first);
+
+  auto num_packets = 32 * 1024 * 1024 / s_packet_size;
+  s_capture        = memory_c::alloc(num_packets * s_packet_size);
+  auto buffer      = s_capture->get_buffer();
+  auto state       = 4711u;
+
+  unsigned int counters[0x2000]{};
+
+  for (auto idx = 0u; idx < num_packets; ++idx) {
+    state       = state * 1103515245 + 12345;
+    auto pid    = schedule[(state >> 8) % schedule.size()];
+    auto packet = buffer + idx * s_packet_size;
+
+    packet[0] = 0x47;
+    packet[1] = pid >> 8;
+    packet[2] = pid & 0xff;
+    packet[3] = 0x10 | (counters[pid]++ & 0x0f);
+
+    std::memset(packet + 4, idx & 0xff, s_packet_size - 4);
+  }
+
+  return s_capture;
+}
+
+std::vector<track_t>
+create_tracks() {
+  std::vector<track_t> tracks;
+
+  for (auto program = 0u; program < 4; ++program)
+    for (auto idx = 0u; idx < 5; ++idx)
+      tracks.push_back({ static_cast<uint16_t>(0x100 + program * 0x100 + idx), 0 });
+
+  return tracks;
+}
+
+void
+handle_packet(track_t &track,
+              unsigned char const *packet) {
+  auto continuity_counter = packet[3] & 0x0f;
+
+  if (continuity_counter != track.expected_continuity_counter)
+    ++track.num_continuity_errors;
+
+  track.expected_continuity_counter  = (continuity_counter + 1) % 16;
+  track.payload_size                += s_packet_size - 4;
+}
+
+uint16_t
+get_pid(unsigned char const *packet) {
+  return ((packet[1] & 0x1f) << 8) | packet[2];
+}
+
+void
+BM_MpegTsReadingPerPacket(benchmark::State &state) {
+  auto const &capture = get_capture();
+  int64_t num_packets = 0;
+
+  for (auto _ : state) {
+    auto tracks = create_tracks();
+    mm_read_buffer_io_c in{std::make_shared<mm_mem_io_c>(capture->get_buffer(), capture->get_size())};
+    unsigned char packet[s_packet_size + 1];
+
+    while (in.read(packet, s_packet_size) == s_packet_size) {
+      ++num_packets;
+
+      auto pid = get_pid(packet);
+
+      for (auto &track : tracks)
+        if ((track.file_num == 0) && (track.pid == pid)) {
+          handle_packet(track, packet);
+          break;
+        }
+    }
+
+    benchmark::DoNotOptimize(tracks.data());
+  }
+
+  state.SetItemsProcessed(num_packets);
+  state.SetBytesProcessed(num_packets * s_packet_size);
+}
+
+void
+BM_MpegTsReadingBatched(benchmark::State &state) {
+  auto const &capture = get_capture();
+  int64_t num_packets = 0;
+
+  for (auto _ : state) {
+    auto tracks = create_tracks();
+    mm_read_buffer_io_c in{std::make_shared<mm_mem_io_c>(capture->get_buffer(), capture->get_size())};
+
+    std::vector<track_t *> pid_to_track_map(0x2000);
+    for (auto &track : tracks)
+      pid_to_track_map[track.pid] = &track;
+
+    auto batch = memory_c::alloc(1024 * s_packet_size);
+
+    while (true) {
+      auto num_read = in.read(batch->get_buffer(), batch->get_size()) / s_packet_size;
+      if (!num_read)
+        break;
+
+      num_packets += num_read;
+
+      for (auto packet = batch->get_buffer(), end = packet + num_read * s_packet_size; packet < end; packet += s_packet_size) {
+        auto track = pid_to_track_map[get_pid(packet)];
+        if (track)
+          handle_packet(*track, packet);
+      }
+    }
+
+    benchmark::DoNotOptimize(tracks.data());
+  }
+
+  state.SetItemsProcessed(num_packets);
+  state.SetBytesProcessed(num_packets * s_packet_size);
+}
+
+}
+
+BENCHMARK(BM_MpegTsReadingPerPacket)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_MpegTsReadingBatched)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,207 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   micro benchmarks – reading frames of badly interleaved MP4/MOV files
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <benchmark/benchmark.h>
+
+#if defined(HAVE_POSIX_FADVISE)
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include "common/mm_file_io.h"
+#include "common/mm_proxy_io.h"
+#include "common/mm_read_buffer_io.h"
+
+// Simulates the access pattern of the Quicktime/MP4 reader for a file
+// in which all video frames are stored before all audio frames, as
+// some cameras write them. Frames are requested alternately from both
+// tracks like the packetizers request them during muxing.
+//
+// The "per frame" variant seeks to & reads each frame individually
+// the way the reader used to. The "coalesced" variant reads frames
+// following each other in the file with a single read of up to 4 MiB
+// and hands out slices of it like qtmp4_reader_c::read_ahead() does.
+//
+// The file read is taken from the environment variable
+// MTX_BENCHMARK_MP4_FILE, e.g. a 50 GB MOV file; its content is only
+// used as raw data. Otherwise a temporary file is created whose size
+// in MiB can be set with MTX_BENCHMARK_MP4_FILE_SIZE (default: 512).
+// The file's pages are dropped from the page cache before each
+// iteration where supported.
+
+namespace {
+
+struct frame_t {
+  int64_t file_pos, size;
+};
+
+class benchmark_file_c {
+public:
+  std::string m_file_name;
+  bool m_is_temporary{};
+  std::vector<frame_t> m_video, m_audio;
+
+public:
+  benchmark_file_c() {
+    auto file_name = getenv("MTX_BENCHMARK_MP4_FILE");
+    if (file_name)
+      m_file_name = file_name;
+
+    else {
+      auto size_in_mib = getenv("MTX_BENCHMARK_MP4_FILE_SIZE");
+      auto size        = (size_in_mib ? std::stoull(size_in_mib) : 512ull) * 1024 * 1024;
+
+      m_file_name      = (bfs::temp_directory_path() / bfs::unique_path("mkvtoolnix-benchmark-%%%%-%%%%.mov")).string();
+      m_is_temporary   = true;
+
+      std::vector<unsigned char> chunk(1024 * 1024);
+      for (auto idx = 0u; idx < chunk.size(); ++idx)
+        chunk[idx] = (idx * 7) & 0xff;
+
+      mm_file_io_c out{m_file_name, libebml::MODE_CREATE};
+      for (auto written = 0ull; written < size; written += chunk.size())
+        out.write(chunk.data(), chunk.size());
+    }
+
+    create_layout(mm_file_io_c{m_file_name}.get_size());
+  }
+
+  ~benchmark_file_c() {
+    if (m_is_temporary)
+      bfs::remove(m_file_name);
+  }
+
+  void
+  create_layout(int64_t file_size) {
+    // Video frames between 20 and 80 KiB fill most of the file. They're
+    // followed by one audio frame of 1 KiB per video frame, similar to
+    // AAC at 48 kHz accompanying 50p video.
+    auto audio_frame_size = int64_t{1024};
+    auto state            = 4711u;
+    auto pos              = int64_t{};
+
+    while (true) {
+      state     = state * 1103515245 + 12345;
+      auto size = static_cast<int64_t>(20 * 1024 + (state >> 8) % (60 * 1024));
+
+      if ((pos + size + static_cast<int64_t>(m_video.size() + 1) * audio_frame_size) > file_size)
+        break;
+
+      m_video.push_back({ pos, size });
+      pos += size;
+    }
+
+    for (auto idx = 0u; idx < m_video.size(); ++idx)
+      m_audio.push_back({ pos + idx * audio_frame_size, audio_frame_size });
+  }
+
+  void
+  drop_from_cache()
+    const {
+#if defined(HAVE_POSIX_FADVISE)
+    auto fd = ::open(m_file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#endif
+  }
+};
+
+benchmark_file_c const &
+get_benchmark_file() {
+  static benchmark_file_c s_file;
+  return s_file;
+}
+
+class track_reader_c {
+public:
+  std::vector<frame_t> const &m_frames;
+  std::deque<memory_cptr> m_read_ahead;
+  std::size_t m_pos{};
+
+public:
+  track_reader_c(std::vector<frame_t> const &frames)
+    : m_frames(frames)
+  {
+  }
+
+  memory_cptr
+  read_frame(mm_io_c &in,
+             bool coalesce) {
+    auto &frame = m_frames[m_pos++];
+
+    if (!coalesce) {
+      in.setFilePointer(frame.file_pos);
+      return in.read(frame.size);
+    }
+
+    if (m_read_ahead.empty()) {
+      auto end = m_pos;
+      while ((end < m_frames.size()) && ((m_frames[end].file_pos + m_frames[end].size - frame.file_pos) <= 4 * 1024 * 1024))
+        ++end;
+
+      auto last = m_frames[end - 1];
+
+      in.setFilePointer(frame.file_pos);
+      auto buffer = in.read(last.file_pos + last.size - frame.file_pos);
+
+      for (auto idx = m_pos - 1; idx < end; ++idx)
+        m_read_ahead.push_back(memory_c::borrow(buffer->get_buffer() + m_frames[idx].file_pos - frame.file_pos, m_frames[idx].size, buffer));
+    }
+
+    auto buffer = m_read_ahead.front();
+    m_read_ahead.pop_front();
+
+    return buffer;
+  }
+};
+
+void
+BM_Qtmp4ReadFrames(benchmark::State &state) {
+  auto coalesce       = !!state.range(0);
+  auto &file          = get_benchmark_file();
+  int64_t bytes_read  = 0;
+  uint32_t checksum   = 0;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    file.drop_from_cache();
+    state.ResumeTiming();
+
+    // Like the reader does for badly interleaved files.
+    mm_read_buffer_io_c in{std::make_shared<mm_file_io_c>(file.m_file_name)};
+    in.enable_buffering(false);
+
+    track_reader_c video{file.m_video}, audio{file.m_audio};
+
+    for (auto idx = 0u; idx < file.m_video.size(); ++idx)
+      for (auto track : { &video, &audio }) {
+        auto frame  = track->read_frame(in, coalesce);
+        checksum   ^= frame->get_buffer()[0];
+        bytes_read += frame->get_size();
+      }
+  }
+
+  benchmark::DoNotOptimize(checksum);
+
+  state.SetBytesProcessed(bytes_read);
+  state.SetLabel(coalesce ? "coalesced" : "per frame");
+}
+
+}
+
+BENCHMARK(BM_Qtmp4ReadFrames)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,129 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   micro benchmarks – reading files with and without read-ahead
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <benchmark/benchmark.h>
+
+#if defined(HAVE_POSIX_FADVISE)
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include "common/mm_file_io.h"
+#include "common/mm_proxy_io.h"
+#include "common/mm_read_buffer_io.h"
+
+// Reads a file in 188 byte packets like the MPEG transport stream
+// reader does, doing a bit of work on each packet in order to
+// simulate parsing.
+//
+// The file read is taken from the environment variable
+// MTX_BENCHMARK_FILE, e.g. a multi-GB M2TS file. Otherwise a
+// temporary file is created whose size in MiB can be set with
+// MTX_BENCHMARK_FILE_SIZE (default: 256).
+//
+// For the "cold" variants the file's pages are dropped from the page
+// cache before each iteration where supported.
+
+namespace {
+
+class benchmark_file_c {
+public:
+  std::string m_file_name;
+  bool m_is_temporary{};
+
+public:
+  benchmark_file_c() {
+    auto file_name = getenv("MTX_BENCHMARK_FILE");
+    if (file_name) {
+      m_file_name = file_name;
+      return;
+    }
+
+    auto size_in_mib = getenv("MTX_BENCHMARK_FILE_SIZE");
+    auto size        = (size_in_mib ? std::stoull(size_in_mib) : 256ull) * 1024 * 1024;
+
+    m_file_name      = (bfs::temp_directory_path() / bfs::unique_path("mkvtoolnix-benchmark-%%%%-%%%%.ts")).string();
+    m_is_temporary   = true;
+
+    std::vector<unsigned char> chunk(1024 * 1024);
+    for (auto idx = 0u; idx < chunk.size(); ++idx)
+      chunk[idx] = (idx % 188) ? (idx * 7) & 0xff : 0x47;
+
+    mm_file_io_c out{m_file_name, libebml::MODE_CREATE};
+    for (auto written = 0ull; written < size; written += chunk.size())
+      out.write(chunk.data(), chunk.size());
+  }
+
+  ~benchmark_file_c() {
+    if (m_is_temporary)
+      bfs::remove(m_file_name);
+  }
+
+  void
+  drop_from_cache()
+    const {
+#if defined(HAVE_POSIX_FADVISE)
+    auto fd = ::open(m_file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#endif
+  }
+};
+
+benchmark_file_c const &
+get_benchmark_file() {
+  static benchmark_file_c s_file;
+  return s_file;
+}
+
+void
+BM_ReadBufferIo(benchmark::State &state) {
+  auto num_read_ahead_buffers = static_cast<std::size_t>(state.range(0));
+  auto cold                   = !!state.range(1);
+  auto &file                  = get_benchmark_file();
+  int64_t bytes_processed     = 0;
+  uint32_t checksum           = 0;
+  unsigned char packet[188];
+
+  for (auto _ : state) {
+    if (cold) {
+      state.PauseTiming();
+      file.drop_from_cache();
+      state.ResumeTiming();
+    }
+
+    mm_read_buffer_io_c in{std::make_shared<mm_file_io_c>(file.m_file_name), num_read_ahead_buffers ? 1 << 20 : 1 << 17, num_read_ahead_buffers};
+
+    while (in.read(packet, 188) == 188) {
+      for (auto byte : packet)
+        checksum = (checksum << 1) ^ byte;
+
+      bytes_processed += 188;
+    }
+  }
+
+  benchmark::DoNotOptimize(checksum);
+
+  state.SetBytesProcessed(bytes_processed);
+  state.SetLabel(fmt::format("{0} {1}", num_read_ahead_buffers ? "read-ahead" : "synchronous", cold ? "cold" : "warm"));
+}
+
+}
+
+BENCHMARK(BM_ReadBufferIo)->ArgsProduct({ { 0, 4 }, { 0, 1 } })->Unit(benchmark::kMillisecond)->UseRealTime();
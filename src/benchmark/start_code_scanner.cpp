@@ -0,0 +1,136 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   micro benchmarks – searching for start codes & emulation prevention bytes
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <benchmark/benchmark.h>
+
+#include "common/mm_file_io.h"
+#include "common/mpeg.h"
+
+// Splits an elementary stream into NALUs and converts each NALU to an
+// RBSP with each of the scanner implementations the CPU supports.
+//
+// The stream is read from the file named by the environment variable
+// MTX_BENCHMARK_ES_FILE, e.g. a raw H.264 or HEVC elementary stream.
+// Otherwise 64 MiB of random data with a start code every 8 KiB is
+// used.
+
+namespace {
+
+memory_cptr
+create_elementary_stream() {
+  auto file_name = getenv("MTX_BENCHMARK_ES_FILE");
+  if (file_name)
+    return mm_file_io_c::slurp(file_name);
+
+  auto size   = 64 * 1024 * 1024;
+  auto es     = memory_c::alloc(size);
+  auto buffer = es->get_buffer();
+  auto state  = 4711u;
+
+  for (auto idx = 0; idx < size; ++idx) {
+    state       = state * 1103515245 + 12345;
+    buffer[idx] = state >> 16;
+
+    // Like in a real stream there are no start codes within NALUs,
+    // but emulation prevention bytes occur every now and then.
+    if ((2 <= idx) && !buffer[idx - 2] && !buffer[idx - 1] && (buffer[idx] <= 0x03))
+      buffer[idx] = 0x03;
+  }
+
+  for (auto idx = 0; idx < size; idx += 8 * 1024) {
+    buffer[idx]     = 0x00;
+    buffer[idx + 1] = 0x00;
+    buffer[idx + 2] = 0x01;
+    buffer[idx + 3] = 0x41;
+  }
+
+  return es;
+}
+
+memory_cptr const &
+get_elementary_stream() {
+  static auto s_es = create_elementary_stream();
+  return s_es;
+}
+
+bool
+use_implementation(benchmark::State &state) {
+  auto implementation = static_cast<mtx::mpeg::scanner_implementation_e>(state.range(0));
+  auto available      = mtx::mpeg::get_available_scanner_implementations();
+
+  if (std::find(available.begin(), available.end(), implementation) == available.end()) {
+    state.SkipWithError("implementation not supported by the CPU");
+    return false;
+  }
+
+  mtx::mpeg::set_scanner_implementation(implementation);
+
+  state.SetLabel(  implementation == mtx::mpeg::scanner_implementation_e::avx2 ? "AVX2"
+                 : implementation == mtx::mpeg::scanner_implementation_e::sse2 ? "SSE2"
+                 :                                                               "scalar");
+
+  return true;
+}
+
+void
+BM_FindStartCodes(benchmark::State &state) {
+  if (!use_implementation(state))
+    return;
+
+  auto &es             = get_elementary_stream();
+  auto begin           = es->get_buffer();
+  auto end             = begin + es->get_size();
+  auto num_start_codes = 0u;
+
+  for (auto _ : state)
+    for (auto start_code = mtx::mpeg::find_start_code(begin, end); start_code != end; start_code = mtx::mpeg::find_start_code(start_code + 3, end))
+      ++num_start_codes;
+
+  benchmark::DoNotOptimize(num_start_codes);
+
+  state.SetBytesProcessed(state.iterations() * es->get_size());
+}
+
+void
+BM_NaluToRbsp(benchmark::State &state) {
+  if (!use_implementation(state))
+    return;
+
+  auto &es = get_elementary_stream();
+  std::vector<memory_cptr> nalus;
+
+  auto begin = es->get_buffer();
+  auto end   = begin + es->get_size();
+  auto start = mtx::mpeg::find_start_code(begin, end);
+
+  while (start != end) {
+    auto next = mtx::mpeg::find_start_code(start + 3, end);
+    nalus.emplace_back(memory_c::borrow(start + 3, next - start - 3));
+    start = next;
+  }
+
+  for (auto _ : state)
+    for (auto const &nalu : nalus) {
+      auto rbsp = mtx::mpeg::nalu_to_rbsp(nalu);
+      benchmark::DoNotOptimize(rbsp->get_buffer());
+    }
+
+  state.SetBytesProcessed(state.iterations() * es->get_size());
+}
+
+}
+
+BENCHMARK(BM_FindStartCodes)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_NaluToRbsp)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,81 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   micro benchmarks – selecting the next packet to mux
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <benchmark/benchmark.h>
+
+#include "common/timestamp.h"
+#include "common/tournament_tree.h"
+
+// Simulates mkvmerge's main loop: each track always has one pending
+// packet; the one with the smallest timestamp is muxed and replaced
+// by the track's next packet. The number of packets processed per
+// second is reported for various numbers of tracks.
+
+namespace {
+
+std::vector<int64_t>
+create_packet_durations(std::size_t num_tracks) {
+  std::vector<int64_t> durations;
+
+  for (auto idx = 0u; idx < num_tracks; ++idx)
+    durations.emplace_back(20'000'000 + (idx * 7'919 % 1'000) * 40'000);
+
+  return durations;
+}
+
+void
+BM_WinnerSelectionLinearScan(benchmark::State &state) {
+  auto num_tracks = static_cast<std::size_t>(state.range(0));
+  auto durations  = create_packet_durations(num_tracks);
+  std::vector<std::optional<timestamp_c>> pending(num_tracks);
+
+  for (auto idx = 0u; idx < num_tracks; ++idx)
+    pending[idx] = timestamp_c::ns(0);
+
+  for (auto _ : state) {
+    auto winner = num_tracks;
+
+    for (auto idx = 0u; idx < num_tracks; ++idx)
+      if (pending[idx] && ((winner == num_tracks) || (*pending[idx] < *pending[winner])))
+        winner = idx;
+
+    pending[winner] = *pending[winner] + timestamp_c::ns(durations[winner]);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+void
+BM_WinnerSelectionTournamentTree(benchmark::State &state) {
+  auto num_tracks = static_cast<std::size_t>(state.range(0));
+  auto durations  = create_packet_durations(num_tracks);
+  mtx::tournament_tree_c<timestamp_c> tree{num_tracks};
+
+  for (auto idx = 0u; idx < num_tracks; ++idx)
+    tree.set(idx, timestamp_c::ns(0));
+
+  for (auto _ : state) {
+    auto winner = tree.top();
+
+    tree.set(winner, *tree.get(winner) + timestamp_c::ns(durations[winner]));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+}
+
+BENCHMARK(BM_WinnerSelectionLinearScan)->RangeMultiplier(2)->Range(2, 256);
+BENCHMARK(BM_WinnerSelectionTournamentTree)->RangeMultiplier(2)->Range(2, 256);
@@ -13,11 +13,166 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define MTX_ADLER32_X86
+# include <immintrin.h>
+#endif
+
 #include "common/checksums/adler32.h"
 #include "common/endian.h"
 
 namespace mtx::checksum {
 
+namespace {
+
+uint32_t constexpr s_mod_adler = 65521;
+
+// The largest number of bytes that can be added before the sums have
+// to be reduced modulo 65521 without overflowing 32 bits.
+std::size_t constexpr s_max_unreduced = 5552;
+
+// Number of bytes the vectorized implementations handle per step.
+std::size_t constexpr s_block_size = 32;
+
+// -1 until the implementation to use has been determined
+std::atomic<int> s_implementation{-1};
+
+void
+add_scalar(uint32_t &a,
+           uint32_t &b,
+           unsigned char const *buffer,
+           size_t size) {
+  while (size) {
+    auto chunk_size = std::min(size, s_max_unreduced);
+    size           -= chunk_size;
+
+    for (; chunk_size >= 8; chunk_size -= 8, buffer += 8) {
+      a += buffer[0]; b += a;
+      a += buffer[1]; b += a;
+      a += buffer[2]; b += a;
+      a += buffer[3]; b += a;
+      a += buffer[4]; b += a;
+      a += buffer[5]; b += a;
+      a += buffer[6]; b += a;
+      a += buffer[7]; b += a;
+    }
+
+    for (; chunk_size; --chunk_size, ++buffer) {
+      a += *buffer;
+      b += a;
+    }
+
+    a %= s_mod_adler;
+    b %= s_mod_adler;
+  }
+}
+
+#if defined(MTX_ADLER32_X86)
+
+// Both vectorized implementations work on blocks of 32 bytes. For
+// each block the byte sum is added to `a`; `b` gains 32 times the
+// value `a` had before the block plus the bytes weighted with 32, 31,
+// …, 1. `size` must be a multiple of 32.
+
+__attribute__((target("ssse3")))
+inline uint32_t
+horizontal_sum(__m128i sums) {
+  sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+  sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2)));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(sums));
+}
+
+__attribute__((target("ssse3")))
+void
+add_ssse3(uint32_t &a,
+          uint32_t &b,
+          unsigned char const *buffer,
+          size_t size) {
+  auto const weights_high = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+  auto const weights_low  = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1);
+  auto const zero         = _mm_setzero_si128();
+  auto const ones         = _mm_set1_epi16(1);
+  auto num_blocks         = size / s_block_size;
+
+  while (num_blocks) {
+    auto num_here   = std::min(num_blocks, s_max_unreduced / s_block_size);
+    num_blocks     -= num_here;
+
+    auto previous_a = _mm_cvtsi32_si128(static_cast<int>(a * num_here));
+    auto sum_b      = _mm_cvtsi32_si128(static_cast<int>(b));
+    auto sum_a      = zero;
+
+    for (; num_here; --num_here, buffer += s_block_size) {
+      auto bytes1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer));
+      auto bytes2 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 16));
+
+      previous_a  = _mm_add_epi32(previous_a, sum_a);
+      sum_a       = _mm_add_epi32(sum_a, _mm_sad_epu8(bytes1, zero));
+      sum_a       = _mm_add_epi32(sum_a, _mm_sad_epu8(bytes2, zero));
+      sum_b       = _mm_add_epi32(sum_b, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, weights_high), ones));
+      sum_b       = _mm_add_epi32(sum_b, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, weights_low),  ones));
+    }
+
+    sum_b = _mm_add_epi32(sum_b, _mm_slli_epi32(previous_a, 5));
+
+    a     = (a + horizontal_sum(sum_a)) % s_mod_adler;
+    b     = horizontal_sum(sum_b)       % s_mod_adler;
+  }
+}
+
+__attribute__((target("avx2")))
+void
+add_avx2(uint32_t &a,
+         uint32_t &b,
+         unsigned char const *buffer,
+         size_t size) {
+  auto const weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                        16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1);
+  auto const zero    = _mm256_setzero_si256();
+  auto const ones    = _mm256_set1_epi16(1);
+  auto num_blocks    = size / s_block_size;
+
+  while (num_blocks) {
+    auto num_here   = std::min(num_blocks, s_max_unreduced / s_block_size);
+    num_blocks     -= num_here;
+
+    auto previous_a = _mm256_zextsi128_si256(_mm_cvtsi32_si128(static_cast<int>(a * num_here)));
+    auto sum_b      = _mm256_zextsi128_si256(_mm_cvtsi32_si128(static_cast<int>(b)));
+    auto sum_a      = zero;
+
+    for (; num_here; --num_here, buffer += s_block_size) {
+      auto bytes = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(buffer));
+
+      previous_a = _mm256_add_epi32(previous_a, sum_a);
+      sum_a      = _mm256_add_epi32(sum_a, _mm256_sad_epu8(bytes, zero));
+      sum_b      = _mm256_add_epi32(sum_b, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, weights), ones));
+    }
+
+    sum_b = _mm256_add_epi32(sum_b, _mm256_slli_epi32(previous_a, 5));
+
+    a     = (a + horizontal_sum(_mm_add_epi32(_mm256_castsi256_si128(sum_a), _mm256_extracti128_si256(sum_a, 1)))) % s_mod_adler;
+    b     =      horizontal_sum(_mm_add_epi32(_mm256_castsi256_si128(sum_b), _mm256_extracti128_si256(sum_b, 1)))  % s_mod_adler;
+  }
+}
+
+#endif  // MTX_ADLER32_X86
+
+adler32_c::implementation_e
+get_implementation() {
+  auto implementation = s_implementation.load(std::memory_order_relaxed);
+  if (implementation >= 0)
+    return static_cast<adler32_c::implementation_e>(implementation);
+
+  auto best = adler32_c::get_available_implementations().back();
+  s_implementation.store(static_cast<int>(best), std::memory_order_relaxed);
+
+  return best;
+}
+
+}
+
 adler32_c::adler32_c()
   : m_a{1}
   , m_b{0}
@@ -41,13 +196,60 @@ adler32_c::get_result_as_uint()
   return (m_b << 16) | m_a;
 }
 
+adler32_c &
+adler32_c::reset() {
+  m_a = 1;
+  m_b = 0;
+
+  return *this;
+}
+
+std::vector<adler32_c::implementation_e>
+adler32_c::get_available_implementations() {
+  std::vector<implementation_e> implementations{ implementation_e::scalar };
+
+#if defined(MTX_ADLER32_X86)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("ssse3"))
+    implementations.push_back(implementation_e::ssse3);
+
+  if (__builtin_cpu_supports("avx2"))
+    implementations.push_back(implementation_e::avx2);
+#endif
+
+  return implementations;
+}
+
+void
+adler32_c::set_implementation(implementation_e implementation) {
+  s_implementation.store(static_cast<int>(implementation), std::memory_order_relaxed);
+}
+
 void
 adler32_c::add_impl(unsigned char const *buffer,
                     size_t size) {
-  for (auto idx = 0u; idx < size; ++idx) {
-    m_a = (m_a + buffer[idx]) % msc_mod_adler;
-    m_b = (m_b + m_a)         % msc_mod_adler;
+#if defined(MTX_ADLER32_X86)
+  // Small buffers such as parameter sets aren't worth the setup.
+  if (size >= 2 * s_block_size) {
+    auto implementation = get_implementation();
+    auto to_vectorize   = size - size % s_block_size;
+
+    if (implementation == implementation_e::avx2)
+      add_avx2(m_a, m_b, buffer, to_vectorize);
+
+    else if (implementation == implementation_e::ssse3)
+      add_ssse3(m_a, m_b, buffer, to_vectorize);
+
+    else
+      to_vectorize = 0;
+
+    buffer += to_vectorize;
+    size   -= to_vectorize;
   }
+#endif
+
+  add_scalar(m_a, m_b, buffer, size);
 }
 
 } // namespace mtx::checksum
@@ -20,8 +20,14 @@
 namespace mtx::checksum {
 
 class adler32_c: public base_c, public uint_result_c {
+public:
+  enum class implementation_e {
+    scalar,
+    ssse3,
+    avx2,
+  };
+
 protected:
-  static uint32_t const msc_mod_adler = 65521;
   uint32_t m_a, m_b;
 
 public:
@@ -31,6 +37,14 @@ public:
   virtual memory_cptr get_result() const;
   virtual uint64_t get_result_as_uint() const;
 
+  // Allows re-using the same object for a lot of small buffers,
+  // e.g. for each frame of a file.
+  adler32_c &reset();
+
+  // Only meant for tests and benchmarks.
+  static std::vector<implementation_e> get_available_implementations();
+  static void set_implementation(implementation_e implementation);
+
 protected:
   virtual void add_impl(unsigned char const *buffer, size_t size);
 };
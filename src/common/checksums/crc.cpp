@@ -16,12 +16,167 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
+#include <mutex>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define MTX_CRC32_PCLMUL
+# include <immintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+# define MTX_CRC32_ARMV8
+# include <arm_acle.h>
+#endif
+
 #include "common/bswap.h"
 #include "common/checksums/crc.h"
 #include "common/endian.h"
 
 namespace mtx::checksum {
 
+namespace {
+
+constexpr auto num_tables = 16u;
+
+// -1 until the implementation to use has been determined
+std::atomic<int> s_implementation{-1};
+
+inline uint32_t
+load_uint32_le(unsigned char const *buffer) {
+  return  static_cast<uint32_t>(buffer[0])
+       | (static_cast<uint32_t>(buffer[1]) <<  8)
+       | (static_cast<uint32_t>(buffer[2]) << 16)
+       | (static_cast<uint32_t>(buffer[3]) << 24);
+}
+
+#if defined(MTX_CRC32_PCLMUL)
+
+__attribute__((target("sse2")))
+inline __m128i
+load(unsigned char const *buffer) {
+  return _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer));
+}
+
+__attribute__((target("pclmul,sse2")))
+inline __m128i
+fold(__m128i value,
+     __m128i constants,
+     __m128i data) {
+  auto low  = _mm_clmulepi64_si128(value, constants, 0x00);
+  auto high = _mm_clmulepi64_si128(value, constants, 0x11);
+  return _mm_xor_si128(_mm_xor_si128(high, low), data);
+}
+
+// Folds 64 bytes at a time with carry-less multiplications as
+// described in Intel's paper "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction". The constants are for the
+// reflected polynomial 0xEDB88320. `size` must be at least 64 and a
+// multiple of 16.
+__attribute__((target("pclmul,sse4.1")))
+uint32_t
+crc32_ieee_le_pclmul(unsigned char const *buffer,
+                     size_t size,
+                     uint32_t crc) {
+  alignas(16) static uint64_t const k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+  alignas(16) static uint64_t const k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+  alignas(16) static uint64_t const k5k0[] = { 0x0163cd6124, 0x0000000000 };
+  alignas(16) static uint64_t const poly[] = { 0x01db710641, 0x01f7011641 };
+
+  auto x1 = _mm_xor_si128(load(buffer), _mm_cvtsi32_si128(static_cast<int>(crc)));
+  auto x2 = load(buffer + 0x10);
+  auto x3 = load(buffer + 0x20);
+  auto x4 = load(buffer + 0x30);
+  auto k  = _mm_load_si128(reinterpret_cast<__m128i const *>(k1k2));
+
+  buffer += 64;
+  size   -= 64;
+
+  while (size >= 64) {
+    x1      = fold(x1, k, load(buffer));
+    x2      = fold(x2, k, load(buffer + 0x10));
+    x3      = fold(x3, k, load(buffer + 0x20));
+    x4      = fold(x4, k, load(buffer + 0x30));
+    buffer += 64;
+    size   -= 64;
+  }
+
+  // Fold the four 128-bit values into one.
+  k  = _mm_load_si128(reinterpret_cast<__m128i const *>(k3k4));
+  x1 = fold(x1, k, x2);
+  x1 = fold(x1, k, x3);
+  x1 = fold(x1, k, x4);
+
+  while (size >= 16) {
+    x1      = fold(x1, k, load(buffer));
+    buffer += 16;
+    size   -= 16;
+  }
+
+  // Fold 128 bits to 64 bits.
+  auto mask = _mm_setr_epi32(~0, 0, ~0, 0);
+  x2        = _mm_clmulepi64_si128(x1, k, 0x10);
+  x1        = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  k         = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(k5k0));
+  x2        = _mm_srli_si128(x1, 4);
+  x1        = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00), x2);
+
+  // Barrett reduction to 32 bits.
+  k  = _mm_load_si128(reinterpret_cast<__m128i const *>(poly));
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+#elif defined(MTX_CRC32_ARMV8)
+
+uint32_t
+crc32_ieee_le_armv8(unsigned char const *buffer,
+                    size_t size,
+                    uint32_t crc) {
+  while (size >= 8) {
+    uint64_t value;
+    std::memcpy(&value, buffer, 8);
+
+    crc     = __crc32d(crc, value);
+    buffer += 8;
+    size   -= 8;
+  }
+
+  while (size--)
+    crc = __crc32b(crc, *buffer++);
+
+  return crc;
+}
+
+#endif
+
+bool
+hardware_crc32_available() {
+#if defined(MTX_CRC32_PCLMUL)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#elif defined(MTX_CRC32_ARMV8)
+  return true;
+#else
+  return false;
+#endif
+}
+
+crc_base_c::implementation_e
+get_implementation() {
+  auto implementation = s_implementation.load(std::memory_order_relaxed);
+  if (implementation >= 0)
+    return static_cast<crc_base_c::implementation_e>(implementation);
+
+  auto best = crc_base_c::get_available_implementations().back();
+  s_implementation.store(static_cast<int>(best), std::memory_order_relaxed);
+
+  return best;
+}
+
+}
+
 crc_base_c::table_parameters_t const crc_base_c::ms_table_parameters[6] = {
   { 0,  8,       0x07 },
   { 0, 16,     0x8005 },
@@ -40,6 +195,9 @@ crc_base_c::crc_base_c(type_e type,
   , m_xor_result{}
   , m_result_in_le{}
 {
+  static std::mutex s_mutex;
+  std::lock_guard<std::mutex> lock{s_mutex};
+
   if (m_table.empty())
     init_table();
 }
@@ -55,7 +213,7 @@ crc_base_c::init_table() {
   if ((parameters.bits < 8) || (parameters.bits > 32) || (parameters.poly >= (1LL<<parameters.bits)))
     throw std::domain_error{"Invalid CRC parameters"};
 
-  m_table.resize(256);
+  m_table.resize(num_tables * 256);
 
   for (auto i = 0u; i < 256u; i++) {
     if (parameters.le) {
@@ -72,6 +230,14 @@ crc_base_c::init_table() {
     }
   }
 
+  // Table k contains the effect of a byte followed by k zero bytes
+  // which allows processing several bytes at once ("slicing-by-N").
+  for (auto k = 1u; k < num_tables; ++k)
+    for (auto i = 0u; i < 256u; ++i) {
+      auto previous        = m_table[(k - 1) * 256 + i];
+      m_table[k * 256 + i] = m_table[previous & 0xff] ^ (previous >> 8);
+    }
+
   // for (auto row = 0u; row < (256u / 4); ++row)
   //   mxinfo(fmt::format("0x{0:08x} 0x{1:08x} 0x{2:08x} 0x{3:08x}\n", m_table[row * 4 + 0], m_table[row * 4 + 1], m_table[row * 4 + 2], m_table[row * 4 + 3]));
 }
@@ -121,9 +287,51 @@ crc_base_c::set_result_in_le(bool result_in_le) {
   m_result_in_le = result_in_le;
 }
 
+std::vector<crc_base_c::implementation_e>
+crc_base_c::get_available_implementations() {
+  std::vector<implementation_e> implementations{ implementation_e::bytewise, implementation_e::slice_by_16 };
+
+  if (hardware_crc32_available())
+    implementations.push_back(implementation_e::hardware);
+
+  return implementations;
+}
+
+void
+crc_base_c::set_implementation(implementation_e implementation) {
+  s_implementation.store(static_cast<int>(implementation), std::memory_order_relaxed);
+}
+
 void
 crc_base_c::add_impl(unsigned char const *buffer,
                      size_t size) {
+  auto implementation = get_implementation();
+
+  if (implementation == implementation_e::bytewise) {
+    add_bytewise(buffer, size);
+    return;
+  }
+
+#if defined(MTX_CRC32_PCLMUL)
+  if ((implementation == implementation_e::hardware) && (m_type == crc_32_ieee_le) && (size >= 64)) {
+    auto to_fold = size & ~static_cast<size_t>(15);
+    m_crc        = crc32_ieee_le_pclmul(buffer, to_fold, m_crc);
+    buffer      += to_fold;
+    size        -= to_fold;
+  }
+#elif defined(MTX_CRC32_ARMV8)
+  if ((implementation == implementation_e::hardware) && (m_type == crc_32_ieee_le)) {
+    m_crc = crc32_ieee_le_armv8(buffer, size, m_crc);
+    return;
+  }
+#endif
+
+  add_slice_by_16(buffer, size);
+}
+
+void
+crc_base_c::add_bytewise(unsigned char const *buffer,
+                         size_t size) {
   auto end = buffer + size;
 
   while (buffer < end) {
@@ -132,6 +340,43 @@ crc_base_c::add_impl(unsigned char const *buffer,
   }
 }
 
+void
+crc_base_c::add_slice_by_16(unsigned char const *buffer,
+                            size_t size) {
+  auto table = m_table.data();
+  auto crc   = m_crc;
+
+  while (size >= 16) {
+    auto one   = load_uint32_le(buffer) ^ crc;
+    auto two   = load_uint32_le(buffer +  4);
+    auto three = load_uint32_le(buffer +  8);
+    auto four  = load_uint32_le(buffer + 12);
+
+    crc = table[15 * 256 + ( one          & 0xff)] ^ table[14 * 256 + ((one   >>  8) & 0xff)] ^ table[13 * 256 + ((one   >> 16) & 0xff)] ^ table[12 * 256 + (one   >> 24)]
+        ^ table[11 * 256 + ( two          & 0xff)] ^ table[10 * 256 + ((two   >>  8) & 0xff)] ^ table[ 9 * 256 + ((two   >> 16) & 0xff)] ^ table[ 8 * 256 + (two   >> 24)]
+        ^ table[ 7 * 256 + ( three        & 0xff)] ^ table[ 6 * 256 + ((three >>  8) & 0xff)] ^ table[ 5 * 256 + ((three >> 16) & 0xff)] ^ table[ 4 * 256 + (three >> 24)]
+        ^ table[ 3 * 256 + ( four         & 0xff)] ^ table[ 2 * 256 + ((four  >>  8) & 0xff)] ^ table[ 1 * 256 + ((four  >> 16) & 0xff)] ^ table[ 0 * 256 + (four  >> 24)];
+
+    buffer += 16;
+    size   -= 16;
+  }
+
+  if (size >= 8) {
+    auto one = load_uint32_le(buffer) ^ crc;
+    auto two = load_uint32_le(buffer + 4);
+
+    crc = table[ 7 * 256 + ( one          & 0xff)] ^ table[ 6 * 256 + ((one   >>  8) & 0xff)] ^ table[ 5 * 256 + ((one   >> 16) & 0xff)] ^ table[ 4 * 256 + (one   >> 24)]
+        ^ table[ 3 * 256 + ( two          & 0xff)] ^ table[ 2 * 256 + ((two   >>  8) & 0xff)] ^ table[ 1 * 256 + ((two   >> 16) & 0xff)] ^ table[ 0 * 256 + (two   >> 24)];
+
+    buffer += 8;
+    size   -= 8;
+  }
+
+  m_crc = crc;
+
+  add_bytewise(buffer, size);
+}
+
 // ----------------------------------------------------------------------
 
 crc_base_c::table_t crc8_atm_c::ms_table;
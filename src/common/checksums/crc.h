@@ -20,6 +20,13 @@
 namespace mtx::checksum {
 
 class crc_base_c: public base_c, public uint_result_c, public set_initial_value_c {
+public:
+  enum class implementation_e {
+    bytewise,
+    slice_by_16,
+    hardware,                   // CRC-32 IEEE LE only; slice_by_16 for the others
+  };
+
 protected:
   enum type_e {
     crc_8_atm      = 0,
@@ -61,9 +68,16 @@ public:
   virtual void set_xor_result(uint64_t xor_result);
   virtual void set_result_in_le(bool result_in_le);
 
+  // Only meant for tests and benchmarks.
+  static std::vector<implementation_e> get_available_implementations();
+  static void set_implementation(implementation_e implementation);
+
 protected:
   virtual void add_impl(unsigned char const *buffer, size_t size);
 
+  void add_bytewise(unsigned char const *buffer, size_t size);
+  void add_slice_by_16(unsigned char const *buffer, size_t size);
+
   virtual void set_initial_value_impl(uint64_t initial_value) ;
   virtual void set_initial_value_impl(unsigned char const *buffer, size_t size);
 };
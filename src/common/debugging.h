@@ -15,6 +15,8 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
+#include <deque>
 #include <sstream>
 #include <unordered_map>
 
@@ -44,7 +46,9 @@ public:
 
 class debugging_option_c {
   struct option_c {
-    std::optional<bool> m_requested;
+    // -1 if not looked up yet. Looking an option up is idempotent, so
+    // concurrent lookups from reader threads may both store the result.
+    std::atomic<int> m_requested{-1};
     std::string m_option;
 
     option_c(std::string const &option)
@@ -53,45 +57,60 @@ class debugging_option_c {
     }
 
     bool get() {
-      if (!m_requested.has_value())
-        m_requested = debugging_c::requested(m_option);
+      auto requested = m_requested.load(std::memory_order_acquire);
 
-      return m_requested.value();
+      if (requested < 0) {
+        requested = debugging_c::requested(m_option) ? 1 : 0;
+        m_requested.store(requested, std::memory_order_release);
+      }
+
+      return requested == 1;
+    }
+
+    void set(std::optional<bool> requested) {
+      m_requested.store(!requested ? -1 : *requested ? 1 : 0, std::memory_order_release);
     }
   };
 
 protected:
-  mutable size_t m_registered_idx;
+  mutable std::atomic<option_c *> m_registered{};
   std::string m_option;
 
 private:
-  static std::vector<option_c> ms_registered_options;
+  static std::deque<option_c> ms_registered_options;
 
 public:
   debugging_option_c(std::string const &option)
-    : m_registered_idx{std::numeric_limits<size_t>::max()}
-    , m_option{option}
+    : m_option{option}
   {
   }
 
   operator bool() const {
-    return ms_registered_options.at(get_idx()).get();
+    return get_registered().get();
   }
 
   void set(std::optional<bool> requested) {
-    ms_registered_options.at(get_idx()).m_requested = requested;
+    get_registered().set(requested);
   }
 
 protected:
-  std::size_t get_idx() const {
-    if (m_registered_idx == std::numeric_limits<size_t>::max())
-      m_registered_idx = register_option(m_option);
+  // Registration cannot happen in the constructor as most options are
+  // static objects initialized before ms_registered_options may be.
+  // register_option() is serialized and returns the same element for
+  // the same name, so racing threads store the same pointer.
+  option_c &get_registered() const {
+    auto registered = m_registered.load(std::memory_order_acquire);
+
+    if (!registered) {
+      registered = &register_option(m_option);
+      m_registered.store(registered, std::memory_order_release);
+    }
 
-    return m_registered_idx;
+    return *registered;
   }
 
 public:
-  static size_t register_option(std::string const &option);
+  static option_c &register_option(std::string const &option);
   static void invalidate_cache();
 };
 
@@ -54,18 +54,9 @@ doc_type_version_handler_c::account(EbmlElement &element,
   if (!with_default && element.IsDefaultValue())
     return element;
 
-  auto p  = p_func();
-  auto id = EbmlId(element).GetValue();
-
-  if (p->s_version_by_element[id] > p->version) {
-    mxdebug_if(p->debug, fmt::format("account: bumping version from {0} to {1} due to ID 0x{2:x}\n", p->version, p->s_version_by_element[id], id));
-    p->version = p->s_version_by_element[id];
-  }
+  auto p = p_func();
 
-  if (p->s_read_version_by_element[id] > p->read_version) {
-    mxdebug_if(p->debug, fmt::format("account: bumping read_version from {0} to {1} due to ID 0x{2:x}\n", p->read_version, p->s_read_version_by_element[id], id));
-    p->read_version = p->s_read_version_by_element[id];
-  }
+  account_id(EbmlId(element).GetValue());
 
   if (dynamic_cast<EbmlMaster *>(&element)) {
     auto &master = static_cast<EbmlMaster &>(element);
@@ -83,6 +74,21 @@ doc_type_version_handler_c::account(EbmlElement &element,
   return element;
 }
 
+void
+doc_type_version_handler_c::account_id(uint32_t id) {
+  auto p = p_func();
+
+  if (p->s_version_by_element[id] > p->version) {
+    mxdebug_if(p->debug, fmt::format("account: bumping version from {0} to {1} due to ID 0x{2:x}\n", p->version, p->s_version_by_element[id], id));
+    p->version = p->s_version_by_element[id];
+  }
+
+  if (p->s_read_version_by_element[id] > p->read_version) {
+    mxdebug_if(p->debug, fmt::format("account: bumping read_version from {0} to {1} due to ID 0x{2:x}\n", p->read_version, p->s_read_version_by_element[id], id));
+    p->read_version = p->s_read_version_by_element[id];
+  }
+}
+
 doc_type_version_handler_c::update_result_e
 doc_type_version_handler_c::update_ebml_head(mm_io_c &file) {
   auto p      = p_func();
@@ -45,6 +45,7 @@ public:
   virtual ~doc_type_version_handler_c();
 
   libebml::EbmlElement &account(libebml::EbmlElement &element, bool with_default = false);
+  void account_id(uint32_t id);
   libebml::EbmlElement &render(libebml::EbmlElement &element, mm_io_c &file, bool with_default = false);
 
   update_result_e update_ebml_head(mm_io_c &file);
@@ -0,0 +1,146 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   buffer collecting data from many pieces
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/gather_buffer.h"
+
+namespace mtx::bytes {
+
+void
+gather_buffer_c::add(unsigned char const *data,
+                     std::size_t size) {
+  if (!size)
+    return;
+
+  gather(size);
+
+  std::memcpy(m_data->get_buffer() + m_offset + m_filled, data, size);
+
+  m_filled           += size;
+  m_num_bytes_added  += size;
+  m_num_bytes_copied += size;
+}
+
+void
+gather_buffer_c::add(memory_cptr const &owner,
+                     unsigned char const *data,
+                     std::size_t size) {
+  if (!size)
+    return;
+
+  m_pieces.push_back({ owner, data, size });
+
+  m_size_of_pieces  += size;
+  m_num_bytes_added += size;
+}
+
+void
+gather_buffer_c::remove(std::size_t num) {
+  if (num > get_size())
+    mxerror("gather_buffer_c: num > get_size(). Should not have happened. Please file a bug report.\n");
+
+  gather();
+
+  m_offset += num;
+  m_filled -= num;
+}
+
+void
+gather_buffer_c::clear() {
+  m_pieces.clear();
+
+  m_filled         = 0;
+  m_offset         = 0;
+  m_size_of_pieces = 0;
+}
+
+unsigned char *
+gather_buffer_c::get_buffer() {
+  gather();
+
+  return m_data ? m_data->get_buffer() + m_offset : nullptr;
+}
+
+std::size_t
+gather_buffer_c::get_size()
+  const {
+  return m_filled + m_size_of_pieces;
+}
+
+memory_cptr
+gather_buffer_c::detach() {
+  gather();
+
+  if (!m_data)
+    return memory_c::alloc(0);
+
+  // Users of memory_c objects expect their offset to be 0, e.g. when
+  // setting an offset themselves. Data removed from the front is
+  // therefore skipped by referencing the rest instead.
+  auto data = m_offset ? memory_c::borrow(m_data->get_buffer() + m_offset, m_filled, m_data) : std::move(m_data);
+
+  if (!m_offset)
+    data->set_size(m_filled);
+
+  m_data.reset();
+  clear();
+
+  return data;
+}
+
+void
+gather_buffer_c::gather(std::size_t additional_size) {
+  auto required_size = m_offset + m_filled + m_size_of_pieces + additional_size;
+
+  if (!m_pieces.empty() || additional_size) {
+    // Memory for pieces is allocated with the exact size so that it
+    // can be handed over as is; data that is copied anyway is
+    // expected to grow further.
+    if (!m_data)
+      m_data = memory_c::alloc(required_size);
+
+    else if (m_data->get_size() < required_size)
+      m_data->resize(additional_size ? std::max(required_size, m_data->get_size() * 2) : required_size);
+  }
+
+  if (m_pieces.empty())
+    return;
+
+  auto buffer = m_data->get_buffer() + m_offset + m_filled;
+
+  for (auto const &piece : m_pieces) {
+    std::memcpy(buffer, piece.data, piece.size);
+    buffer += piece.size;
+  }
+
+  m_filled           += m_size_of_pieces;
+  m_num_bytes_copied += m_size_of_pieces;
+  m_size_of_pieces    = 0;
+
+  m_pieces.clear();
+}
+
+uint64_t
+gather_buffer_c::get_num_bytes_added()
+  const {
+  return m_num_bytes_added;
+}
+
+uint64_t
+gather_buffer_c::get_num_bytes_copied()
+  const {
+  return m_num_bytes_copied;
+}
+
+}
@@ -0,0 +1,61 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   buffer collecting data from many pieces
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+namespace mtx::bytes {
+
+// Collects data spread over many pieces, e.g. the payloads of the
+// transport stream packets a PES packet consists of. Pieces that are
+// part of a memory_c are only referenced until the data is needed as a
+// whole. Then all of them are copied into a single buffer of the
+// required size at once. Pieces given as plain pointers are copied
+// right away.
+class gather_buffer_c {
+protected:
+  struct piece_t {
+    memory_cptr owner;
+    unsigned char const *data;
+    std::size_t size;
+  };
+
+  std::vector<piece_t> m_pieces;
+  memory_cptr m_data;
+  std::size_t m_filled{}, m_offset{}, m_size_of_pieces{};
+  uint64_t m_num_bytes_added{}, m_num_bytes_copied{};
+
+public:
+  void add(unsigned char const *data, std::size_t size);
+  void add(memory_cptr const &owner, unsigned char const *data, std::size_t size);
+  void remove(std::size_t num);
+  void clear();
+
+  unsigned char *get_buffer();
+  std::size_t get_size() const;
+
+  // Hands the data over without copying it. The buffer is empty
+  // afterwards and allocates new memory for data added later.
+  memory_cptr detach();
+
+  uint64_t get_num_bytes_added() const;
+  uint64_t get_num_bytes_copied() const;
+
+protected:
+  void gather(std::size_t additional_size = 0);
+};
+
+using gather_buffer_cptr = std::shared_ptr<gather_buffer_c>;
+
+}
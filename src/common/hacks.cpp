@@ -63,6 +63,24 @@ get_list() {
                                                            Y("This option forces mkvmerge to treat all of those I slices as key frames.") });
   hacks.emplace_back("append_and_split_flac",        svec{ Y("Enable appending and splitting FLAC tracks."),
                                                            Y("The resulting tracks will be broken: the official FLAC tools will not be able to decode them and seeking will not work as expected.") });
+  hacks.emplace_back("multi_threaded_reading",       svec{ Y("Run each reader and its packetizers on a separate thread."),
+                                                           Y("The output is identical to the single-threaded mode. This is not used when appending files.") });
+  hacks.emplace_back("async_writing",                svec{ Y("Write the output file on a separate thread so that multiplexing continues while data is written."),
+                                                           Y("This helps with slow destinations such as network file systems.") });
+  hacks.emplace_back("read_ahead",                   svec{ Y("Read the source files ahead on a separate thread so that parsing doesn't wait for the disk."),
+                                                           Y("Source files must not grow while they're being read.") });
+  hacks.emplace_back("memory_mapped_input",          svec{ Y("Map single source files into memory instead of reading them so that frames can be passed on without being copied."),
+                                                           Y("Pipes, devices and files consisting of several parts are read normally. Source files must not change while they're being read.") });
+  hacks.emplace_back("parallel_probing",             svec{ Y("Probe the source files and read their headers on several threads at the same time."),
+                                                           Y("Messages are still output in the order of the source files.") });
+  hacks.emplace_back("fast_matroska_reading",        svec{ Y("Read clusters of Matroska source files with a single read and pass frames on without parsing them into libebml elements or copying them."),
+                                                           Y("Clusters with unknown sizes, encrypted blocks or damaged structures are read normally.") });
+  hacks.emplace_back("multi_threaded_extraction",    svec{ Y("mkvextract: convert & write the extracted tracks on several threads while the source file is read."),
+                                                           Y("The files created are identical to the single-threaded mode.") });
+  hacks.emplace_back("fast_mpeg_ts_probing",         svec{ Y("MPEG transport streams: stop probing a file as soon as the PAT, all PMTs and all elementary streams listed in them or in the Blu-ray clip information have been found instead of reading at least 5 MB."),
+                                                           Y("After the PAT and all PMTs have been found at most 4 MB are read or 250 ms spent; tracks not identified by then are ignored.") });
+  hacks.emplace_back("direct_cluster_rendering",     svec{ Y("mkvmerge: write clusters with a dedicated serializer instead of building libmatroska elements for them first."),
+                                                           Y("Clusters with block additions, reference priorities or gaps are still rendered by libmatroska.") });
   hacks.emplace_back("cow",                          svec{ Y("No help available.") });
 
 
@@ -44,7 +44,16 @@ constexpr unsigned int KEEP_LAST_CHAPTER_IN_MPLS    = 19;
 constexpr unsigned int KEEP_TRACK_STATISTICS_TAGS   = 20;
 constexpr unsigned int ALL_I_SLICES_ARE_KEY_FRAMES  = 21;
 constexpr unsigned int APPEND_AND_SPLIT_FLAC        = 22;
-constexpr unsigned int MAX_IDX                      = 22;
+constexpr unsigned int MULTI_THREADED_READING       = 23;
+constexpr unsigned int ASYNC_WRITING                = 24;
+constexpr unsigned int READ_AHEAD                   = 25;
+constexpr unsigned int MEMORY_MAPPED_INPUT          = 26;
+constexpr unsigned int PARALLEL_PROBING             = 27;
+constexpr unsigned int FAST_MATROSKA_READING        = 28;
+constexpr unsigned int MULTI_THREADED_EXTRACTION    = 29;
+constexpr unsigned int FAST_MPEG_TS_PROBING         = 30;
+constexpr unsigned int DIRECT_CLUSTER_RENDERING     = 31;
+constexpr unsigned int MAX_IDX                      = 31;
 }
 
 struct hack_t {
@@ -25,7 +25,6 @@
 #include "common/hevc.h"
 #include "common/hevc_es_parser.h"
 #include "common/hevcc.h"
-#include "common/memory_slice_cursor.h"
 #include "common/strings/formatting.h"
 #include "common/timestamp.h"
 
@@ -113,50 +112,41 @@ es_parser_c::discard_actual_frames(bool discard) {
 void
 es_parser_c::add_bytes(unsigned char *buffer,
                        size_t size) {
-  mtx::mem::slice_cursor_c cursor;
-  int marker_size              = 0;
-  int previous_marker_size     = 0;
-  int previous_pos             = -1;
+  int64_t previous_marker_size = 0;
+  int64_t previous_pos         = -1;
   uint64_t previous_parsed_pos = m_parsed_position;
+  memory_cptr combined;
 
-  if (m_unparsed_buffer && (0 != m_unparsed_buffer->get_size()))
-    cursor.add_slice(m_unparsed_buffer);
-  cursor.add_slice(buffer, size);
-
-  if (3 <= cursor.get_remaining_size()) {
-    uint32_t marker =                               1 << 24
-                    | (unsigned int)cursor.get_char() << 16
-                    | (unsigned int)cursor.get_char() <<  8
-                    | (unsigned int)cursor.get_char();
-
-    while (true) {
-      if (NALU_START_CODE == marker)
-        marker_size = 4;
-      else if (NALU_START_CODE == (marker & 0x00ffffff))
-        marker_size = 3;
-
-      if (0 != marker_size) {
-        if (-1 != previous_pos) {
-          auto new_size = cursor.get_position() - marker_size - previous_pos - previous_marker_size;
-          auto nalu     = memory_c::alloc(new_size);
-          cursor.copy(nalu->get_buffer(), previous_pos + previous_marker_size, new_size);
-          m_parsed_position = previous_parsed_pos + previous_pos;
-
-          mtx::mpeg::remove_trailing_zero_bytes(*nalu);
-          if (nalu->get_size())
-            handle_nalu(nalu, m_parsed_position);
-        }
-        previous_pos         = cursor.get_position() - marker_size;
-        previous_marker_size = marker_size;
-        marker_size          = 0;
-      }
+  if (m_unparsed_buffer && (0 != m_unparsed_buffer->get_size())) {
+    combined = memory_c::alloc(m_unparsed_buffer->get_size() + size);
+    std::memcpy(combined->get_buffer(),                                m_unparsed_buffer->get_buffer(), m_unparsed_buffer->get_size());
+    std::memcpy(combined->get_buffer() + m_unparsed_buffer->get_size(), buffer,                          size);
+  }
 
-      if (!cursor.char_available())
-        break;
+  auto data       = combined ? combined->get_buffer() : buffer;
+  auto total_size = combined ? combined->get_size()   : size;
+  auto end        = data + total_size;
+
+  for (auto start_code = mtx::mpeg::find_start_code(data, end); start_code != end; start_code = mtx::mpeg::find_start_code(start_code + 3, end)) {
+    int64_t pos         = start_code - data;
+    int64_t marker_size = 3;
+
+    if ((0 < pos) && !data[pos - 1]) {
+      --pos;
+      marker_size = 4;
+    }
+
+    if (-1 != previous_pos) {
+      auto nalu         = memory_c::clone(data + previous_pos + previous_marker_size, pos - previous_pos - previous_marker_size);
+      m_parsed_position = previous_parsed_pos + previous_pos;
 
-      marker <<= 8;
-      marker  |= (unsigned int)cursor.get_char();
+      mtx::mpeg::remove_trailing_zero_bytes(*nalu);
+      if (nalu->get_size())
+        handle_nalu(nalu, m_parsed_position);
     }
+
+    previous_pos         = pos;
+    previous_marker_size = marker_size;
   }
 
   if (-1 == previous_pos)
@@ -165,12 +155,13 @@ es_parser_c::add_bytes(unsigned char *buffer,
   m_stream_position += size;
   m_parsed_position  = previous_parsed_pos + previous_pos;
 
-  int new_size = cursor.get_size() - previous_pos;
-  if (0 != new_size) {
-    m_unparsed_buffer = memory_c::alloc(new_size);
-    cursor.copy(m_unparsed_buffer->get_buffer(), previous_pos, new_size);
+  if (combined && !previous_pos)
+    m_unparsed_buffer = combined;
 
-  } else
+  else if (static_cast<int64_t>(total_size) != previous_pos)
+    m_unparsed_buffer = memory_c::clone(data + previous_pos, total_size - previous_pos);
+
+  else
     m_unparsed_buffer.reset();
 }
 
@@ -0,0 +1,158 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   persistent cache for identification results
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/checksums/base.h"
+#include "common/debugging.h"
+#include "common/fs_sys_helpers.h"
+#include "common/identification_cache.h"
+#include "common/mm_file_io.h"
+#include "common/mm_io_x.h"
+#include "common/strings/formatting.h"
+
+namespace mtx::id::cache {
+
+namespace {
+
+debugging_option_c s_debug{"identification_cache"};
+
+bfs::path
+entry_path(bfs::path const &folder,
+           std::string const &key) {
+  return folder / fmt::format("{0}.json", key);
+}
+
+}
+
+bfs::path
+default_folder() {
+#if defined(SYS_WINDOWS)
+  return mtx::sys::get_application_data_folder() / "cache" / "identification";
+#else
+  auto xdg_cache_home = mtx::sys::get_environment_variable("XDG_CACHE_HOME");
+  if (!xdg_cache_home.empty())
+    return bfs::path{xdg_cache_home} / "mkvtoolnix" / "identification";
+
+  auto home = mtx::sys::get_environment_variable("HOME");
+  if (!home.empty())
+    return bfs::path{home} / ".cache" / "mkvtoolnix" / "identification";
+
+  return mtx::sys::get_application_data_folder() / "cache" / "identification";
+#endif
+}
+
+std::string
+create_key(std::string const &file_name,
+           std::string const &context) {
+  try {
+    auto path = bfs::path{file_name};
+
+    mm_file_io_c in{file_name};
+
+    auto size   = in.get_size();
+    auto mtime  = static_cast<int64_t>(bfs::last_write_time(path));
+    auto buffer = memory_c::alloc(std::min<uint64_t>(size, num_bytes_hashed));
+    auto md5    = mtx::checksum::for_algorithm(mtx::checksum::algorithm_e::md5);
+    auto header = fmt::format("{0}\n{1}\n{2}\n{3}\n{4}\n", file_name, bfs::absolute(path).lexically_normal().string(), size, mtime, context);
+
+    md5->add(header.c_str(), header.length());
+
+    in.read(buffer, buffer->get_size());
+    md5->add(*buffer);
+
+    if (size > static_cast<int64_t>(buffer->get_size())) {
+      in.setFilePointer(size - buffer->get_size());
+      in.read(buffer, buffer->get_size());
+      md5->add(*buffer);
+    }
+
+    md5->finish();
+
+    return mtx::string::to_hex(md5->get_result(), true);
+
+  } catch (mtx::mm_io::exception &ex) {
+    mxdebug_if(s_debug, fmt::format("create_key: I/O exception for {0}: {1}\n", file_name, ex.what()));
+
+  } catch (bfs::filesystem_error &ex) {
+    mxdebug_if(s_debug, fmt::format("create_key: file system error for {0}: {1}\n", file_name, ex.what()));
+  }
+
+  return {};
+}
+
+std::optional<std::string>
+retrieve(bfs::path const &folder,
+         std::string const &key) {
+  auto file_name = entry_path(folder, key);
+
+  try {
+    if (!bfs::exists(file_name)) {
+      mxdebug_if(s_debug, fmt::format("retrieve: miss for {0}\n", key));
+      return {};
+    }
+
+    auto content = mm_file_io_c::slurp(file_name.string());
+
+    mxdebug_if(s_debug, fmt::format("retrieve: hit for {0}\n", key));
+
+    return content->to_string();
+
+  } catch (mtx::mm_io::exception &) {
+  } catch (bfs::filesystem_error &) {
+  }
+
+  return {};
+}
+
+void
+store(bfs::path const &folder,
+      std::string const &key,
+      std::string const &content) {
+  // Write to a temporary file first and rename it afterwards so that
+  // concurrent readers never see partially written entries.
+  auto file_name      = entry_path(folder, key);
+  auto temp_file_name = folder / bfs::unique_path(fmt::format("{0}.%%%%-%%%%-%%%%.tmp", key));
+
+  try {
+    bfs::create_directories(folder);
+
+    {
+      mm_file_io_c out{temp_file_name.string(), libebml::MODE_CREATE};
+      out.write(content.c_str(), content.length());
+    }
+
+    bfs::rename(temp_file_name, file_name);
+
+    mxdebug_if(s_debug, fmt::format("store: stored {0}\n", key));
+
+    return;
+
+  } catch (mtx::mm_io::exception &ex) {
+    mxdebug_if(s_debug, fmt::format("store: I/O exception for {0}: {1}\n", key, ex.what()));
+
+  } catch (bfs::filesystem_error &ex) {
+    mxdebug_if(s_debug, fmt::format("store: file system error for {0}: {1}\n", key, ex.what()));
+  }
+
+  boost::system::error_code ec;
+  bfs::remove(temp_file_name, ec);
+}
+
+void
+clear(bfs::path const &folder) {
+  boost::system::error_code ec;
+  bfs::remove_all(folder, ec);
+}
+
+}
@@ -0,0 +1,44 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   persistent cache for identification results
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+namespace mtx::id::cache {
+
+// The number of bytes hashed at the start and at the end of a file
+// when creating its key.
+constexpr auto const num_bytes_hashed = 64 * 1024;
+
+enum class mode_e {
+  off,
+  use,
+  refresh,
+};
+
+bfs::path default_folder();
+
+// Returns a key identifying the file's current state: its name as
+// given and its absolute path, its size, its modification time and
+// hashes over its first and last bytes. `context` must contain
+// everything else the result depends on, e.g. the program version
+// and options influencing identification. Returns an empty string if
+// the file cannot be examined.
+std::string create_key(std::string const &file_name, std::string const &context);
+
+std::optional<std::string> retrieve(bfs::path const &folder, std::string const &key);
+void store(bfs::path const &folder, std::string const &key, std::string const &content);
+void clear(bfs::path const &folder);
+
+}
@@ -0,0 +1,210 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   running jobs from several queues on a pool of threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/job_queues.h"
+
+namespace mtx {
+
+job_queues_c::job_queues_c(std::size_t num_queues,
+                           int64_t max_queued_bytes,
+                           unsigned int num_threads)
+  : m_queues(num_queues)
+  , m_max_queued_bytes{max_queued_bytes}
+{
+  if (!num_threads)
+    num_threads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), num_queues);
+
+  num_threads = std::max(num_threads, 1u);
+
+  for (auto idx = 0u; idx < num_threads; ++idx)
+    m_threads.emplace_back([this]() { run(); });
+}
+
+job_queues_c::~job_queues_c() {
+  stop_threads(true);
+}
+
+unsigned int
+job_queues_c::get_num_threads()
+  const {
+  return m_threads.size();
+}
+
+void
+job_queues_c::add(std::size_t queue_idx,
+                  job_t const &job,
+                  int64_t size) {
+  {
+    std::unique_lock<std::mutex> lock{m_mutex};
+
+    m_work_done.wait(lock, [this, size]() { return m_failed || !m_queued_bytes || ((m_queued_bytes + size) <= m_max_queued_bytes); });
+
+    if (!m_failed) {
+      auto &queue = m_queues[queue_idx];
+
+      queue.jobs.push_back({ job, size });
+      m_queued_bytes += size;
+
+      if (queue.scheduled)
+        return;
+
+      queue.scheduled = true;
+      m_ready.push_back(queue_idx);
+      lock.unlock();
+
+      m_work_available.notify_one();
+
+      return;
+    }
+  }
+
+  finish();
+}
+
+void
+job_queues_c::finish() {
+  stop_threads(false);
+
+  for (auto &queue : m_queues) {
+    queue.capture.replay();
+
+    if (queue.exception) {
+      auto exception  = queue.exception;
+      queue.exception = nullptr;
+
+      std::rethrow_exception(exception);
+    }
+  }
+}
+
+void
+job_queues_c::stop_threads(bool discard) {
+  if (m_threads.empty())
+    return;
+
+  {
+    std::unique_lock<std::mutex> lock{m_mutex};
+
+    if (discard) {
+      for (auto &queue : m_queues)
+        discard_jobs(queue);
+
+      for (auto queue_idx : m_ready)
+        m_queues[queue_idx].scheduled = false;
+
+      m_ready.clear();
+    }
+
+    m_work_done.wait(lock, [this]() { return m_ready.empty() && !m_num_running; });
+
+    m_quit = true;
+  }
+
+  m_work_available.notify_all();
+
+  for (auto &thread : m_threads)
+    thread.join();
+
+  m_threads.clear();
+}
+
+void
+job_queues_c::discard_jobs(queue_t &queue) {
+  for (auto const &job : queue.jobs)
+    m_queued_bytes -= job.size;
+
+  queue.jobs.clear();
+}
+
+void
+job_queues_c::run() {
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  while (true) {
+    m_work_available.wait(lock, [this]() { return m_quit || !m_ready.empty(); });
+
+    if (m_ready.empty())
+      return;
+
+    // Run all of the queue's jobs added so far without locking in
+    // between. Other threads don't touch the queue while it isn't in
+    // the list of ready queues.
+    auto queue_idx = m_ready.front();
+    auto &queue    = m_queues[queue_idx];
+    auto jobs      = std::move(queue.jobs);
+
+    m_ready.pop_front();
+    queue.jobs.clear();
+    ++m_num_running;
+
+    lock.unlock();
+
+    auto num_run = std::size_t{};
+    auto size    = int64_t{};
+    auto failed  = false;
+    std::exception_ptr exception;
+
+    queue.capture.start();
+
+    for (auto &job : jobs) {
+      try {
+        job.job();
+      } catch (mtx::output::capture_c::error_x &) {
+        // Recorded by the capture already.
+        failed = true;
+      } catch (...) {
+        failed    = true;
+        exception = std::current_exception();
+      }
+
+      ++num_run;
+      size += job.size;
+
+      if (failed)
+        break;
+
+      // Release whatever the job holds on to as early as possible.
+      job.job = nullptr;
+    }
+
+    queue.capture.stop();
+
+    jobs.erase(jobs.begin(), jobs.begin() + num_run);
+
+    lock.lock();
+
+    --m_num_running;
+    m_queued_bytes -= size;
+
+    if (failed) {
+      queue.exception = exception;
+      m_failed        = true;
+
+      for (auto const &job : jobs)
+        m_queued_bytes -= job.size;
+
+      discard_jobs(queue);
+    }
+
+    if (queue.jobs.empty())
+      queue.scheduled = false;
+    else
+      m_ready.push_back(queue_idx);
+
+    m_work_done.notify_all();
+  }
+}
+
+}
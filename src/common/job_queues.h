@@ -0,0 +1,88 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   running jobs from several queues on a pool of threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "common/output.h"
+
+namespace mtx {
+
+// Jobs are added to one of several queues and run on a pool of worker
+// threads. Jobs from the same queue are run one after the other in
+// the order they were added; jobs from different queues run
+// concurrently. Adding a job blocks while the sizes of all jobs not
+// run yet exceed the maximum given.
+//
+// Messages output by jobs are captured and shown by finish() queue by
+// queue. After a job has failed, either by calling mxerror() or by
+// throwing an exception, the remaining jobs of its queue are
+// discarded, and the next call to add() or finish() reports the error
+// or re-throws the exception.
+class job_queues_c {
+public:
+  using job_t = std::function<void()>;
+
+protected:
+  struct queued_job_t {
+    job_t job;
+    int64_t size;
+  };
+
+  struct queue_t {
+    std::deque<queued_job_t> jobs;
+    mtx::output::capture_c capture;
+    std::exception_ptr exception;
+    bool scheduled{};
+  };
+
+  std::vector<queue_t> m_queues;
+  std::deque<std::size_t> m_ready;
+  int64_t m_max_queued_bytes, m_queued_bytes{};
+  unsigned int m_num_running{};
+  bool m_failed{}, m_quit{};
+
+  std::mutex m_mutex;
+  std::condition_variable m_work_available, m_work_done;
+  std::vector<std::thread> m_threads;
+
+public:
+  // If "num_threads" is 0 then one thread per CPU core is used but not
+  // more than there are queues.
+  job_queues_c(std::size_t num_queues, int64_t max_queued_bytes, unsigned int num_threads = 0);
+  ~job_queues_c();
+
+  job_queues_c(job_queues_c const &) = delete;
+  job_queues_c &operator =(job_queues_c const &) = delete;
+
+  void add(std::size_t queue_idx, job_t const &job, int64_t size = 0);
+
+  // Waits for all jobs to be run and stops the threads. Captured
+  // messages are shown and exceptions are re-thrown afterwards.
+  void finish();
+
+  unsigned int get_num_threads() const;
+
+protected:
+  void run();
+  void stop_threads(bool discard_jobs);
+  void discard_jobs(queue_t &queue);
+};
+
+}
@@ -0,0 +1,453 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   writing clusters without creating libebml elements
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/kax_cluster_writer.h"
+#include "common/mm_io.h"
+
+namespace mtx::kax {
+
+namespace {
+
+uint32_t constexpr s_cluster_id         = 0x1f43b675;
+uint32_t constexpr s_cluster_timestamp  = 0xe7;
+uint32_t constexpr s_simple_block_id    = 0xa3;
+uint32_t constexpr s_block_group_id     = 0xa0;
+uint32_t constexpr s_block_id           = 0xa1;
+uint32_t constexpr s_reference_block_id = 0xfb;
+uint32_t constexpr s_codec_state_id     = 0xa4;
+uint32_t constexpr s_discard_padding_id = 0x75a2;
+uint32_t constexpr s_block_duration_id  = 0x9b;
+
+unsigned int
+get_id_length(uint32_t id) {
+  return id > 0xffffff ? 4 : id > 0xffff ? 3 : id > 0xff ? 2 : 1;
+}
+
+// Same as libebml's CodedSizeLengthSigned() & CodedValueLengthSigned()
+// used for EBML lacing.
+unsigned int
+get_coded_signed_size_length(int64_t value) {
+  return (value > -64)        && (value < 64)        ? 1
+       : (value > -8192)      && (value < 8192)      ? 2
+       : (value > -1048576)   && (value < 1048576)   ? 3
+       : (value > -134217728) && (value < 134217728) ? 4
+       :                                               5;
+}
+
+uint64_t
+get_signed_size_bias(int64_t value) {
+  return (value > -64)        && (value < 64)        ? 63
+       : (value > -8192)      && (value < 8192)      ? 8191
+       : (value > -1048576)   && (value < 1048576)   ? 1048575
+       : (value > -134217728) && (value < 134217728) ? 134217727
+       :                                               0;
+}
+
+void
+put_coded_size(std::vector<unsigned char> &buffer,
+               uint64_t value,
+               unsigned int length) {
+  auto pos = buffer.size();
+  buffer.resize(pos + length);
+
+  auto out = &buffer[pos];
+
+  for (auto idx = length - 1; idx > 0; --idx) {
+    out[idx]   = value & 0xff;
+    value    >>= 8;
+  }
+
+  out[0] = (1 << (8 - length)) | (value & (0xff >> length));
+}
+
+}
+
+bool
+cluster_writer_c::block_t::add_frame(memory_cptr const &frame) {
+  frames.push_back(frame);
+
+  // No more than eight frames are laced as the overhead saved is
+  // minimal. Neither are large frames.
+  if ((frames.size() >= 8) || (lacing_e::none == lacing))
+    return false;
+
+  return frame->get_size() < 6 * 0xff;
+}
+
+bool
+cluster_writer_c::block_t::add_frame_auto(memory_cptr const &frame,
+                                          int64_t frame_timestamp,
+                                          int64_t past_block,
+                                          int64_t forw_block,
+                                          std::optional<bool> p_key_flag,
+                                          std::optional<bool> p_discardable_flag) {
+  if (frames.empty())
+    timestamp = frame_timestamp;
+
+  auto more_data = add_frame(frame);
+
+  if (is_simple_block) {
+    if (p_key_flag || p_discardable_flag) {
+      key_flag         = p_key_flag         && *p_key_flag;
+      discardable_flag = p_discardable_flag && *p_discardable_flag;
+
+    } else if ((-1 == past_block) && (-1 == forw_block)) {
+      key_flag         = true;
+      discardable_flag = false;
+
+    } else {
+      key_flag         = false;
+      discardable_flag = !(   ((-1 == forw_block) || (forw_block <= frame_timestamp))
+                           && ((-1 == past_block) || (past_block <= frame_timestamp)));
+    }
+
+    return more_data;
+  }
+
+  // Same references as set by kax_block_group_c::add_frame().
+  if (0 <= past_block) {
+    if (references.empty())
+      references.push_back(past_block);
+    else
+      references[0] = past_block;
+  }
+
+  if (0 <= forw_block) {
+    if ((0 <= past_block) || references.empty())
+      references.push_back(forw_block);
+    else
+      references[0] = forw_block;
+  }
+
+  return more_data;
+}
+
+cluster_writer_c::cluster_writer_c(int64_t timestamp_scale)
+  : m_timestamp_scale{timestamp_scale}
+{
+}
+
+cluster_writer_c::block_t &
+cluster_writer_c::add_block() {
+  return m_blocks.emplace_back();
+}
+
+std::vector<cluster_writer_c::block_t> &
+cluster_writer_c::get_blocks() {
+  return m_blocks;
+}
+
+void
+cluster_writer_c::clear() {
+  m_blocks.clear();
+}
+
+uint64_t
+cluster_writer_c::get_position()
+  const {
+  return m_position;
+}
+
+uint64_t
+cluster_writer_c::get_head_size()
+  const {
+  return m_head_size;
+}
+
+std::vector<uint32_t> const &
+cluster_writer_c::get_element_ids_written()
+  const {
+  return m_element_ids_written;
+}
+
+unsigned int
+cluster_writer_c::get_coded_size_length(uint64_t size) {
+  // All bits set means "unknown size"; libebml therefore uses one
+  // more byte for sizes like 127.
+  auto length = 1u;
+
+  while ((length < 8) && (size >= ((1ull << (7 * length)) - 1)))
+    ++length;
+
+  return length;
+}
+
+unsigned int
+cluster_writer_c::get_uint_size(uint64_t value) {
+  auto size = 1u;
+
+  while ((size < 8) && (value >> (8 * size)))
+    ++size;
+
+  return size;
+}
+
+unsigned int
+cluster_writer_c::get_sint_size(int64_t value) {
+  auto size = 1u;
+
+  while ((size < 8) && ((value < -(1ll << (8 * size - 1))) || (value >= (1ll << (8 * size - 1)))))
+    ++size;
+
+  return size;
+}
+
+uint64_t
+cluster_writer_c::get_element_size(uint32_t id,
+                                   uint64_t content_size) {
+  return get_id_length(id) + get_coded_size_length(content_size) + content_size;
+}
+
+cluster_writer_c::lacing_e
+cluster_writer_c::determine_best_lacing(std::vector<memory_cptr> const &frames) {
+  auto same_size   = true;
+  auto xiph_size   = uint64_t{1};
+  auto ebml_size   = uint64_t{1} + get_coded_size_length(frames[0]->get_size());
+
+  for (auto idx = 0u; (idx + 1) < frames.size(); ++idx) {
+    if (frames[idx]->get_size() != frames[idx + 1]->get_size())
+      same_size = false;
+
+    xiph_size += frames[idx]->get_size() / 0xff + 1;
+
+    if (idx)
+      ebml_size += get_coded_signed_size_length(static_cast<int64_t>(frames[idx]->get_size()) - static_cast<int64_t>(frames[idx - 1]->get_size()));
+  }
+
+  return same_size               ? lacing_e::fixed
+       : xiph_size < ebml_size   ? lacing_e::xiph
+       :                           lacing_e::ebml;
+}
+
+uint64_t
+cluster_writer_c::get_lacing_head_size(lacing_e lacing,
+                                       std::vector<memory_cptr> const &frames) {
+  auto size = uint64_t{1};      // number of frames - 1
+
+  if (lacing_e::xiph == lacing)
+    for (auto idx = 0u; (idx + 1) < frames.size(); ++idx)
+      size += frames[idx]->get_size() / 0xff + 1;
+
+  else if (lacing_e::ebml == lacing) {
+    size += get_coded_size_length(frames[0]->get_size());
+
+    for (auto idx = 1u; (idx + 1) < frames.size(); ++idx)
+      size += get_coded_signed_size_length(static_cast<int64_t>(frames[idx]->get_size()) - static_cast<int64_t>(frames[idx - 1]->get_size()));
+  }
+
+  return size;
+}
+
+void
+cluster_writer_c::calculate_sizes(block_t &block) {
+  auto num_frames      = block.frames.size();
+  block.m_lacing_used  = num_frames < 2                        ? lacing_e::none
+                       : lacing_e::automatic == block.lacing   ? determine_best_lacing(block.frames)
+                       : lacing_e::none      == block.lacing   ? lacing_e::ebml
+                       :                                         block.lacing;
+
+  block.m_block_size   = (block.track_number < 0x80 ? 4 : 5) + (num_frames > 1 ? get_lacing_head_size(block.m_lacing_used, block.frames) : 0);
+
+  for (auto const &frame : block.frames)
+    block.m_block_size += frame->get_size();
+
+  if (block.is_simple_block)
+    return;
+
+  block.m_content_size = get_element_size(s_block_id, block.m_block_size);
+
+  for (auto reference : block.references)
+    block.m_content_size += get_element_size(s_reference_block_id, get_sint_size((reference - static_cast<int64_t>(block.timestamp)) / m_timestamp_scale));
+
+  if (block.codec_state)
+    block.m_content_size += get_element_size(s_codec_state_id, block.codec_state->get_size());
+
+  if (block.discard_padding)
+    block.m_content_size += get_element_size(s_discard_padding_id, get_sint_size(*block.discard_padding));
+
+  if (block.duration)
+    block.m_content_size += get_element_size(s_block_duration_id, get_uint_size(*block.duration / static_cast<uint64_t>(m_timestamp_scale)));
+}
+
+void
+cluster_writer_c::account_element_id(uint32_t id) {
+  if (std::find(m_element_ids_written.begin(), m_element_ids_written.end(), id) == m_element_ids_written.end())
+    m_element_ids_written.push_back(id);
+}
+
+void
+cluster_writer_c::put_element_head(uint32_t id,
+                                   uint64_t content_size) {
+  for (auto shift = static_cast<int>(get_id_length(id) - 1) * 8; shift >= 0; shift -= 8)
+    m_buffer.push_back((id >> shift) & 0xff);
+
+  put_coded_size(m_buffer, content_size, get_coded_size_length(content_size));
+
+  account_element_id(id);
+}
+
+void
+cluster_writer_c::put_uint(uint32_t id,
+                           uint64_t value) {
+  auto size = get_uint_size(value);
+
+  put_element_head(id, size);
+
+  for (auto shift = static_cast<int>(size - 1) * 8; shift >= 0; shift -= 8)
+    m_buffer.push_back((value >> shift) & 0xff);
+}
+
+void
+cluster_writer_c::put_sint(uint32_t id,
+                           int64_t value) {
+  auto size = get_sint_size(value);
+
+  put_element_head(id, size);
+
+  for (auto shift = static_cast<int>(size - 1) * 8; shift >= 0; shift -= 8)
+    m_buffer.push_back((static_cast<uint64_t>(value) >> shift) & 0xff);
+}
+
+void
+cluster_writer_c::put_lacing_head(block_t const &block) {
+  auto const &frames = block.frames;
+
+  m_buffer.push_back(frames.size() - 1);
+
+  if (lacing_e::xiph == block.m_lacing_used) {
+    for (auto idx = 0u; (idx + 1) < frames.size(); ++idx) {
+      auto size = frames[idx]->get_size();
+
+      for (; size >= 0xff; size -= 0xff)
+        m_buffer.push_back(0xff);
+
+      m_buffer.push_back(size);
+    }
+
+  } else if (lacing_e::ebml == block.m_lacing_used) {
+    put_coded_size(m_buffer, frames[0]->get_size(), get_coded_size_length(frames[0]->get_size()));
+
+    for (auto idx = 1u; (idx + 1) < frames.size(); ++idx) {
+      auto difference = static_cast<int64_t>(frames[idx]->get_size()) - static_cast<int64_t>(frames[idx - 1]->get_size());
+      put_coded_size(m_buffer, difference + get_signed_size_bias(difference), get_coded_signed_size_length(difference));
+    }
+  }
+}
+
+void
+cluster_writer_c::flush_buffer(mm_io_c &out) {
+  out.write(m_buffer.data(), m_buffer.size());
+  m_position_in_cluster += m_buffer.size();
+  m_buffer.clear();
+}
+
+void
+cluster_writer_c::write_block(mm_io_c &out,
+                              block_t &block,
+                              uint64_t cluster_timestamp) {
+  block.position = m_position + m_position_in_cluster + m_buffer.size();
+
+  if (block.is_simple_block)
+    put_element_head(s_simple_block_id, block.m_block_size);
+
+  else {
+    put_element_head(s_block_group_id, block.m_content_size);
+    put_element_head(s_block_id,       block.m_block_size);
+  }
+
+  if (block.track_number < 0x80)
+    m_buffer.push_back(0x80 | block.track_number);
+  else {
+    m_buffer.push_back(0x40 | (block.track_number >> 8));
+    m_buffer.push_back(block.track_number & 0xff);
+  }
+
+  auto relative_timestamp = static_cast<int16_t>((static_cast<int64_t>(block.timestamp) - static_cast<int64_t>(cluster_timestamp)) / m_timestamp_scale);
+  m_buffer.push_back(static_cast<uint16_t>(relative_timestamp) >> 8);
+  m_buffer.push_back(static_cast<uint16_t>(relative_timestamp) & 0xff);
+
+  auto flags = block.m_lacing_used == lacing_e::xiph  ? 0x02
+             : block.m_lacing_used == lacing_e::ebml  ? 0x06
+             : block.m_lacing_used == lacing_e::fixed ? 0x04
+             :                                          0x00;
+
+  if (block.is_simple_block)
+    flags |= (block.key_flag ? 0x80 : 0x00) | (block.discardable_flag ? 0x01 : 0x00);
+
+  m_buffer.push_back(flags);
+
+  if (block.frames.size() > 1)
+    put_lacing_head(block);
+
+  flush_buffer(out);
+
+  for (auto const &frame : block.frames) {
+    out.write(frame->get_buffer(), frame->get_size());
+    m_position_in_cluster += frame->get_size();
+  }
+
+  if (block.is_simple_block)
+    return;
+
+  for (auto reference : block.references)
+    put_sint(s_reference_block_id, (reference - static_cast<int64_t>(block.timestamp)) / m_timestamp_scale);
+
+  if (block.codec_state) {
+    block.codec_state_position = m_position + m_position_in_cluster + m_buffer.size();
+
+    put_element_head(s_codec_state_id, block.codec_state->get_size());
+    flush_buffer(out);
+
+    out.write(block.codec_state->get_buffer(), block.codec_state->get_size());
+    m_position_in_cluster += block.codec_state->get_size();
+  }
+
+  if (block.discard_padding)
+    put_sint(s_discard_padding_id, *block.discard_padding);
+
+  if (block.duration)
+    put_uint(s_block_duration_id, *block.duration / static_cast<uint64_t>(m_timestamp_scale));
+}
+
+uint64_t
+cluster_writer_c::render(mm_io_c &out,
+                         uint64_t timestamp) {
+  auto timestamp_value = timestamp / static_cast<uint64_t>(m_timestamp_scale);
+  auto content_size    = get_element_size(s_cluster_timestamp, get_uint_size(timestamp_value));
+
+  for (auto &block : m_blocks) {
+    calculate_sizes(block);
+    content_size += block.is_simple_block ? get_element_size(s_simple_block_id, block.m_block_size) : get_element_size(s_block_group_id, block.m_content_size);
+  }
+
+  m_position            = out.getFilePointer();
+  m_head_size           = get_id_length(s_cluster_id) + get_coded_size_length(content_size);
+  m_position_in_cluster = 0;
+
+  m_buffer.clear();
+  m_element_ids_written.clear();
+
+  put_element_head(s_cluster_id, content_size);
+  put_uint(s_cluster_timestamp, timestamp_value);
+
+  for (auto &block : m_blocks)
+    write_block(out, block, timestamp);
+
+  flush_buffer(out);
+
+  return m_head_size + content_size;
+}
+
+}
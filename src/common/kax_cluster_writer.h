@@ -0,0 +1,125 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   writing clusters without creating libebml elements
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+class mm_io_c;
+
+namespace mtx::kax {
+
+// Writes a cluster with SimpleBlocks and BlockGroups in one go. All
+// element sizes are calculated before anything is written, and the
+// frames are written to the output straight from their buffers.
+//
+// The output is the same libebml & libmatroska create for the same
+// content when rendering a KaxCluster without default values: sizes
+// are coded with as few bytes as libebml uses, the children of a
+// BlockGroup are ordered Block, ReferenceBlocks, CodecState,
+// DiscardPadding, BlockDuration, and the lacing is chosen the same
+// way. Block additions and reference priorities aren't supported.
+class cluster_writer_c {
+public:
+  enum class lacing_e {
+    none,
+    automatic,
+    xiph,
+    ebml,
+    fixed,
+  };
+
+  struct block_t {
+    bool is_simple_block{};
+    uint64_t track_number{};
+    uint64_t timestamp{};       // in ns; the one of the first frame
+    lacing_e lacing{lacing_e::automatic};
+    std::vector<memory_cptr> frames;
+
+    // Only written for SimpleBlocks:
+    bool key_flag{}, discardable_flag{};
+
+    // Only written for BlockGroups:
+    std::vector<int64_t> references;        // timestamps in ns
+    memory_cptr codec_state;
+    std::optional<int64_t> discard_padding; // in ns
+    std::optional<uint64_t> duration;       // in ns
+
+    // Set by render(): absolute positions of the SimpleBlock or
+    // BlockGroup element and of the CodecState element.
+    uint64_t position{}, codec_state_position{};
+
+    // Adds a frame the way libmatroska's KaxInternalBlock::AddFrame()
+    // does. Returns whether or not another frame may be laced into
+    // the same block.
+    bool add_frame(memory_cptr const &frame);
+
+    // Adds a frame and sets the flags of SimpleBlocks or the
+    // references of BlockGroups the way mkvmerge's
+    // kax_block_blob_c::add_frame_auto() does. Timestamps are in ns;
+    // -1 means "no reference".
+    bool add_frame_auto(memory_cptr const &frame, int64_t frame_timestamp, int64_t past_block, int64_t forw_block, std::optional<bool> p_key_flag, std::optional<bool> p_discardable_flag);
+
+  protected:
+    friend class cluster_writer_c;
+
+    lacing_e m_lacing_used{};
+    uint64_t m_block_size{}, m_content_size{};
+  };
+
+protected:
+  int64_t m_timestamp_scale;
+  std::vector<block_t> m_blocks;
+  std::vector<unsigned char> m_buffer;
+  std::vector<uint32_t> m_element_ids_written;
+  uint64_t m_position{}, m_head_size{}, m_position_in_cluster{};
+
+public:
+  explicit cluster_writer_c(int64_t timestamp_scale);
+
+  // Blocks are written in the order they're added. References to
+  // blocks are invalidated by adding further blocks.
+  block_t &add_block();
+  std::vector<block_t> &get_blocks();
+  void clear();
+
+  // Writes the cluster and returns its total size. "timestamp" is
+  // the cluster's timestamp in ns.
+  uint64_t render(mm_io_c &out, uint64_t timestamp);
+
+  // Information about the cluster last rendered.
+  uint64_t get_position() const;
+  uint64_t get_head_size() const;
+  std::vector<uint32_t> const &get_element_ids_written() const;
+
+protected:
+  void calculate_sizes(block_t &block);
+  void write_block(mm_io_c &out, block_t &block, uint64_t cluster_timestamp);
+  void flush_buffer(mm_io_c &out);
+
+  void put_element_head(uint32_t id, uint64_t content_size);
+  void put_uint(uint32_t id, uint64_t value);
+  void put_sint(uint32_t id, int64_t value);
+  void put_lacing_head(block_t const &block);
+  void account_element_id(uint32_t id);
+
+public:
+  static unsigned int get_coded_size_length(uint64_t size);
+  static unsigned int get_uint_size(uint64_t value);
+  static unsigned int get_sint_size(int64_t value);
+  static uint64_t get_element_size(uint32_t id, uint64_t content_size);
+  static lacing_e determine_best_lacing(std::vector<memory_cptr> const &frames);
+  static uint64_t get_lacing_head_size(lacing_e lacing, std::vector<memory_cptr> const &frames);
+};
+
+}
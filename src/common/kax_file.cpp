@@ -18,7 +18,9 @@
 #include <ebml/EbmlCrc32.h>
 #include <ebml/EbmlStream.h>
 #include <ebml/EbmlVoid.h>
+#include <matroska/KaxBlock.h>
 
+#include "common/construct.h"
 #include "common/ebml.h"
 #include "common/fs_sys_helpers.h"
 #include "common/kax_file.h"
@@ -38,6 +40,7 @@ kax_file_c::kax_file_c(mm_io_c &in)
   , m_es{new EbmlStream{m_in}}
   , m_debug_read_next{"kax_file|kax_file_read_next"}
   , m_debug_resync{   "kax_file|kax_file_resync"}
+  , m_debug_skip_blocks{"kax_file|kax_file_skip_blocks"}
 {
 }
 
@@ -296,7 +299,225 @@ kax_file_c::resync_to_cluster() {
 
 std::shared_ptr<KaxCluster>
 kax_file_c::read_next_cluster() {
-  return std::static_pointer_cast<KaxCluster>(read_next_level1_element(EBML_ID_VALUE(EBML_ID(KaxCluster))));
+  if (!m_track_numbers_to_skip.empty()) {
+    auto cluster = read_next_cluster_skipping_blocks();
+    if (cluster)
+      return cluster;
+  }
+
+  auto cluster = std::static_pointer_cast<KaxCluster>(read_next_level1_element(EBML_ID_VALUE(EBML_ID(KaxCluster))));
+  if (cluster) {
+    m_cluster_position  = cluster->GetElementPosition();
+    m_cluster_head_size = cluster->HeadSize();
+  }
+
+  return cluster;
+}
+
+uint64_t
+kax_file_c::get_cluster_position()
+  const {
+  return m_cluster_position;
+}
+
+uint64_t
+kax_file_c::get_cluster_head_size()
+  const {
+  return m_cluster_head_size;
+}
+
+std::shared_ptr<KaxCluster>
+kax_file_c::read_next_cluster_skipping_blocks() {
+  // Only handles the regular case: a cluster with a known size
+  // follows right away & its children are intact. Otherwise the file
+  // position is restored and the caller falls back to reading the
+  // cluster with libebml, including its error handling & resyncing.
+  auto start_pos = m_in.getFilePointer();
+
+  if (m_segment_end && (start_pos >= m_segment_end))
+    return {};
+
+  auto cluster_id   = vint_c::read_ebml_id(m_in);
+  auto cluster_size = vint_c::read(m_in);
+
+  if (   !cluster_id.is_valid()
+      || (EBML_ID_VALUE(EBML_ID(KaxCluster)) != cluster_id.m_value)
+      || cluster_size.is_unknown()
+      || ((m_in.getFilePointer() + cluster_size.m_value) > m_file_size)) {
+    m_in.setFilePointer(start_pos);
+    return {};
+  }
+
+  // Only the children's heads and the track numbers of blocks are read
+  // in order to determine which children to keep.
+  auto cluster_end = m_in.getFilePointer() + cluster_size.m_value;
+  auto child_pos   = m_in.getFilePointer();
+  auto num_skipped = 0u;
+  auto num_kept    = uint64_t{};
+  std::vector<uint64_t> children_to_keep;
+
+  try {
+    while (child_pos < cluster_end) {
+      m_in.setFilePointer(child_pos);
+
+      auto child_id   = vint_c::read_ebml_id(m_in);
+      auto child_size = vint_c::read(m_in);
+      auto child_end  = m_in.getFilePointer() + child_size.m_value;
+
+      if (!child_id.is_valid() || child_size.is_unknown() || (child_end > cluster_end))
+        break;
+
+      auto track_number = read_block_track_number(child_id, child_end);
+
+      if (track_number && m_track_numbers_to_skip.count(*track_number))
+        ++num_skipped;
+
+      else {
+        children_to_keep.push_back(child_pos);
+        num_kept += child_end - child_pos;
+      }
+
+      child_pos = child_end;
+    }
+
+  } catch (mtx::mm_io::exception &) {
+  }
+
+  if (child_pos != cluster_end) {
+    mxdebug_if(m_debug_skip_blocks, fmt::format("kax_file::read_next_cluster_skipping_blocks(): invalid child at {0} in cluster at {1}; falling back\n", child_pos, start_pos));
+    m_in.setFilePointer(start_pos);
+    return {};
+  }
+
+  // The children to keep are then parsed by libebml right where they
+  // are in the file and added to an empty cluster.
+  auto cluster = std::shared_ptr<KaxCluster>{mtx::construct::master<KaxCluster>()};
+
+  for (auto position : children_to_keep) {
+    m_in.setFilePointer(position);
+
+    auto upper_lvl_el = 0;
+    auto l2           = static_cast<EbmlElement *>(nullptr);
+    auto child        = std::unique_ptr<EbmlElement>{m_es->FindNextElement(EBML_CLASS_CONTEXT(KaxCluster), upper_lvl_el, 0xFFFFFFFFL, true)};
+
+    if (!child || upper_lvl_el || (child->GetElementPosition() != position)) {
+      m_in.setFilePointer(start_pos);
+      return {};
+    }
+
+    try {
+      child->Read(*m_es, EBML_CONTEXT(child.get()), upper_lvl_el, l2, true);
+      if (upper_lvl_el && !found_in(*child, l2))
+        delete l2;
+
+    } catch (std::runtime_error &) {
+      m_in.setFilePointer(start_pos);
+      return {};
+    }
+
+    cluster->PushElement(*child.release());
+  }
+
+  mxdebug_if(m_debug_skip_blocks,
+             fmt::format("kax_file::read_next_cluster_skipping_blocks(): cluster at {0}: {1} blocks skipped, {2} of {3} bytes read\n",
+                         start_pos, num_skipped, num_kept, cluster_size.m_value));
+
+  m_resynced          = false;
+  m_resync_start_pos  = 0;
+  m_cluster_position  = start_pos;
+  m_cluster_head_size = cluster_end - cluster_size.m_value - start_pos;
+
+  m_in.setFilePointer(cluster_end);
+
+  return cluster;
+}
+
+mtx::kax::raw_cluster_cptr
+kax_file_c::read_next_raw_cluster() {
+  auto start_pos = m_in.getFilePointer();
+
+  if (m_segment_end && (start_pos >= m_segment_end))
+    return {};
+
+  try {
+    auto cluster_id   = vint_c::read_ebml_id(m_in);
+    auto cluster_size = vint_c::read(m_in);
+
+    if (   cluster_id.is_valid()
+        && (EBML_ID_VALUE(EBML_ID(KaxCluster)) == cluster_id.m_value)
+        && cluster_size.is_valid()
+        && !cluster_size.is_unknown()
+        && (cluster_size.m_value <= 256 * 1024 * 1024)
+        && ((m_in.getFilePointer() + cluster_size.m_value) <= m_file_size)) {
+      auto content = m_in.read(cluster_size.m_value);
+
+      if (m_account_raw_cluster) {
+        auto account = m_account_raw_cluster;
+        auto size    = static_cast<int64_t>(content->get_size());
+
+        account(size);
+        content = memory_cptr{content.get(), [content, account, size](memory_c *) { account(-size); }};
+      }
+
+      auto cluster = mtx::kax::parse_raw_cluster(content, m_timestamp_scale, m_track_numbers_to_skip);
+
+      if (cluster) {
+        m_resynced         = false;
+        m_resync_start_pos = 0;
+
+        return cluster;
+      }
+
+      mxdebug_if(m_debug_read_next, fmt::format("kax_file::read_next_raw_cluster(): cluster at {0} cannot be parsed without libebml\n", start_pos));
+    }
+
+  } catch (mtx::mm_io::exception &) {
+  }
+
+  m_in.setFilePointer(start_pos);
+
+  return {};
+}
+
+void
+kax_file_c::set_raw_cluster_accounting(std::function<void(int64_t)> const &account) {
+  m_account_raw_cluster = account;
+}
+
+std::optional<uint64_t>
+kax_file_c::read_block_track_number(vint_c const &id,
+                                    uint64_t data_end) {
+  // The track number is the first field of a block's content. For a
+  // block group it's taken from the block inside it. Returns nothing
+  // for other elements & if the structure is damaged.
+  auto id_value = static_cast<uint32_t>(id.m_value);
+
+  if (EBML_ID_VALUE(EBML_ID(KaxBlockGroup)) == id_value) {
+    while (m_in.getFilePointer() < data_end) {
+      auto child_id   = vint_c::read_ebml_id(m_in);
+      auto child_size = vint_c::read(m_in);
+
+      if (!child_id.is_valid() || child_size.is_unknown())
+        return {};
+
+      if (EBML_ID_VALUE(EBML_ID(KaxBlock)) == child_id.m_value) {
+        id_value = EBML_ID_VALUE(EBML_ID(KaxBlock));
+        break;
+      }
+
+      m_in.setFilePointer(m_in.getFilePointer() + child_size.m_value);
+    }
+  }
+
+  if (   (EBML_ID_VALUE(EBML_ID(KaxSimpleBlock)) != id_value)
+      && (EBML_ID_VALUE(EBML_ID(KaxBlock))       != id_value))
+    return {};
+
+  auto track_number = vint_c::read(m_in);
+  if (!track_number.is_valid() || (m_in.getFilePointer() > data_end))
+    return {};
+
+  return track_number.m_value;
 }
 
 bool
@@ -349,6 +570,11 @@ kax_file_c::enable_reporting(bool enable) {
   m_reporting_enabled = enable;
 }
 
+void
+kax_file_c::set_track_numbers_to_skip(std::unordered_set<uint64_t> const &track_numbers) {
+  m_track_numbers_to_skip = track_numbers;
+}
+
 void
 kax_file_c::report(std::string const &message) {
   if (m_reporting_enabled)
@@ -15,9 +15,12 @@
 
 #include "common/common_pch.h"
 
+#include <unordered_set>
+
 #include <matroska/KaxSegment.h>
 #include <matroska/KaxCluster.h>
 
+#include "common/kax_raw_cluster.h"
 #include "common/vint.h"
 
 class kax_file_c {
@@ -25,10 +28,13 @@ protected:
   mm_io_c &m_in;
   bool m_resynced, m_reporting_enabled{true};
   uint64_t m_resync_start_pos, m_file_size, m_segment_end;
+  uint64_t m_cluster_position{}, m_cluster_head_size{};
   int64_t m_timestamp_scale, m_last_timestamp;
   std::shared_ptr<libebml::EbmlStream> m_es;
+  std::unordered_set<uint64_t> m_track_numbers_to_skip;
+  std::function<void(int64_t)> m_account_raw_cluster;
 
-  debugging_option_c m_debug_read_next, m_debug_resync;
+  debugging_option_c m_debug_read_next, m_debug_resync, m_debug_skip_blocks;
 
 public:
   kax_file_c(mm_io_c &in);
@@ -40,6 +46,25 @@ public:
   virtual std::shared_ptr<libebml::EbmlElement> read_next_level1_element(uint32_t wanted_id = 0, bool report_cluster_timestamp = false);
   virtual std::shared_ptr<libmatroska::KaxCluster> read_next_cluster();
 
+  // Position and head size of the last cluster returned by
+  // read_next_cluster() as found in the file. Clusters read while
+  // skipping blocks don't carry them themselves.
+  virtual uint64_t get_cluster_position() const;
+  virtual uint64_t get_cluster_head_size() const;
+
+  // Reads the next cluster with a single read and parses it without
+  // creating libebml elements. Returns nullptr without changing the
+  // file position if the cluster cannot be handled that way; use
+  // read_next_cluster() then.
+  virtual mtx::kax::raw_cluster_cptr read_next_raw_cluster();
+
+  // Frames returned by read_next_raw_cluster() are slices of the
+  // cluster's content and keep all of it alive. "account" is called
+  // with the content's size when a cluster is read and with its
+  // negated size once neither the content nor any slice of it is
+  // referenced anymore, possibly on a different thread.
+  virtual void set_raw_cluster_accounting(std::function<void(int64_t)> const &account);
+
   virtual std::shared_ptr<libebml::EbmlElement> resync_to_level1_element(uint32_t wanted_id = 0);
   virtual std::shared_ptr<libmatroska::KaxCluster> resync_to_cluster();
 
@@ -50,8 +75,14 @@ public:
 
   virtual void enable_reporting(bool enable);
 
+  // Blocks of these tracks are skipped without reading their content
+  // by read_next_cluster(). The clusters returned don't contain them.
+  virtual void set_track_numbers_to_skip(std::unordered_set<uint64_t> const &track_numbers);
+
 protected:
   virtual std::shared_ptr<libebml::EbmlElement> read_one_element();
+  virtual std::shared_ptr<libmatroska::KaxCluster> read_next_cluster_skipping_blocks();
+  virtual std::optional<uint64_t> read_block_track_number(vint_c const &id, uint64_t data_end);
 
   virtual std::shared_ptr<libebml::EbmlElement> read_next_level1_element_internal(uint32_t wanted_id = 0);
   virtual std::shared_ptr<libebml::EbmlElement> resync_to_level1_element_internal(uint32_t wanted_id = 0);
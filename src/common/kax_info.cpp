@@ -53,7 +53,6 @@
 #include "common/avc.h"
 #include "common/avcc.h"
 #include "common/chapters/chapters.h"
-#include "common/checksums/base.h"
 #include "common/codec.h"
 #include "common/command_line.h"
 #include "common/date_time.h"
@@ -464,7 +463,7 @@ kax_info_c::format_binary(EbmlBinary &bin,
     result += u8"…";
 
   if (p_func()->m_calc_checksums)
-    result += fmt::format(Y(" (adler: 0x{0:08x})"), mtx::checksum::calculate_as_uint(mtx::checksum::algorithm_e::adler32, bin.GetBuffer(), bin.GetSize()));
+    result += fmt::format(Y(" (adler: 0x{0:08x})"), p_func()->calculate_adler32(bin.GetBuffer(), bin.GetSize()));
 
   mtx::string::strip(result);
 
@@ -585,7 +584,7 @@ kax_info_c::init_custom_element_value_formatters_and_processors() {
     p->m_track-> fourcc = create_codec_dependent_private_info(c_priv, p->m_track->type, p->m_track->codec_id);
 
     if (p->m_calc_checksums && !p->m_show_summary)
-      p->m_track->fourcc += fmt::format(Y(" (adler: 0x{0:08x})"), mtx::checksum::calculate_as_uint(mtx::checksum::algorithm_e::adler32, c_priv.GetBuffer(), c_priv.GetSize()));
+      p->m_track->fourcc += fmt::format(Y(" (adler: 0x{0:08x})"), p->calculate_adler32(c_priv.GetBuffer(), c_priv.GetSize()));
 
     if (p->m_show_hexdump)
       p->m_track->fourcc += create_hexdump(c_priv.GetBuffer(), c_priv.GetSize());
@@ -882,7 +881,8 @@ kax_info_c::post_block(EbmlElement &e) {
 
   for (int i = 0, num_frames = block.NumberFrames(); i < num_frames; ++i) {
     auto &data = block.GetBuffer(i);
-    auto adler = mtx::checksum::calculate_as_uint(mtx::checksum::algorithm_e::adler32, data.Buffer(), data.Size());
+    // Only the checksum display and the summary need the checksum.
+    auto adler = p->m_calc_checksums || p->m_show_summary ? p->calculate_adler32(data.Buffer(), data.Size()) : 0u;
 
     std::string adler_str;
     if (p->m_calc_checksums)
@@ -1027,7 +1027,8 @@ kax_info_c::post_simple_block(EbmlElement &e) {
 
   for (int idx = 0; idx < num_frames; ++idx) {
     auto &data = block.GetBuffer(idx);
-    auto adler = mtx::checksum::calculate_as_uint(mtx::checksum::algorithm_e::adler32, data.Buffer(), data.Size());
+    // Only the checksum display and the summary need the checksum.
+    auto adler = p->m_calc_checksums || p->m_show_summary ? p->calculate_adler32(data.Buffer(), data.Size()) : 0u;
 
     std::string adler_str;
     if (p->m_calc_checksums)
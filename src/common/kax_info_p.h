@@ -15,6 +15,8 @@
 
 #include "common/common_pch.h"
 
+#include "common/checksums/adler32.h"
+
 namespace mtx::kax_info {
 
 struct track_t {
@@ -48,6 +50,7 @@ public:
   libmatroska::KaxCluster *m_cluster{};
   std::vector<int> m_frame_sizes;
   std::vector<uint32_t> m_frame_adlers;
+  mtx::checksum::adler32_c m_adler32;
   std::vector<std::string> m_frame_hexdumps;
   int64_t m_num_references{}, m_lf_timestamp{}, m_lf_tnum{};
   std::optional<int64_t> m_block_duration;
@@ -64,6 +67,13 @@ public:
 public:
   private_c() = default;
   virtual ~private_c() = default;
+
+  uint32_t
+  calculate_adler32(void const *buffer,
+                    std::size_t size) {
+    m_adler32.reset().add(buffer, size);
+    return m_adler32.get_result_as_uint();
+  }
 };
 
 }
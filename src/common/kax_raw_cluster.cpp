@@ -0,0 +1,355 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   parsing clusters without creating libebml elements
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <ebml/EbmlCrc32.h>
+#include <ebml/EbmlVoid.h>
+#include <matroska/KaxBlock.h>
+#include <matroska/KaxBlockData.h>
+#include <matroska/KaxCluster.h>
+#include <matroska/KaxClusterData.h>
+
+#include "common/kax_raw_cluster.h"
+#include "common/list_utils.h"
+
+using namespace libebml;
+using namespace libmatroska;
+
+namespace mtx::kax {
+
+namespace {
+
+class invalid_x {
+};
+
+class cursor_c {
+public:
+  unsigned char const *m_pos, *m_end;
+
+public:
+  cursor_c(unsigned char const *pos,
+           unsigned char const *end)
+    : m_pos{pos}
+    , m_end{end}
+  {
+  }
+
+  bool
+  at_end()
+    const {
+    return m_pos >= m_end;
+  }
+
+  std::size_t
+  remaining()
+    const {
+    return m_end - m_pos;
+  }
+
+  unsigned char
+  read_uint8() {
+    if (at_end())
+      throw invalid_x{};
+    return *m_pos++;
+  }
+
+  // EBML IDs keep their length marker; sizes & numbers don't.
+  uint64_t
+  read_vint(bool keep_marker,
+            bool *is_unknown = nullptr) {
+    auto first = read_uint8();
+    if (!first)
+      throw invalid_x{};
+
+    auto length = 1u;
+    while (!(first & (0x80 >> (length - 1))))
+      ++length;
+
+    if (remaining() < (length - 1))
+      throw invalid_x{};
+
+    auto value   = static_cast<uint64_t>(keep_marker ? first : first & (0xff >> length));
+    auto all_one = value == static_cast<uint64_t>(0xff >> length);
+
+    for (auto idx = 1u; idx < length; ++idx) {
+      value   = (value << 8) | *m_pos;
+      all_one = all_one && (0xff == *m_pos);
+      ++m_pos;
+    }
+
+    if (is_unknown)
+      *is_unknown = !keep_marker && all_one;
+
+    return value;
+  }
+
+  int64_t
+  read_signed_vint() {
+    auto start  = m_pos;
+    auto value  = read_vint(false);
+    auto length = static_cast<unsigned int>(m_pos - start);
+
+    return static_cast<int64_t>(value) - ((int64_t{1} << (7 * length - 1)) - 1);
+  }
+
+  uint64_t
+  read_uint(std::size_t size) {
+    if ((size > 8) || (remaining() < size))
+      throw invalid_x{};
+
+    auto value = uint64_t{};
+    for (auto idx = 0u; idx < size; ++idx)
+      value = (value << 8) | *m_pos++;
+
+    return value;
+  }
+
+  int64_t
+  read_int(std::size_t size) {
+    auto value = read_uint(size);
+    if (size && (size < 8) && (value & (uint64_t{1} << (8 * size - 1))))
+      value |= ~uint64_t{} << (8 * size);
+
+    return static_cast<int64_t>(value);
+  }
+
+  // Reads an element's header and returns its ID & a cursor for its
+  // content. Advances past the whole element.
+  std::pair<uint32_t, cursor_c>
+  read_element() {
+    auto is_unknown = false;
+    auto id         = read_vint(true);
+    auto size       = read_vint(false, &is_unknown);
+
+    if (is_unknown || (size > remaining()))
+      throw invalid_x{};
+
+    auto content = cursor_c{m_pos, m_pos + size};
+    m_pos       += size;
+
+    return { static_cast<uint32_t>(id), content };
+  }
+};
+
+memory_cptr
+slice(memory_cptr const &content,
+      unsigned char const *pos,
+      std::size_t size) {
+  return memory_c::borrow(const_cast<unsigned char *>(pos), size, content);
+}
+
+void
+parse_frames(memory_cptr const &content,
+             cursor_c &cursor,
+             raw_block_t &block) {
+  auto flags   = cursor.read_uint8();
+  auto lacing  = (flags >> 1) & 0x03;
+
+  if (block.is_simple_block) {
+    block.key_flag         = !!(flags & 0x80);
+    block.discardable_flag = !!(flags & 0x01);
+  }
+
+  if (!lacing) {
+    block.frames.emplace_back(slice(content, cursor.m_pos, cursor.remaining()));
+    return;
+  }
+
+  auto num_frames = cursor.read_uint8() + 1u;
+  std::vector<std::size_t> sizes;
+  sizes.reserve(num_frames);
+
+  if (1 == lacing) {            // Xiph lacing
+    for (auto idx = 1u; idx < num_frames; ++idx) {
+      auto size = std::size_t{};
+      unsigned char byte;
+
+      do {
+        byte  = cursor.read_uint8();
+        size += byte;
+      } while (0xff == byte);
+
+      sizes.push_back(size);
+    }
+
+  } else if (3 == lacing) {     // EBML lacing
+    auto size = static_cast<int64_t>(cursor.read_vint(false));
+    sizes.push_back(size);
+
+    for (auto idx = 2u; idx < num_frames; ++idx) {
+      size += cursor.read_signed_vint();
+      if (size < 0)
+        throw invalid_x{};
+
+      sizes.push_back(size);
+    }
+
+  } else {                      // fixed-size lacing
+    if (cursor.remaining() % num_frames)
+      throw invalid_x{};
+
+    sizes.assign(num_frames - 1, cursor.remaining() / num_frames);
+  }
+
+  auto total = std::accumulate(sizes.begin(), sizes.end(), std::size_t{});
+  if (total > cursor.remaining())
+    throw invalid_x{};
+
+  sizes.push_back(cursor.remaining() - total);
+
+  for (auto size : sizes) {
+    block.frames.emplace_back(slice(content, cursor.m_pos, size));
+    cursor.m_pos += size;
+  }
+}
+
+bool
+parse_block(memory_cptr const &content,
+            cursor_c cursor,
+            raw_block_t &block,
+            uint64_t cluster_timestamp,
+            int64_t timestamp_scale,
+            std::unordered_set<uint64_t> const &tracks_to_skip) {
+  block.track_number = cursor.read_vint(false);
+
+  if (tracks_to_skip.count(block.track_number))
+    return false;
+
+  auto relative_timestamp = static_cast<int16_t>(cursor.read_uint(2));
+  block.timestamp         = static_cast<int64_t>(cluster_timestamp * timestamp_scale) + relative_timestamp * timestamp_scale;
+
+  parse_frames(content, cursor, block);
+
+  return true;
+}
+
+void
+parse_block_additions(memory_cptr const &content,
+                      cursor_c cursor,
+                      raw_block_t &block) {
+  while (!cursor.at_end()) {
+    auto [id, more] = cursor.read_element();
+    if (EBML_ID_VALUE(EBML_ID(KaxBlockMore)) != id)
+      continue;
+
+    auto additional = memory_c::alloc(0);
+
+    while (!more.at_end()) {
+      auto [child_id, child] = more.read_element();
+      if (EBML_ID_VALUE(EBML_ID(KaxBlockAdditional)) == child_id)
+        additional = slice(content, child.m_pos, child.remaining());
+    }
+
+    block.additions.emplace_back(additional);
+  }
+}
+
+std::optional<raw_block_t>
+parse_block_group(memory_cptr const &content,
+                  cursor_c cursor,
+                  uint64_t cluster_timestamp,
+                  int64_t timestamp_scale,
+                  std::unordered_set<uint64_t> const &tracks_to_skip) {
+  raw_block_t block;
+  auto block_found = false;
+
+  while (!cursor.at_end()) {
+    auto [id, child] = cursor.read_element();
+
+    if (EBML_ID_VALUE(EBML_ID(KaxBlock)) == id) {
+      if (block_found)
+        throw invalid_x{};
+
+      block_found = true;
+      if (!parse_block(content, child, block, cluster_timestamp, timestamp_scale, tracks_to_skip))
+        return {};
+
+    } else if (EBML_ID_VALUE(EBML_ID(KaxBlockDuration)) == id)
+      block.duration = child.read_uint(child.remaining());
+
+    else if (EBML_ID_VALUE(EBML_ID(KaxReferenceBlock)) == id)
+      block.references.push_back(child.read_int(child.remaining()));
+
+    else if (EBML_ID_VALUE(EBML_ID(KaxDiscardPadding)) == id)
+      block.discard_padding = child.read_int(child.remaining());
+
+    else if (EBML_ID_VALUE(EBML_ID(KaxCodecState)) == id)
+      block.codec_state = slice(content, child.m_pos, child.remaining());
+
+    else if (EBML_ID_VALUE(EBML_ID(KaxBlockAdditions)) == id)
+      parse_block_additions(content, child, block);
+
+    else if (!mtx::included_in(id, EBML_ID_VALUE(EBML_ID(KaxReferencePriority)), EBML_ID_VALUE(EBML_ID(EbmlVoid)), EBML_ID_VALUE(EBML_ID(EbmlCrc32))))
+      // Slices, virtual blocks & references etc.
+      throw invalid_x{};
+  }
+
+  if (!block_found)
+    return {};
+
+  return block;
+}
+
+}
+
+raw_cluster_cptr
+parse_raw_cluster(memory_cptr const &content,
+                  int64_t timestamp_scale,
+                  std::unordered_set<uint64_t> const &tracks_to_skip) {
+  auto cluster = std::make_shared<raw_cluster_t>();
+  auto cursor  = cursor_c{content->get_buffer(), content->get_buffer() + content->get_size()};
+
+  try {
+    // The timestamp usually comes first, but that's not required.
+    std::vector<std::pair<uint32_t, cursor_c>> block_elements;
+
+    while (!cursor.at_end()) {
+      auto element = cursor.read_element();
+      auto id      = element.first;
+
+      if (EBML_ID_VALUE(EBML_ID(KaxClusterTimecode)) == id)
+        cluster->timestamp = element.second.read_uint(element.second.remaining());
+
+      else if (mtx::included_in(id, EBML_ID_VALUE(EBML_ID(KaxSimpleBlock)), EBML_ID_VALUE(EBML_ID(KaxBlockGroup))))
+        block_elements.emplace_back(element);
+
+      else if (!mtx::included_in(id,
+                                 EBML_ID_VALUE(EBML_ID(KaxClusterPosition)), EBML_ID_VALUE(EBML_ID(KaxClusterPrevSize)), EBML_ID_VALUE(EBML_ID(KaxClusterSilentTracks)),
+                                 EBML_ID_VALUE(EBML_ID(EbmlVoid)),           EBML_ID_VALUE(EBML_ID(EbmlCrc32))))
+        // Encrypted blocks, unknown elements
+        return {};
+    }
+
+    cluster->blocks.reserve(block_elements.size());
+
+    for (auto &[id, element] : block_elements) {
+      if (EBML_ID_VALUE(EBML_ID(KaxSimpleBlock)) == id) {
+        raw_block_t block;
+        block.is_simple_block = true;
+
+        if (parse_block(content, element, block, cluster->timestamp, timestamp_scale, tracks_to_skip))
+          cluster->blocks.emplace_back(std::move(block));
+
+      } else if (auto block = parse_block_group(content, element, cluster->timestamp, timestamp_scale, tracks_to_skip); block)
+        cluster->blocks.emplace_back(std::move(*block));
+    }
+
+  } catch (invalid_x &) {
+    return {};
+  }
+
+  return cluster;
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   parsing clusters without creating libebml elements
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+#include <unordered_set>
+
+namespace mtx::kax {
+
+// A SimpleBlock or a BlockGroup with its Block. All buffers are
+// slices of the cluster's content and keep it alive; nothing is
+// copied.
+struct raw_block_t {
+  bool is_simple_block{};
+  uint64_t track_number{};
+  int64_t timestamp{};          // in ns
+  bool key_flag{}, discardable_flag{};
+  std::vector<memory_cptr> frames;
+
+  // Only set for BlockGroups:
+  std::optional<uint64_t> duration; // in units of the timestamp scale
+  std::vector<int64_t> references;  // in units of the timestamp scale
+  std::vector<memory_cptr> additions;
+  memory_cptr codec_state;
+  std::optional<int64_t> discard_padding;
+};
+
+struct raw_cluster_t {
+  uint64_t timestamp{};         // in units of the timestamp scale
+  std::vector<raw_block_t> blocks;
+};
+using raw_cluster_cptr = std::shared_ptr<raw_cluster_t>;
+
+// Parses the content of a cluster, meaning everything after the
+// cluster's size field. Blocks of the tracks in tracks_to_skip are
+// left out. Returns nullptr for anything that isn't handled here,
+// e.g. damaged structures, elements with unknown sizes or encrypted
+// blocks, so that the caller can fall back to libebml.
+raw_cluster_cptr parse_raw_cluster(memory_cptr const &content, int64_t timestamp_scale, std::unordered_set<uint64_t> const &tracks_to_skip = {});
+
+}
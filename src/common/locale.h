@@ -16,6 +16,7 @@
 #include "common/common_pch.h"
 
 #include <iconv.h>
+#include <mutex>
 
 class charset_converter_c;
 using charset_converter_cptr = std::shared_ptr<charset_converter_c>;
@@ -50,6 +51,7 @@ class iconv_charset_converter_c: public charset_converter_c {
 private:
   bool m_is_utf8;
   iconv_t m_to_utf8_handle, m_from_utf8_handle;
+  std::mutex m_mutex;           // iconv handles must not be used by several threads at once
 
 public:
   iconv_charset_converter_c(const std::string &charset);
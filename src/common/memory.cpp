@@ -23,7 +23,27 @@ memory_c::resize(size_t new_size)
   if (new_size == m_size)
     return;
 
-  if (m_is_owned) {
+  if (m_is_owned && m_pool_capacity) {
+    if ((new_size + m_offset) > m_pool_capacity) {
+      // Buffers outgrowing the pool continue with realloc() so that
+      // growing them repeatedly doesn't copy them each time.
+      auto &pool    = mtx::mem::pool_c::get();
+      auto capacity = mtx::mem::pool_c::get_block_size(new_size + m_offset);
+      auto tmp      = capacity > mtx::mem::pool_c::max_block_size ? safemalloc(capacity) : pool.allocate(capacity);
+
+      if (capacity > mtx::mem::pool_c::max_block_size)
+        capacity = 0;
+
+      std::memcpy(tmp, m_ptr, std::min(new_size + m_offset, m_size));
+      pool.release(m_ptr, m_pool_capacity);
+
+      m_ptr           = tmp;
+      m_pool_capacity = capacity;
+    }
+
+    m_size = new_size + m_offset;
+
+  } else if (m_is_owned) {
     m_ptr  = static_cast<unsigned char *>(saferealloc(m_ptr, new_size + m_offset));
     m_size = new_size + m_offset;
 
@@ -33,6 +53,8 @@ memory_c::resize(size_t new_size)
     m_ptr      = tmp;
     m_is_owned = true;
     m_size     = new_size;
+    m_offset   = 0;
+    m_keep_alive.reset();
   }
 }
 
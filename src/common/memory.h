@@ -16,6 +16,7 @@
 #include "common/common_pch.h"
 
 #include "common/error.h"
+#include "common/memory_pool.h"
 
 namespace mtx {
   namespace mem {
@@ -83,23 +84,44 @@ class memory_c {
 private:
   unsigned char *m_ptr{};
   std::size_t m_size{}, m_offset{};
+  std::size_t m_pool_capacity{}; // != 0 if m_ptr was allocated from the pool
+  std::shared_ptr<void> m_keep_alive; // owner of a borrowed buffer, e.g. a memory mapping
   bool m_is_owned{};
 
   explicit memory_c(void *ptr,
                     std::size_t size,
-                    bool take_ownership) // allocate a new counter
+                    bool take_ownership,
+                    std::size_t pool_capacity = 0) // allocate a new counter
     : m_ptr{static_cast<unsigned char *>(ptr)}
     , m_size{size}
+    , m_pool_capacity{pool_capacity}
     , m_is_owned{take_ownership}
   {
   }
 
+  void release_buffer() {
+    if (!m_is_owned || !m_ptr)
+      return;
+
+    if (m_pool_capacity)
+      mtx::mem::pool_c::get().release(m_ptr, m_pool_capacity);
+    else
+      free(m_ptr);
+  }
+
 public:
   memory_c() {}
 
   ~memory_c() {
-    if (m_is_owned && m_ptr)
-      free(m_ptr);
+    release_buffer();
+  }
+
+  static void *operator new(std::size_t size) {
+    return mtx::mem::pool_c::get().allocate(size);
+  }
+
+  static void operator delete(void *ptr, std::size_t size) {
+    mtx::mem::pool_c::get().release(ptr, size);
   }
 
   memory_c(const memory_c &r) = delete;
@@ -135,17 +157,42 @@ public:
     return m_is_owned;
   }
 
+  // Borrowed buffers whose owner is kept alive don't need to be
+  // copied.
   void take_ownership() {
-    if (m_is_owned)
+    if (m_is_owned || m_keep_alive)
       return;
 
-    m_ptr       = static_cast<unsigned char *>(safememdup(get_buffer(), get_size()));
-    m_is_owned  = true;
-    m_size     -= m_offset;
-    m_offset    = 0;
+    auto size        = get_size();
+    auto copy        = mtx::mem::pool_c::get().allocate(size);
+    std::memcpy(copy, get_buffer(), size);
+
+    m_ptr           = copy;
+    m_pool_capacity = mtx::mem::pool_c::get_block_size(size);
+    m_is_owned      = true;
+    m_size          = size;
+    m_offset        = 0;
   }
 
+  bool is_kept_alive() const {
+    return !!m_keep_alive;
+  }
+
+  // The caller takes over the buffer and will free() it eventually.
   void lock() {
+    if (m_is_owned && m_pool_capacity) {
+      auto copy = safememdup(m_ptr, m_size);
+      release_buffer();
+      m_ptr           = copy;
+      m_pool_capacity = 0;
+
+    } else if (m_keep_alive) {
+      m_ptr    = safememdup(get_buffer(), get_size());
+      m_size   = get_size();
+      m_offset = 0;
+      m_keep_alive.reset();
+    }
+
     m_is_owned = false;
   }
 
@@ -175,12 +222,21 @@ public:
 public:
   static inline memory_cptr
   take_ownership(void *buffer, std::size_t length) {
-    return memory_cptr{ new memory_c(reinterpret_cast<unsigned char *>(buffer), length, true) };
+    return mtx::mem::make_pooled_shared(new memory_c(reinterpret_cast<unsigned char *>(buffer), length, true));
   }
 
   static inline memory_cptr
   borrow(void *buffer, std::size_t length) {
-    return memory_cptr{ new memory_c(reinterpret_cast<unsigned char *>(buffer), length, false) };
+    return mtx::mem::make_pooled_shared(new memory_c(reinterpret_cast<unsigned char *>(buffer), length, false));
+  }
+
+  // The buffer stays valid for as long as the returned object holds
+  // on to the owner.
+  static inline memory_cptr
+  borrow(void *buffer, std::size_t length, std::shared_ptr<void> const &owner) {
+    auto mem          = borrow(buffer, length);
+    mem->m_keep_alive = owner;
+    return mem;
   }
 
   static inline memory_cptr
@@ -188,15 +244,22 @@ public:
     return borrow(&buffer[0], buffer.length());
   }
 
+  // Buffers created by alloc() and clone() come from the pool.
   static memory_cptr
   alloc(std::size_t size) {
-    return take_ownership(safemalloc(size), size);
+    auto buffer = mtx::mem::pool_c::get().allocate(size);
+    return mtx::mem::make_pooled_shared(new memory_c(buffer, size, true, mtx::mem::pool_c::get_block_size(size)));
   };
 
   static inline memory_cptr
   clone(const void *buffer,
         std::size_t size) {
-    return take_ownership(safememdup(buffer, size), size);
+    if (!buffer)
+      return take_ownership(nullptr, size);
+
+    auto mem = alloc(size);
+    std::memcpy(mem->get_buffer(), buffer, size);
+    return mem;
   }
 
   static inline memory_cptr
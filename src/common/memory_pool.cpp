@@ -0,0 +1,171 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   size class based memory pool
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/memory_pool.h"
+
+namespace mtx::mem {
+
+pool_c::~pool_c() {
+  trim();
+}
+
+pool_c &
+pool_c::get() {
+  // Never destroyed: memory might still be released by destructors
+  // of other static objects after this one would have been destroyed.
+  static auto s_pool = new pool_c;
+  return *s_pool;
+}
+
+std::optional<std::size_t>
+pool_c::get_class(std::size_t size,
+                  std::size_t *block_size) {
+  if (size > max_block_size)
+    return {};
+
+  if (size <= min_block_size) {
+    if (block_size)
+      *block_size = min_block_size;
+    return 0;
+  }
+
+  auto power = min_block_size;
+  auto idx   = std::size_t{1};
+
+  while (size > (2 * power)) {
+    power *= 2;
+    idx   += num_steps;
+  }
+
+  auto step  = power / num_steps;
+  auto steps = (size - power + step - 1) / step;
+
+  if (block_size)
+    *block_size = power + steps * step;
+
+  return idx + steps - 1;
+}
+
+std::size_t
+pool_c::get_block_size(std::size_t size) {
+  auto block_size = size;
+  get_class(size, &block_size);
+
+  return block_size;
+}
+
+unsigned char *
+pool_c::allocate(std::size_t size) {
+  m_num_allocations.fetch_add(1, std::memory_order_relaxed);
+
+  auto block_size = size;
+  auto cls        = get_class(size, &block_size);
+
+  if (cls) {
+    auto &size_class = m_classes[*cls];
+    std::lock_guard<std::mutex> lock{size_class.mutex};
+
+    if (!size_class.free_blocks.empty()) {
+      auto block = size_class.free_blocks.back();
+      size_class.free_blocks.pop_back();
+
+      m_num_reused.fetch_add(1, std::memory_order_relaxed);
+      m_num_cached.fetch_sub(1, std::memory_order_relaxed);
+      m_cached_bytes.fetch_sub(block_size, std::memory_order_relaxed);
+
+      return block;
+    }
+  }
+
+  m_num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+
+  return safemalloc(block_size);
+}
+
+void
+pool_c::release(void *block,
+                std::size_t size) {
+  if (!block)
+    return;
+
+  m_num_releases.fetch_add(1, std::memory_order_relaxed);
+
+  auto block_size = size;
+  auto cls        = get_class(size, &block_size);
+
+  if (!cls || ((m_cached_bytes.load(std::memory_order_relaxed) + block_size) > max_cached_size)) {
+    m_num_heap_releases.fetch_add(1, std::memory_order_relaxed);
+    free(block);
+    return;
+  }
+
+  {
+    auto &size_class = m_classes[*cls];
+    std::lock_guard<std::mutex> lock{size_class.mutex};
+
+    size_class.free_blocks.push_back(static_cast<unsigned char *>(block));
+  }
+
+  m_num_cached.fetch_add(1, std::memory_order_relaxed);
+  auto cached_bytes = m_cached_bytes.fetch_add(block_size, std::memory_order_relaxed) + block_size;
+  auto peak         = m_peak_cached_bytes.load(std::memory_order_relaxed);
+
+  while ((cached_bytes > peak) && !m_peak_cached_bytes.compare_exchange_weak(peak, cached_bytes, std::memory_order_relaxed))
+    ;
+}
+
+void
+pool_c::trim() {
+  for (auto &size_class : m_classes) {
+    std::lock_guard<std::mutex> lock{size_class.mutex};
+
+    for (auto block : size_class.free_blocks)
+      free(block);
+
+    size_class.free_blocks.clear();
+  }
+
+  m_num_cached   = 0;
+  m_cached_bytes = 0;
+}
+
+pool_c::statistics_t
+pool_c::get_statistics()
+  const {
+  statistics_t stats;
+
+  stats.num_allocations      = m_num_allocations.load(std::memory_order_relaxed);
+  stats.num_reused           = m_num_reused.load(std::memory_order_relaxed);
+  stats.num_heap_allocations = m_num_heap_allocations.load(std::memory_order_relaxed);
+  stats.num_releases         = m_num_releases.load(std::memory_order_relaxed);
+  stats.num_heap_releases    = m_num_heap_releases.load(std::memory_order_relaxed);
+  stats.num_cached           = m_num_cached.load(std::memory_order_relaxed);
+  stats.cached_bytes         = m_cached_bytes.load(std::memory_order_relaxed);
+  stats.peak_cached_bytes    = m_peak_cached_bytes.load(std::memory_order_relaxed);
+
+  return stats;
+}
+
+void
+pool_c::dump_statistics()
+  const {
+  auto stats = get_statistics();
+
+  mxdebug(fmt::format("memory pool: allocations {0} reused {1} ({2}%) heap allocations {3} releases {4} heap releases {5} cached blocks {6} cached bytes {7} peak cached bytes {8}\n",
+                      stats.num_allocations, stats.num_reused, stats.num_allocations ? stats.num_reused * 100 / stats.num_allocations : 0, stats.num_heap_allocations,
+                      stats.num_releases, stats.num_heap_releases, stats.num_cached, stats.cached_bytes, stats.peak_cached_bytes));
+}
+
+}
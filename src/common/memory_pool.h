@@ -0,0 +1,140 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   size class based memory pool
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+namespace mtx::mem {
+
+// A pool of memory blocks grouped into size classes. Blocks released
+// to the pool are kept in per-class free lists and handed out again
+// by the next allocation of the same class instead of going through
+// malloc() & free() for each frame. Sizes are rounded up to one of
+// four steps per power of two, so the overhead is at most 25%.
+// Requests larger than the largest class are served by malloc()
+// directly.
+//
+// The pool is thread-safe as blocks are allocated on the reader
+// threads and released on the main thread.
+class pool_c {
+public:
+  static constexpr std::size_t min_block_size  = 64;
+  static constexpr std::size_t max_block_size  = 1024 * 1024;
+  static constexpr std::size_t num_steps       = 4;
+  static constexpr std::size_t num_classes     = 1 + num_steps * 14; // 2^6 … 2^20
+  static constexpr std::size_t max_cached_size = 64 * 1024 * 1024;
+
+  struct statistics_t {
+    uint64_t num_allocations{}, num_reused{}, num_heap_allocations{}, num_releases{}, num_heap_releases{};
+    uint64_t num_cached{}, cached_bytes{}, peak_cached_bytes{};
+  };
+
+protected:
+  struct size_class_t {
+    std::mutex mutex;
+    std::vector<unsigned char *> free_blocks;
+  };
+
+  std::array<size_class_t, num_classes> m_classes;
+
+  std::atomic<uint64_t> m_num_allocations{}, m_num_reused{}, m_num_heap_allocations{}, m_num_releases{}, m_num_heap_releases{};
+  std::atomic<uint64_t> m_num_cached{}, m_cached_bytes{}, m_peak_cached_bytes{};
+
+public:
+  pool_c() = default;
+  ~pool_c();
+
+  pool_c(pool_c const &) = delete;
+  pool_c &operator =(pool_c const &) = delete;
+
+  // Returns a block of at least get_block_size(size) bytes. The same
+  // size must be passed to release().
+  unsigned char *allocate(std::size_t size);
+  void release(void *block, std::size_t size);
+
+  // Frees all cached blocks.
+  void trim();
+
+  statistics_t get_statistics() const;
+  void dump_statistics() const;
+
+  static pool_c &get();
+
+  // Returns the size actually reserved for a request of "size"
+  // bytes. Requests that aren't served from the pool return "size"
+  // unchanged.
+  static std::size_t get_block_size(std::size_t size);
+
+protected:
+  static std::optional<std::size_t> get_class(std::size_t size, std::size_t *block_size = nullptr);
+};
+
+// A standard allocator using the pool. Meant for the control blocks
+// of shared pointers to objects created for each frame.
+template<typename T>
+class pool_allocator_c {
+public:
+  using value_type = T;
+
+  pool_allocator_c() noexcept = default;
+
+  template<typename U>
+  pool_allocator_c(pool_allocator_c<U> const &) noexcept {
+  }
+
+  T *
+  allocate(std::size_t n) {
+    return reinterpret_cast<T *>(pool_c::get().allocate(n * sizeof(T)));
+  }
+
+  void
+  deallocate(T *p,
+             std::size_t n)
+    noexcept {
+    pool_c::get().release(p, n * sizeof(T));
+  }
+
+  template<typename U>
+  bool
+  operator ==(pool_allocator_c<U> const &)
+    const noexcept {
+    return true;
+  }
+
+  template<typename U>
+  bool
+  operator !=(pool_allocator_c<U> const &)
+    const noexcept {
+    return false;
+  }
+};
+
+// A vector whose storage comes from the pool. Meant for members of
+// objects created for each frame.
+template<typename T>
+using pooled_vector_t = std::vector<T, pool_allocator_c<T>>;
+
+// Wraps a newly allocated object in a shared pointer whose control
+// block comes from the pool.
+template<typename T>
+std::shared_ptr<T>
+make_pooled_shared(T *object) {
+  return std::shared_ptr<T>{object, std::default_delete<T>{}, pool_allocator_c<T>{}};
+}
+
+}
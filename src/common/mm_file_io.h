@@ -36,6 +36,11 @@ public:
   virtual void clear_eof();
   virtual int truncate(int64_t pos);
 
+  // Hints for the operating system's caching; no-ops where not
+  // supported.
+  void advise_sequential_reading();
+  void prefetch(int64_t offset, int64_t length);
+
   virtual std::string get_file_name() const;
 
 public:
@@ -18,6 +18,7 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -151,6 +152,21 @@ mm_file_io_c::truncate(int64_t pos) {
   return ftruncate(fileno(p->file), pos);
 }
 
+void
+mm_file_io_c::advise_sequential_reading() {
+#if defined(HAVE_POSIX_FADVISE)
+  posix_fadvise(fileno(p_func()->file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+void
+mm_file_io_c::prefetch([[maybe_unused]] int64_t offset,
+                       [[maybe_unused]] int64_t length) {
+#if defined(HAVE_POSIX_FADVISE)
+  posix_fadvise(fileno(p_func()->file), offset, length, POSIX_FADV_WILLNEED);
+#endif
+}
+
 /** \brief OS and kernel dependant setup
 */
 void
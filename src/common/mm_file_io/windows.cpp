@@ -193,6 +193,15 @@ mm_file_io_c::truncate(int64_t pos) {
   return -1;
 }
 
+void
+mm_file_io_c::advise_sequential_reading() {
+}
+
+void
+mm_file_io_c::prefetch(int64_t,
+                       int64_t) {
+}
+
 void
 mm_file_io_c::setup() {
 }
@@ -134,6 +134,13 @@ mm_io_c::read(size_t size) {
   return buffer;
 }
 
+// The returned buffer must not be modified. Implementations may hand
+// out a slice of their own memory instead of a copy.
+memory_cptr
+mm_io_c::read_immutable(size_t size) {
+  return read(size);
+}
+
 uint32_t
 mm_io_c::read(void *buffer,
               size_t size) {
@@ -24,6 +24,9 @@ using mm_file_io_cptr = std::shared_ptr<mm_file_io_c>;
 class mm_mem_io_c;
 using mm_mem_io_cptr = std::shared_ptr<mm_mem_io_c>;
 
+class mm_mmap_io_c;
+using mm_mmap_io_cptr = std::shared_ptr<mm_mmap_io_c>;
+
 class mm_mpls_multi_file_io_c;
 using mm_mpls_multi_file_io_cptr = std::shared_ptr<mm_mpls_multi_file_io_c>;
 
@@ -0,0 +1,209 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   IO callback class implementation
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#if defined(SYS_WINDOWS)
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/types.h>
+# include <unistd.h>
+#endif
+
+#include "common/at_scope_exit.h"
+#include "common/mm_io_x.h"
+#include "common/mm_mmap_io.h"
+#include "common/mm_mmap_io_p.h"
+#if defined(SYS_WINDOWS)
+# include "common/strings/utf8.h"
+#endif
+
+mm_mmap_io_private_c::mm_mmap_io_private_c(std::string const &p_file_name)
+  : file_name{p_file_name}
+{
+  // Only non-empty regular files can be mapped. Everything else is
+  // reported as "not supported" so that callers can fall back to
+  // regular I/O.
+  auto not_supported = std::make_error_code(std::errc::not_supported);
+
+#if defined(SYS_WINDOWS)
+  auto file = CreateFileW(to_wide(file_name).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+
+  mtx::at_scope_exit_c close_file{[file]() { CloseHandle(file); }};
+
+  LARGE_INTEGER file_size;
+  if ((GetFileType(file) != FILE_TYPE_DISK) || !GetFileSizeEx(file, &file_size) || (file_size.QuadPart <= 0) || (static_cast<uint64_t>(file_size.QuadPart) > std::numeric_limits<std::size_t>::max()))
+    throw mtx::mm_io::open_x{not_supported};
+
+  auto file_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!file_mapping)
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+
+  mtx::at_scope_exit_c close_file_mapping{[file_mapping]() { CloseHandle(file_mapping); }};
+
+  auto address = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!address)
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+
+  size = file_size.QuadPart;
+  mapping.reset(static_cast<unsigned char *>(address), [](unsigned char *ptr) { UnmapViewOfFile(ptr); });
+
+#else  // SYS_WINDOWS
+  auto fd = ::open(g_cc_local_utf8->native(file_name).c_str(), O_RDONLY);
+  if (fd < 0)
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+
+  mtx::at_scope_exit_c close_file{[fd]() { ::close(fd); }};
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+
+  if (!S_ISREG(st.st_mode) || (st.st_size <= 0) || (static_cast<uint64_t>(st.st_size) > std::numeric_limits<std::size_t>::max()))
+    throw mtx::mm_io::open_x{not_supported};
+
+  auto length  = static_cast<std::size_t>(st.st_size);
+  auto address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (address == MAP_FAILED)
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+
+# if defined(MADV_SEQUENTIAL)
+  madvise(address, length, MADV_SEQUENTIAL);
+# endif
+
+  size = length;
+  mapping.reset(static_cast<unsigned char *>(address), [length](unsigned char *ptr) { munmap(ptr, length); });
+#endif  // SYS_WINDOWS
+}
+
+mm_mmap_io_c::mm_mmap_io_c(std::string const &file_name)
+  : mm_io_c{*new mm_mmap_io_private_c{file_name}}
+{
+}
+
+mm_mmap_io_c::mm_mmap_io_c(mm_mmap_io_private_c &p)
+  : mm_io_c{p}
+{
+}
+
+mm_mmap_io_c::~mm_mmap_io_c() {
+  close();
+}
+
+mm_io_cptr
+mm_mmap_io_c::open(std::string const &file_name) {
+  try {
+    return std::make_shared<mm_mmap_io_c>(file_name);
+  } catch (mtx::mm_io::exception &) {
+    return {};
+  }
+}
+
+uint64
+mm_mmap_io_c::getFilePointer() {
+  return p_func()->pos;
+}
+
+void
+mm_mmap_io_c::setFilePointer(int64 offset,
+                             libebml::seek_mode mode) {
+  auto p = p_func();
+
+  int64_t new_pos
+    = libebml::seek_beginning == mode ? offset
+    : libebml::seek_end       == mode ? static_cast<int64_t>(p->size) + offset // offsets from the end are negative already
+    :                                   static_cast<int64_t>(p->pos)  + offset;
+
+  if (new_pos < 0)
+    throw mtx::mm_io::seek_x{std::make_error_code(std::errc::invalid_argument)};
+
+  // Like mm_read_buffer_io_c positions beyond the end are clamped.
+  p->pos = std::min<uint64_t>(new_pos, p->size);
+  p->eof = false;
+}
+
+memory_cptr
+mm_mmap_io_c::read_immutable(size_t size) {
+  auto p = p_func();
+
+  if ((p->size - p->pos) < size) {
+    p->pos = p->size;
+    p->eof = true;
+    throw mtx::mm_io::end_of_file_x{};
+  }
+
+  auto buffer  = memory_c::borrow(p->mapping.get() + p->pos, size, p->mapping);
+  p->pos      += size;
+
+  return buffer;
+}
+
+uint32
+mm_mmap_io_c::_read(void *buffer,
+                    size_t size) {
+  auto p        = p_func();
+  auto num_read = std::min<uint64_t>(size, p->size - p->pos);
+
+  if (num_read)
+    std::memcpy(buffer, p->mapping.get() + p->pos, num_read);
+
+  p->pos += num_read;
+
+  if (num_read < size)
+    p->eof = true;
+
+  return num_read;
+}
+
+size_t
+mm_mmap_io_c::_write(const void *,
+                     size_t) {
+  throw mtx::mm_io::wrong_read_write_access_x();
+}
+
+void
+mm_mmap_io_c::close() {
+  auto p = p_func();
+
+  // Buffers handed out by read() may still reference the mapping. It
+  // is released once the last of them is gone.
+  p->mapping.reset();
+  p->size = 0;
+  p->pos  = 0;
+}
+
+bool
+mm_mmap_io_c::eof() {
+  return p_func()->eof;
+}
+
+void
+mm_mmap_io_c::clear_eof() {
+  p_func()->eof = false;
+}
+
+std::string
+mm_mmap_io_c::get_file_name()
+  const {
+  return p_func()->file_name;
+}
+
+int64_t
+mm_mmap_io_c::get_size() {
+  return p_func()->size;
+}
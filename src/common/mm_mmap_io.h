@@ -0,0 +1,57 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   IO callback class definitions
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+#include "common/mm_io.h"
+
+/*
+   Read-only access to a regular file that is mapped into memory. The
+   buffers returned by read_immutable() reference the mapping directly
+   instead of being copied; they keep the mapping alive even after
+   the file has been closed.
+
+   The mapping itself is read-only. Buffers returned by read(size_t)
+   are copies that callers may modify.
+*/
+
+class mm_mmap_io_private_c;
+class mm_mmap_io_c: public mm_io_c {
+protected:
+  MTX_DECLARE_PRIVATE(mm_mmap_io_private_c)
+
+  explicit mm_mmap_io_c(mm_mmap_io_private_c &p);
+
+public:
+  mm_mmap_io_c(std::string const &file_name);
+  virtual ~mm_mmap_io_c();
+
+  virtual uint64 getFilePointer();
+  virtual void setFilePointer(int64 offset, libebml::seek_mode mode = libebml::seek_beginning);
+  virtual memory_cptr read_immutable(size_t size);
+  virtual void close();
+  virtual bool eof();
+  virtual void clear_eof();
+  virtual std::string get_file_name() const;
+  virtual int64_t get_size();
+
+  // Returns an empty pointer if the file cannot be mapped, e.g. for
+  // pipes, devices or empty files.
+  static mm_io_cptr open(std::string const &file_name);
+
+protected:
+  virtual uint32 _read(void *buffer, size_t size);
+  virtual size_t _write(const void *buffer, size_t size);
+};
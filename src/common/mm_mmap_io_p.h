@@ -0,0 +1,28 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+#include "common/mm_io_p.h"
+
+class mm_mmap_io_c;
+
+class mm_mmap_io_private_c : public mm_io_private_c {
+public:
+  std::string file_name;
+  std::shared_ptr<unsigned char> mapping; // unmaps the file when the last reference is gone
+  uint64_t size{}, pos{};
+  bool eof{};
+
+  explicit mm_mmap_io_private_c(std::string const &p_file_name);
+};
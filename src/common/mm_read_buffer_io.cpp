@@ -14,6 +14,7 @@
 
 #include "common/common_pch.h"
 
+#include "common/mm_file_io.h"
 #include "common/mm_io_x.h"
 #include "common/mm_proxy_io.h"
 #include "common/mm_read_buffer_io.h"
@@ -24,9 +25,11 @@ debugging_option_c s_debug_seek{"read_buffer_io|read_buffer_io_seek"}, s_debug_r
 }
 
 mm_read_buffer_io_c::mm_read_buffer_io_c(mm_io_cptr const &in,
-                                         std::size_t buffer_size)
-  : mm_proxy_io_c{*new mm_read_buffer_io_private_c{in, buffer_size}}
+                                         std::size_t buffer_size,
+                                         std::size_t num_read_ahead_buffers)
+  : mm_proxy_io_c{*new mm_read_buffer_io_private_c{in, buffer_size, num_read_ahead_buffers}}
 {
+  start_read_ahead_thread();
 }
 
 mm_read_buffer_io_c::mm_read_buffer_io_c(mm_read_buffer_io_private_c &p)
@@ -38,6 +41,12 @@ mm_read_buffer_io_c::~mm_read_buffer_io_c() {
   close();
 }
 
+void
+mm_read_buffer_io_c::close() {
+  stop_read_ahead_thread();
+  mm_proxy_io_c::close();
+}
+
 uint64
 mm_read_buffer_io_c::getFilePointer() {
   auto p = p_func();
@@ -87,6 +96,17 @@ mm_read_buffer_io_c::setFilePointer(int64 offset,
     return;
   }
 
+  // With read-ahead the underlying file belongs to the read-ahead
+  // thread. The next refill picks up the new position.
+  if (p->reader.joinable()) {
+    mxdebug_if(s_debug_seek, fmt::format("seek with read-ahead from {0} to {1} relative {2}\n", p->offset + p->cursor, new_pos, new_pos - p->offset - static_cast<int64_t>(p->cursor)));
+
+    p->offset = std::min(new_pos, get_size());
+    p->cursor = p->fill = 0;
+
+    return;
+  }
+
   int64_t previous_pos = p->proxy_io->getFilePointer();
 
   // Actual seeking
@@ -104,7 +124,9 @@ mm_read_buffer_io_c::setFilePointer(int64 offset,
 
 int64_t
 mm_read_buffer_io_c::get_size() {
-  return p_func()->proxy_io->get_size();
+  auto p = p_func();
+
+  return p->reader.joinable() ? p->file_size : p->proxy_io->get_size();
 }
 
 uint32
@@ -128,33 +150,257 @@ mm_read_buffer_io_c::_read(void *buffer,
       size     -= avail;
       p->cursor += avail;
 
-    } else {
-      // Refill the buffer
-      p->offset += p->cursor;
-      p->cursor  = 0;
-      p->fill    = 0;
-      avail     = std::min(get_size() - p->offset, static_cast<int64_t>(p->af_buffer->get_size()));
-
-      if (!avail) {
-        // must keep track of eof, as p->proxy_io->eof() will never be reached
-        // because of the above eof calculation
-        p->eof = true;
-        break;
-      }
+    } else if (!refill_buffer())
+      break;
+  }
 
-      int64_t previous_pos = p->proxy_io->getFilePointer();
+  return res;
+}
+
+bool
+mm_read_buffer_io_c::refill_buffer() {
+  auto p = p_func();
+
+  p->offset += p->cursor;
+  p->cursor  = 0;
+  p->fill    = 0;
+
+  if (p->reader.joinable())
+    return refill_buffer_from_read_ahead();
+
+  auto avail = std::min(get_size() - p->offset, static_cast<int64_t>(p->af_buffer->get_size()));
+
+  if (!avail) {
+    // must keep track of eof, as p->proxy_io->eof() will never be reached
+    // because of the above eof calculation
+    p->eof = true;
+    return false;
+  }
+
+  int64_t previous_pos = p->proxy_io->getFilePointer();
+
+  p->fill = p->proxy_io->read(p->buffer, avail);
+  mxdebug_if(s_debug_read, fmt::format("physical read from position {2} for {0} returned {1}\n", avail, p->fill, previous_pos));
+  if (p->fill != static_cast<std::size_t>(avail)) {
+    p->eof = true;
+    if (!p->fill)
+      return false;
+  }
+
+  return true;
+}
+
+bool
+mm_read_buffer_io_c::refill_buffer_from_read_ahead() {
+  auto p          = p_func();
+  auto block_size = static_cast<int64_t>(p->af_buffer->get_size());
 
-      p->fill = p->proxy_io->read(p->buffer, avail);
-      mxdebug_if(s_debug_read, fmt::format("physical read from position {2} for {0} returned {1}\n", avail, p->fill, previous_pos));
-      if (p->fill != avail) {
+  if (p->offset >= p->file_size) {
+    p->eof = true;
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock{p->mutex};
+
+  for (auto restarted = false; ;) {
+    // Drop blocks before the current position, e.g. after seeking
+    // forward.
+    while (!p->prefetched.empty() && ((p->prefetched.front().offset + static_cast<int64_t>(p->prefetched.front().fill)) <= p->offset)) {
+      p->free_buffers.emplace_back(p->prefetched.front().buffer);
+      p->prefetched.pop_front();
+    }
+
+    if (!p->prefetched.empty() && (p->prefetched.front().offset <= p->offset))
+      break;
+
+    auto in_flight = p->prefetched.empty()
+                  && p->read_ahead_active
+                  && !p->exhausted
+                  && (p->next_read_offset <= p->offset)
+                  && (p->offset           <  (p->next_read_offset + block_size));
+
+    if (!in_flight) {
+      // Either seeking backwards, seeking beyond the blocks read
+      // ahead or the previous read was short.
+      if (restarted) {
         p->eof = true;
-        if (!p->fill)
-          break;
+        return false;
       }
+
+      restart_read_ahead(lock, p->offset);
+      restarted = true;
+    }
+
+    p->condition.wait(lock, [p]() { return !p->prefetched.empty() || p->read_exception || (!p->reading && p->exhausted); });
+
+    if (p->read_exception) {
+      auto exception       = p->read_exception;
+      p->read_exception    = nullptr;
+      p->read_ahead_active = false;
+
+      std::rethrow_exception(exception);
     }
   }
 
-  return res;
+  auto &block = p->prefetched.front();
+
+  p->free_buffers.emplace_back(p->af_buffer);
+
+  p->af_buffer = block.buffer;
+  p->buffer    = p->af_buffer->get_buffer();
+  p->cursor    = p->offset - block.offset;
+  p->offset    = block.offset;
+  p->fill      = block.fill;
+
+  if (block.short_read)
+    p->eof = true;
+
+  p->prefetched.pop_front();
+
+  lock.unlock();
+  p->condition.notify_all();
+
+  return true;
+}
+
+void
+mm_read_buffer_io_c::start_read_ahead_thread() {
+  auto p = p_func();
+
+  if (!p->num_read_ahead_buffers)
+    return;
+
+  p->file_size = p->proxy_io->get_size();
+
+  for (auto idx = 0u; idx < p->num_read_ahead_buffers; ++idx)
+    p->free_buffers.emplace_back(memory_c::alloc(p->af_buffer->get_size()));
+
+  auto file_io = dynamic_cast<mm_file_io_c *>(p->proxy_io.get());
+  if (file_io)
+    file_io->advise_sequential_reading();
+
+  p->reader = std::thread{[this]() { run_read_ahead(); }};
+}
+
+void
+mm_read_buffer_io_c::stop_read_ahead_thread() {
+  auto p = p_func();
+
+  if (!p->reader.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock{p->mutex};
+    p->quit = true;
+  }
+
+  p->condition.notify_all();
+  p->reader.join();
+
+  for (auto const &block : p->prefetched)
+    p->free_buffers.emplace_back(block.buffer);
+
+  p->prefetched.clear();
+  p->read_ahead_active = false;
+}
+
+void
+mm_read_buffer_io_c::cancel_read_ahead(std::unique_lock<std::mutex> &lock) {
+  auto p = p_func();
+
+  p->read_ahead_active = false;
+  p->condition.wait(lock, [p]() { return !p->reading; });
+
+  for (auto const &block : p->prefetched)
+    p->free_buffers.emplace_back(block.buffer);
+
+  p->prefetched.clear();
+  p->read_exception = nullptr;
+}
+
+void
+mm_read_buffer_io_c::restart_read_ahead(std::unique_lock<std::mutex> &lock,
+                                        int64_t offset) {
+  auto p = p_func();
+
+  cancel_read_ahead(lock);
+
+  mxdebug_if(s_debug_seek, fmt::format("read-ahead restarted at {0}\n", offset));
+
+  p->next_read_offset  = offset;
+  p->exhausted         = offset >= p->file_size;
+  p->read_ahead_active = true;
+
+  p->condition.notify_all();
+}
+
+void
+mm_read_buffer_io_c::run_read_ahead() {
+  auto p       = p_func();
+  auto file_io = dynamic_cast<mm_file_io_c *>(p->proxy_io.get());
+
+  std::unique_lock<std::mutex> lock{p->mutex};
+
+  while (true) {
+    p->condition.wait(lock, [p]() { return p->quit || (p->read_ahead_active && !p->exhausted && !p->free_buffers.empty()); });
+
+    if (p->quit)
+      return;
+
+    auto buffer   = p->free_buffers.back();
+    auto position = p->next_read_offset;
+    auto to_read  = static_cast<std::size_t>(std::min<int64_t>(p->file_size - position, buffer->get_size()));
+    p->reading    = true;
+
+    p->free_buffers.pop_back();
+
+    lock.unlock();
+
+    auto num_read = std::size_t{};
+    std::exception_ptr exception;
+
+    try {
+      if (static_cast<int64_t>(p->proxy_io->getFilePointer()) != position)
+        p->proxy_io->setFilePointer(position);
+
+      // Let the OS start reading the blocks after the ones we're
+      // about to read.
+      if (file_io)
+        file_io->prefetch(position + to_read, p->num_read_ahead_buffers * buffer->get_size());
+
+      num_read = p->proxy_io->read(buffer->get_buffer(), to_read);
+
+      mxdebug_if(s_debug_read, fmt::format("read-ahead from position {2} for {0} returned {1}\n", to_read, num_read, position));
+
+    } catch (...) {
+      exception = std::current_exception();
+    }
+
+    lock.lock();
+
+    p->reading = false;
+
+    if (!p->read_ahead_active)
+      // Cancelled while reading.
+      p->free_buffers.emplace_back(buffer);
+
+    else if (exception) {
+      p->read_exception = exception;
+      p->exhausted      = true;
+      p->free_buffers.emplace_back(buffer);
+
+    } else {
+      if (num_read)
+        p->prefetched.push_back({ buffer, position, num_read, num_read != to_read });
+      else
+        p->free_buffers.emplace_back(buffer);
+
+      p->next_read_offset += num_read;
+      p->exhausted         = (num_read != to_read) || (p->next_read_offset >= p->file_size);
+    }
+
+    p->condition.notify_all();
+  }
 }
 
 size_t
@@ -168,6 +414,14 @@ void
 mm_read_buffer_io_c::enable_buffering(bool enable) {
   auto p = p_func();
 
+  if (!enable && p->reader.joinable()) {
+    // Reading directly from the underlying file from now on; it must
+    // be positioned where the caller expects it to be.
+    auto position = getFilePointer();
+    stop_read_ahead_thread();
+    p->proxy_io->setFilePointer(position);
+  }
+
   p->buffering = enable;
   if (!p->buffering) {
     p->offset = 0;
@@ -183,6 +437,26 @@ mm_read_buffer_io_c::set_buffer_size(std::size_t new_buffer_size) {
   if (new_buffer_size == p->af_buffer->get_size())
     return;
 
+  if (p->reader.joinable()) {
+    std::unique_lock<std::mutex> lock{p->mutex};
+
+    cancel_read_ahead(lock);
+
+    auto previous_pos = getFilePointer();
+
+    p->af_buffer->resize(new_buffer_size);
+    p->buffer = p->af_buffer->get_buffer();
+
+    for (auto const &buffer : p->free_buffers)
+      buffer->resize(new_buffer_size);
+
+    p->offset = previous_pos;
+    p->cursor = 0;
+    p->fill   = 0;
+
+    return;
+  }
+
   p->af_buffer->resize(new_buffer_size);
   p->buffer = p->af_buffer->get_buffer();
 
@@ -197,6 +471,12 @@ mm_read_buffer_io_c::set_buffer_size(std::size_t new_buffer_size) {
   p->proxy_io->setFilePointer(previous_pos);
 }
 
+std::size_t
+mm_read_buffer_io_c::get_buffer_size()
+  const {
+  return p_func()->af_buffer->get_size();
+}
+
 bool
 mm_read_buffer_io_c::eof() {
   return p_func()->eof;
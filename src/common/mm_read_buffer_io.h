@@ -26,7 +26,13 @@ protected:
   explicit mm_read_buffer_io_c(mm_read_buffer_io_private_c &p);
 
 public:
-  mm_read_buffer_io_c(mm_io_cptr const &in, std::size_t buffer_size = 1 << 17);
+  // If "num_read_ahead_buffers" is not 0 then a background thread
+  // keeps reading up to that many blocks following the current
+  // one. Seeking doesn't touch the underlying file; if the new
+  // position isn't covered by the blocks read so far the read-ahead
+  // is restarted there. The file size is determined once and must not
+  // change afterwards.
+  mm_read_buffer_io_c(mm_io_cptr const &in, std::size_t buffer_size = 1 << 17, std::size_t num_read_ahead_buffers = 0);
   virtual ~mm_read_buffer_io_c();
 
   virtual uint64 getFilePointer();
@@ -36,8 +42,19 @@ public:
   virtual void clear_eof();
   virtual void enable_buffering(bool enable);
   virtual void set_buffer_size(std::size_t new_buffer_size = 1 << 17);
+  virtual std::size_t get_buffer_size() const;
+  virtual void close();
 
 protected:
   virtual uint32 _read(void *buffer, size_t size);
   virtual size_t _write(const void *buffer, size_t size);
+
+  bool refill_buffer();
+  bool refill_buffer_from_read_ahead();
+
+  void start_read_ahead_thread();
+  void stop_read_ahead_thread();
+  void cancel_read_ahead(std::unique_lock<std::mutex> &lock);
+  void restart_read_ahead(std::unique_lock<std::mutex> &lock, int64_t offset);
+  void run_read_ahead();
 };
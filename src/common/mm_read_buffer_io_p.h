@@ -13,6 +13,11 @@
 
 #include "common/common_pch.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #include "common/mm_proxy_io_p.h"
 
 class mm_read_buffer_io_c;
@@ -27,12 +32,34 @@ public:
   int64_t offset{};
   bool buffering{true};
 
+  // Read-ahead: "reader" reads the blocks following "next_read_offset"
+  // into "free_buffers" and appends them to "prefetched". While
+  // "reader" exists only it touches "proxy_io".
+  struct prefetched_t {
+    memory_cptr buffer;
+    int64_t offset{};
+    std::size_t fill{};
+    bool short_read{};
+  };
+
+  std::size_t const num_read_ahead_buffers{};
+  std::deque<prefetched_t> prefetched;
+  std::vector<memory_cptr> free_buffers;
+  int64_t next_read_offset{}, file_size{};
+  bool read_ahead_active{}, reading{}, exhausted{}, quit{};
+  std::exception_ptr read_exception;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::thread reader;
+
   explicit mm_read_buffer_io_private_c(mm_io_cptr const &proxy_io,
-                                       std::size_t buffer_size)
+                                       std::size_t buffer_size,
+                                       std::size_t p_num_read_ahead_buffers = 0)
     : mm_proxy_io_private_c{proxy_io}
     , af_buffer{memory_c::alloc(buffer_size)}
     , buffer{af_buffer->get_buffer()}
     , offset{static_cast<int64_t>(proxy_io->getFilePointer())}
+    , num_read_ahead_buffers{p_num_read_ahead_buffers}
   {
   }
 };
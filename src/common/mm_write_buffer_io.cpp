@@ -25,9 +25,11 @@ debugging_option_c s_debug_seek{"write_buffer_io|write_buffer_io_seek"}, s_debug
 }
 
 mm_write_buffer_io_c::mm_write_buffer_io_c(mm_io_cptr const &out,
-                                           std::size_t buffer_size)
-  : mm_proxy_io_c{*new mm_write_buffer_io_private_c{out, buffer_size}}
+                                           std::size_t buffer_size,
+                                           std::size_t num_async_buffers)
+  : mm_proxy_io_c{*new mm_write_buffer_io_private_c{out, buffer_size, num_async_buffers}}
 {
+  start_writer_thread();
 }
 
 mm_write_buffer_io_c::mm_write_buffer_io_c(mm_write_buffer_io_private_c &p)
@@ -41,18 +43,28 @@ mm_write_buffer_io_c::~mm_write_buffer_io_c() {
 
 mm_io_cptr
 mm_write_buffer_io_c::open(const std::string &file_name,
-                           size_t buffer_size) {
-  return std::make_shared<mm_write_buffer_io_c>(std::make_shared<mm_file_io_c>(file_name, MODE_CREATE), buffer_size);
+                           size_t buffer_size,
+                           std::size_t num_async_buffers) {
+  return std::make_shared<mm_write_buffer_io_c>(std::make_shared<mm_file_io_c>(file_name, MODE_CREATE), buffer_size, num_async_buffers);
 }
 
 uint64
 mm_write_buffer_io_c::getFilePointer() {
-  return mm_proxy_io_c::getFilePointer() + p_func()->fill;
+  auto p = p_func();
+
+  return (p->num_async_buffers ? p->async_file_pos : mm_proxy_io_c::getFilePointer()) + p->fill;
 }
 
 void
 mm_write_buffer_io_c::setFilePointer(int64 offset,
                                      libebml::seek_mode mode) {
+  auto p = p_func();
+
+  // The size of the underlying file is only accurate once all queued
+  // buffers have been written.
+  if (p->num_async_buffers && (libebml::seek_end == mode))
+    flush_buffer();
+
   int64_t new_pos
     = libebml::seek_beginning == mode ? offset
     : libebml::seek_end       == mode ? p_func()->proxy_io->get_size() + offset // offsets from the end are negative already
@@ -69,6 +81,9 @@ mm_write_buffer_io_c::setFilePointer(int64 offset,
   }
 
   mm_proxy_io_c::setFilePointer(offset, mode);
+
+  if (p->num_async_buffers)
+    p->async_file_pos = mm_proxy_io_c::getFilePointer();
 }
 
 void
@@ -84,15 +99,29 @@ mm_write_buffer_io_c::close() {
 
 void
 mm_write_buffer_io_c::close_write_buffer_io() {
-  flush_buffer();
+  try {
+    flush_buffer();
+  } catch (...) {
+    stop_writer_thread();
+    throw;
+  }
+
+  stop_writer_thread();
   mm_proxy_io_c::close();
 }
 
 uint32
 mm_write_buffer_io_c::_read(void *buffer,
                             size_t size) {
+  auto p = p_func();
+
   flush_buffer();
-  return mm_proxy_io_c::_read(buffer, size);
+  auto num_read = mm_proxy_io_c::_read(buffer, size);
+
+  if (p->num_async_buffers)
+    p->async_file_pos = mm_proxy_io_c::getFilePointer();
+
+  return num_read;
 }
 
 size_t
@@ -104,6 +133,25 @@ mm_write_buffer_io_c::_write(const void *buffer,
   const char *buf = static_cast<const char *>(buffer);
   size_t remain   = size;
 
+  if (p->num_async_buffers) {
+    // The caller's buffer may be reused as soon as we return, so
+    // everything must be copied.
+    while (remain) {
+      avail = std::min(remain, p->size - p->fill);
+      memcpy(p->buffer + p->fill, buf, avail);
+      p->fill += avail;
+      remain  -= avail;
+      buf     += avail;
+
+      if (p->fill == p->size)
+        queue_buffer();
+    }
+
+    p->cached_size = -1;
+
+    return size;
+  }
+
   // whole blocks
   while (remain >= (avail = p->size - p->fill)) {
     if (p->fill) {
@@ -140,6 +188,12 @@ void
 mm_write_buffer_io_c::flush_buffer() {
   auto p = p_func();
 
+  if (p->num_async_buffers) {
+    queue_buffer();
+    wait_for_writer();
+    return;
+  }
+
   if (!p->fill)
     return;
 
@@ -155,5 +209,153 @@ mm_write_buffer_io_c::flush_buffer() {
 
 void
 mm_write_buffer_io_c::discard_buffer() {
-  p_func()->fill = 0;
+  auto p  = p_func();
+  p->fill = 0;
+
+  if (!p->num_async_buffers)
+    return;
+
+  std::unique_lock<std::mutex> lock{p->mutex};
+
+  for (auto const &queued : p->queued_buffers)
+    p->free_buffers.emplace_back(queued.first);
+
+  p->queued_buffers.clear();
+
+  // A buffer that's being written cannot be discarded anymore. Once
+  // it's done the underlying file position is where the discarded
+  // buffers would have started.
+  p->condition.wait(lock, [p]() { return !p->writing; });
+
+  p->write_exception = nullptr;
+  p->async_file_pos  = mm_proxy_io_c::getFilePointer();
+}
+
+void
+mm_write_buffer_io_c::start_writer_thread() {
+  auto p = p_func();
+
+  if (!p->num_async_buffers)
+    return;
+
+  for (auto idx = 1u; idx < p->num_async_buffers; ++idx)
+    p->free_buffers.emplace_back(memory_c::alloc(p->size));
+
+  p->async_file_pos = mm_proxy_io_c::getFilePointer();
+  p->writer         = std::thread{[this]() { run_writer(); }};
+}
+
+void
+mm_write_buffer_io_c::stop_writer_thread() {
+  auto p = p_func();
+
+  if (!p->writer.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock{p->mutex};
+    p->quit = true;
+  }
+
+  p->condition.notify_all();
+  p->writer.join();
+}
+
+void
+mm_write_buffer_io_c::queue_buffer() {
+  auto p = p_func();
+
+  if (!p->fill)
+    return;
+
+  std::unique_lock<std::mutex> lock{p->mutex};
+
+  p->queued_buffers.emplace_back(p->af_buffer, p->fill);
+  p->async_file_pos += p->fill;
+  p->fill            = 0;
+
+  p->condition.notify_all();
+  p->condition.wait(lock, [p]() { return !p->free_buffers.empty(); });
+
+  p->af_buffer = p->free_buffers.back();
+  p->buffer    = p->af_buffer->get_buffer();
+  p->free_buffers.pop_back();
+
+  if (!p->write_exception)
+    return;
+
+  auto exception     = p->write_exception;
+  p->write_exception = nullptr;
+
+  std::rethrow_exception(exception);
+}
+
+void
+mm_write_buffer_io_c::wait_for_writer() {
+  auto p = p_func();
+
+  std::unique_lock<std::mutex> lock{p->mutex};
+
+  p->condition.wait(lock, [p]() { return p->queued_buffers.empty() && !p->writing; });
+
+  if (!p->write_exception)
+    return;
+
+  auto exception     = p->write_exception;
+  p->write_exception = nullptr;
+
+  std::rethrow_exception(exception);
+}
+
+void
+mm_write_buffer_io_c::run_writer() {
+  auto p = p_func();
+
+  while (true) {
+    std::pair<memory_cptr, std::size_t> job;
+
+    {
+      std::unique_lock<std::mutex> lock{p->mutex};
+
+      p->condition.wait(lock, [p]() { return p->quit || !p->queued_buffers.empty(); });
+
+      if (p->queued_buffers.empty())
+        return;
+
+      job = p->queued_buffers.front();
+      p->queued_buffers.pop_front();
+      p->writing = true;
+    }
+
+    try {
+      auto written = p->proxy_io->write(job.first->get_buffer(), job.second);
+
+      mxdebug_if(s_debug_write, fmt::format("writer thread at {0} for {1} written {2}\n", p->proxy_io->getFilePointer() - written, job.second, written));
+
+      if (written != job.second)
+        throw mtx::mm_io::insufficient_space_x();
+
+    } catch (...) {
+      // Everything queued after a failed write is dropped; the error
+      // is reported to the main thread by the next queue_buffer() or
+      // wait_for_writer().
+      std::lock_guard<std::mutex> lock{p->mutex};
+
+      p->write_exception = std::current_exception();
+
+      for (auto const &queued : p->queued_buffers)
+        p->free_buffers.emplace_back(queued.first);
+
+      p->queued_buffers.clear();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{p->mutex};
+
+      p->free_buffers.emplace_back(job.first);
+      p->writing = false;
+    }
+
+    p->condition.notify_all();
+  }
 }
@@ -26,7 +26,13 @@ protected:
   explicit mm_write_buffer_io_c(mm_write_buffer_io_private_c &p);
 
 public:
-  mm_write_buffer_io_c(mm_io_cptr const &out, std::size_t buffer_size);
+  // If "num_async_buffers" is not 0 then full buffers are written by
+  // a background thread while the caller continues filling the next
+  // one of the ring of "num_async_buffers" buffers. Operations that
+  // need the underlying file to be up to date (seeking, reading,
+  // flushing, closing) wait until all queued buffers have been
+  // written.
+  mm_write_buffer_io_c(mm_io_cptr const &out, std::size_t buffer_size, std::size_t num_async_buffers = 0);
   virtual ~mm_write_buffer_io_c();
 
   virtual uint64 getFilePointer();
@@ -35,11 +41,17 @@ public:
   virtual void close();
   virtual void discard_buffer();
 
-  static mm_io_cptr open(const std::string &file_name, size_t buffer_size);
+  static mm_io_cptr open(const std::string &file_name, size_t buffer_size, std::size_t num_async_buffers = 0);
 
 protected:
   virtual uint32 _read(void *buffer, size_t size);
   virtual size_t _write(const void *buffer, size_t size);
   void flush_buffer();
   void close_write_buffer_io();
+
+  void start_writer_thread();
+  void stop_writer_thread();
+  void queue_buffer();
+  void wait_for_writer();
+  void run_writer();
 };
@@ -13,6 +13,11 @@
 
 #include "common/common_pch.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #include "common/mm_proxy_io_p.h"
 
 class mm_write_buffer_io_c;
@@ -24,12 +29,27 @@ public:
   std::size_t fill{};
   std::size_t const size{};
 
+  // Asynchronous writing: full buffers are queued and written by
+  // "writer" in order. The main thread only touches "proxy_io" once
+  // the queue has been drained.
+  std::size_t const num_async_buffers{};
+  std::deque<std::pair<memory_cptr, std::size_t>> queued_buffers;
+  std::vector<memory_cptr> free_buffers;
+  uint64_t async_file_pos{};
+  bool writing{}, quit{};
+  std::exception_ptr write_exception;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::thread writer;
+
   explicit mm_write_buffer_io_private_c(mm_io_cptr const &p_proxy_io,
-                                        std::size_t p_buffer_size)
+                                        std::size_t p_buffer_size,
+                                        std::size_t p_num_async_buffers = 0)
     : mm_proxy_io_private_c{p_proxy_io}
     , af_buffer{memory_c::alloc(p_buffer_size)}
     , buffer{af_buffer->get_buffer()}
     , size{p_buffer_size}
+    , num_async_buffers{p_num_async_buffers ? std::max<std::size_t>(p_num_async_buffers, 2) : 0}
   {
   }
 };
@@ -21,33 +21,33 @@ namespace mtx::mpeg {
 
 memory_cptr
 nalu_to_rbsp(memory_cptr const &buffer) {
-  mm_mem_io_cptr d;
-  auto b = buffer->get_buffer();
+  auto src  = static_cast<unsigned char const *>(buffer->get_buffer());
+  auto end  = src + buffer->get_size();
+  auto next = find_00_00_xx(src, end, 0x03);
 
-  for (int pos = 0, size = buffer->get_size(); pos < size; ++pos) {
-    if (   ((pos + 2) < size)
-        && (0 == b[pos])
-        && (0 == b[pos + 1])
-        && (3 == b[pos + 2])) {
+  if (next == end)
+    return buffer;
 
-      if (!d) {
-        d = std::make_shared<mm_mem_io_c>(nullptr, size, 100);
-        if (pos > 0)
-          d->write(b, pos);
-      }
+  auto rbsp = memory_c::alloc(buffer->get_size());
+  auto dest = rbsp->get_buffer();
 
-      d->write_uint8(0);
-      d->write_uint8(0);
-      pos += 2;
+  // Copy everything up to and including the two zero bytes, then
+  // skip the emulation prevention byte.
+  do {
+    auto num_bytes = next + 2 - src;
+    std::memcpy(dest, src, num_bytes);
 
-    } else if (d)
-      d->write_uint8(b[pos]);
-  }
+    dest += num_bytes;
+    src   = next + 3;
+    next  = find_00_00_xx(src, end, 0x03);
+  } while (next != end);
 
-  if (!d)
-    return buffer;
+  std::memcpy(dest, src, end - src);
+  dest += end - src;
+
+  rbsp->set_size(dest - rbsp->get_buffer());
 
-  return d->get_and_lock_buffer();
+  return rbsp;
 }
 
 memory_cptr
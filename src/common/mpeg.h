@@ -40,6 +40,33 @@ public:
   }
 };
 
+enum class scanner_implementation_e {
+  scalar,
+  sse2,
+  avx2,
+};
+
+// Returns a pointer to the first occurrence of the three bytes `00
+// 00 third_byte` lying completely within [begin, end) or `end` if
+// there's none. Uses the fastest implementation the CPU supports.
+unsigned char const *find_00_00_xx(unsigned char const *begin, unsigned char const *end, unsigned char third_byte);
+
+inline unsigned char const *
+find_start_code(unsigned char const *begin,
+                unsigned char const *end) {
+  return find_00_00_xx(begin, end, 0x01);
+}
+
+inline unsigned char *
+find_start_code(unsigned char *begin,
+                unsigned char *end) {
+  return const_cast<unsigned char *>(find_00_00_xx(begin, end, 0x01));
+}
+
+// Only meant for tests and benchmarks.
+std::vector<scanner_implementation_e> get_available_scanner_implementations();
+void set_scanner_implementation(scanner_implementation_e implementation);
+
 memory_cptr nalu_to_rbsp(memory_cptr const &buffer);
 memory_cptr rbsp_to_nalu(memory_cptr const &buffer);
 
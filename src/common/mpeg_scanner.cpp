@@ -0,0 +1,173 @@
+/** MPEG helper functions – start code & emulation prevention byte scanner
+
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   \author Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define MTX_X86_SCANNERS
+# include <immintrin.h>
+#endif
+
+#include "common/mpeg.h"
+
+namespace mtx::mpeg {
+
+namespace {
+
+using scanner_t = unsigned char const *(*)(unsigned char const *, unsigned char const *, unsigned char);
+
+unsigned char const *
+find_00_00_xx_scalar(unsigned char const *begin,
+                     unsigned char const *end,
+                     unsigned char third_byte) {
+  // Look at the third byte of each candidate first. Unless it is
+  // either 0 or the wanted byte no sequence can start at any of the
+  // three positions covering it.
+  auto p = begin;
+
+  while ((end - p) >= 3) {
+    if (p[2] && (p[2] != third_byte))
+      p += 3;
+
+    else if (p[1])
+      p += 2;
+
+    else if (p[0] || (p[2] != third_byte))
+      ++p;
+
+    else
+      return p;
+  }
+
+  return end;
+}
+
+#if defined(MTX_X86_SCANNERS)
+
+__attribute__((target("sse2")))
+unsigned char const *
+find_00_00_xx_sse2(unsigned char const *begin,
+                   unsigned char const *end,
+                   unsigned char third_byte) {
+  auto zero  = _mm_setzero_si128();
+  auto third = _mm_set1_epi8(static_cast<char>(third_byte));
+  auto p     = begin;
+
+  // Each iteration checks the sequences starting at the 16 positions
+  // p…p+15 and therefore needs the 18 bytes p…p+17.
+  while ((end - p) >= 18) {
+    auto bytes0 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+    auto bytes1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + 1));
+    auto bytes2 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + 2));
+    auto found  = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(bytes0, zero), _mm_cmpeq_epi8(bytes1, zero)), _mm_cmpeq_epi8(bytes2, third));
+    auto mask   = static_cast<unsigned int>(_mm_movemask_epi8(found));
+
+    if (mask)
+      return p + __builtin_ctz(mask);
+
+    p += 16;
+  }
+
+  return find_00_00_xx_scalar(p, end, third_byte);
+}
+
+__attribute__((target("avx2")))
+unsigned char const *
+find_00_00_xx_avx2(unsigned char const *begin,
+                   unsigned char const *end,
+                   unsigned char third_byte) {
+  auto zero  = _mm256_setzero_si256();
+  auto third = _mm256_set1_epi8(static_cast<char>(third_byte));
+  auto p     = begin;
+
+  while ((end - p) >= 34) {
+    auto bytes0 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p));
+    auto bytes1 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + 1));
+    auto bytes2 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + 2));
+    auto found  = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(bytes0, zero), _mm256_cmpeq_epi8(bytes1, zero)), _mm256_cmpeq_epi8(bytes2, third));
+    auto mask   = static_cast<unsigned int>(_mm256_movemask_epi8(found));
+
+    if (mask)
+      return p + __builtin_ctz(mask);
+
+    p += 32;
+  }
+
+  return find_00_00_xx_sse2(p, end, third_byte);
+}
+
+#endif  // MTX_X86_SCANNERS
+
+scanner_t
+get_scanner(scanner_implementation_e implementation) {
+#if defined(MTX_X86_SCANNERS)
+  if (scanner_implementation_e::avx2 == implementation)
+    return find_00_00_xx_avx2;
+
+  if (scanner_implementation_e::sse2 == implementation)
+    return find_00_00_xx_sse2;
+#endif
+
+  return find_00_00_xx_scalar;
+}
+
+unsigned char const *find_00_00_xx_dispatch(unsigned char const *begin, unsigned char const *end, unsigned char third_byte);
+
+// Starts out with a function that determines the implementation to
+// use on its first call so that calls from static initializers work,
+// too.
+std::atomic<scanner_t> s_scanner{find_00_00_xx_dispatch};
+
+unsigned char const *
+find_00_00_xx_dispatch(unsigned char const *begin,
+                       unsigned char const *end,
+                       unsigned char third_byte) {
+  auto scanner = get_scanner(get_available_scanner_implementations().back());
+  s_scanner.store(scanner, std::memory_order_relaxed);
+
+  return scanner(begin, end, third_byte);
+}
+
+}
+
+std::vector<scanner_implementation_e>
+get_available_scanner_implementations() {
+  std::vector<scanner_implementation_e> implementations{ scanner_implementation_e::scalar };
+
+#if defined(MTX_X86_SCANNERS)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("sse2"))
+    implementations.push_back(scanner_implementation_e::sse2);
+
+  if (__builtin_cpu_supports("sse2") && __builtin_cpu_supports("avx2"))
+    implementations.push_back(scanner_implementation_e::avx2);
+#endif
+
+  return implementations;
+}
+
+void
+set_scanner_implementation(scanner_implementation_e implementation) {
+  s_scanner.store(get_scanner(implementation), std::memory_order_relaxed);
+}
+
+unsigned char const *
+find_00_00_xx(unsigned char const *begin,
+              unsigned char const *end,
+              unsigned char third_byte) {
+  return s_scanner.load(std::memory_order_relaxed)(begin, end, third_byte);
+}
+
+}
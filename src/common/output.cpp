@@ -13,6 +13,8 @@
 
 #include "common/common_pch.h"
 
+#include <mutex>
+
 #include "common/command_line.h"
 #include "common/date_time.h"
 #include "common/debugging.h"
@@ -56,6 +58,11 @@ display_json_output(nlohmann::json json) {
   mxinfo(fmt::format("{0}\n", mtx::json::dump(json, 2)));
 }
 
+bool
+json_warnings_or_errors_emitted() {
+  return !s_warnings_emitted.empty() || !s_errors_emitted.empty();
+}
+
 static void
 json_warning_error_handler(unsigned int level,
                            std::string const &message) {
@@ -111,10 +118,13 @@ mxmsg(unsigned int level,
   static debugging_option_c s_timestamped_messages{"timestamped_messages"};
   static debugging_option_c s_memory_usage_in_messages{"memory_usage_in_messages"};
   static bool s_saw_cr_after_nl = false;
+  static std::mutex s_mutex;
 
   if (g_suppress_info && (MXMSG_INFO == level))
     return;
 
+  std::lock_guard<std::mutex> lock{s_mutex};
+
   if ('\n' == message[0]) {
     message.erase(0, 1);
     g_mm_stdio->puts("\n");
@@ -158,6 +168,9 @@ default_mxinfo(unsigned int,
 
 void
 mxinfo(std::string const &info) {
+  if (mtx::output::capture_c::defer([info]() { mxinfo(info); }))
+    return;
+
   if (s_mxmsg_info_handler)
     s_mxmsg_info_handler(MXMSG_INFO, info);
 }
@@ -183,6 +196,9 @@ default_mxwarn(unsigned int,
 
 void
 mxwarn(std::string const &warning) {
+  if (mtx::output::capture_c::defer([warning]() { mxwarn(warning); }))
+    return;
+
   if (s_mxmsg_warning_handler)
     s_mxmsg_warning_handler(MXMSG_WARNING, warning);
 }
@@ -196,6 +212,9 @@ default_mxerror(unsigned int,
 
 void
 mxerror(std::string const &error) {
+  if (mtx::output::capture_c::defer([error]() { mxerror(error); }))
+    throw mtx::output::capture_c::error_x{};
+
   if (s_mxmsg_error_handler)
     s_mxmsg_error_handler(MXMSG_ERROR, error);
 }
@@ -293,3 +312,52 @@ fourcc_to_string(uint32_t fourcc) {
 
   return std::string(reinterpret_cast<char *>(buffer), 4);
 }
+
+namespace mtx::output {
+
+static thread_local capture_c *s_active_capture{};
+
+capture_c::~capture_c() {
+  stop();
+}
+
+void
+capture_c::start() {
+  if (m_active)
+    return;
+
+  m_previous       = s_active_capture;
+  m_active         = true;
+  s_active_capture = this;
+}
+
+void
+capture_c::stop() {
+  if (!m_active)
+    return;
+
+  s_active_capture = m_previous;
+  m_previous       = nullptr;
+  m_active         = false;
+}
+
+void
+capture_c::replay() {
+  auto actions = std::move(m_actions);
+  m_actions.clear();
+
+  for (auto const &action : actions)
+    action();
+}
+
+bool
+capture_c::defer(std::function<void()> const &action) {
+  if (!s_active_capture)
+    return false;
+
+  s_active_capture->m_actions.push_back(action);
+
+  return true;
+}
+
+}
@@ -36,6 +36,7 @@ bool stdio_redirected();
 
 void redirect_warnings_and_errors_to_json();
 void display_json_output(nlohmann::json json);
+bool json_warnings_or_errors_emitted();
 
 void init_common_output(bool no_charset_detection);
 void set_cc_stdio(const std::string &charset);
@@ -65,3 +66,41 @@ void mxverb_fn(unsigned int level, const std::string &file_name, const std::stri
 void mxverb_tid(unsigned int level, const std::string &file_name, int64_t track_id, const std::string &message);
 
 std::string fourcc_to_string(uint32_t fourcc);
+
+namespace mtx::output {
+
+// While capturing is active on a thread, messages output by that
+// thread are collected instead of being shown. replay() shows them
+// later on in their original order. This allows doing work on
+// several threads while keeping the output deterministic. Code with
+// other side effects that must happen in a fixed order can defer
+// them the same way.
+class capture_c {
+public:
+  // Thrown by mxerror() on a capturing thread after the error has
+  // been recorded. It doesn't derive from mtx::exception so that
+  // readers don't handle it by accident.
+  class error_x {};
+
+private:
+  std::vector<std::function<void()>> m_actions;
+  capture_c *m_previous{};
+  bool m_active{};
+
+public:
+  capture_c() = default;
+  ~capture_c();
+
+  capture_c(capture_c const &) = delete;
+  capture_c &operator =(capture_c const &) = delete;
+
+  void start();
+  void stop();
+  void replay();
+
+  // Returns false if the calling thread isn't capturing; the caller
+  // must then do its work immediately.
+  static bool defer(std::function<void()> const &action);
+};
+
+}
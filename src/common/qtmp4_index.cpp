@@ -0,0 +1,162 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   compact sample index for the Quicktime & MP4 reader
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/qtmp4_index.h"
+
+namespace {
+
+void
+put_varint(std::vector<unsigned char> &buffer,
+           int64_t signed_value) {
+  // Zigzag encoding so that small negative differences are short, too.
+  auto value = (static_cast<uint64_t>(signed_value) << 1) ^ static_cast<uint64_t>(signed_value >> 63);
+
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+
+  buffer.push_back(static_cast<unsigned char>(value));
+}
+
+int64_t
+get_varint(std::vector<unsigned char> const &buffer,
+           std::size_t &pos) {
+  uint64_t value = 0;
+  auto shift     = 0u;
+
+  while (buffer[pos] & 0x80) {
+    value |= static_cast<uint64_t>(buffer[pos++] & 0x7f) << shift;
+    shift += 7;
+  }
+
+  value |= static_cast<uint64_t>(buffer[pos++]) << shift;
+
+  return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+}
+
+qt_index_t
+qt_index_c::operator [](std::size_t idx)
+  const {
+  assert((idx < m_size) && ((idx / s_entries_per_block) >= m_num_released_blocks));
+
+  if (   !m_cursor_valid
+      || (idx < m_cursor_idx)
+      || ((idx / s_entries_per_block) != (m_cursor_idx / s_entries_per_block))) {
+    m_cursor_idx   = idx - idx % s_entries_per_block;
+    m_cursor_byte  = 0;
+    m_cursor_entry = qt_index_t{};
+    m_cursor_valid = true;
+
+    decode_next();
+  }
+
+  while (m_cursor_idx < idx) {
+    ++m_cursor_idx;
+    decode_next();
+  }
+
+  auto entry         = m_cursor_entry;
+  entry.timestamp   += m_timestamp_offset;
+  entry.is_keyframe  = m_keyframes[idx];
+
+  return entry;
+}
+
+void
+qt_index_c::decode_next()
+  const {
+  // Decodes the entry m_cursor_idx; m_cursor_entry holds the previous
+  // entry of the same block or all zeros at the start of a block.
+  auto const &block = m_blocks[m_cursor_idx / s_entries_per_block];
+  auto &entry       = m_cursor_entry;
+
+  entry.file_pos    = entry.file_pos  + entry.size     + get_varint(block, m_cursor_byte);
+  entry.size        =                                    get_varint(block, m_cursor_byte);
+  entry.timestamp   = entry.timestamp + entry.duration + get_varint(block, m_cursor_byte);
+  entry.duration    = entry.duration                   + get_varint(block, m_cursor_byte);
+}
+
+void
+qt_index_c::push_back(qt_index_t const &entry) {
+  if (!(m_size % s_entries_per_block)) {
+    if (!m_blocks.empty())
+      m_blocks.back().shrink_to_fit();
+
+    m_blocks.emplace_back();
+    m_blocks.back().reserve(s_entries_per_block * 4);
+    m_last_added = qt_index_t{};
+  }
+
+  auto &block    = m_blocks.back();
+  auto timestamp = entry.timestamp - m_timestamp_offset;
+
+  put_varint(block, entry.file_pos - m_last_added.file_pos  - m_last_added.size);
+  put_varint(block, entry.size);
+  put_varint(block, timestamp      - m_last_added.timestamp - m_last_added.duration);
+  put_varint(block, entry.duration - m_last_added.duration);
+
+  m_last_added = qt_index_t{entry.file_pos, entry.size, timestamp, entry.duration, false};
+
+  m_keyframes.push_back(entry.is_keyframe);
+  ++m_size;
+}
+
+void
+qt_index_c::set_keyframe(std::size_t idx) {
+  m_keyframes[idx] = true;
+}
+
+void
+qt_index_c::adjust_timestamps(int64_t delta) {
+  m_timestamp_offset += delta;
+}
+
+void
+qt_index_c::release_before(std::size_t idx) {
+  // Only blocks whose entries all precede idx are released. The block
+  // new entries are appended to is never among them.
+  auto num_blocks = std::min(idx, m_size) / s_entries_per_block;
+
+  for (; m_num_released_blocks < num_blocks; ++m_num_released_blocks)
+    std::vector<unsigned char>{}.swap(m_blocks[m_num_released_blocks]);
+
+  if (m_cursor_valid && ((m_cursor_idx / s_entries_per_block) < m_num_released_blocks))
+    m_cursor_valid = false;
+}
+
+void
+qt_index_c::clear() {
+  m_blocks.clear();
+  m_keyframes.clear();
+  m_size                = 0;
+  m_num_released_blocks = 0;
+  m_timestamp_offset    = 0;
+  m_last_added          = qt_index_t{};
+  m_cursor_valid        = false;
+}
+
+std::size_t
+qt_index_c::get_memory_usage()
+  const {
+  auto usage = m_blocks.capacity() * sizeof(m_blocks[0]) + m_keyframes.capacity() / 8;
+
+  for (auto const &block : m_blocks)
+    usage += block.capacity();
+
+  return usage;
+}
@@ -0,0 +1,90 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   compact sample index for the Quicktime & MP4 reader
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+struct qt_index_t {
+  int64_t file_pos, size;
+  int64_t timestamp, duration;
+  bool    is_keyframe;
+
+  qt_index_t()
+    : file_pos{}
+    , size{}
+    , timestamp{}
+    , duration{}
+    , is_keyframe{}
+  {
+  };
+
+  qt_index_t(int64_t p_file_pos, int64_t p_size, int64_t p_timestamp, int64_t p_duration, bool p_is_keyframe)
+    : file_pos{p_file_pos}
+    , size{p_size}
+    , timestamp{p_timestamp}
+    , duration{p_duration}
+    , is_keyframe{p_is_keyframe}
+  {
+  }
+};
+
+// Stores the index entries of a track with a couple of bytes per
+// entry instead of the 40 bytes of a qt_index_t. Entries are grouped
+// into blocks. Within a block each entry is stored as variable-length
+// differences to what the previous entry predicts: the position right
+// after the previous frame, a timestamp right after the previous
+// frame ends and the same duration. Most entries therefore only
+// require the bytes for their size.
+//
+// Entries can only be appended. Reading them in order is cheap as the
+// position of the last entry read is cached; random access decodes at
+// most one block. Blocks containing entries that have already been
+// processed can be released.
+class qt_index_c {
+public:
+  static constexpr std::size_t s_entries_per_block = 256;
+
+protected:
+  std::vector<std::vector<unsigned char>> m_blocks;
+  std::vector<bool> m_keyframes;
+  std::size_t m_size{}, m_num_released_blocks{};
+  int64_t m_timestamp_offset{};
+  qt_index_t m_last_added;
+
+  mutable std::size_t m_cursor_idx{}, m_cursor_byte{};
+  mutable qt_index_t m_cursor_entry;
+  mutable bool m_cursor_valid{};
+
+public:
+  std::size_t size() const {
+    return m_size;
+  }
+
+  bool empty() const {
+    return !m_size;
+  }
+
+  qt_index_t operator [](std::size_t idx) const;
+
+  void push_back(qt_index_t const &entry);
+  void set_keyframe(std::size_t idx);
+  void adjust_timestamps(int64_t delta);
+  void release_before(std::size_t idx);
+  void clear();
+
+  std::size_t get_memory_usage() const;
+
+protected:
+  void decode_next() const;
+};
@@ -0,0 +1,134 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   coalesced reads of frames for the Quicktime & MP4 reader
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/qtmp4_read_ahead.h"
+
+namespace mtx::qtmp4 {
+
+read_ahead_c::read_ahead_c(int64_t max_span_size,
+                           int64_t max_gap,
+                           int64_t max_queued_size)
+  : m_max_span_size{max_span_size}
+  , m_max_gap{max_gap}
+  , m_max_queued_size{max_queued_size}
+{
+}
+
+read_ahead_c::plan_t
+read_ahead_c::plan(std::size_t track,
+                   std::size_t num_tracks,
+                   frame_lookup_t const &lookup)
+  const {
+  plan_t plan;
+
+  auto first = lookup(track, get_num_queued(track));
+  if (!first || (first->size >= m_max_span_size))
+    return plan;
+
+  auto start = first->file_pos;
+  auto end   = first->file_pos + first->size;
+
+  // Number of frames per track handed out, queued or planned so far
+  std::vector<std::size_t> num_used;
+  for (auto idx = 0u; idx < num_tracks; ++idx)
+    num_used.push_back(get_num_queued(idx));
+
+  plan.frames.push_back({ track, 0, first->size });
+  ++num_used[track];
+
+  while ((m_queued_size + (end - start)) < m_max_queued_size) {
+    std::optional<std::size_t> best_track;
+    int64_t best_file_pos{};
+
+    for (auto idx = 0u; idx < num_used.size(); ++idx) {
+      auto candidate = lookup(idx, num_used[idx]);
+
+      if (   !candidate
+          || (candidate->file_pos < end)
+          || (candidate->file_pos > (end + m_max_gap))
+          || ((candidate->file_pos + candidate->size - start) > m_max_span_size))
+        continue;
+
+      if (!best_track || (candidate->file_pos < best_file_pos)) {
+        best_track    = idx;
+        best_file_pos = candidate->file_pos;
+      }
+    }
+
+    if (!best_track)
+      break;
+
+    auto next = *lookup(*best_track, num_used[*best_track]);
+
+    plan.frames.push_back({ *best_track, next.file_pos - start, next.size });
+    end = next.file_pos + next.size;
+    ++num_used[*best_track];
+  }
+
+  if (plan.frames.size() < 2) {
+    plan.frames.clear();
+    return plan;
+  }
+
+  plan.start = start;
+  plan.size  = end - start;
+
+  return plan;
+}
+
+void
+read_ahead_c::queue(plan_t const &plan,
+                    memory_cptr const &buffer) {
+  auto span = std::make_shared<span_t>(span_t{ plan.size, plan.frames.size() });
+
+  m_queued_size += plan.size;
+
+  for (auto const &frame : plan.frames) {
+    if (frame.track >= m_queues.size())
+      m_queues.resize(frame.track + 1);
+
+    m_queues[frame.track].push_back({ memory_c::borrow(buffer->get_buffer() + frame.offset, frame.size, buffer), span });
+  }
+}
+
+memory_cptr
+read_ahead_c::get(std::size_t track) {
+  if (!get_num_queued(track))
+    return {};
+
+  auto &queue = m_queues[track];
+  auto frame  = queue.front();
+
+  queue.pop_front();
+
+  if (!--frame.span->num_queued)
+    m_queued_size -= frame.span->size;
+
+  return frame.data;
+}
+
+std::size_t
+read_ahead_c::get_num_queued(std::size_t track)
+  const {
+  return track < m_queues.size() ? m_queues[track].size() : 0;
+}
+
+int64_t
+read_ahead_c::get_queued_size()
+  const {
+  return m_queued_size;
+}
+
+}
@@ -0,0 +1,91 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   coalesced reads of frames for the Quicktime & MP4 reader
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+namespace mtx::qtmp4 {
+
+// Badly interleaved files would require one seek per frame. Instead
+// the frames of all tracks being read that follow each other in the
+// file are read with a single read ("span"), and each track is handed
+// slices of that buffer without copying.
+//
+// A slice keeps its whole span alive. Therefore the full size of a
+// span is charged against the limit until the last of its slices has
+// been handed out, no matter how small the slices of a track lagging
+// behind are.
+class read_ahead_c {
+public:
+  // Default limits: the size of a span, the size of unused data
+  // between frames (e.g. frames of tracks not being read) and the
+  // total size of all spans with frames not handed out yet.
+  static constexpr int64_t s_max_span_size   =  4 * 1024 * 1024;
+  static constexpr int64_t s_max_gap         = 64 * 1024;
+  static constexpr int64_t s_max_queued_size = 32 * 1024 * 1024;
+
+  struct frame_position_t {
+    int64_t file_pos{}, size{};
+  };
+
+  // Returns the position of the num-th frame of a track after the ones
+  // already handed out by get() or nothing if the track isn't read or
+  // has no such frame.
+  using frame_lookup_t = std::function<std::optional<frame_position_t>(std::size_t track, std::size_t num)>;
+
+  struct planned_frame_t {
+    std::size_t track{};
+    int64_t offset{}, size{};
+  };
+
+  struct plan_t {
+    int64_t start{}, size{};
+    std::vector<planned_frame_t> frames;
+  };
+
+protected:
+  struct span_t {
+    int64_t size{};
+    std::size_t num_queued{};
+  };
+
+  struct queued_frame_t {
+    memory_cptr data;
+    std::shared_ptr<span_t> span;
+  };
+
+  std::vector<std::deque<queued_frame_t>> m_queues;
+  int64_t m_max_span_size, m_max_gap, m_max_queued_size, m_queued_size{};
+
+public:
+  read_ahead_c(int64_t max_span_size = s_max_span_size, int64_t max_gap = s_max_gap, int64_t max_queued_size = s_max_queued_size);
+
+  // Collects the next frame of "track" and the frames of all
+  // "num_tracks" tracks following it in the file with gaps of at most
+  // max_gap bytes as long as the span and the total of all spans
+  // queued stay within their limits. The plan is empty if fewer than
+  // two frames would be read.
+  plan_t plan(std::size_t track, std::size_t num_tracks, frame_lookup_t const &lookup) const;
+
+  // Queues the frames of a plan; "buffer" contains the plan's span.
+  void queue(plan_t const &plan, memory_cptr const &buffer);
+
+  // Returns the next queued frame of a track or nothing.
+  memory_cptr get(std::size_t track);
+
+  std::size_t get_num_queued(std::size_t track) const;
+  int64_t get_queued_size() const;
+};
+
+}
@@ -0,0 +1,117 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   tournament tree for k-way merging
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+namespace mtx {
+
+// A tournament tree over a fixed number of slots. Each slot is either
+// empty or holds a key. The slot with the smallest key wins; if
+// several slots hold the same key the one with the lowest index
+// wins. This is exactly the result a linear scan with a strict "<"
+// comparison would yield.
+//
+// Changing a single slot costs O(log n); determining the winner is
+// O(1).
+template<typename Tkey, typename Tcompare = std::less<Tkey>>
+class tournament_tree_c {
+public:
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+protected:
+  std::vector<std::optional<Tkey>> m_keys;
+  std::vector<std::size_t> m_winners;
+  std::size_t m_num_leaves{};
+  Tcompare m_compare;
+
+public:
+  tournament_tree_c(std::size_t num_slots = 0) {
+    reset(num_slots);
+  }
+
+  void
+  reset(std::size_t num_slots) {
+    m_num_leaves = 1;
+    while (m_num_leaves < num_slots)
+      m_num_leaves *= 2;
+
+    m_keys.clear();
+    m_keys.resize(num_slots);
+
+    // Inner nodes are stored in [1, m_num_leaves), leaves in
+    // [m_num_leaves, 2 * m_num_leaves).
+    m_winners.assign(2 * m_num_leaves, npos);
+  }
+
+  std::size_t
+  size()
+    const {
+    return m_keys.size();
+  }
+
+  bool
+  empty()
+    const {
+    return top() == npos;
+  }
+
+  std::optional<Tkey> const &
+  get(std::size_t slot)
+    const {
+    return m_keys.at(slot);
+  }
+
+  void
+  set(std::size_t slot,
+      std::optional<Tkey> const &key) {
+    m_keys.at(slot) = key;
+
+    auto node       = m_num_leaves + slot;
+    m_winners[node] = key ? slot : npos;
+
+    while (node > 1) {
+      node            /= 2;
+      m_winners[node]  = play(m_winners[2 * node], m_winners[2 * node + 1]);
+    }
+  }
+
+  void
+  clear(std::size_t slot) {
+    set(slot, std::nullopt);
+  }
+
+  std::size_t
+  top()
+    const {
+    return m_winners[1];
+  }
+
+protected:
+  std::size_t
+  play(std::size_t left,
+       std::size_t right)
+    const {
+    if (left == npos)
+      return right;
+    if (right == npos)
+      return left;
+
+    // "left" always has the lower slot index. It only loses if the
+    // right key is strictly smaller.
+    return m_compare(*m_keys[right], *m_keys[left]) ? right : left;
+  }
+};
+
+}
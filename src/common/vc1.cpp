@@ -16,7 +16,7 @@
 
 #include "common/bit_reader.h"
 #include "common/endian.h"
-#include "common/memory_slice_cursor.h"
+#include "common/mpeg.h"
 #include "common/strings/formatting.h"
 #include "common/vc1.h"
 
@@ -299,51 +299,43 @@ es_parser_c::es_parser_c()
 void
 es_parser_c::add_bytes(unsigned char *buffer,
                        int size) {
-  mtx::mem::slice_cursor_c cursor;
-
-  int previous_pos            = -1;
+  int64_t previous_pos        = -1;
   int64_t previous_stream_pos = m_stream_pos;
+  memory_cptr combined;
 
-  if (m_unparsed_buffer && (0 != m_unparsed_buffer->get_size()))
-    cursor.add_slice(m_unparsed_buffer);
-  cursor.add_slice(buffer, size);
-
-  if (3 <= cursor.get_remaining_size()) {
-    uint32_t marker = (1 << 24) | ((unsigned int)cursor.get_char() << 16) | ((unsigned int)cursor.get_char() << 8) | (unsigned int)cursor.get_char();
-
-    while (true) {
-      if (is_marker(marker)) {
-        if (-1 != previous_pos) {
-          int new_size = cursor.get_position() - 4 - previous_pos;
+  if (m_unparsed_buffer && (0 != m_unparsed_buffer->get_size())) {
+    combined = memory_c::alloc(m_unparsed_buffer->get_size() + size);
+    std::memcpy(combined->get_buffer(),                                m_unparsed_buffer->get_buffer(), m_unparsed_buffer->get_size());
+    std::memcpy(combined->get_buffer() + m_unparsed_buffer->get_size(), buffer,                          size);
+  }
 
-          memory_cptr packet(memory_c::alloc(new_size));
-          cursor.copy(packet->get_buffer(), previous_pos, new_size);
+  auto data       = combined ? combined->get_buffer() : buffer;
+  auto total_size = combined ? static_cast<int64_t>(combined->get_size()) : static_cast<int64_t>(size);
 
-          handle_packet(packet);
-        }
+  // A marker consists of the start code and the byte following it,
+  // therefore the start code must end before the last byte.
+  auto end        = data + std::max<int64_t>(total_size - 1, 0);
 
-        previous_pos = cursor.get_position() - 4;
-        m_stream_pos = previous_stream_pos + previous_pos;
-      }
+  for (auto marker = mtx::mpeg::find_start_code(data, end); marker != end; marker = mtx::mpeg::find_start_code(marker + 3, end)) {
+    int64_t pos = marker - data;
 
-      if (!cursor.char_available())
-        break;
+    if (-1 != previous_pos)
+      handle_packet(memory_c::clone(data + previous_pos, pos - previous_pos));
 
-      marker <<= 8;
-      marker  |= (unsigned int)cursor.get_char();
-    }
+    previous_pos = pos;
+    m_stream_pos = previous_stream_pos + previous_pos;
   }
 
   if (-1 == previous_pos)
     previous_pos = 0;
 
-  int new_size = cursor.get_size() - previous_pos;
-  if (0 != new_size) {
-    memory_cptr new_unparsed_buffer = memory_c::alloc(new_size);
-    cursor.copy(new_unparsed_buffer->get_buffer(), previous_pos, new_size);
-    m_unparsed_buffer = new_unparsed_buffer;
+  if (combined && !previous_pos)
+    m_unparsed_buffer = combined;
+
+  else if (total_size != previous_pos)
+    m_unparsed_buffer = memory_c::clone(data + previous_pos, total_size - previous_pos);
 
-  } else
+  else
     m_unparsed_buffer.reset();
 }
 
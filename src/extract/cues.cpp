@@ -153,21 +153,37 @@ parse_cue_points(kax_analyzer_c &analyzer) {
 static void
 determine_cluster_data_start_positions(mm_io_c &file,
                                        uint64_t segment_data_start_pos,
-                                       std::unordered_map<int64_t, std::vector<cue_point_t> > &cue_points) {
+                                       std::unordered_map<int64_t, std::vector<cue_point_t> > &cue_points,
+                                       cluster_head_sizes_t const *cluster_head_sizes) {
   auto es           = std::make_shared<EbmlStream>(file);
   auto upper_lvl_el = 0;
 
+  // Clusters seen while extracting tracks don't have to be read again,
+  // and each of the others is only read once even if several tracks'
+  // cue points refer to it.
+  auto head_sizes = cluster_head_sizes ? *cluster_head_sizes : cluster_head_sizes_t{};
+
   for (auto &track_cue_points_pair : cue_points) {
     for (auto &cue_point : track_cue_points_pair.second) {
       if (!cue_point.cluster_position || !cue_point.relative_position)
         continue;
 
+      auto cluster_position = segment_data_start_pos + cue_point.cluster_position.value();
+      auto head_size_itr    = head_sizes.find(cluster_position);
+
+      if (head_size_itr != head_sizes.end()) {
+        cue_point.relative_position = cue_point.relative_position.value() + head_size_itr->second;
+        continue;
+      }
+
       try {
-        file.setFilePointer(segment_data_start_pos + cue_point.cluster_position.value());
+        file.setFilePointer(cluster_position);
         auto elt = std::shared_ptr<EbmlElement>(es->FindNextElement(EBML_CLASS_CONTEXT(KaxSegment), upper_lvl_el, std::numeric_limits<int64_t>::max(), true));
 
-        if (elt && Is<KaxCluster>(*elt))
-          cue_point.relative_position = cue_point.relative_position.value() + elt->HeadSize();
+        if (elt && Is<KaxCluster>(*elt)) {
+          head_sizes[cluster_position] = elt->HeadSize();
+          cue_point.relative_position  = cue_point.relative_position.value() + elt->HeadSize();
+        }
 
       } catch (mtx::mm_io::exception &) {
       }
@@ -177,7 +193,8 @@ determine_cluster_data_start_positions(mm_io_c &file,
 
 bool
 extract_cues(kax_analyzer_c &analyzer,
-             options_c::mode_options_c &options) {
+             options_c::mode_options_c &options,
+             cluster_head_sizes_t const *cluster_head_sizes) {
   if (options.m_tracks.empty())
     return false;
 
@@ -186,7 +203,7 @@ extract_cues(kax_analyzer_c &analyzer,
   auto track_number_map       = generate_track_number_map(analyzer);
   auto segment_data_start_pos = analyzer.get_segment_data_start_pos();
 
-  determine_cluster_data_start_positions(analyzer.get_file(), segment_data_start_pos, cue_points);
+  determine_cluster_data_start_positions(analyzer.get_file(), segment_data_start_pos, cue_points, cluster_head_sizes);
   write_cues(options.m_tracks, track_number_map, cue_points, segment_data_start_pos, timestamp_scale);
 
   return true;
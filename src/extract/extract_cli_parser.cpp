@@ -17,6 +17,7 @@
 #include "common/iso639.h"
 #include "common/list_utils.h"
 #include "common/regex.h"
+#include "common/strings/editing.h"
 #include "common/strings/formatting.h"
 #include "common/strings/parsing.h"
 #include "common/translation.h"
@@ -73,11 +74,12 @@ extract_cli_parser_c::init_parser() {
 
   add_section_header(YT("Track extraction"));
   add_information(YT("The first mode extracts some tracks to external files."));
-  OPT("c=charset",      set_charset,  YT("Convert text subtitles to this charset (default: UTF-8)."));
-  OPT("cuesheet",       set_cuesheet, YT("Also try to extract the cue sheet from the chapter information and tags for this track."));
-  OPT("blockadd=level", set_blockadd, YT("Keep only the BlockAdditions up to this level (default: keep all levels)"));
-  OPT("raw",            set_raw,      YT("Extract the data to a raw file."));
-  OPT("fullraw",        set_fullraw,  YT("Extract the data to a raw file including the CodecPrivate as a header."));
+  OPT("c=charset",       set_charset,  YT("Convert text subtitles to this charset (default: UTF-8)."));
+  OPT("cuesheet",        set_cuesheet, YT("Also try to extract the cue sheet from the chapter information and tags for this track."));
+  OPT("blockadd=level",  set_blockadd, YT("Keep only the BlockAdditions up to this level (default: keep all levels)"));
+  OPT("raw",             set_raw,      YT("Extract the data to a raw file."));
+  OPT("fullraw",         set_fullraw,  YT("Extract the data to a raw file including the CodecPrivate as a header."));
+  OPT("range=start-end", set_range,    YT("Only extract the frames from this range of timestamps, starting with a key frame for each track. Either end can be omitted. Also valid for timestamp extraction."));
   add_informational_option("TID:out", YT("Write track with the ID TID to the file 'out'."));
 
   add_section_header(YT("Example"));
@@ -193,6 +195,25 @@ extract_cli_parser_c::set_fullraw() {
   m_target_mode = track_spec_t::tm_full_raw;
 }
 
+void
+extract_cli_parser_c::set_range() {
+  if (!mtx::included_in(m_current_mode->m_extraction_mode, options_c::em_tracks, options_c::em_timestamps_v2))
+    mxerror(fmt::format(Y("'{0}' is only allowed when extracting tracks or timestamps.\n"), m_current_arg));
+
+  auto parts = mtx::string::split(m_next_arg, "-");
+  timestamp_c start, end;
+
+  if (   (parts.size() != 2)
+      || (parts[0].empty() && parts[1].empty())
+      || (!parts[0].empty() && !mtx::string::parse_timestamp(parts[0], start))
+      || (!parts[1].empty() && !mtx::string::parse_timestamp(parts[1], end))
+      || (start.valid() && end.valid() && !(start < end)))
+    mxerror(fmt::format(Y("Invalid range '{0}'. The format is 'start-end' with either 'start' or 'end' being optional, and 'start' must be less than 'end'.\n"), m_next_arg));
+
+  m_current_mode->m_range_start = start;
+  m_current_mode->m_range_end   = end;
+}
+
 void
 extract_cli_parser_c::set_simple() {
   assert_mode(options_c::em_chapters);
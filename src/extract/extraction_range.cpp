@@ -0,0 +1,137 @@
+/*
+   mkvextract -- extract tracks from Matroska files into other files
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   extracts tracks and other items from Matroska files into other files
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <matroska/KaxBlock.h>
+#include <matroska/KaxCluster.h>
+#include <matroska/KaxCues.h>
+#include <matroska/KaxCuesData.h>
+
+#include "common/ebml.h"
+#include "extract/extraction_range.h"
+
+using namespace libmatroska;
+
+extraction_range_c::extraction_range_c(timestamp_c const &start,
+                                       timestamp_c const &end)
+  : m_start{start}
+  , m_end{end}
+{
+}
+
+timestamp_c const &
+extraction_range_c::get_start()
+  const {
+  return m_start;
+}
+
+timestamp_c const &
+extraction_range_c::get_end()
+  const {
+  return m_end;
+}
+
+bool
+extraction_range_c::is_in_range(int64_t track_number,
+                                int64_t timestamp,
+                                bool key_frame) {
+  if (!m_start.valid() && !m_end.valid())
+    return true;
+
+  auto &state = m_track_states[track_number];
+
+  if (state.finished)
+    return false;
+
+  if (!key_frame)
+    state.has_non_key_frames = true;
+
+  if (!state.started) {
+    if (!key_frame || (m_start.valid() && (timestamp < m_start.to_ns())))
+      return false;
+
+    state.started = true;
+  }
+
+  if (key_frame && m_end.valid() && (timestamp >= m_end.to_ns())) {
+    state.finished = true;
+    return false;
+  }
+
+  return true;
+}
+
+// The cluster's timestamp must have been initialized. A cluster is
+// only past the range if all of its blocks are: blocks with negative
+// relative timestamps can still be inside the range even if the
+// cluster's timestamp isn't.
+bool
+extraction_range_c::is_past_range(KaxCluster &cluster)
+  const {
+  if (!m_end.valid() || (static_cast<int64_t>(cluster.GlobalTimecode()) < m_end.to_ns()))
+    return false;
+
+  for (auto child : cluster) {
+    auto block = dynamic_cast<KaxInternalBlock *>(child);
+
+    if (auto group = dynamic_cast<KaxBlockGroup *>(child); group)
+      block = FindChild<KaxBlock>(*group);
+
+    if (!block)
+      continue;
+
+    block->SetParent(cluster);
+
+    if (static_cast<int64_t>(block->GlobalTimecode()) < m_end.to_ns())
+      return false;
+  }
+
+  // Tracks consisting of key frames only are done once the clusters
+  // are past the range. Others might still have to complete their
+  // last group of pictures.
+  return std::all_of(m_track_states.begin(), m_track_states.end(), [](auto const &pair) {
+    return pair.second.finished || !pair.second.has_non_key_frames;
+  });
+}
+
+// Returns the position relative to the segment's data of the cluster
+// referenced by the last cue point before the range's start.
+std::optional<uint64_t>
+extraction_range_c::find_start_position(KaxCues const &cues,
+                                        int64_t timestamp_scale)
+  const {
+  if (!m_start.valid())
+    return {};
+
+  std::optional<uint64_t> best_time, best_position;
+
+  for (auto const &elt : cues) {
+    auto kcue_point = dynamic_cast<KaxCuePoint *>(elt);
+    if (!kcue_point)
+      continue;
+
+    auto ktime      = FindChild<KaxCueTime>(*kcue_point);
+    auto ktrack_pos = FindChild<KaxCueTrackPositions>(*kcue_point);
+    auto kposition  = ktrack_pos ? FindChild<KaxCueClusterPosition>(*ktrack_pos) : nullptr;
+
+    if (!ktime || !kposition || (static_cast<int64_t>(ktime->GetValue() * timestamp_scale) > m_start.to_ns()))
+      continue;
+
+    if (!best_time || (ktime->GetValue() > *best_time) || ((ktime->GetValue() == *best_time) && (kposition->GetValue() < *best_position))) {
+      best_time     = ktime->GetValue();
+      best_position = kposition->GetValue();
+    }
+  }
+
+  return best_position;
+}
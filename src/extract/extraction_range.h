@@ -0,0 +1,48 @@
+/*
+   mkvextract -- extract tracks from Matroska files into other files
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   extracts tracks and other items from Matroska files into other files
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+#include "common/timestamp.h"
+
+namespace libmatroska {
+class KaxCluster;
+class KaxCues;
+}
+
+// Decides which frames are extracted when only a range is
+// extracted. Each track starts with its first key frame in the range
+// and ends before its first key frame after the range so that the
+// extracted data can be decoded and that the last group of pictures
+// is complete.
+class extraction_range_c {
+protected:
+  struct track_state_t {
+    bool started{}, finished{}, has_non_key_frames{};
+  };
+
+  timestamp_c m_start, m_end;
+  std::unordered_map<int64_t, track_state_t> m_track_states;
+
+public:
+  extraction_range_c() = default;
+  extraction_range_c(timestamp_c const &start, timestamp_c const &end);
+
+  timestamp_c const &get_start() const;
+  timestamp_c const &get_end() const;
+
+  bool is_in_range(int64_t track_number, int64_t timestamp, bool key_frame);
+  bool is_past_range(libmatroska::KaxCluster &cluster) const;
+  std::optional<uint64_t> find_start_position(libmatroska::KaxCues const &cues, int64_t timestamp_scale) const;
+};
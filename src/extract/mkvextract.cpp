@@ -136,13 +136,21 @@ main(int argc,
   auto analyzer       = open_and_analyze(options.m_file_name, options.m_parse_mode);
   auto done_something = false;
 
-  for (auto &mode_options : options.m_modes) {
+  // The modes are run in the order given by the user. If cues are
+  // extracted right after tracks (including timestamps), the cues
+  // mode uses what the track mode's cluster walk has learned about the
+  // clusters instead of reading them again.
+  auto cluster_head_sizes = cluster_head_sizes_t{};
+
+  for (auto idx = 0u, num_modes = static_cast<unsigned int>(options.m_modes.size()); idx < num_modes; ++idx) {
+    auto &mode_options       = options.m_modes[idx];
     auto done_something_here = false;
 
-    if (options_c::em_tracks == mode_options.m_extraction_mode)
-      done_something_here = extract_tracks(*analyzer, mode_options);
+    if (options_c::em_tracks == mode_options.m_extraction_mode) {
+      auto cues_follow    = ((idx + 1) < num_modes) && (options_c::em_cues == options.m_modes[idx + 1].m_extraction_mode);
+      done_something_here = extract_tracks(*analyzer, mode_options, cues_follow ? &cluster_head_sizes : nullptr);
 
-    else if (options_c::em_tags == mode_options.m_extraction_mode)
+    } else if (options_c::em_tags == mode_options.m_extraction_mode)
       done_something_here = extract_tags(*analyzer, mode_options);
 
     else if (options_c::em_attachments == mode_options.m_extraction_mode)
@@ -151,10 +159,11 @@ main(int argc,
     else if (options_c::em_chapters == mode_options.m_extraction_mode)
       done_something_here = extract_chapters(*analyzer, mode_options);
 
-    else if (options_c::em_cues == mode_options.m_extraction_mode)
-      done_something_here = extract_cues(*analyzer, mode_options);
+    else if (options_c::em_cues == mode_options.m_extraction_mode) {
+      auto after_tracks   = (0 < idx) && (options_c::em_tracks == options.m_modes[idx - 1].m_extraction_mode);
+      done_something_here = extract_cues(*analyzer, mode_options, after_tracks ? &cluster_head_sizes : nullptr);
 
-    else if (options_c::em_cuesheet == mode_options.m_extraction_mode)
+    } else if (options_c::em_cuesheet == mode_options.m_extraction_mode)
       done_something_here = extract_cuesheet(*analyzer, mode_options);
 
     if (done_something_here)
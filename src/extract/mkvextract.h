@@ -35,13 +35,18 @@ void show_error(const std::string &error);
 void find_and_verify_track_uids(libmatroska::KaxTracks &tracks, std::vector<track_spec_t> &tspecs);
 void write_cuesheet(std::string file_name, libmatroska::KaxChapters &chapters, libmatroska::KaxTags &tags, int64_t tuid, mm_io_c &out);
 
-bool extract_tracks(kax_analyzer_c &analyzer, options_c::mode_options_c &options);
+// Head sizes of the clusters by their position in the file. Gathered
+// while extracting tracks so that extracting cues doesn't have to read
+// the clusters again.
+using cluster_head_sizes_t = std::unordered_map<uint64_t, uint64_t>;
+
+bool extract_tracks(kax_analyzer_c &analyzer, options_c::mode_options_c &options, cluster_head_sizes_t *cluster_head_sizes = nullptr);
 bool extract_tags(kax_analyzer_c &analyzer, options_c::mode_options_c &options);
 bool extract_chapters(kax_analyzer_c &analyzer, options_c::mode_options_c &options);
 bool extract_attachments(kax_analyzer_c &analyzer, options_c::mode_options_c &options);
 bool extract_cuesheet(kax_analyzer_c &analyzer, options_c::mode_options_c &options);
 bool extract_timestamps(kax_analyzer_c &analyzer, options_c::mode_options_c &options);
-bool extract_cues(kax_analyzer_c &analyzer, options_c::mode_options_c &options);
+bool extract_cues(kax_analyzer_c &analyzer, options_c::mode_options_c &options, cluster_head_sizes_t const *cluster_head_sizes = nullptr);
 
 kax_analyzer_cptr open_and_analyze(std::string const &file_name, kax_analyzer_c::parse_mode_e parse_mode, bool exit_on_error = true);
 mm_io_cptr open_output_file(std::string const &file_name);
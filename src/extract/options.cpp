@@ -11,6 +11,7 @@
 #include "common/common_pch.h"
 
 #include "common/list_utils.h"
+#include "common/strings/formatting.h"
 #include "extract/mkvextract.h"
 #include "extract/options.h"
 
@@ -26,8 +27,10 @@ options_c::mode_options_c::dump(std::string const &prefix)
   mxinfo(fmt::format("{0}simple chapter format:   {1}\n"
                      "{0}simple chapter language: {2}\n"
                      "{0}extraction mode:         {3}\n"
+                     "{0}range:                   {5}-{6}\n"
                      "{0}num track specs:         {4}\n",
-                     prefix, m_simple_chapter_format, m_simple_chapter_language.get_iso639_2_code_or("<none>"), static_cast<int>(m_extraction_mode), m_tracks.size()));
+                     prefix, m_simple_chapter_format, m_simple_chapter_language.get_iso639_2_code_or("<none>"), static_cast<int>(m_extraction_mode), m_tracks.size(),
+                     m_range_start.valid() ? mtx::string::format_timestamp(m_range_start) : ""s, m_range_end.valid() ? mtx::string::format_timestamp(m_range_end) : ""s));
 
 
   for (auto idx = 0u; idx < m_tracks.size(); ++idx) {
@@ -89,6 +92,17 @@ options_c::merge_tracks_and_timestamps_targets() {
     timestamps_itr->m_extraction_mode = em_tracks;
 
   else {
+    // Both modes are handled in the same pass over the file.
+    auto &range_start = tracks_itr->m_range_start.valid() ? tracks_itr->m_range_start : timestamps_itr->m_range_start;
+    auto &range_end   = tracks_itr->m_range_end.valid()   ? tracks_itr->m_range_end   : timestamps_itr->m_range_end;
+
+    if (   (timestamps_itr->m_range_start.valid() && !(timestamps_itr->m_range_start == range_start))
+        || (timestamps_itr->m_range_end.valid()   && !(timestamps_itr->m_range_end   == range_end)))
+      mxerror(Y("The same range must be used for extracting tracks and timestamps.\n"));
+
+    tracks_itr->m_range_start = range_start;
+    tracks_itr->m_range_end   = range_end;
+
     std::copy(timestamps_itr->m_tracks.begin(), timestamps_itr->m_tracks.end(), std::back_inserter(tracks_itr->m_tracks));
     m_modes.erase(timestamps_itr);
   }
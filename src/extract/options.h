@@ -13,6 +13,7 @@
 #include "common/common_pch.h"
 
 #include "common/bcp47.h"
+#include "common/timestamp.h"
 #include "extract/track_spec.h"
 
 class options_c {
@@ -36,6 +37,9 @@ public:
 
     std::vector<track_spec_t> m_tracks;
 
+    // Only extract frames from this range; both are optional.
+    timestamp_c m_range_start, m_range_end;
+
     std::string m_output_file_name;
 
     mode_options_c();
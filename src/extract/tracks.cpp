@@ -22,6 +22,8 @@
 #include <matroska/KaxBlockData.h>
 #include <matroska/KaxCluster.h>
 #include <matroska/KaxClusterData.h>
+#include <matroska/KaxCues.h>
+#include <matroska/KaxCuesData.h>
 #include <matroska/KaxInfo.h>
 #include <matroska/KaxInfoData.h>
 #include <matroska/KaxSegment.h>
@@ -32,11 +34,14 @@
 
 #include "common/command_line.h"
 #include "common/ebml.h"
+#include "common/hacks.h"
+#include "common/job_queues.h"
 #include "common/kax_file.h"
 #include "common/mm_io_x.h"
 #include "common/mm_proxy_io.h"
 #include "common/mm_write_buffer_io.h"
 #include "common/strings/formatting.h"
+#include "extract/extraction_range.h"
 #include "extract/mkvextract.h"
 #include "extract/xtr_base.h"
 
@@ -82,6 +87,43 @@ static std::unordered_map<int64_t, std::shared_ptr<timestamp_extractor_t>> times
 static std::unordered_map<int64_t, std::shared_ptr<xtr_base_c>> track_extractors_by_track_number;
 static std::vector<std::shared_ptr<xtr_base_c>> track_extractor_list;
 
+// With multi-threaded extraction frames are handed to the extractors
+// on a pool of threads. Each output file gets its own queue so that
+// frames of tracks written to the same file are still handled in
+// their original order.
+static int64_t constexpr max_queued_bytes = 64 * 1024 * 1024;
+static std::unique_ptr<mtx::job_queues_c> extraction_queues;
+static std::unordered_map<xtr_base_c *, std::size_t> queue_idx_by_extractor;
+
+// ------------------------------------------------------------------------
+
+static extraction_range_c range;
+
+// Returns the position of the cluster referenced by the last cue
+// point before the range's start.
+static std::optional<uint64_t>
+find_range_start_position(kax_analyzer_c &analyzer,
+                          int64_t tc_scale) {
+  if (!range.get_start().valid())
+    return {};
+
+  auto af_cues = ebml_master_cptr{ analyzer.read_all(EBML_INFO(KaxCues)) };
+  auto cues    = dynamic_cast<KaxCues *>(af_cues.get());
+
+  if (!cues) {
+    mxinfo(Y("The file does not contain cues. It has to be read from the start in order to find the range to extract.\n"));
+    return {};
+  }
+
+  auto position = range.find_start_position(*cues, tc_scale);
+  if (!position)
+    return {};
+
+  return analyzer.get_segment_data_start_pos() + *position;
+}
+
+// ------------------------------------------------------------------------
+
 static void
 create_extractors(KaxTracks &kax_tracks,
                   std::vector<track_spec_t> &tracks) {
@@ -143,6 +185,49 @@ create_extractors(KaxTracks &kax_tracks,
     extractor->headers_done();
 }
 
+static void
+create_extraction_queues() {
+  if (!mtx::hacks::is_engaged(mtx::hacks::MULTI_THREADED_EXTRACTION) || track_extractor_list.empty())
+    return;
+
+  auto num_queues = std::size_t{};
+
+  for (auto &extractor : track_extractor_list) {
+    auto file_owner = extractor->m_master ? extractor->m_master : extractor.get();
+    auto itr        = queue_idx_by_extractor.find(file_owner);
+
+    queue_idx_by_extractor[extractor.get()] = itr != queue_idx_by_extractor.end() ? itr->second : num_queues++;
+  }
+
+  extraction_queues = std::make_unique<mtx::job_queues_c>(num_queues, max_queued_bytes);
+}
+
+static void
+handle_frame(xtr_base_c &extractor,
+             xtr_frame_t &f,
+             std::shared_ptr<KaxCluster> const &cluster) {
+  if (!extraction_queues) {
+    extractor.decode_and_handle_frame(f);
+    return;
+  }
+
+  // The frame's buffer and the block additions belong to the cluster
+  // which must be kept around until the frame has been handled.
+  extraction_queues->add(queue_idx_by_extractor[&extractor], [&extractor, f, cluster]() mutable { extractor.decode_and_handle_frame(f); }, f.frame->get_size());
+}
+
+static void
+handle_codec_state(xtr_base_c &extractor,
+                   memory_cptr &codec_state,
+                   std::shared_ptr<KaxCluster> const &cluster) {
+  if (!extraction_queues) {
+    extractor.handle_codec_state(codec_state);
+    return;
+  }
+
+  extraction_queues->add(queue_idx_by_extractor[&extractor], [&extractor, codec_state, cluster]() mutable { extractor.handle_codec_state(codec_state); }, codec_state->get_size());
+}
+
 static void
 close_timestamp_files() {
   for (auto &pair : timestamp_extractors) {
@@ -215,6 +300,9 @@ handle_blockgroup_timestamps(KaxBlockGroup &blockgroup,
   auto kduration   = FindChild<KaxBlockDuration>(blockgroup);
   int64_t duration = !kduration ? extractor->second->m_default_duration * block->NumberFrames() : kduration->GetValue() * tc_scale;
 
+  if (!range.is_in_range(block->TrackNum(), block->GlobalTimecode(), !FindChild<KaxReferenceBlock>(blockgroup)))
+    return;
+
   // Pass the block to the extractor.
   for (auto idx = 0u, end = block->NumberFrames(); idx < end; ++idx)
     extractor->second->m_timestamps.push_back(timestamp_t(block->GlobalTimecode() + idx * duration / block->NumberFrames(), duration / block->NumberFrames()));
@@ -226,6 +314,9 @@ handle_simpleblock_timestamps(KaxSimpleBlock &simpleblock) {
   if (timestamp_extractors.end() == itr)
     return;
 
+  if (!range.is_in_range(simpleblock.TrackNum(), simpleblock.GlobalTimecode(), simpleblock.IsKeyframe()))
+    return;
+
   // Pass the block to the extractor.
   auto &extractor = *itr->second;
   for (auto idx = 0u, end = simpleblock.NumberFrames(); idx < end; ++idx)
@@ -234,14 +325,14 @@ handle_simpleblock_timestamps(KaxSimpleBlock &simpleblock) {
 
 static int64_t
 handle_blockgroup(KaxBlockGroup &blockgroup,
-                  KaxCluster &cluster,
+                  std::shared_ptr<KaxCluster> const &cluster,
                   int64_t tc_scale) {
   // Only continue if this block group actually contains a block.
   KaxBlock *block = FindChild<KaxBlock>(&blockgroup);
   if (!block || (0 == block->NumberFrames()))
     return -1;
 
-  block->SetParent(cluster);
+  block->SetParent(*cluster);
 
   handle_blockgroup_timestamps(blockgroup, tc_scale);
 
@@ -250,6 +341,9 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
   if (extractor_itr == track_extractors_by_track_number.end())
     return -1;
 
+  if (!range.is_in_range(block->TrackNum(), block->GlobalTimecode(), !FindChild<KaxReferenceBlock>(&blockgroup)))
+    return -1;
+
   // Next find the block duration if there is one.
   auto &extractor               = *extractor_itr->second;
   KaxBlockDuration *kduration   = FindChild<KaxBlockDuration>(&blockgroup);
@@ -277,7 +371,7 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
   KaxCodecState *kcstate = FindChild<KaxCodecState>(&blockgroup);
   if (kcstate) {
     auto ctstate = memory_c::borrow(kcstate->GetBuffer(), kcstate->GetSize());
-    extractor.handle_codec_state(ctstate);
+    handle_codec_state(extractor, ctstate, cluster);
   }
 
   for (int i = 0, num_frames = block->NumberFrames(); i < num_frames; i++) {
@@ -300,7 +394,7 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
     auto &data = block->GetBuffer(i);
     auto frame = memory_c::borrow(data.Buffer(), data.Size());
     auto f     = xtr_frame_t{frame, kadditions, this_timestamp, this_duration, bref, fref, false, false, true, discard_padding};
-    extractor.decode_and_handle_frame(f);
+    handle_frame(extractor, f, cluster);
 
     max_timestamp = std::max(max_timestamp, this_timestamp);
   }
@@ -310,11 +404,11 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
 
 static int64_t
 handle_simpleblock(KaxSimpleBlock &simpleblock,
-                   KaxCluster &cluster) {
+                   std::shared_ptr<KaxCluster> const &cluster) {
   if (0 == simpleblock.NumberFrames())
     return -1;
 
-  simpleblock.SetParent(cluster);
+  simpleblock.SetParent(*cluster);
 
   handle_simpleblock_timestamps(simpleblock);
 
@@ -323,6 +417,9 @@ handle_simpleblock(KaxSimpleBlock &simpleblock,
   if (extractor_itr == track_extractors_by_track_number.end())
     return - 1;
 
+  if (!range.is_in_range(simpleblock.TrackNum(), simpleblock.GlobalTimecode(), simpleblock.IsKeyframe()))
+    return -1;
+
   auto &extractor       = *extractor_itr->second;
   int64_t duration      = extractor.m_default_duration * simpleblock.NumberFrames();
   int64_t max_timestamp = 0;
@@ -341,7 +438,7 @@ handle_simpleblock(KaxSimpleBlock &simpleblock,
     auto &data = simpleblock.GetBuffer(i);
     auto frame = memory_c::borrow(data.Buffer(), data.Size());
     auto f     = xtr_frame_t{frame, nullptr, this_timestamp, this_duration, -1, -1, simpleblock.IsKeyframe(), simpleblock.IsDiscardable(), false, timestamp_c::ns(0)};
-    extractor.decode_and_handle_frame(f);
+    handle_frame(extractor, f, cluster);
 
     max_timestamp = std::max(max_timestamp, this_timestamp);
   }
@@ -351,6 +448,11 @@ handle_simpleblock(KaxSimpleBlock &simpleblock,
 
 static void
 close_extractors() {
+  if (extraction_queues) {
+    extraction_queues->finish();
+    extraction_queues.reset();
+  }
+
   for (auto &extractor : track_extractor_list)
     extractor->finish_track();
 
@@ -364,6 +466,7 @@ close_extractors() {
 
   track_extractors_by_track_number.clear();
   track_extractor_list.clear();
+  queue_idx_by_extractor.clear();
 }
 
 static void
@@ -404,6 +507,27 @@ write_all_cuesheets(KaxChapters &chapters,
   }
 }
 
+static void
+skip_blocks_of_unused_tracks(KaxTracks &kax_tracks,
+                             kax_file_c &file) {
+  // Blocks of tracks that are neither extracted nor have their
+  // timestamps extracted are skipped without reading their content.
+  std::unordered_set<uint64_t> track_numbers_to_skip;
+
+  for (auto const &element : kax_tracks) {
+    if (!Is<KaxTrackEntry>(element))
+      continue;
+
+    auto tnum = kt_get_number(*static_cast<KaxTrackEntry *>(element));
+
+    if (   (track_extractors_by_track_number.find(tnum) == track_extractors_by_track_number.end())
+        && (timestamp_extractors.find(tnum)             == timestamp_extractors.end()))
+      track_numbers_to_skip.insert(tnum);
+  }
+
+  file.set_track_numbers_to_skip(track_numbers_to_skip);
+}
+
 void
 find_and_verify_track_uids(KaxTracks &tracks,
                            std::vector<track_spec_t> &tspecs) {
@@ -433,12 +557,15 @@ find_and_verify_track_uids(KaxTracks &tracks,
 
 bool
 extract_tracks(kax_analyzer_c &analyzer,
-               options_c::mode_options_c &options) {
+               options_c::mode_options_c &options,
+               cluster_head_sizes_t *cluster_head_sizes) {
   auto &tspecs = options.m_tracks;
 
   if (tspecs.empty())
     return false;
 
+  range = extraction_range_c{options.m_range_start, options.m_range_end};
+
   // open input file
   auto &in          = analyzer.get_file();
   auto file         = std::make_shared<kax_file_c>(in);
@@ -455,7 +582,9 @@ extract_tracks(kax_analyzer_c &analyzer,
 
   find_and_verify_track_uids(*tracks, tspecs);
   create_extractors(*tracks, tspecs);
+  create_extraction_queues();
   create_timestamp_files(*tracks, tspecs);
+  skip_blocks_of_unused_tracks(*tracks, *file);
 
   try {
     in.setFilePointer(0);
@@ -494,16 +623,32 @@ extract_tracks(kax_analyzer_c &analyzer,
     file->set_timestamp_scale(tc_scale);
     file->set_segment_end(*l0);
 
+    // Continue with the cluster the range starts in instead of reading
+    // all clusters before it.
+    auto start_position = find_range_start_position(analyzer, tc_scale);
+    if (start_position)
+      in.setFilePointer(*start_position);
+
+    auto progress_start_position  = static_cast<int64_t>(start_position.value_or(0));
+    auto progress_start_timestamp = range.get_start().valid() ? range.get_start().to_ns() : 0;
+
     while (true) {
       auto cluster = file->read_next_cluster();
       if (!cluster)
         break;
 
+      if (cluster_head_sizes)
+        (*cluster_head_sizes)[file->get_cluster_position()] = file->get_cluster_head_size();
+
       auto ctc = static_cast<KaxClusterTimecode *> (cluster->FindFirstElt(EBML_INFO(KaxClusterTimecode), false));
       cluster->InitTimecode(ctc ? ctc->GetValue() : 0, tc_scale);
 
+      if (range.is_past_range(*cluster))
+        break;
+
       if (0 == verbose) {
-        auto current_percentage = in.getFilePointer() * 100 / file_size;
+        auto current_percentage = range.get_end().valid() ? std::clamp<int64_t>((static_cast<int64_t>(cluster->GlobalTimecode()) - progress_start_timestamp) * 100 / std::max<int64_t>(range.get_end().to_ns() - progress_start_timestamp, 1), 0, 100)
+                                :                           (static_cast<int64_t>(in.getFilePointer()) - progress_start_position) * 100 / std::max<int64_t>(file_size - progress_start_position, 1);
 
         if (previous_percentage != static_cast<int>(current_percentage)) {
           if (mtx::cli::g_gui_mode)
@@ -523,10 +668,10 @@ extract_tracks(kax_analyzer_c &analyzer,
         EbmlElement *el          = (*cluster)[i];
 
         if (Is<KaxBlockGroup>(el))
-          max_bg_timestamp = handle_blockgroup(*static_cast<KaxBlockGroup *>(el), *cluster, tc_scale);
+          max_bg_timestamp = handle_blockgroup(*static_cast<KaxBlockGroup *>(el), cluster, tc_scale);
 
         else if (Is<KaxSimpleBlock>(el))
-          max_bg_timestamp = handle_simpleblock(*static_cast<KaxSimpleBlock *>(el), *cluster);
+          max_bg_timestamp = handle_simpleblock(*static_cast<KaxSimpleBlock *>(el), cluster);
 
         max_timestamp = std::max(max_timestamp, max_bg_timestamp);
       }
@@ -561,6 +706,7 @@ extract_tracks(kax_analyzer_c &analyzer,
 
     return true;
   } catch (...) {
+    extraction_queues.reset();
     show_error(Y("Caught exception"));
 
     return false;
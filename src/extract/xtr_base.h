@@ -22,7 +22,7 @@
 #include "extract/mkvextract.h"
 
 struct xtr_frame_t {
-  memory_cptr &frame;
+  memory_cptr frame;
   libmatroska::KaxBlockAdditions *additions;
   int64_t timestamp, duration, bref, fref;
   bool keyframe, discardable, references_valid;
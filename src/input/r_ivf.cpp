@@ -17,6 +17,7 @@
 
 #include "common/endian.h"
 #include "common/ivf.h"
+#include "common/mm_io_x.h"
 #include "common/id_info.h"
 #include "input/r_ivf.h"
 #include "output/p_av1.h"
@@ -102,8 +103,14 @@ ivf_reader_c::read(generic_packetizer_c *,
     return flush_packetizers();
   }
 
-  memory_cptr buffer = memory_c::alloc(frame_size);
-  if (m_in->read(buffer->get_buffer(), frame_size) < frame_size) {
+  memory_cptr buffer;
+
+  try {
+    // Memory-mapped input returns the frame without copying it if the
+    // packetizer doesn't modify it.
+    buffer = PTZR0->accepts_immutable_frames() ? m_in->read_immutable(frame_size) : m_in->read(frame_size);
+
+  } catch (mtx::mm_io::end_of_file_x &) {
     m_in->setFilePointer(0, seek_end);
     return flush_packetizers();
   }
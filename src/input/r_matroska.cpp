@@ -68,6 +68,7 @@
 #include "input/r_matroska.h"
 #include "merge/file_status.h"
 #include "merge/input_x.h"
+#include "merge/memory_budget.h"
 #include "merge/output_control.h"
 #include "output/p_aac.h"
 #include "output/p_ac3.h"
@@ -1512,6 +1513,12 @@ kax_reader_c::read_headers_internal() {
 
     m_in_file->enable_reporting(!g_identifying);
 
+    if (mtx::hacks::is_engaged(mtx::hacks::FAST_MATROSKA_READING))
+      m_in_file->set_raw_cluster_accounting([raw_cluster_bytes = m_raw_cluster_bytes](int64_t num_bytes) {
+        *raw_cluster_bytes += num_bytes;
+        mtx::merge::memory_budget::account(num_bytes);
+      });
+
     // Find the EbmlHead element. Must be the first one.
     auto l0 = std::shared_ptr<EbmlElement>(m_es->FindNextID(EBML_INFO(EbmlHead), 0xFFFFFFFFFFFFFFFFLL));
     if (!l0) {
@@ -2139,6 +2146,8 @@ kax_reader_c::create_packetizers() {
   for (auto &track : m_tracks)
     create_packetizer(track->tnum);
 
+  skip_blocks_of_unused_tracks();
+
   if (!g_segment_title_set && !m_title.empty()) {
     g_segment_title     = m_title;
     g_segment_title_set = true;
@@ -2147,6 +2156,27 @@ kax_reader_c::create_packetizers() {
   m_in->restore_pos();
 }
 
+void
+kax_reader_c::skip_blocks_of_unused_tracks() {
+  // Blocks of tracks that aren't muxed are skipped by the cluster
+  // reader without reading their content. Blocks with unknown track
+  // numbers are still read so that they can be reported.
+  std::unordered_set<uint64_t> track_numbers_to_skip, track_numbers_used;
+
+  for (auto &track : m_tracks)
+    if (-1 == track->ptzr)
+      track_numbers_to_skip.insert(track->track_number);
+    else
+      track_numbers_used.insert(track->track_number);
+
+  for (auto track_number : track_numbers_used)
+    track_numbers_to_skip.erase(track_number);
+
+  mxdebug_if(m_debug_skip_blocks, fmt::format("skip_blocks_of_unused_tracks: skipping blocks of {0} track number(s)\n", track_numbers_to_skip.size()));
+
+  m_in_file->set_track_numbers_to_skip(track_numbers_to_skip);
+}
+
 void
 kax_reader_c::create_avc_es_video_packetizer(kax_track_t *t,
                                              track_info_c &nti) {
@@ -2270,6 +2300,15 @@ kax_reader_c::read_first_frames(kax_track_t *t,
   }
 }
 
+int64_t
+kax_reader_c::get_queued_bytes()
+  const {
+  // A frame read by the fast cluster reader keeps its whole cluster
+  // alive. Those clusters are counted in addition to the packets
+  // queued even though the packets' data may be part of them.
+  return generic_reader_c::get_queued_bytes() + m_raw_cluster_bytes->load(std::memory_order_relaxed);
+}
+
 file_status_e
 kax_reader_c::read(generic_packetizer_c *requested_ptzr,
                    bool force) {
@@ -2278,15 +2317,29 @@ kax_reader_c::read(generic_packetizer_c *requested_ptzr,
 
   auto num_queued_bytes = get_queued_bytes();
 
-  if (20 * 1024 * 1024 < num_queued_bytes) {
+  if (mtx::merge::memory_budget::exceeds_soft_limit(num_queued_bytes)) {
     auto requested_ptzr_track = m_ptzr_to_track_map[requested_ptzr];
     if (   !requested_ptzr_track
         || (!force && ('a' != requested_ptzr_track->type) && ('v' != requested_ptzr_track->type))
-        || (!force && (128 * 1024 * 1024 < num_queued_bytes)))
+        || (!force && mtx::merge::memory_budget::exceeds_hard_limit(num_queued_bytes, 128 * 1024 * 1024)))
       return FILE_STATUS_HOLDING;
   }
 
   try {
+    if (mtx::hacks::is_engaged(mtx::hacks::FAST_MATROSKA_READING)) {
+      auto raw_cluster = m_in_file->read_next_raw_cluster();
+
+      if (raw_cluster) {
+        for (auto const &block : raw_cluster->blocks)
+          if (block.is_simple_block)
+            process_simple_block(block);
+          else
+            process_block_group(block);
+
+        return FILE_STATUS_MOREDATA;
+      }
+    }
+
     auto cluster = m_in_file->read_next_cluster();
     if (!cluster)
       return finish_file();
@@ -2328,19 +2381,38 @@ kax_reader_c::finish_file() {
 void
 kax_reader_c::process_simple_block(KaxCluster *cluster,
                                    KaxSimpleBlock *block_simple) {
+  block_simple->SetParent(*cluster);
+
+  mtx::kax::raw_block_t block;
+  block.is_simple_block  = true;
+  block.track_number     = block_simple->TrackNum();
+  block.timestamp        = mtx::math::to_signed(block_simple->GlobalTimecode());
+  block.key_flag         = block_simple->IsKeyframe();
+  block.discardable_flag = block_simple->IsDiscardable();
+
+  for (auto idx = 0u, num_frames = block_simple->NumberFrames(); idx < num_frames; ++idx) {
+    auto &data_buffer = block_simple->GetBuffer(idx);
+    block.frames.emplace_back(memory_c::borrow(data_buffer.Buffer(), data_buffer.Size()));
+  }
+
+  process_simple_block(block);
+}
+
+void
+kax_reader_c::process_simple_block(mtx::kax::raw_block_t const &block) {
   int64_t block_duration = -1;
   int64_t block_bref     = VFT_IFRAME;
   int64_t block_fref     = VFT_NOBFRAME;
 
-  block_simple->SetParent(*cluster);
-  auto block_track     = find_track_by_num(block_simple->TrackNum());
-  auto block_timestamp = mtx::math::to_signed(block_simple->GlobalTimecode()) - m_global_timestamp_offset;
+  auto block_track     = find_track_by_num(block.track_number);
+  auto block_timestamp = block.timestamp - m_global_timestamp_offset;
+  auto num_frames      = block.frames.size();
 
   if (!block_track) {
-    if (!m_known_bad_track_numbers[block_simple->TrackNum()])
+    if (!m_known_bad_track_numbers[block.track_number])
       mxwarn_fn(m_ti.m_fname,
                 fmt::format(Y("A block was found at timestamp {0} for track number {1}. However, no headers were found for that track number. "
-                              "The block will be skipped.\n"), mtx::string::format_timestamp(block_timestamp), block_simple->TrackNum()));
+                              "The block will be skipped.\n"), mtx::string::format_timestamp(block_timestamp), block.track_number));
     return;
   }
 
@@ -2354,8 +2426,8 @@ kax_reader_c::process_simple_block(KaxCluster *cluster,
       block_duration = 0;
   }
 
-  auto key_flag         = block_simple->IsKeyframe();
-  auto discardable_flag = block_simple->IsDiscardable();
+  auto key_flag         = block.key_flag;
+  auto discardable_flag = block.discardable_flag;
 
   if (!key_flag) {
     if (discardable_flag)
@@ -2365,20 +2437,19 @@ kax_reader_c::process_simple_block(KaxCluster *cluster,
   }
 
   m_last_timestamp = block_timestamp;
-  if (0 < block_simple->NumberFrames())
-    m_in_file->set_last_timestamp(m_last_timestamp + (block_simple->NumberFrames() - 1) * frame_duration);
+  if (0 < num_frames)
+    m_in_file->set_last_timestamp(m_last_timestamp + (num_frames - 1) * frame_duration);
 
   if ((-1 != block_track->ptzr) && block_track->passthrough) {
     // The handling for passthrough is a bit different. We don't have
     // any special cases, e.g. 0 terminating a string for the subs
     // and stuff. Just pass everything through as it is.
     size_t i;
-    for (i = 0; block_simple->NumberFrames() > i; ++i) {
-      DataBuffer &data_buffer = block_simple->GetBuffer(i);
-      auto data = memory_c::borrow(data_buffer.Buffer(), data_buffer.Size());
+    for (i = 0; num_frames > i; ++i) {
+      auto data = block.frames[i];
       block_track->content_decoder.reverse(data, CONTENT_ENCODING_SCOPE_BLOCK);
 
-      packet_cptr packet(new packet_t(data, m_last_timestamp + i * frame_duration, block_duration, block_bref, block_fref));
+      auto packet              = make_packet(data, m_last_timestamp + i * frame_duration, block_duration, block_bref, block_fref);
       packet->key_flag         = key_flag;
       packet->discardable_flag = discardable_flag;
 
@@ -2387,12 +2458,11 @@ kax_reader_c::process_simple_block(KaxCluster *cluster,
 
   } else if (-1 != block_track->ptzr) {
     size_t i;
-    for (i = 0; i < block_simple->NumberFrames(); i++) {
-      DataBuffer &data_buffer = block_simple->GetBuffer(i);
-      auto data = memory_c::borrow(data_buffer.Buffer(), data_buffer.Size());
+    for (i = 0; i < num_frames; i++) {
+      auto data = block.frames[i];
       block_track->content_decoder.reverse(data, CONTENT_ENCODING_SCOPE_BLOCK);
 
-      auto packet              = std::make_shared<packet_t>(data, m_last_timestamp + i * frame_duration, block_duration, block_bref, block_fref);
+      auto packet              = make_packet(data, m_last_timestamp + i * frame_duration, block_duration, block_bref, block_fref);
       packet->key_flag         = key_flag;
       packet->discardable_flag = discardable_flag;
 
@@ -2401,33 +2471,21 @@ kax_reader_c::process_simple_block(KaxCluster *cluster,
   }
 
   block_track->previous_timestamp  = m_last_timestamp;
-  block_track->units_processed    += block_simple->NumberFrames();
+  block_track->units_processed    += num_frames;
 }
 
 void
-kax_reader_c::process_block_group_common(KaxBlockGroup *block_group,
+kax_reader_c::process_block_group_common(mtx::kax::raw_block_t const &block,
                                          packet_t *packet,
                                          kax_track_t &block_track) {
-  auto codec_state     = FindChild<KaxCodecState>(block_group);
-  auto discard_padding = FindChild<KaxDiscardPadding>(block_group);
-  auto blockadd        = FindChild<KaxBlockAdditions>(block_group);
+  if (block.codec_state)
+    packet->codec_state = block.codec_state;
 
-  if (codec_state)
-    packet->codec_state = memory_c::clone(codec_state->GetBuffer(), codec_state->GetSize());
-
-  if (discard_padding)
-    packet->discard_padding = timestamp_c::ns(discard_padding->GetValue());
-
-  if (!blockadd)
-    return;
-
-  for (auto &child : *blockadd) {
-    if (!(Is<KaxBlockMore>(child)))
-      continue;
+  if (block.discard_padding)
+    packet->discard_padding = timestamp_c::ns(*block.discard_padding);
 
-    auto blockmore     = static_cast<KaxBlockMore *>(child);
-    auto blockadd_data = &GetChild<KaxBlockAdditional>(*blockmore);
-    auto blockadded    = memory_c::borrow(blockadd_data->GetBuffer(), blockadd_data->GetSize());
+  for (auto const &addition : block.additions) {
+    auto blockadded = addition;
     block_track.content_decoder.reverse(blockadded, CONTENT_ENCODING_SCOPE_BLOCK);
 
     packet->data_adds.push_back(blockadded);
@@ -2437,31 +2495,75 @@ kax_reader_c::process_block_group_common(KaxBlockGroup *block_group,
 void
 kax_reader_c::process_block_group(KaxCluster *cluster,
                                   KaxBlockGroup *block_group) {
-  auto block = FindChild<KaxBlock>(block_group);
-  if (!block)
+  auto kblock = FindChild<KaxBlock>(block_group);
+  if (!kblock)
     return;
 
-  block->SetParent(*cluster);
-  auto block_track     = find_track_by_num(block->TrackNum());
-  auto block_timestamp = mtx::math::to_signed(block->GlobalTimecode()) - m_global_timestamp_offset;
+  kblock->SetParent(*cluster);
+
+  mtx::kax::raw_block_t block;
+  block.track_number = kblock->TrackNum();
+  block.timestamp    = mtx::math::to_signed(kblock->GlobalTimecode());
+
+  for (auto idx = 0u, num_frames = kblock->NumberFrames(); idx < num_frames; ++idx) {
+    auto &data_buffer = kblock->GetBuffer(idx);
+    block.frames.emplace_back(memory_c::borrow(data_buffer.Buffer(), data_buffer.Size()));
+  }
+
+  auto duration = FindChild<KaxBlockDuration>(block_group);
+  if (duration)
+    block.duration = duration->GetValue();
+
+  for (auto ref_block = FindChild<KaxReferenceBlock>(block_group); ref_block; ref_block = FindNextChild(*block_group, *ref_block))
+    block.references.push_back(ref_block->GetValue());
+
+  // The block group is freed before the packets are processed
+  // completely.
+  auto codec_state = FindChild<KaxCodecState>(block_group);
+  if (codec_state)
+    block.codec_state = memory_c::clone(codec_state->GetBuffer(), codec_state->GetSize());
+
+  auto discard_padding = FindChild<KaxDiscardPadding>(block_group);
+  if (discard_padding)
+    block.discard_padding = discard_padding->GetValue();
+
+  auto blockadd = FindChild<KaxBlockAdditions>(block_group);
+  if (blockadd) {
+    for (auto &child : *blockadd) {
+      if (!(Is<KaxBlockMore>(child)))
+        continue;
+
+      auto blockmore     = static_cast<KaxBlockMore *>(child);
+      auto blockadd_data = &GetChild<KaxBlockAdditional>(*blockmore);
+      block.additions.emplace_back(memory_c::borrow(blockadd_data->GetBuffer(), blockadd_data->GetSize()));
+    }
+  }
+
+  process_block_group(block);
+}
+
+void
+kax_reader_c::process_block_group(mtx::kax::raw_block_t const &block) {
+  auto block_track     = find_track_by_num(block.track_number);
+  auto block_timestamp = block.timestamp - m_global_timestamp_offset;
+  auto num_frames      = block.frames.size();
 
   if (!block_track) {
-    if (!m_known_bad_track_numbers[block->TrackNum()])
+    if (!m_known_bad_track_numbers[block.track_number])
       mxwarn_fn(m_ti.m_fname,
                 fmt::format(Y("A block was found at timestamp {0} for track number {1}. However, no headers were found for that track number. "
-                              "The block will be skipped.\n"), mtx::string::format_timestamp(block_timestamp), block->TrackNum()));
+                              "The block will be skipped.\n"), mtx::string::format_timestamp(block_timestamp), block.track_number));
     return;
   }
 
-  auto duration       = FindChild<KaxBlockDuration>(block_group);
-  auto block_duration = duration             ? static_cast<int64_t>(duration->GetValue() * m_tc_scale / block->NumberFrames())
+  auto block_duration = block.duration      ? static_cast<int64_t>(*block.duration * m_tc_scale / num_frames)
                       : block_track->v_frate ? static_cast<int64_t>(1000000000.0 / block_track->v_frate)
                       :                        int64_t{-1};
   auto frame_duration = -1 == block_duration ? int64_t{0} : block_duration;
   m_last_timestamp    = block_timestamp;
 
-  if (0 < block->NumberFrames())
-    m_in_file->set_last_timestamp(m_last_timestamp + (block->NumberFrames() - 1) * frame_duration);
+  if (0 < num_frames)
+    m_in_file->set_last_timestamp(m_last_timestamp + (num_frames - 1) * frame_duration);
 
   if (-1 == block_track->ptzr)
     return;
@@ -2470,18 +2572,15 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
   auto block_fref = int64_t{VFT_NOBFRAME};
   bool bref_found = false;
   bool fref_found = false;
-  auto ref_block  = FindChild<KaxReferenceBlock>(block_group);
 
-  while (ref_block) {
-    if (0 >= ref_block->GetValue()) {
-      block_bref = ref_block->GetValue() * m_tc_scale;
+  for (auto reference : block.references) {
+    if (0 >= reference) {
+      block_bref = reference * m_tc_scale;
       bref_found = true;
     } else {
-      block_fref = ref_block->GetValue() * m_tc_scale;
+      block_fref = reference * m_tc_scale;
       fref_found = true;
     }
-
-    ref_block = FindNextChild(*block_group, *ref_block);
   }
 
   if (block_track->ignore_duration_hack) {
@@ -2500,15 +2599,14 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
       block_fref += m_last_timestamp;
 
     size_t i;
-    for (i = 0; i < block->NumberFrames(); i++) {
-      auto &data_buffer = block->GetBuffer(i);
-      auto data         = memory_c::borrow(data_buffer.Buffer(), data_buffer.Size());
+    for (i = 0; i < num_frames; i++) {
+      auto data = block.frames[i];
       block_track->content_decoder.reverse(data, CONTENT_ENCODING_SCOPE_BLOCK);
 
-      auto packet                = std::make_shared<packet_t>(data, m_last_timestamp + i * frame_duration, block_duration, block_bref, block_fref);
-      packet->duration_mandatory = duration;
+      auto packet                = make_packet(data, m_last_timestamp + i * frame_duration, block_duration, block_bref, block_fref);
+      packet->duration_mandatory = !!block.duration;
 
-      process_block_group_common(block_group, packet.get(), *block_track);
+      process_block_group_common(block, packet.get(), *block_track);
 
       static_cast<passthrough_packetizer_c *>(PTZR(block_track->ptzr))->process(packet);
     }
@@ -2521,23 +2619,22 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
   if (fref_found)
     block_fref += m_last_timestamp;
 
-  for (auto block_idx = 0u, num_frames = block->NumberFrames(); block_idx < num_frames; ++block_idx) {
-    auto &data_buffer = block->GetBuffer(block_idx);
-    auto data         = memory_c::borrow(data_buffer.Buffer(), data_buffer.Size());
+  for (auto block_idx = 0u; block_idx < num_frames; ++block_idx) {
+    auto data = block.frames[block_idx];
     block_track->content_decoder.reverse(data, CONTENT_ENCODING_SCOPE_BLOCK);
 
-    auto packet = std::make_shared<packet_t>(data, m_last_timestamp + block_idx * frame_duration, block_duration, block_bref, block_fref);
+    auto packet = make_packet(data, m_last_timestamp + block_idx * frame_duration, block_duration, block_bref, block_fref);
 
-    if (duration && !duration->GetValue())
+    if (block.duration && !*block.duration)
       packet->duration_mandatory = true;
 
-    process_block_group_common(block_group, packet.get(), *block_track);
+    process_block_group_common(block, packet.get(), *block_track);
 
     PTZR(block_track->ptzr)->process(packet);
   }
 
   block_track->previous_timestamp  = m_last_timestamp;
-  block_track->units_processed    += block->NumberFrames();
+  block_track->units_processed    += num_frames;
 }
 
 void
@@ -16,6 +16,7 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
 #include <ctime>
 
 #include "common/codec.h"
@@ -211,6 +212,10 @@ private:
 
   kax_file_cptr m_in_file;
 
+  // Size of the clusters read by the fast cluster reader that are
+  // still referenced, e.g. by packets queued in packetizers
+  std::shared_ptr<std::atomic<int64_t>> m_raw_cluster_bytes{std::make_shared<std::atomic<int64_t>>(0)};
+
   std::shared_ptr<libebml::EbmlStream> m_es;
 
   int64_t m_segment_duration{}, m_last_timestamp{}, m_global_timestamp_offset{};
@@ -234,6 +239,7 @@ private:
   bool m_opus_experimental_warning_shown{}, m_regenerate_chapter_uids{};
 
   debugging_option_c m_debug_minimum_timestamp{"kax_reader|kax_reader_minimum_timestamp"}, m_debug_track_headers{"kax_reader|kax_reader_track_headers"};
+  debugging_option_c m_debug_skip_blocks{"kax_reader|kax_reader_skip_blocks"};
 
 public:
   kax_reader_c();
@@ -252,6 +258,8 @@ public:
 
   virtual bool probe_file() override;
 
+  virtual int64_t get_queued_bytes() const override;
+
 protected:
   virtual file_status_e read(generic_packetizer_c *ptzr, bool force = false) override;
   virtual file_status_e finish_file();
@@ -298,6 +306,8 @@ protected:
   virtual void create_subtitle_packetizer(kax_track_t *t, track_info_c &nti);
   virtual void create_button_packetizer(kax_track_t *t, track_info_c &nti);
 
+  virtual void skip_blocks_of_unused_tracks();
+
   virtual void create_aac_audio_packetizer(kax_track_t *t, track_info_c &nti);
   virtual void create_ac3_audio_packetizer(kax_track_t *t, track_info_c &nti);
   virtual void create_alac_audio_packetizer(kax_track_t *t, track_info_c &nti);
@@ -333,8 +343,10 @@ protected:
   virtual void find_level1_elements_via_analyzer();
 
   virtual void process_simple_block(libmatroska::KaxCluster *cluster, libmatroska::KaxSimpleBlock *block_simple);
+  virtual void process_simple_block(mtx::kax::raw_block_t const &block);
   virtual void process_block_group(libmatroska::KaxCluster *cluster, libmatroska::KaxBlockGroup *block_group);
-  virtual void process_block_group_common(libmatroska::KaxBlockGroup *block_group, packet_t *packet, kax_track_t &track);
+  virtual void process_block_group(mtx::kax::raw_block_t const &block);
+  virtual void process_block_group_common(mtx::kax::raw_block_t const &block, packet_t *packet, kax_track_t &track);
 
   void init_l1_position_storage(deferred_positions_t &storage);
   virtual bool has_deferred_element_been_processed(deferred_l1_type_e type, int64_t position);
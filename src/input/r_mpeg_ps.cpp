@@ -27,6 +27,7 @@
 #include "common/truehd.h"
 #include "input/r_mpeg_ps.h"
 #include "merge/file_status.h"
+#include "merge/memory_budget.h"
 #include "mpegparser/M2VParser.h"
 #include "output/p_ac3.h"
 #include "output/p_avc_es.h"
@@ -1288,9 +1289,9 @@ mpeg_ps_reader_c::read(generic_packetizer_c *requested_ptzr,
     return flush_packetizers();
 
   auto num_queued_bytes = get_queued_bytes();
-  if (!force && (20 * 1024 * 1024 < num_queued_bytes)) {
+  if (!force && mtx::merge::memory_budget::exceeds_soft_limit(num_queued_bytes)) {
     mpeg_ps_track_ptr requested_ptzr_track = m_ptzr_to_track_map[requested_ptzr];
-    if (!requested_ptzr_track || (('a' != requested_ptzr_track->type) && ('v' != requested_ptzr_track->type)) || (64 * 1024 * 1024 < num_queued_bytes))
+    if (!requested_ptzr_track || (('a' != requested_ptzr_track->type) && ('v' != requested_ptzr_track->type)) || mtx::merge::memory_budget::exceeds_hard_limit(num_queued_bytes, 64 * 1024 * 1024))
       return FILE_STATUS_HOLDING;
   }
 
@@ -1333,7 +1334,7 @@ mpeg_ps_reader_c::read(generic_packetizer_c *requested_ptzr,
 
       if (0 < track->buffer_size) {
         if (((track->buffer_usage + packet.m_length) > track->buffer_size)) {
-          auto new_packet = std::make_shared<packet_t>(memory_c::borrow(track->buffer, track->buffer_usage));
+          auto new_packet = make_packet(memory_c::borrow(track->buffer, track->buffer_usage));
 
           if (!track->multiple_timestamps_packet_extension->empty()) {
             new_packet->extensions.push_back(packet_extension_cptr(track->multiple_timestamps_packet_extension));
@@ -25,6 +25,8 @@
 #include "common/checksums/crc.h"
 #include "common/checksums/base_fwd.h"
 #include "common/endian.h"
+#include "common/fs_sys_helpers.h"
+#include "common/hacks.h"
 #include "common/hdmv_textst.h"
 #include "common/mp3.h"
 #include "common/mm_file_io.h"
@@ -46,6 +48,7 @@
 #include "input/teletext_to_srt_packet_converter.h"
 #include "input/truehd_ac3_splitting_packet_converter.h"
 #include "merge/cluster_helper.h"
+#include "merge/memory_budget.h"
 #include "merge/output_control.h"
 #include "output/p_aac.h"
 #include "output/p_ac3.h"
@@ -67,11 +70,18 @@
 #define TS_PACKET_SIZE     188
 #define TS_MAX_PACKET_SIZE 204
 
+#define TS_NUM_PIDS        0x2000
+
 #define TS_PAT_PID         0x0000
 #define TS_SDT_PID         0x0011
 
 #define TS_SDT_TID         0x42
 
+// Budgets for probing with "--engage fast_mpeg_ts_probing", counted
+// from the point at which the PAT & all PMTs have been found.
+#define TS_FAST_PROBING_MAX_BYTES  (4 * 1024 * 1024)
+#define TS_FAST_PROBING_MAX_MILLIS 250
+
 namespace mtx::mpeg_ts {
 
 int reader_c::potential_packet_sizes[] = { 188, 192, 204, 0 };
@@ -88,7 +98,7 @@ track_c::track_c(reader_c &p_reader,
   , pid{}
   , program_number{}
   , pes_payload_size_to_read{}
-  , pes_payload_read{new mtx::bytes::buffer_c}
+  , pes_payload_read{new mtx::bytes::gather_buffer_c}
   , probed_ok{}
   , ptzr{-1}
   , m_timestamp_wrap_add{timestamp_c::ns(0)}
@@ -154,7 +164,8 @@ track_c::send_to_packetizer() {
                          pid, pes_payload_size_to_read, pes_payload_read->get_size() - bytes_to_skip, timestamp_to_use, timestamp_to_check, m_timestamp, m_previous_timestamp, f.m_stream_timestamp, min, max, ptzr, use_packet));
 
   if (use_packet) {
-    process(std::make_shared<packet_t>(memory_c::clone(pes_payload_read->get_buffer() + bytes_to_skip, pes_payload_read->get_size() - bytes_to_skip), timestamp_to_use.to_ns(-1)));
+    pes_payload_read->remove(bytes_to_skip);
+    process(make_packet(pes_payload_read->detach(), timestamp_to_use.to_ns(-1)));
 
     f.m_packet_sent_to_packetizer = true;
   }
@@ -184,7 +195,16 @@ track_c::add_pes_payload(unsigned char *ts_payload,
                          size_t ts_payload_size) {
   auto to_add = is_pes_payload_size_unbounded() ? ts_payload_size : std::min(ts_payload_size, remaining_payload_size_to_read());
 
-  if (to_add)
+  if (!to_add)
+    return;
+
+  // Payloads of packets read in batches are only referenced. They're
+  // copied once the PES packet is complete.
+  auto &batch = reader.file().m_packet_batch;
+
+  if (batch && (ts_payload >= batch->get_buffer()) && (ts_payload < (batch->get_buffer() + batch->get_size())))
+    pes_payload_read->add(batch, ts_payload, to_add);
+  else
     pes_payload_read->add(ts_payload, to_add);
 }
 
@@ -470,6 +490,8 @@ track_c::new_stream_a_truehd() {
         coupled_track.a_sample_rate = header.m_sample_rate;
         coupled_track.a_bsid        = header.m_bs_id;
         coupled_track.probed_ok     = true;
+
+        --reader.file().m_es_to_process;
       }
 
       continue;
@@ -854,90 +876,85 @@ track_c::derive_hdmv_textst_pts_from_content() {
   return timestamp;
 }
 
-void
-track_c::determine_codec_from_stream_type(stream_type_e stream_type) {
+// Maps a stream type from a PMT or from Blu-ray clip information to
+// the types of track and codec it results in. Unknown stream types
+// result in pid_type_e::unknown.
+std::pair<pid_type_e, codec_c::type_e>
+track_c::look_up_stream_type(stream_type_e stream_type) {
   switch (stream_type) {
     case stream_type_e::iso_11172_video:
     case stream_type_e::iso_13818_video:
-      type  = pid_type_e::video;
-      codec = codec_c::look_up(codec_c::type_e::V_MPEG12);
-      break;
+      return { pid_type_e::video,     codec_c::type_e::V_MPEG12 };
     case stream_type_e::iso_14496_part2_video:
-      type  = pid_type_e::video;
-      codec = codec_c::look_up(codec_c::type_e::V_MPEG4_P2);
-      break;
+      return { pid_type_e::video,     codec_c::type_e::V_MPEG4_P2 };
     case stream_type_e::iso_14496_part10_video:
-      type  = pid_type_e::video;
-      codec = codec_c::look_up(codec_c::type_e::V_MPEG4_P10);
-      break;
+      return { pid_type_e::video,     codec_c::type_e::V_MPEG4_P10 };
     case stream_type_e::iso_23008_part2_video:
-      type  = pid_type_e::video;
-      codec = codec_c::look_up(codec_c::type_e::V_MPEGH_P2);
-      break;
+      return { pid_type_e::video,     codec_c::type_e::V_MPEGH_P2 };
     case stream_type_e::stream_video_vc1:
-      type  = pid_type_e::video;
-      codec = codec_c::look_up(codec_c::type_e::V_VC1);
-      break;
+      return { pid_type_e::video,     codec_c::type_e::V_VC1 };
     case stream_type_e::iso_11172_audio:
     case stream_type_e::iso_13818_audio:
-      type  = pid_type_e::audio;
-      codec = codec_c::look_up(codec_c::type_e::A_MP3);
-      break;
+      return { pid_type_e::audio,     codec_c::type_e::A_MP3 };
     case stream_type_e::iso_13818_part7_audio:
     case stream_type_e::iso_14496_part3_audio:
-      type  = pid_type_e::audio;
-      codec = codec_c::look_up(codec_c::type_e::A_AAC);
-      break;
+      return { pid_type_e::audio,     codec_c::type_e::A_AAC };
     case stream_type_e::stream_audio_pcm:
-      type  = pid_type_e::audio;
-      codec = codec_c::look_up(codec_c::type_e::A_PCM);
-      break;
-
-    case stream_type_e::stream_audio_ac3_lossless: {
-      auto ac3_track       = std::make_shared<track_c>(*this);
-      ac3_track->type      = pid_type_e::audio;
-      ac3_track->codec     = codec_c::look_up(codec_c::type_e::A_AC3);
-      ac3_track->converter = std::make_shared<truehd_ac3_splitting_packet_converter_c>();
-      ac3_track->m_master  = this;
-      ac3_track->set_pid(pid);
-
-      type                 = pid_type_e::audio;
-      codec                = codec_c::look_up(codec_c::type_e::A_TRUEHD);
-      converter            = ac3_track->converter;
-      m_coupled_tracks.push_back(ac3_track);
-
-      break;
-    }
-
+      return { pid_type_e::audio,     codec_c::type_e::A_PCM };
+    case stream_type_e::stream_audio_ac3_lossless:
+      return { pid_type_e::audio,     codec_c::type_e::A_TRUEHD };
     case stream_type_e::stream_audio_ac3:
     case stream_type_e::stream_audio_eac3:      // E-AC-3
     case stream_type_e::stream_audio_eac3_2:    // E-AC-3 secondary stream
     case stream_type_e::stream_audio_eac3_atsc: // E-AC-3 as defined in ATSC A/52:2012 Annex G
-      type      = pid_type_e::audio;
-      codec     = codec_c::look_up(codec_c::type_e::A_AC3);
-      break;
+      return { pid_type_e::audio,     codec_c::type_e::A_AC3 };
     case stream_type_e::stream_audio_dts:
     case stream_type_e::stream_audio_dts_hd:
     case stream_type_e::stream_audio_dts_hd_ma:
     case stream_type_e::stream_audio_dts_hd2:
-      type      = pid_type_e::audio;
-      codec     = codec_c::look_up(codec_c::type_e::A_DTS);
-      break;
+      return { pid_type_e::audio,     codec_c::type_e::A_DTS };
     case stream_type_e::stream_subtitles_hdmv_pgs:
-      type      = pid_type_e::subtitles;
-      codec     = codec_c::look_up(codec_c::type_e::S_HDMV_PGS);
-      probed_ok = true;
-      break;
+      return { pid_type_e::subtitles, codec_c::type_e::S_HDMV_PGS };
     case stream_type_e::stream_subtitles_hdmv_textst:
-      type      = pid_type_e::subtitles;
-      codec     = codec_c::look_up(codec_c::type_e::S_HDMV_TEXTST);
-      break;
-    case stream_type_e::iso_13818_pes_private:
-      break;
+      return { pid_type_e::subtitles, codec_c::type_e::S_HDMV_TEXTST };
     default:
-      mxdebug_if(reader.m_debug_pat_pmt, fmt::format("parse_pmt: Unknown stream type: {0}\n", static_cast<int>(stream_type)));
-      type      = pid_type_e::unknown;
-      break;
+      return { pid_type_e::unknown,   codec_c::type_e::UNKNOWN };
+  }
+}
+
+void
+track_c::determine_codec_from_stream_type(stream_type_e stream_type) {
+  // The type of private PES streams is determined from their
+  // descriptors.
+  if (stream_type_e::iso_13818_pes_private == stream_type)
+    return;
+
+  auto types = look_up_stream_type(stream_type);
+
+  type = types.first;
+
+  if (pid_type_e::unknown == type) {
+    mxdebug_if(reader.m_debug_pat_pmt, fmt::format("parse_pmt: Unknown stream type: {0}\n", static_cast<int>(stream_type)));
+    return;
+  }
+
+  codec = codec_c::look_up(types.second);
+
+  if (stream_type_e::stream_subtitles_hdmv_pgs == stream_type)
+    probed_ok = true;
+
+  else if (stream_type_e::stream_audio_ac3_lossless == stream_type) {
+    // TrueHD streams contain an AC-3 core that is provided as a track
+    // of its own.
+    auto ac3_track       = std::make_shared<track_c>(*this);
+    ac3_track->type      = pid_type_e::audio;
+    ac3_track->codec     = codec_c::look_up(codec_c::type_e::A_AC3);
+    ac3_track->converter = std::make_shared<truehd_ac3_splitting_packet_converter_c>();
+    ac3_track->m_master  = this;
+    ac3_track->set_pid(pid);
+
+    converter            = ac3_track->converter;
+    m_coupled_tracks.push_back(ac3_track);
   }
 }
 
@@ -1014,6 +1031,61 @@ file_t::reset_processing_state(processing_state_e new_state) {
   m_state = new_state;
   m_last_non_subtitle_pts.reset();
   m_last_non_subtitle_dts.reset();
+  m_pid_to_track_map.clear();
+  discard_packet_batch();
+}
+
+// Returns the next packet or nullptr at the end of the file and sets
+// m_position to the packet's position. Reading with a single call for
+// many packets avoids going through mm_io_c for each of them; a
+// partial packet at the end of a batch is moved to the front of the
+// next one.
+unsigned char *
+file_t::read_next_packet() {
+  static std::size_t constexpr s_num_packets_per_batch = 1024;
+
+  if ((m_packet_batch_pos + m_detected_packet_size) > m_packet_batch_fill) {
+    auto remaining      = m_packet_batch_fill - m_packet_batch_pos;
+    auto previous_batch = m_packet_batch;
+
+    // PES payloads may still refer to packets of the current batch. Its
+    // memory is only re-used if none does.
+    if (!previous_batch || (previous_batch.use_count() > 2))
+      m_packet_batch = memory_c::alloc(s_num_packets_per_batch * m_detected_packet_size);
+
+    auto buffer = m_packet_batch->get_buffer();
+
+    if (remaining)
+      std::memmove(buffer, previous_batch->get_buffer() + m_packet_batch_pos, remaining);
+
+    m_packet_batch_pos  = 0;
+    m_packet_batch_fill = remaining + m_in->read(buffer + remaining, m_packet_batch->get_size() - remaining);
+
+    if (m_packet_batch_fill < m_detected_packet_size)
+      return nullptr;
+  }
+
+  m_position  = get_read_position();
+  auto packet = m_packet_batch->get_buffer() + m_packet_batch_pos;
+
+  m_packet_batch_pos += m_detected_packet_size;
+
+  return packet;
+}
+
+// Must be called before the file position is changed while packets
+// read in a batch haven't been parsed yet.
+void
+file_t::discard_packet_batch() {
+  m_packet_batch_pos  = 0;
+  m_packet_batch_fill = 0;
+}
+
+// The position of the next packet to parse.
+uint64_t
+file_t::get_read_position()
+  const {
+  return m_in->getFilePointer() - (m_packet_batch_fill - m_packet_batch_pos);
 }
 
 bool
@@ -1032,7 +1104,9 @@ file_t::get_start_source_packet_position()
 
 bool
 reader_c::probe_file() {
-  return detect_packet_size(*m_in, m_in->get_size()) > 0;
+  m_probed_packet_size = detect_packet_size(*m_in, m_in->get_size());
+
+  return m_probed_packet_size > 0;
 }
 
 int
@@ -1107,7 +1181,9 @@ reader_c::read_headers_for_file(std::size_t file_num) {
     f.m_probe_range          = calculate_probe_range(file_size, 10 * 1024 * 1024);
     auto size_to_probe       = std::min<uint64_t>(file_size,     f.m_probe_range);
     auto min_size_to_probe   = std::min<uint64_t>(size_to_probe, 5 * 1024 * 1024);
-    f.m_detected_packet_size = detect_packet_size(*f.m_in, size_to_probe);
+    // probe_file() has already looked at the start of the first file
+    // the same way.
+    f.m_detected_packet_size = (0 == file_num) && (0 < m_probed_packet_size) ? m_probed_packet_size : detect_packet_size(*f.m_in, size_to_probe);
 
     f.m_in->setFilePointer(0);
 
@@ -1115,6 +1191,15 @@ reader_c::read_headers_for_file(std::size_t file_num) {
 
     unsigned char buf[TS_MAX_PACKET_SIZE]; // maximum TS packet size + 1
 
+    // In fast mode the budgets only start once the program structure
+    // is known; until then the whole probe range is searched for the
+    // PAT & the PMTs.
+    auto fast_probing          = mtx::hacks::is_engaged(mtx::hacks::FAST_MPEG_TS_PROBING);
+    auto clip_info_pids        = fast_probing ? get_clip_info_pids_to_probe(f) : std::vector<uint16_t>{};
+    auto programs_found_at     = std::optional<uint64_t>{};
+    auto programs_found_millis = int64_t{};
+    auto num_packets           = 0u;
+
     while (true) {
       if (f.m_in->read(buf, f.m_detected_packet_size) != static_cast<unsigned int>(f.m_detected_packet_size))
         break;
@@ -1127,12 +1212,28 @@ reader_c::read_headers_for_file(std::size_t file_num) {
 
       parse_packet(buf);
 
-      if (   f.m_pat_found
-          && f.all_pmts_found()
+      auto programs_found = f.m_pat_found && f.all_pmts_found();
+
+      if (   programs_found
           && (0 == f.m_es_to_process)
-          && (f.m_in->getFilePointer() >= min_size_to_probe))
+          && (   (f.m_in->getFilePointer() >= min_size_to_probe)
+              || (fast_probing && all_clip_info_streams_probed(clip_info_pids))))
         break;
 
+      if (fast_probing && programs_found) {
+        if (!programs_found_at) {
+          programs_found_at     = f.m_in->getFilePointer();
+          programs_found_millis = mtx::sys::get_current_time_millis();
+        }
+
+        if (   (f.m_in->getFilePointer() >= (*programs_found_at + TS_FAST_PROBING_MAX_BYTES))
+            || (   ((++num_packets % 256) == 0)
+                && (mtx::sys::get_current_time_millis() >= (programs_found_millis + TS_FAST_PROBING_MAX_MILLIS)))) {
+          mxdebug_if(m_debug_headers, fmt::format("read_headers: fast probing budget exhausted; ES to process: {0}\n", f.m_es_to_process));
+          break;
+        }
+      }
+
       auto eof = f.m_in->eof() || (f.m_in->getFilePointer() >= size_to_probe);
       if (!eof)
         continue;
@@ -1157,6 +1258,7 @@ reader_c::read_headers_for_file(std::size_t file_num) {
 
       f.m_in->setFilePointer(0);
       f.m_in->clear_eof();
+      programs_found_at.reset();
 
       setup_initial_tracks();
     }
@@ -1228,13 +1330,18 @@ reader_c::read_headers() {
     add_external_files_from_mpls(*mpls_in);
   }
 
+  // The clip information is read first so that fast probing knows
+  // which streams to expect.
+  for (int idx = 0, num_files = m_files.size(); idx < num_files; ++idx)
+    parse_clip_info_file(idx);
+
   for (int idx = 0, num_files = m_files.size(); idx < num_files; ++idx)
     read_headers_for_file(idx);
 
   m_tracks = std::move(m_all_probed_tracks);
 
   for (int idx = 0, num_files = m_files.size(); idx < num_files; ++idx) {
-    parse_clip_info_file(idx);
+    set_track_languages_from_clip_info(idx);
     determine_start_source_packet_number(*m_files[idx]);
   }
 
@@ -1592,10 +1699,17 @@ reader_c::parse_pmt_pid_info(mm_mem_io_c &mem,
   if (track->type != pid_type_e::unknown) {
     track->processed = false;
     m_tracks.push_back(track);
-    ++f.m_es_to_process;
-
     std::copy(track->m_coupled_tracks.begin(), track->m_coupled_tracks.end(), std::back_inserter(m_tracks));
-    f.m_es_to_process += track->m_coupled_tracks.size();
+
+    // Tracks whose parameters are known from the PMT alone
+    // (e.g. HDMV PGS or teletext pages) don't have to wait for their
+    // content.
+    if (!track->probed_ok)
+      ++f.m_es_to_process;
+
+    for (auto const &coupled_track : track->m_coupled_tracks)
+      if (!coupled_track->probed_ok)
+        ++f.m_es_to_process;
   }
 
   mxdebug_if(m_debug_pat_pmt,
@@ -1921,6 +2035,7 @@ reader_c::parse_pes(track_c &track) {
 
   if (f.m_timestamp_restriction_max.valid() && has_pts && (pts >= f.m_timestamp_restriction_max)) {
     mxdebug_if(m_debug_mpls, fmt::format("MPLS: stopping processing file as PTS {0} >= max. timestamp restriction {1}\n", pts, f.m_timestamp_restriction_max));
+    f.discard_packet_batch();
     f.m_in->setFilePointer(f.m_in->get_size());
     return;
   }
@@ -1989,21 +2104,27 @@ reader_c::parse_packet(unsigned char *buf) {
   if (!track)
     track = handle_packet_for_pid_not_listed_in_pmt(hdr->get_pid());
 
-  if (   !track
-      || !hdr->has_payload())   // no ts_payload
+  if (track)
+    parse_packet_for_track(*track, *hdr);
+}
+
+void
+reader_c::parse_packet_for_track(track_c &track,
+                                 packet_header_t &hdr) {
+  if (!hdr.has_payload())       // no ts_payload
     return;
 
-  if (mtx::included_in(track->type, pid_type_e::video, pid_type_e::audio, pid_type_e::subtitles, pid_type_e::unknown))
-    handle_transport_errors(*track, *hdr);
+  if (mtx::included_in(track.type, pid_type_e::video, pid_type_e::audio, pid_type_e::subtitles, pid_type_e::unknown))
+    handle_transport_errors(track, hdr);
 
-  if (   hdr->has_transport_error() // corrupted packet
-      || track->processed)
+  if (   hdr.has_transport_error() // corrupted packet
+      || track.processed)
     return;
 
-  auto payload = determine_ts_payload_start(hdr);
+  auto payload = determine_ts_payload_start(&hdr);
 
   if (payload.second)
-    handle_ts_payload(*track, *hdr, payload.first, payload.second);
+    handle_ts_payload(track, hdr, payload.first, payload.second);
 }
 
 void
@@ -2172,8 +2293,6 @@ reader_c::determine_track_parameters(track_c &track,
     else if (track.codec.is(codec_c::type_e::V_VC1))
       return track.new_stream_v_vc1();
 
-    track.pes_payload_read->set_chunk_size(512 * 1024);
-
   } else if (track.type == pid_type_e::subtitles) {
     if (track.codec.is(codec_c::type_e::S_HDMV_TEXTST))
       return track.new_stream_s_hdmv_textst();
@@ -2452,6 +2571,10 @@ reader_c::finish() {
 
     if (-1 != track->ptzr)
       PTZR(track->ptzr)->flush();
+
+    mxdebug_if(m_debug_copies,
+               fmt::format("finish: PID {0}: {1} bytes of PES payload, {2} bytes copied\n",
+                           track->pid, track->pes_payload_read->get_num_bytes_added(), track->pes_payload_read->get_num_bytes_copied()));
   }
 
   file().m_file_done = true;
@@ -2473,22 +2596,22 @@ reader_c::read(generic_packetizer_c *requested_ptzr,
   auto &f               = file();
   auto num_queued_bytes = f.get_queued_bytes();
 
-  if (!force && (20 * 1024 * 1024 < num_queued_bytes)) {
+  if (!force && mtx::merge::memory_budget::exceeds_soft_limit(num_queued_bytes)) {
     if (   !requested_ptzr_track
         || !mtx::included_in(requested_ptzr_track->type, pid_type_e::audio, pid_type_e::video)
-        || (512 * 1024 * 1024 < num_queued_bytes))
+        || mtx::merge::memory_budget::exceeds_hard_limit(num_queued_bytes, 512 * 1024 * 1024))
       return FILE_STATUS_HOLDING;
   }
 
   f.m_packet_sent_to_packetizer = false;
-  auto prior_position           = f.m_in->getFilePointer();
+  auto prior_position           = f.get_read_position();
 
-  unsigned char buf[TS_MAX_PACKET_SIZE + 1];
+  if (f.m_pid_to_track_map.empty())
+    build_pid_to_track_map();
 
   while (!f.m_packet_sent_to_packetizer) {
-    f.m_position = f.m_in->getFilePointer();
-
-    if (f.m_in->read(buf, f.m_detected_packet_size) != static_cast<unsigned int>(f.m_detected_packet_size))
+    auto buf = f.read_next_packet();
+    if (!buf)
       return finish();
 
     if (buf[0] != 0x47) {
@@ -2499,14 +2622,31 @@ reader_c::read(generic_packetizer_c *requested_ptzr,
 
     ++m_packet_num;
 
-    parse_packet(buf);
+    auto hdr   = reinterpret_cast<packet_header_t *>(buf);
+    auto track = f.m_pid_to_track_map[hdr->get_pid()];
+
+    if (track)
+      parse_packet_for_track(*track, *hdr);
   }
 
-  m_bytes_processed += f.m_in->getFilePointer() - prior_position;
+  m_bytes_processed += f.get_read_position() - prior_position;
 
   return FILE_STATUS_MOREDATA;
 }
 
+void
+reader_c::build_pid_to_track_map() {
+  // Which track a PID's packets belong to doesn't change while
+  // multiplexing, so it's determined once for all possible PIDs instead
+  // of searching the tracks for each packet.
+  auto &f = file();
+
+  f.m_pid_to_track_map.resize(TS_NUM_PIDS);
+
+  for (auto pid = 0u; pid < TS_NUM_PIDS; ++pid)
+    f.m_pid_to_track_map[pid] = find_track_for_pid(pid).get();
+}
+
 void
 reader_c::parse_clip_info_file(std::size_t file_idx) {
   auto &file         = *m_files[file_idx];
@@ -2523,10 +2663,16 @@ reader_c::parse_clip_info_file(std::size_t file_idx) {
     return;
 
   file.m_clpi_parser.reset(new mtx::bluray::clpi::parser_c{clpi_file.string()});
-  if (!file.m_clpi_parser->parse()) {
+  if (!file.m_clpi_parser->parse())
     file.m_clpi_parser.reset();
+}
+
+void
+reader_c::set_track_languages_from_clip_info(std::size_t file_idx) {
+  auto &file = *m_files[file_idx];
+
+  if (!file.m_clpi_parser)
     return;
-  }
 
   for (auto &track : m_tracks) {
     if (track->m_file_num != file_idx)
@@ -2550,12 +2696,42 @@ reader_c::parse_clip_info_file(std::size_t file_idx) {
   }
 }
 
+// Blu-ray clip information lists all of a clip's streams, including
+// the ones missing from its PMT. Interactive graphics and other
+// streams that never become tracks aren't waited for.
+std::vector<uint16_t>
+reader_c::get_clip_info_pids_to_probe(file_t const &file) {
+  std::vector<uint16_t> pids;
+
+  if (!file.m_clpi_parser)
+    return pids;
+
+  for (auto const &program : file.m_clpi_parser->m_programs)
+    for (auto const &stream : program->program_streams)
+      if (track_c::look_up_stream_type(static_cast<stream_type_e>(stream->coding_type)).first != pid_type_e::unknown)
+        pids.push_back(stream->pid);
+
+  return pids;
+}
+
+bool
+reader_c::all_clip_info_streams_probed(std::vector<uint16_t> &pids_to_probe)
+  const {
+  pids_to_probe.erase(std::remove_if(pids_to_probe.begin(), pids_to_probe.end(), [this](uint16_t pid) {
+    auto track = find_track_for_pid(pid);
+    return track && track->probed_ok;
+  }), pids_to_probe.end());
+
+  return pids_to_probe.empty();
+}
+
 bool
 reader_c::resync(int64_t start_at) {
   auto &f = file();
 
   try {
     mxdebug_if(m_debug_resync, fmt::format("resync: Start resync for data from {0}\n", start_at));
+    f.discard_packet_batch();
     f.m_in->setFilePointer(start_at);
 
     unsigned char buf[TS_MAX_PACKET_SIZE + 1];
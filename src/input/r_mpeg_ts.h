@@ -22,6 +22,7 @@
 #include "common/codec.h"
 #include "common/endian.h"
 #include "common/dts.h"
+#include "common/gather_buffer.h"
 #include "common/hevc.h"
 #include "common/truehd.h"
 #include "common/vc1_fwd.h"
@@ -302,7 +303,7 @@ public:
   std::optional<int> m_ttx_wanted_page;
   std::optional<uint8_t> m_expected_next_continuity_counter;
   std::size_t pes_payload_size_to_read; // size of the current PID payload in bytes
-  mtx::bytes::buffer_cptr pes_payload_read;    // buffer with the current PID payload
+  mtx::bytes::gather_buffer_cptr pes_payload_read; // buffer with the current PID payload
 
   bool probed_ok;
   int ptzr;                         // the actual packetizer instance
@@ -386,6 +387,7 @@ public:
   timestamp_c derive_hdmv_textst_pts_from_content();
 
   void determine_codec_from_stream_type(stream_type_e stream_type);
+  static std::pair<pid_type_e, codec_c::type_e> look_up_stream_type(stream_type_e stream_type);
 
   void process(packet_cptr const &packet);
 
@@ -399,8 +401,15 @@ public:
 struct file_t {
   mm_io_cptr m_in;
 
-  std::unordered_map<uint16_t, track_ptr> m_pid_to_track_map;
+  // Tracks by PID while multiplexing, built when the first packet is
+  // read; nullptr for PIDs whose packets are ignored.
+  std::vector<track_c *> m_pid_to_track_map;
   std::unordered_map<uint16_t, bool> m_ignored_pids, m_pmt_pid_seen;
+
+  // Packets are read in batches while multiplexing. The ones not
+  // parsed yet are kept between calls to reader_c::read().
+  memory_cptr m_packet_batch;
+  std::size_t m_packet_batch_pos{}, m_packet_batch_fill{};
   std::vector<generic_packetizer_c *> m_packetizers;
   std::vector<program_t> m_programs;
 
@@ -424,6 +433,10 @@ struct file_t {
 
   int64_t get_queued_bytes() const;
   void reset_processing_state(processing_state_e new_state);
+
+  unsigned char *read_next_packet();
+  void discard_packet_batch();
+  uint64_t get_read_position() const;
   bool all_pmts_found() const;
   uint64_t get_start_source_packet_position() const;
 };
@@ -441,6 +454,7 @@ protected:
   mtx::bluray::mpls::chapters_t m_mpls_chapters;
 
   int64_t m_bytes_to_process{}, m_bytes_processed{};
+  int m_probed_packet_size{};
 
   debugging_option_c
       m_dont_use_audio_pts{      "mpeg_ts|mpeg_ts_dont_use_audio_pts"}
@@ -454,7 +468,8 @@ protected:
     , m_debug_timestamp_wrapping{"mpeg_ts|mpeg_ts_timestamp_wrapping"}
     , m_debug_clpi{              "mpeg_ts|mpeg_ts_clpi|clpi"}
     , m_debug_mpls{              "mpeg_ts|mpeg_ts_mpls|mpls"}
-    , m_debug_timestamp_offset{  "mpeg_ts|mpeg_ts_headers|mpeg_ts_timestamp_offset|mpeg_ts_timestamp_offsets"};
+    , m_debug_timestamp_offset{  "mpeg_ts|mpeg_ts_headers|mpeg_ts_timestamp_offset|mpeg_ts_timestamp_offsets"}
+    , m_debug_copies{            "mpeg_ts|mpeg_ts_copies"};
 
 protected:
   static int potential_packet_sizes[];
@@ -486,6 +501,8 @@ private:
   void read_headers_for_file(std::size_t file_num);
 
   track_ptr find_track_for_pid(uint16_t pid) const;
+  void build_pid_to_track_map();
+  void parse_packet_for_track(track_c &track, packet_header_t &hdr);
   std::pair<unsigned char *, std::size_t> determine_ts_payload_start(packet_header_t *hdr) const;
   void setup_initial_tracks();
 
@@ -525,6 +542,9 @@ private:
   void determine_global_timestamp_offset();
 
   void parse_clip_info_file(std::size_t file_idx);
+  void set_track_languages_from_clip_info(std::size_t file_idx);
+  std::vector<uint16_t> get_clip_info_pids_to_probe(file_t const &file);
+  bool all_clip_info_streams_probed(std::vector<uint16_t> &pids_to_probe) const;
   void determine_start_source_packet_number(file_t &file);
 
   void add_external_files_from_mpls(mm_mpls_multi_file_io_c &mpls_in);
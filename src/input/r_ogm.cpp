@@ -39,6 +39,7 @@
 #include "input/r_ogm_flac.h"
 #include "merge/file_status.h"
 #include "merge/input_x.h"
+#include "merge/memory_budget.h"
 #include "merge/output_control.h"
 #include "output/p_aac.h"
 #include "output/p_ac3.h"
@@ -639,7 +640,7 @@ ogm_reader_c::read(generic_packetizer_c *,
                    bool) {
   // Some tracks may contain huge gaps. We don't want to suck in the complete
   // file.
-  if (get_queued_bytes() > 20 * 1024 * 1024)
+  if (mtx::merge::memory_budget::exceeds_hard_limit(get_queued_bytes(), mtx::merge::memory_budget::default_soft_limit))
     return FILE_STATUS_HOLDING;
 
   ogg_page og;
@@ -794,13 +795,39 @@ ogm_reader_c::handle_language_and_title(mtx::tags::converted_vorbis_comments_t c
   if (converted.m_title.empty())
     return;
 
-  if (!g_segment_title_set && g_segment_title.empty() && dmx->ms_compat) {
-    g_segment_title     = m_chapter_charset_converter->utf8(converted.m_title);
+  dmx->title = m_chapter_charset_converter->utf8(converted.m_title);
+
+  // Whether or not it becomes the segment title is decided by
+  // apply_segment_title().
+  if (m_segment_title.empty() && dmx->ms_compat)
+    m_segment_title = dmx->title;
+}
+
+void
+ogm_reader_c::apply_segment_title(std::string const &segment_title,
+                                  bool chapters_set,
+                                  bool exception_parsing_chapters) {
+  if (!segment_title.empty() && !g_segment_title_set && g_segment_title.empty()) {
+    g_segment_title     = segment_title;
     g_segment_title_set = true;
     m_segment_title_set = true;
   }
 
-  dmx->title = m_chapter_charset_converter->utf8(converted.m_title);
+  if (   exception_parsing_chapters
+      || (   (m_segment_title_set || chapters_set)
+          && !m_charset_warning_printed
+          && (m_ti.m_chapter_charset.empty()))) {
+    mxwarn_fn(m_ti.m_fname,
+              Y("This Ogg/OGM file contains chapter or title information. Unfortunately the charset used to store this information in "
+                "the file cannot be identified unambiguously. The program assumes that your system's current charset is appropriate. This can "
+                "be overridden with the '--chapter-charset <charset>' switch.\n"));
+    m_charset_warning_printed = true;
+
+    if (exception_parsing_chapters)
+      mxwarn_fn(m_ti.m_fname,
+                Y("This Ogg/OGM file contains chapters but they could not be parsed. "
+                  "This can be due to the character set not being set properly for them or due to the entries not matching the expected SRT-style format.\n"));
+  }
 }
 
 void
@@ -831,21 +858,16 @@ ogm_reader_c::handle_stream_comments() {
     handle_language_and_title(converted, dmx);
     handle_tags(converted, dmx);
 
-    if (   m_exception_parsing_chapters
-        || (   (m_segment_title_set || m_chapters_set)
-            && !m_charset_warning_printed
-            && (m_ti.m_chapter_charset.empty()))) {
-      mxwarn_fn(m_ti.m_fname,
-                Y("This Ogg/OGM file contains chapter or title information. Unfortunately the charset used to store this information in "
-                  "the file cannot be identified unambiguously. The program assumes that your system's current charset is appropriate. This can "
-                  "be overridden with the '--chapter-charset <charset>' switch.\n"));
-      m_charset_warning_printed = true;
-
-      if (m_exception_parsing_chapters)
-        mxwarn_fn(m_ti.m_fname,
-                  Y("This Ogg/OGM file contains chapters but they could not be parsed. "
-                    "This can be due to the character set not being set properly for them or due to the entries not matching the expected SRT-style format.\n"));
-    }
+    // The segment title is shared by all source files and must be
+    // taken from the first one containing one, even if headers are
+    // read on several threads. Therefore it's set in the order of the
+    // source files on the main thread.
+    auto apply = [this, segment_title = m_segment_title, chapters_set = m_chapters_set, exception_parsing_chapters = m_exception_parsing_chapters]() {
+      apply_segment_title(segment_title, chapters_set, exception_parsing_chapters);
+    };
+
+    if (!mtx::output::capture_c::defer(apply))
+      apply();
 
     if (!comments.valid())
       continue;
@@ -1182,7 +1204,7 @@ ogm_a_opus_demuxer_c::process_page(int64_t granulepos) {
       continue;
 
     try {
-      auto packet    = std::make_shared<packet_t>(memory_c::clone(op.packet, op.bytes));
+      auto packet    = make_packet(memory_c::clone(op.packet, op.bytes));
       auto toc       = mtx::opus::toc_t::decode(packet->data);
       page_duration += toc.packet_duration;
 
@@ -91,6 +91,7 @@ private:
   int bos_pages_read;
   int64_t m_attachment_id{};
   bool m_charset_warning_printed{}, m_chapters_set{}, m_exception_parsing_chapters{}, m_segment_title_set{};
+  std::string m_segment_title;
   charset_converter_cptr m_chapter_charset_converter;
   debugging_option_c m_debug_tags{"ogg_tags"};
 
@@ -124,5 +125,6 @@ private:
   virtual void handle_cover_art(mtx::tags::converted_vorbis_comments_t const &converted);
   virtual void handle_chapters(mtx::tags::vorbis_comments_t const &comments);
   virtual void handle_language_and_title(mtx::tags::converted_vorbis_comments_t const &converted, ogm_demuxer_cptr const &dmx);
+  virtual void apply_segment_title(std::string const &segment_title, bool chapters_set, bool exception_parsing_chapters);
   virtual void handle_tags(mtx::tags::converted_vorbis_comments_t const &converted, ogm_demuxer_cptr const &dmx);
 };
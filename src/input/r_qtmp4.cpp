@@ -200,7 +200,8 @@ void
 qtmp4_reader_c::calculate_num_bytes_to_process() {
   for (auto const &dmx : m_demuxers)
     if (demuxing_requested(dmx->type, dmx->id, dmx->language))
-      m_bytes_to_process += std::accumulate(dmx->m_index.begin(), dmx->m_index.end(), 0ull, [](int64_t num, auto const &entry) { return num + entry.size; });
+      for (auto idx = 0u, num_entries = static_cast<unsigned int>(dmx->m_index.size()); idx < num_entries; ++idx)
+        m_bytes_to_process += dmx->m_index[idx].size;
 }
 
 qt_atom_t
@@ -384,6 +385,7 @@ qtmp4_reader_c::calculate_timestamps() {
   for (auto &dmx : m_demuxers) {
     dmx->calculate_frame_rate();
     dmx->calculate_timestamps();
+    dmx->release_tables();
   }
 
   auto min_timestamp = calculate_global_min_timestamp();
@@ -856,8 +858,8 @@ qtmp4_reader_c::handle_trun_atom(qt_atom_t,
   auto entries = m_in->read_uint32_be();
   auto &track  = *m_track_for_fragment;
 
-  if (track.raw_frame_offset_table.empty() && !track.sample_table.empty())
-    track.raw_frame_offset_table.emplace_back(track.sample_table.size(), 0);
+  if (track.raw_frame_offset_table.empty() && !track.sample_size_table.empty())
+    track.raw_frame_offset_table.emplace_back(track.sample_size_table.size(), 0);
 
   auto data_offset        = flags & QTMP4_TRUN_DATA_OFFSET ? m_in->read_uint32_be() : 0;
   auto first_sample_flags = flags & QTMP4_TRUN_FIRST_SAMPLE_FLAGS ? m_in->read_uint32_be() : m_fragment->sample_flags;
@@ -869,7 +871,7 @@ qtmp4_reader_c::handle_trun_atom(qt_atom_t,
   };
 
   track.durmap_table.reserve(calc_reserve_size(track.durmap_table.size()));
-  track.sample_table.reserve(calc_reserve_size(track.sample_table.size()));
+  track.sample_size_table.reserve(calc_reserve_size(track.sample_size_table.size()));
   track.chunk_table.reserve(calc_reserve_size(track.chunk_table.size()));
   track.raw_frame_offset_table.reserve(calc_reserve_size(track.raw_frame_offset_table.size()));
   track.keyframe_table.reserve(calc_reserve_size(track.keyframe_table.size()));
@@ -890,7 +892,7 @@ qtmp4_reader_c::handle_trun_atom(qt_atom_t,
     auto keyframe        = !track.is_video()                    ? true                   : !(sample_flags & (QTMP4_FRAG_SAMPLE_FLAG_IS_NON_SYNC | QTMP4_FRAG_SAMPLE_FLAG_DEPENDS_YES));
 
     track.durmap_table.emplace_back(1, sample_duration);
-    track.sample_table.emplace_back(sample_size);
+    track.sample_size_table.emplace_back(sample_size);
     track.chunk_table.emplace_back(1, offset);
     track.raw_frame_offset_table.emplace_back(1, mtx::math::to_signed(ctts_duration));
 
@@ -918,7 +920,7 @@ qtmp4_reader_c::handle_trun_atom(qt_atom_t,
 
   auto spc                = space((level + 2) * 2 + 1);
   auto durmap_start       = track.durmap_table.size()           - entries;
-  auto sample_start       = track.sample_table.size()           - entries;
+  auto sample_start       = track.sample_size_table.size()      - entries;
   auto chunk_start        = track.chunk_table.size()            - entries;
   auto frame_offset_start = track.raw_frame_offset_table.size() - entries;
   auto end                = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), entries);
@@ -927,9 +929,9 @@ qtmp4_reader_c::handle_trun_atom(qt_atom_t,
     mxdebug(fmt::format("{0}{1}: duration {2} size {3} data start {4} end {5} pts offset {6} key? {7} raw flags 0x{8:08x}\n",
                         spc, idx,
                         track.durmap_table[durmap_start + idx].duration,
-                        track.sample_table[sample_start + idx].size,
+                        track.sample_size_table[sample_start + idx],
                         track.chunk_table[chunk_start + idx].pos,
-                        (track.sample_table[sample_start + idx].size + track.chunk_table[chunk_start + idx].pos),
+                        (track.sample_size_table[sample_start + idx] + track.chunk_table[chunk_start + idx].pos),
                         track.raw_frame_offset_table[frame_offset_start + idx].offset,
                         static_cast<unsigned int>(all_keyframe_flags[idx]),
                         all_sample_flags[idx]));
@@ -1122,7 +1124,7 @@ qtmp4_reader_c::read_chapter_track() {
   if (m_demuxers.end() == chapter_dmx_itr)
     return;
 
-  if ((*chapter_dmx_itr)->sample_table.empty())
+  if ((*chapter_dmx_itr)->sample_size_table.empty())
     return;
 
   std::vector<qtmp4_chapter_entry_t> entries;
@@ -1130,24 +1132,26 @@ qtmp4_reader_c::read_chapter_track() {
   uint64_t pts_scale_num = 1000000000ull                                         / pts_scale_gcd;
   uint64_t pts_scale_den = static_cast<uint64_t>((*chapter_dmx_itr)->time_scale) / pts_scale_gcd;
 
-  entries.reserve((*chapter_dmx_itr)->sample_table.size());
+  entries.reserve((*chapter_dmx_itr)->sample_size_table.size());
 
-  for (auto &sample : (*chapter_dmx_itr)->sample_table) {
+  (*chapter_dmx_itr)->for_each_sample([&](qt_sample_t const &sample) {
     if (2 >= sample.size)
-      continue;
+      return true;
 
     m_in->setFilePointer(sample.pos);
     memory_cptr chunk(memory_c::alloc(sample.size));
     if (m_in->read(chunk->get_buffer(), sample.size) != sample.size)
-      continue;
+      return true;
 
     unsigned int name_len = get_uint16_be(chunk->get_buffer());
     if ((name_len + 2) > sample.size)
-      continue;
+      return true;
 
     entries.push_back(qtmp4_chapter_entry_t(std::string(reinterpret_cast<char *>(chunk->get_buffer()) + 2, name_len),
                                             sample.pts * pts_scale_num / pts_scale_den));
-  }
+
+    return true;
+  });
 
   recode_chapter_entries(entries);
   process_chapter_entries(0, entries);
@@ -1374,28 +1378,26 @@ qtmp4_reader_c::handle_stsz_atom(qtmp4_demuxer_c &dmx,
   uint32_t count       = m_in->read_uint32_be();
 
   if (0 == sample_size) {
-    dmx.sample_table.reserve(dmx.sample_table.size() + count);
+    dmx.sample_size_table.reserve(dmx.sample_size_table.size() + count);
 
     size_t i;
     for (i = 0; i < count; ++i) {
-      qt_sample_t sample;
-
-      sample.size = m_in->read_uint32_be();
+      auto size = m_in->read_uint32_be();
 
       // This is a sanity check against damaged samples. I have one of
       // those in which one sample was suppposed to be > 2GB big.
-      if (sample.size >= 100 * 1024 * 1024)
-        sample.size = 0;
+      if (size >= 100 * 1024 * 1024)
+        size = 0;
 
-      dmx.sample_table.push_back(sample);
+      dmx.sample_size_table.push_back(size);
     }
 
     mxdebug_if(m_debug_headers, fmt::format("{0}Sample size table: {1} entries\n", space(level * 2 + 1), count));
     if (m_debug_tables) {
-      auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), dmx.sample_table.size());
+      auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), dmx.sample_size_table.size());
 
       for (auto idx = 0u; idx < end; ++idx)
-        mxdebug(fmt::format("{0}{1}: size {2}\n", space((level + 1) * 2 + 1), idx, dmx.sample_table[idx].size));
+        mxdebug(fmt::format("{0}{1}: size {2}\n", space((level + 1) * 2 + 1), idx, dmx.sample_size_table[idx]));
     }
 
   } else {
@@ -1606,38 +1608,39 @@ qtmp4_reader_c::read(generic_packetizer_c *ptzr,
   if (m_demuxers.size() == dmx_idx)
     return flush_packetizers();
 
-  auto &dmx   = *m_demuxers[dmx_idx];
-  auto &index = dmx.m_index[dmx.pos];
+  auto &dmx  = *m_demuxers[dmx_idx];
+  auto index = dmx.m_index[dmx.pos];
 
-  m_in->setFilePointer(index.file_pos);
-
-  int buffer_offset = 0;
   memory_cptr buffer;
 
+  try {
+    buffer = read_frame(dmx_idx);
+
+  } catch (mtx::mm_io::end_of_file_x &) {
+    mxwarn(fmt::format(Y("Quicktime/MP4 reader: Could not read chunk number {0}/{1} with size {2} from position {3}. Aborting.\n"),
+                       dmx.pos, dmx.m_index.size(), index.size, index.file_pos));
+    return flush_packetizers();
+  }
+
   if (   dmx.is_video()
       && !dmx.pos
       && dmx.codec.is(codec_c::type_e::V_MPEG4_P2)
       && dmx.esds_parsed
       && (dmx.esds.decoder_config)) {
-    buffer        = memory_c::alloc(index.size + dmx.esds.decoder_config->get_size());
-    buffer_offset = dmx.esds.decoder_config->get_size();
-
-    memcpy(buffer->get_buffer(), dmx.esds.decoder_config->get_buffer(), dmx.esds.decoder_config->get_size());
+    auto frame = buffer;
+    buffer     = memory_c::alloc(dmx.esds.decoder_config->get_size() + frame->get_size());
 
-  } else {
-    buffer = memory_c::alloc(index.size);
-  }
-
-  if (m_in->read(buffer->get_buffer() + buffer_offset, index.size) != index.size) {
-    mxwarn(fmt::format(Y("Quicktime/MP4 reader: Could not read chunk number {0}/{1} with size {2} from position {3}. Aborting.\n"),
-                       dmx.pos, dmx.m_index.size(), index.size, index.file_pos));
-    return flush_packetizers();
+    memcpy(buffer->get_buffer(),                                      dmx.esds.decoder_config->get_buffer(), dmx.esds.decoder_config->get_size());
+    memcpy(buffer->get_buffer() + dmx.esds.decoder_config->get_size(), frame->get_buffer(),                   frame->get_size());
   }
 
   auto duration = dmx.m_use_frame_rate_for_duration ? *dmx.m_use_frame_rate_for_duration : index.duration;
   PTZR(dmx.ptzr)->process(new packet_t(buffer, index.timestamp, duration, index.is_keyframe ? VFT_IFRAME : VFT_PFRAMEAUTOMATIC, VFT_NOBFRAME));
   ++dmx.pos;
 
+  // Entries before the current position are never accessed again.
+  dmx.m_index.release_before(dmx.pos);
+
   m_bytes_processed += index.size;
 
   if (dmx.pos < dmx.m_index.size())
@@ -1646,6 +1649,63 @@ qtmp4_reader_c::read(generic_packetizer_c *ptzr,
   return flush_packetizers();
 }
 
+memory_cptr
+qtmp4_reader_c::read_frame(std::size_t dmx_idx) {
+  auto &dmx = *m_demuxers[dmx_idx];
+
+  if (!m_read_ahead.get_num_queued(dmx_idx))
+    read_ahead(dmx_idx);
+
+  auto frame = m_read_ahead.get(dmx_idx);
+  if (frame)
+    return frame;
+
+  auto index = dmx.m_index[dmx.pos];
+
+  m_in->setFilePointer(index.file_pos);
+
+  // Memory-mapped input returns the chunk without copying it if the
+  // packetizer doesn't modify it.
+  return PTZR(dmx.ptzr)->accepts_immutable_frames() ? m_in->read_immutable(index.size) : m_in->read(index.size);
+}
+
+void
+qtmp4_reader_c::read_ahead(std::size_t dmx_idx) {
+  // Badly interleaved files would otherwise require one seek per
+  // frame. Instead read the frames of all tracks being read that
+  // follow the next frame of this track in the file at once.
+  auto lookup = [this](std::size_t track, std::size_t num) -> std::optional<mtx::qtmp4::read_ahead_c::frame_position_t> {
+    auto const &dmx = *m_demuxers[track];
+    auto idx        = dmx.pos + num;
+
+    if ((-1 == dmx.ptzr) || (idx >= dmx.m_index.size()))
+      return {};
+
+    auto index = dmx.m_index[idx];
+    return mtx::qtmp4::read_ahead_c::frame_position_t{ index.file_pos, index.size };
+  };
+
+  auto plan = m_read_ahead.plan(dmx_idx, m_demuxers.size(), lookup);
+
+  if (plan.frames.empty())
+    return;
+
+  memory_cptr buffer;
+
+  try {
+    m_in->setFilePointer(plan.start);
+    buffer = m_in->read(plan.size);
+
+  } catch (mtx::mm_io::exception &) {
+    // Let reading the single frame report the error.
+    return;
+  }
+
+  mxdebug_if(m_debug_read_ahead, fmt::format("read_ahead: {0} frames, {1} bytes from {2}\n", plan.frames.size(), plan.size, plan.start));
+
+  m_read_ahead.queue(plan, buffer);
+}
+
 memory_cptr
 qtmp4_reader_c::create_bitmap_info_header(qtmp4_demuxer_c &dmx,
                                           const char *fourcc,
@@ -2104,7 +2164,7 @@ qtmp4_reader_c::detect_interleaving() {
   decltype(m_demuxers) demuxers_to_read;
 
   std::copy_if(m_demuxers.begin(), m_demuxers.end(), std::back_inserter(demuxers_to_read), [this](auto const &dmx) {
-    return (dmx->ok && (dmx->is_audio() || dmx->is_video()) && this->demuxing_requested(dmx->type, dmx->id, dmx->language) && (dmx->sample_table.size() > 1));
+    return (dmx->ok && (dmx->is_audio() || dmx->is_video()) && this->demuxing_requested(dmx->type, dmx->id, dmx->language) && (dmx->sample_size_table.size() > 1));
   });
 
   if (demuxers_to_read.size() < 2) {
@@ -2112,12 +2172,17 @@ qtmp4_reader_c::detect_interleaving() {
     return;
   }
 
-  auto cmp = [](const qt_sample_t &s1, const qt_sample_t &s2) -> uint64_t { return s1.pos < s2.pos; };
-
   std::list<double> gradients;
   for (auto &dmx : demuxers_to_read) {
-    uint64_t min = std::min_element(dmx->sample_table.begin(), dmx->sample_table.end(), cmp)->pos;
-    uint64_t max = std::max_element(dmx->sample_table.begin(), dmx->sample_table.end(), cmp)->pos;
+    auto min = std::numeric_limits<uint64_t>::max();
+    auto max = uint64_t{};
+
+    dmx->for_each_sample([&min, &max](qt_sample_t const &sample) {
+      min = std::min<uint64_t>(min, sample.pos);
+      max = std::max<uint64_t>(max, sample.pos);
+      return true;
+    });
+
     gradients.push_back(static_cast<double>(max - min) / m_in->get_size());
 
     mxdebug_if(m_debug_interleaving, fmt::format("Interleaving: Track id {0} min {1} max {2} gradient {3}\n", dmx->id, min, max, gradients.back()));
@@ -2134,7 +2199,7 @@ qtmp4_reader_c::detect_interleaving() {
 
 void
 qtmp4_demuxer_c::calculate_frame_rate() {
-  if ((1 == durmap_table.size()) && (0 != durmap_table[0].duration) && ((0 != sample_size) || (0 == frame_offset_table.size()))) {
+  if ((1 == durmap_table.size()) && (0 != durmap_table[0].duration) && ((0 != sample_size) || (0 == m_num_frame_offsets))) {
     // Constant frame_rate. Let's set the default duration.
     frame_rate.assign(time_scale, static_cast<int64_t>(durmap_table[0].duration));
     mxdebug_if(m_debug_frame_rate, fmt::format("calculate_frame_rate: case 1: {0}/{1}\n", frame_rate.numerator(), frame_rate.denominator()));
@@ -2142,7 +2207,7 @@ qtmp4_demuxer_c::calculate_frame_rate() {
     return;
   }
 
-  if (('v' == type) && time_scale && global_duration && (sample_table.size() < 2)) {
+  if (('v' == type) && time_scale && global_duration && (sample_size_table.size() < 2)) {
     frame_rate = mtx::frame_timing::determine_frame_rate(static_cast<uint64_t>(global_duration) * 1'000'000'000ull / static_cast<uint64_t>(time_scale));
     if (frame_rate)
       m_use_frame_rate_for_duration = boost::rational_cast<int64_t>(int64_rational_c{1'000'000'000ll} / frame_rate);
@@ -2154,21 +2219,22 @@ qtmp4_demuxer_c::calculate_frame_rate() {
     return;
   }
 
-  if (sample_table.size() < 2) {
+  if (sample_size_table.size() < 2) {
     mxdebug_if(m_debug_frame_rate, fmt::format("calculate_frame_rate: case 3: sample table too small\n"));
     return;
   }
 
-  auto max_pts = sample_table[0].pts;
-  auto min_pts = max_pts;
+  auto max_pts = std::numeric_limits<int64_t>::min();
+  auto min_pts = std::numeric_limits<int64_t>::max();
 
-  for (auto const &sample : sample_table) {
+  for_each_sample([&max_pts, &min_pts](qt_sample_t const &sample) {
     max_pts = std::max(max_pts, sample.pts);
     min_pts = std::min(min_pts, sample.pts);
-  }
+    return true;
+  });
 
   auto duration   = to_nsecs(max_pts - min_pts);
-  auto num_frames = sample_table.size() - 1;
+  auto num_frames = sample_size_table.size() - 1;
   frame_rate      = mtx::frame_timing::determine_frame_rate(duration / num_frames);
 
   if (frame_rate) {
@@ -2183,10 +2249,15 @@ qtmp4_demuxer_c::calculate_frame_rate() {
   }
 
   std::map<int64_t, int> duration_map;
+  std::optional<int64_t> previous_pts;
+
+  for_each_sample([&duration_map, &previous_pts](qt_sample_t const &sample) {
+    if (previous_pts)
+      duration_map[sample.pts - *previous_pts]++;
 
-  std::accumulate(sample_table.begin() + 1, sample_table.end(), sample_table[0], [&duration_map](auto const &previous_sample, auto const &current_sample) -> auto {
-    duration_map[current_sample.pts - previous_sample.pts]++;
-    return current_sample;
+    previous_pts = sample.pts;
+
+    return true;
   });
 
   auto most_common = std::accumulate(duration_map.begin(), duration_map.end(), std::pair<int64_t, int>(*duration_map.begin()),
@@ -2210,88 +2281,11 @@ qtmp4_demuxer_c::to_nsecs(int64_t value,
   return boost::rational_cast<int64_t>(int64_rational_c{value, actual_time_scale} * int64_rational_c{1'000'000'000ll, 1});
 }
 
-void
-qtmp4_demuxer_c::calculate_timestamps_constant_sample_size() {
-  int const num_frame_offsets = frame_offset_table.size();
-  auto chunk_index            = 0;
-
-  timestamps.reserve(timestamps.size() + chunk_table.size());
-  durations.reserve(durations.size() + chunk_table.size());
-  frame_indices.reserve(frame_indices.size() + chunk_table.size());
-
-  for (auto const &chunk : chunk_table) {
-    auto frame_offset = chunk_index < num_frame_offsets ? frame_offset_table[chunk_index] : 0;
-
-    timestamps.push_back(to_nsecs(static_cast<uint64_t>(chunk.samples) * track_duration + frame_offset));
-    durations.push_back(to_nsecs(static_cast<uint64_t>(chunk.size)     * track_duration));
-    frame_indices.push_back(chunk_index);
-
-    ++chunk_index;
-  }
-}
-
-void
-qtmp4_demuxer_c::calculate_timestamps_variable_sample_size() {
-  auto const num_frame_offsets = frame_offset_table.size();
-  auto const num_samples       = sample_table.size();
-
-  std::vector<int64_t> timestamps_before_offsets;
-
-  timestamps.reserve(num_samples);
-  timestamps_before_offsets.reserve(num_samples);
-  durations.reserve(num_samples);
-  frame_indices.reserve(num_samples);
-
-  for (int frame = 0; static_cast<int>(num_samples) > frame; ++frame) {
-    auto timestamp = to_nsecs(sample_table[frame].pts);
-
-    frame_indices.push_back(frame);
-    timestamps_before_offsets.push_back(timestamp);
-    timestamps.push_back(timestamp + (static_cast<unsigned int>(frame) < num_frame_offsets ? to_nsecs(frame_offset_table[frame]) : 0));
-  }
-
-  int64_t avg_duration = 0, num_good_frames = 0;
-
-  for (int frame = 0; static_cast<int>(num_samples) > (frame + 1); ++frame) {
-    int64_t diff = timestamps_before_offsets[frame + 1] - timestamps_before_offsets[frame];
-
-    if (0 >= diff)
-      durations.push_back(0);
-    else {
-      ++num_good_frames;
-      avg_duration += diff;
-      durations.push_back(diff);
-    }
-  }
-
-  durations.push_back(0);
-
-  if (num_good_frames) {
-    avg_duration /= num_good_frames;
-    for (auto &duration : durations)
-      if (!duration)
-        duration = avg_duration;
-  }
-}
-
 void
 qtmp4_demuxer_c::calculate_timestamps() {
   if (m_timestamps_calculated)
     return;
 
-  if (0 != sample_size)
-    calculate_timestamps_constant_sample_size();
-  else
-    calculate_timestamps_variable_sample_size();
-
-  if (m_debug_tables) {
-    mxdebug(fmt::format("Timestamps for track ID {0}:\n", id));
-    auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), timestamps.size());
-
-    for (auto idx = 0u; idx < end; ++idx)
-      mxdebug(fmt::format("  {0}: pts {1}\n", idx, mtx::string::format_timestamp(timestamps[idx])));
-  }
-
   build_index();
   apply_edit_list();
 
@@ -2300,11 +2294,7 @@ qtmp4_demuxer_c::calculate_timestamps() {
 
 void
 qtmp4_demuxer_c::adjust_timestamps(int64_t delta) {
-  for (auto &timestamp : timestamps)
-    timestamp += delta;
-
-  for (auto &index : m_index)
-    index.timestamp += delta;
+  m_index.adjust_timestamps(delta);
 }
 
 std::optional<int64_t>
@@ -2314,7 +2304,12 @@ qtmp4_demuxer_c::min_timestamp()
     return {};
   }
 
-  return std::accumulate(m_index.begin(), m_index.end(), std::numeric_limits<int64_t>::max(), [](int64_t min, auto const &entry) { return std::min(min, entry.timestamp); });
+  auto min = std::numeric_limits<int64_t>::max();
+
+  for (auto idx = 0u, num_entries = static_cast<unsigned int>(m_index.size()); idx < num_entries; ++idx)
+    min = std::min(min, m_index[idx].timestamp);
+
+  return min;
 }
 
 bool
@@ -2358,18 +2353,12 @@ qtmp4_demuxer_c::update_tables() {
 
   // workaround for fixed-size video frames (dv and uncompressed), but
   // also for audio with constant sample size
-  if (sample_table.empty() && (sample_size > 1)) {
-    for (i = 0; i < s; ++i) {
-      qt_sample_t sample;
-
-      sample.size = sample_size;
-      sample_table.push_back(sample);
-    }
-
+  if (sample_size_table.empty() && (sample_size > 1)) {
+    sample_size_table.resize(s, sample_size);
     sample_size = 0;
   }
 
-  if (sample_table.empty()) {
+  if (sample_size_table.empty()) {
     // constant sample size
     if ((1 == durmap_table.size()) || ((2 == durmap_table.size()) && (1 == durmap_table[1].number)))
       track_duration = durmap_table[0].duration;
@@ -2381,61 +2370,102 @@ qtmp4_demuxer_c::update_tables() {
     return true;
   }
 
-  // calc pts:
-  auto num_samples = sample_table.size();
-  s                = 0;
-  uint64_t pts     = 0;
+  // The timestamps & positions of the samples aren't expanded here;
+  // for_each_sample() derives them from the run-length encoded tables.
+  auto num_samples    = sample_size_table.size();
+  auto num_timestamps = std::accumulate(durmap_table.begin(), durmap_table.end(), uint64_t{}, [](uint64_t sum, qt_durmap_t const &durmap) { return sum + durmap.number; });
 
-  for (j = 0; (j < durmap_table.size()) && (s < num_samples); ++j) {
-    for (i = 0; (i < durmap_table[j].number) && (s < num_samples); ++i) {
-      sample_table[s].pts  = pts;
-      pts                 += durmap_table[j].duration;
-      ++s;
-    }
-  }
-
-  if (s < num_samples) {
-    mxdebug_if(m_debug_headers, fmt::format("Track {0}: fewer timestamps assigned than entries in the sample table: {1} < {2}; dropping the excessive items\n", id, s, num_samples));
-    sample_table.resize(s);
-    num_samples = s;
-  }
-
-  // calc sample offsets
-  s = 0;
-  for (j = 0; (j < chunk_table.size()) && (s < num_samples); ++j) {
-    uint64_t chunk_pos = chunk_table[j].pos;
-
-    for (i = 0; (i < chunk_table[j].size) && (s < num_samples); ++i) {
-      sample_table[s].pos  = chunk_pos;
-      chunk_pos           += sample_table[s].size;
-      ++s;
-    }
+  if (num_timestamps < num_samples) {
+    mxdebug_if(m_debug_headers, fmt::format("Track {0}: fewer timestamps assigned than entries in the sample table: {1} < {2}; dropping the excessive items\n", id, num_timestamps, num_samples));
+    sample_size_table.resize(num_timestamps);
+    sample_size_table.shrink_to_fit();
   }
 
-  // calc pts/dts offsets
-  for (j = 0; j < raw_frame_offset_table.size(); ++j) {
-    size_t k;
-
-    for (k = 0; k < raw_frame_offset_table[j].count; ++k)
-      frame_offset_table.push_back(raw_frame_offset_table[j].offset);
-  }
+  // number of pts/dts offsets; they're taken from the run-length
+  // encoded table while building the index
+  for (auto const &frame_offset : raw_frame_offset_table)
+    m_num_frame_offsets += frame_offset.count;
 
   m_tables_updated = true;
 
   if (!m_debug_tables)
     return true;
 
-  mxdebug(fmt::format(" Frame offset table for track ID {0}: {1} entries\n",    id, frame_offset_table.size()));
-  mxdebug(fmt::format(" Sample table contents for track ID {0}: {1} entries\n", id, sample_table.size()));
+  mxdebug(fmt::format(" Frame offset table for track ID {0}: {1} entries\n",    id, m_num_frame_offsets));
+  mxdebug(fmt::format(" Sample table contents for track ID {0}: {1} entries\n", id, sample_size_table.size()));
 
-  auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), sample_table.size());
+  auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), sample_size_table.size());
+  auto idx = std::size_t{};
 
-  for (auto idx = 0u; idx < end; ++idx)
-    mxdebug(fmt::format("   {0}: pts {1} size {2} pos {3}\n", idx, sample_table[idx].pts, sample_table[idx].size, sample_table[idx].pos));
+  for_each_sample([&idx, end](qt_sample_t const &sample) {
+    mxdebug(fmt::format("   {0}: pts {1} size {2} pos {3}\n", idx, sample.pts, sample.size, sample.pos));
+    return ++idx < end;
+  });
 
   return true;
 }
 
+void
+qtmp4_demuxer_c::release_tables() {
+  // The per-sample tables are only needed for building the index.
+  // The run-length encoded ones are kept as they're tiny.
+  sample_size_table = {};
+  chunk_table       = {};
+  chunkmap_table    = {};
+  durmap_table      = {};
+  keyframe_table    = {};
+}
+
+void
+qtmp4_demuxer_c::for_each_sample(std::function<bool(qt_sample_t const &)> const &worker)
+  const {
+  // Walks the samples in order, deriving their timestamps from the
+  // durations in the 'stts' table and their positions from the chunk
+  // offsets & the sizes of the previous samples of the same chunk.
+  // Stops as soon as the worker returns false.
+  auto durmap_itr      = durmap_table.begin();
+  auto chunk_itr       = chunk_table.begin();
+  auto num_from_durmap = uint64_t{};
+  auto num_from_chunk  = uint64_t{};
+  auto pts             = int64_t{};
+  auto chunk_pos       = uint64_t{};
+  qt_sample_t sample;
+
+  for (auto size : sample_size_table) {
+    while ((durmap_itr != durmap_table.end()) && (num_from_durmap >= durmap_itr->number)) {
+      ++durmap_itr;
+      num_from_durmap = 0;
+    }
+
+    if (durmap_itr == durmap_table.end())
+      return;
+
+    while ((chunk_itr != chunk_table.end()) && (num_from_chunk >= chunk_itr->size)) {
+      ++chunk_itr;
+      num_from_chunk = 0;
+    }
+
+    sample.pts  = pts;
+    sample.size = size;
+    sample.pos  = 0;
+
+    if (chunk_itr != chunk_table.end()) {
+      if (!num_from_chunk)
+        chunk_pos = chunk_itr->pos;
+
+      sample.pos  = chunk_pos;
+      chunk_pos  += size;
+      ++num_from_chunk;
+    }
+
+    pts += durmap_itr->duration;
+    ++num_from_durmap;
+
+    if (!worker(sample))
+      return;
+  }
+}
+
 void
 qtmp4_demuxer_c::apply_edit_list() {
   if (editlist_table.empty())
@@ -2445,12 +2475,35 @@ qtmp4_demuxer_c::apply_edit_list() {
              fmt::format("Applying edit list for track {0}: {1} entries; track time scale {2}, global time scale {3}\n",
                          id, editlist_table.size(), time_scale, m_reader.m_time_scale));
 
-  std::vector<qt_index_t> edited_index;
+  qt_index_c edited_index;
+
+  // Each edit shifts the timestamps of a range of entries. Edits
+  // processed later see the shifted timestamps. The accumulated shift
+  // is kept for the first entry of each run of entries shifted by the
+  // same amount so that it can be looked up with a binary search.
+  std::map<uint64_t, int64_t> shifts{ { 0, 0 } };
+
+  auto get_entry = [this, &shifts](uint64_t idx) {
+    auto entry       = m_index[idx];
+    entry.timestamp += std::prev(shifts.upper_bound(idx))->second;
+
+    return entry;
+  };
+
+  auto add_shift = [&shifts](uint64_t first, uint64_t end, int64_t shift) {
+    if (first >= end)
+      return;
+
+    // Split the runs at the range's boundaries first.
+    for (auto boundary : { first, end })
+      shifts.emplace(boundary, std::prev(shifts.upper_bound(boundary))->second);
+
+    for (auto itr = shifts.find(first); itr->first < end; ++itr)
+      itr->second += shift;
+  };
 
   auto const num_edits         = editlist_table.size();
-  auto const num_index_entries = m_index.size();
-  auto const index_begin       = m_index.begin();
-  auto const index_end         = m_index.end();
+  auto const num_index_entries = static_cast<uint64_t>(m_index.size());
   auto const global_time_scale = m_reader.m_time_scale;
   auto timeline_cts            = int64_t{};
   auto entry_index             = 0u;
@@ -2507,25 +2560,39 @@ qtmp4_demuxer_c::apply_edit_list() {
     auto const edit_duration  = to_nsecs(edit.segment_duration, global_time_scale);
     auto const edit_start_cts = to_nsecs(edit.media_time);
     auto const edit_end_cts   = edit_start_cts + edit_duration;
-    auto itr                  = std::find_if(m_index.begin(), m_index.end(), [edit_start_cts](auto const &entry) { return (entry.timestamp + entry.duration - (entry.duration > 0 ? 1 : 0)) >= edit_start_cts; });
-    auto const frame_idx      = static_cast<uint64_t>(std::distance(index_begin, itr));
+    auto idx                  = uint64_t{};
+
+    for (; idx < num_index_entries; ++idx) {
+      auto entry = get_entry(idx);
+      if ((entry.timestamp + entry.duration - (entry.duration > 0 ? 1 : 0)) >= edit_start_cts)
+        break;
+    }
+
+    auto const frame_idx      = idx;
 
     mxdebug_if(m_debug_editlists,
                fmt::format("  {0}: normal entry; first frame {1} edit CTS {2}–{3} at timeline CTS {4}\n",
                            info, frame_idx >= num_index_entries ? -1 : frame_idx, mtx::string::format_timestamp(edit_start_cts), mtx::string::format_timestamp(edit_end_cts), mtx::string::format_timestamp(timeline_cts)));
 
     // Find active key frame.
-    while ((itr != index_end) && (itr > index_begin) && !itr->is_keyframe) {
-      --itr;
+    while ((idx < num_index_entries) && (idx > 0) && !m_index[idx].is_keyframe) {
+      --idx;
     }
 
-    while ((itr < index_end) && (!edit_duration || (itr->timestamp < edit_end_cts))) {
-      itr->timestamp = timeline_cts + itr->timestamp - edit_start_cts;
-      edited_index.emplace_back(*itr);
+    auto const first_idx = idx;
+    auto const shift     = timeline_cts - edit_start_cts;
+
+    for (; idx < num_index_entries; ++idx) {
+      auto entry = get_entry(idx);
+      if (edit_duration && (entry.timestamp >= edit_end_cts))
+        break;
 
-      ++itr;
+      entry.timestamp += shift;
+      edited_index.push_back(entry);
     }
 
+    add_shift(first_idx, idx, shift);
+
     timeline_cts += edit_end_cts - edit_start_cts;
   }
 
@@ -2539,7 +2606,7 @@ qtmp4_demuxer_c::apply_edit_list() {
 void
 qtmp4_demuxer_c::dump_index_entries(std::string const &message)
   const {
-  mxdebug(fmt::format("{0} for track ID {1}: {2} entries\n", message, id, m_index.size()));
+  mxdebug(fmt::format("{0} for track ID {1}: {2} entries using {3} bytes\n", message, id, m_index.size(), m_index.get_memory_usage()));
 
   auto end = std::min<int>(!m_debug_indexes_full ? 10 : std::numeric_limits<int>::max(), m_index.size());
 
@@ -2562,11 +2629,21 @@ qtmp4_demuxer_c::dump_index_entries(std::string const &message)
 
 void
 qtmp4_demuxer_c::build_index() {
+  // The index is built in a single pass over the tables without
+  // intermediate per-sample lists of timestamps & durations.
   if (sample_size != 0)
     build_index_constant_sample_size_mode();
   else
     build_index_chunk_mode();
 
+  if (m_debug_tables) {
+    mxdebug(fmt::format("Timestamps for track ID {0}:\n", id));
+    auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), m_index.size());
+
+    for (auto idx = 0u; idx < end; ++idx)
+      mxdebug(fmt::format("  {0}: pts {1}\n", idx, mtx::string::format_timestamp(m_index[idx].timestamp)));
+  }
+
   mark_key_frames_from_key_frame_table();
   mark_open_gop_random_access_points_as_key_frames();
 
@@ -2574,65 +2651,133 @@ qtmp4_demuxer_c::build_index() {
     dump_index_entries("Index before edit list");
 }
 
-void
-qtmp4_demuxer_c::build_index_constant_sample_size_mode() {
-  auto is_audio              = 'a' == type;
-  auto sound_stsd_atom       = reinterpret_cast<sound_v1_stsd_atom_t *>(is_audio && stsd ? stsd->get_buffer() : nullptr);
+uint64_t
+qtmp4_demuxer_c::get_constant_sample_size_frame_size(qt_chunk_t const &chunk) {
+  if (1 != sample_size)
+    return chunk.size * sample_size;
+
+  uint64_t frame_size = chunk.size;
+
+  if ('a' != type)
+    return frame_size;
+
+  auto sound_stsd_atom       = reinterpret_cast<sound_v1_stsd_atom_t *>(stsd ? stsd->get_buffer() : nullptr);
   auto v0_sample_size        = sound_stsd_atom       ? get_uint16_be(&sound_stsd_atom->v0.sample_size)        : 0;
   auto v0_audio_version      = sound_stsd_atom       ? get_uint16_be(&sound_stsd_atom->v0.version)            : 0;
   auto v1_bytes_per_frame    = 1 == v0_audio_version ? get_uint32_be(&sound_stsd_atom->v1.bytes_per_frame)    : 0;
   auto v1_samples_per_packet = 1 == v0_audio_version ? get_uint32_be(&sound_stsd_atom->v1.samples_per_packet) : 0;
 
-  m_index.reserve(m_index.size() + chunk_table.size());
+  if ((0 != v1_bytes_per_frame) && (0 != v1_samples_per_packet)) {
+    frame_size *= v1_bytes_per_frame;
+    frame_size /= v1_samples_per_packet;
+  } else
+    frame_size  = frame_size * a_channels * v0_sample_size / 8;
+
+  return frame_size;
+}
+
+void
+qtmp4_demuxer_c::build_index_constant_sample_size_mode() {
+  auto frame_offset_itr = raw_frame_offset_table.begin();
+  auto chunk_index      = uint64_t{};
+  auto remaining        = uint64_t{};
 
-  size_t frame_idx;
-  for (frame_idx = 0; frame_idx < chunk_table.size(); ++frame_idx) {
-    uint64_t frame_size;
+  for (auto const &chunk : chunk_table) {
+    int32_t frame_offset = 0;
 
-    if (1 != sample_size) {
-      frame_size = chunk_table[frame_idx].size * sample_size;
+    if (chunk_index < m_num_frame_offsets) {
+      while (!remaining)
+        remaining = (frame_offset_itr++)->count;
 
-    } else {
-      frame_size = chunk_table[frame_idx].size;
-
-      if (is_audio) {
-        if ((0 != v1_bytes_per_frame) && (0 != v1_samples_per_packet)) {
-          frame_size *= v1_bytes_per_frame;
-          frame_size /= v1_samples_per_packet;
-        } else
-          frame_size  = frame_size * a_channels * v0_sample_size / 8;
-      }
+      frame_offset = std::prev(frame_offset_itr)->offset;
+      --remaining;
     }
 
-    m_index.emplace_back(chunk_table[frame_idx].pos, frame_size, timestamps[frame_idx], durations[frame_idx], false);
+    m_index.push_back({ static_cast<int64_t>(chunk.pos),
+                        static_cast<int64_t>(get_constant_sample_size_frame_size(chunk)),
+                        to_nsecs(static_cast<uint64_t>(chunk.samples) * track_duration + frame_offset),
+                        to_nsecs(static_cast<uint64_t>(chunk.size)    * track_duration),
+                        false });
+
+    ++chunk_index;
   }
 }
 
 void
 qtmp4_demuxer_c::build_index_chunk_mode() {
-  m_index.reserve(m_index.size() + frame_indices.size());
+  if (sample_size_table.empty())
+    return;
+
+  // Frames whose duration cannot be derived from the following
+  // frame's timestamp get the average duration of all other frames.
+  int64_t avg_duration = 0, num_good_frames = 0;
+  std::optional<int64_t> previous_timestamp;
 
-  for (int frame_idx = 0, num_frames = frame_indices.size(); frame_idx < num_frames; ++frame_idx) {
-    auto act_frame_idx = frame_indices[frame_idx];
-    auto &sample       = sample_table[act_frame_idx];
+  for_each_sample([this, &avg_duration, &num_good_frames, &previous_timestamp](qt_sample_t const &sample) {
+    auto timestamp = to_nsecs(sample.pts);
 
-    m_index.emplace_back(sample.pos, sample.size, timestamps[frame_idx], durations[frame_idx], false);
-  }
+    if (previous_timestamp && (timestamp > *previous_timestamp)) {
+      ++num_good_frames;
+      avg_duration += timestamp - *previous_timestamp;
+    }
+
+    previous_timestamp = timestamp;
+
+    return true;
+  });
+
+  if (num_good_frames)
+    avg_duration /= num_good_frames;
+
+  // An entry is added once the following sample's timestamp and
+  // therefore its duration is known.
+  auto frame_offset_itr = raw_frame_offset_table.begin();
+  auto remaining        = uint64_t{};
+  auto frame            = uint64_t{};
+  std::optional<qt_sample_t> previous_sample;
+
+  auto add_entry = [this, &frame_offset_itr, &remaining, &frame, avg_duration](qt_sample_t const &sample, std::optional<int64_t> next_timestamp) {
+    auto timestamp = to_nsecs(sample.pts);
+    auto duration  = next_timestamp && (*next_timestamp > timestamp) ? *next_timestamp - timestamp : avg_duration;
+
+    if (frame < m_num_frame_offsets) {
+      while (!remaining)
+        remaining = (frame_offset_itr++)->count;
+
+      timestamp += to_nsecs(static_cast<int32_t>(std::prev(frame_offset_itr)->offset));
+      --remaining;
+    }
+
+    m_index.push_back({ static_cast<int64_t>(sample.pos), static_cast<int64_t>(sample.size), timestamp, duration, false });
+    ++frame;
+  };
+
+  for_each_sample([this, &add_entry, &previous_sample](qt_sample_t const &sample) {
+    if (previous_sample)
+      add_entry(*previous_sample, to_nsecs(sample.pts));
+
+    previous_sample = sample;
+
+    return true;
+  });
+
+  if (previous_sample)
+    add_entry(*previous_sample, std::nullopt);
 }
 
 void
 qtmp4_demuxer_c::mark_key_frames_from_key_frame_table() {
+  auto num_index_entries = m_index.size();
+
   if (keyframe_table.empty()) {
-    for (auto &index : m_index)
-      index.is_keyframe = true;
+    for (auto idx = 0u; idx < num_index_entries; ++idx)
+      m_index.set_keyframe(idx);
     return;
   }
 
-  auto num_index_entries = m_index.size();
-
   for (auto const &keyframe_number : keyframe_table)
     if ((keyframe_number > 0) && (keyframe_number <= num_index_entries))
-      m_index[keyframe_number - 1].is_keyframe = true;
+      m_index.set_keyframe(keyframe_number - 1);
 }
 
 void
@@ -2650,7 +2795,7 @@ qtmp4_demuxer_c::mark_open_gop_random_access_points_as_key_frames() {
   for (auto const &s2g : table_itr->second) {
     if (s2g.group_description_index && ((s2g.group_description_index - 1) < num_random_access_points)) {
       for (auto end = std::min<int>(current_sample + s2g.sample_count, num_index_entries); current_sample < end; ++current_sample)
-        m_index[current_sample].is_keyframe = true;
+        m_index.set_keyframe(current_sample);
 
     } else
       current_sample += s2g.sample_count;
@@ -2662,27 +2807,45 @@ qtmp4_demuxer_c::mark_open_gop_random_access_points_as_key_frames() {
 
 memory_cptr
 qtmp4_demuxer_c::read_first_bytes(int num_bytes) {
-  if (!update_tables())
+  if (!m_timestamps_calculated && !update_tables())
     return memory_cptr{};
 
-  calculate_timestamps();
-
   auto buf       = memory_c::alloc(num_bytes);
   size_t buf_pos = 0;
-  size_t idx_pos = 0;
 
-  while ((0 < num_bytes) && (idx_pos < m_index.size())) {
-    qt_index_t &index          = m_index[idx_pos];
-    uint64_t num_bytes_to_read = std::min<int64_t>(num_bytes, index.size);
+  // Returns whether or not more frames have to be read.
+  auto read_frame = [this, &buf, &buf_pos, &num_bytes](int64_t file_pos, int64_t size) {
+    uint64_t num_bytes_to_read = std::min<int64_t>(num_bytes, size);
 
-    m_reader.m_in->setFilePointer(index.file_pos);
+    m_reader.m_in->setFilePointer(file_pos);
     if (m_reader.m_in->read(buf->get_buffer() + buf_pos, num_bytes_to_read) < num_bytes_to_read)
-      return memory_cptr{};
+      return false;
 
     num_bytes -= num_bytes_to_read;
     buf_pos   += num_bytes_to_read;
-    ++idx_pos;
-  }
+
+    return 0 < num_bytes;
+  };
+
+  // Before the index has been built (e.g. during identification) the
+  // frames are taken directly from the tables in the same order the
+  // index would contain them.
+  if (m_timestamps_calculated) {
+    for (auto idx = 0u, num_entries = static_cast<unsigned int>(m_index.size()); (idx < num_entries) && (0 < num_bytes); ++idx) {
+      auto index = m_index[idx];
+      if (!read_frame(index.file_pos, index.size))
+        break;
+    }
+
+  } else if (sample_size != 0) {
+    for (auto const &chunk : chunk_table)
+      if ((0 == num_bytes) || !read_frame(chunk.pos, get_constant_sample_size_frame_size(chunk)))
+        break;
+
+  } else if (0 < num_bytes)
+    for_each_sample([&read_frame](qt_sample_t const &sample) {
+      return read_frame(sample.pos, sample.size);
+    });
 
   return 0 == num_bytes ? buf : memory_cptr{};
 }
@@ -19,6 +19,8 @@
 #include "common/codec.h"
 #include "common/dts.h"
 #include "common/fourcc.h"
+#include "common/qtmp4_index.h"
+#include "common/qtmp4_read_ahead.h"
 #include "input/qtmp4_atoms.h"
 #include "merge/generic_reader.h"
 #include "output/p_pcm.h"
@@ -118,13 +120,6 @@ struct qt_sample_t {
     , pos{}
   {
   }
-
-  qt_sample_t(uint32_t p_size)
-    : pts{}
-    , size{p_size}
-    , pos{}
-  {
-  }
 };
 
 struct qt_frame_offset_t {
@@ -144,30 +139,6 @@ struct qt_frame_offset_t {
   }
 };
 
-struct qt_index_t {
-  int64_t file_pos, size;
-  int64_t timestamp, duration;
-  bool    is_keyframe;
-
-  qt_index_t()
-    : file_pos{}
-    , size{}
-    , timestamp{}
-    , duration{}
-    , is_keyframe{}
-  {
-  };
-
-  qt_index_t(int64_t p_file_pos, int64_t p_size, int64_t p_timestamp, int64_t p_duration, bool p_is_keyframe)
-    : file_pos{p_file_pos}
-    , size{p_size}
-    , timestamp{p_timestamp}
-    , duration{p_duration}
-    , is_keyframe{p_is_keyframe}
-  {
-  }
-};
-
 struct qt_track_defaults_t {
   unsigned int sample_description_id, sample_duration, sample_size, sample_flags;
 
@@ -235,20 +206,19 @@ struct qtmp4_demuxer_c {
   int64_t time_scale, track_duration, global_duration, num_frames_from_trun;
   uint32_t sample_size;
 
-  std::vector<qt_sample_t> sample_table;
+  std::vector<uint32_t> sample_size_table;
   std::vector<qt_chunk_t> chunk_table;
   std::vector<qt_chunkmap_t> chunkmap_table;
   std::vector<qt_durmap_t> durmap_table;
   std::vector<uint32_t> keyframe_table;
   std::vector<qt_editlist_t> editlist_table;
   std::vector<qt_frame_offset_t> raw_frame_offset_table;
-  std::vector<int32_t> frame_offset_table;
   std::vector<qt_random_access_point_t> random_access_point_table;
   std::unordered_map<uint32_t, std::vector<qt_sample_to_group_t> > sample_to_group_tables;
 
-  std::vector<int64_t> timestamps, durations, frame_indices;
+  uint64_t m_num_frame_offsets{};
 
-  std::vector<qt_index_t> m_index;
+  qt_index_c m_index;
   std::vector<qt_fragment_t> m_fragments;
 
   int64_rational_c frame_rate;
@@ -323,6 +293,8 @@ struct qtmp4_demuxer_c {
   void adjust_timestamps(int64_t delta);
 
   bool update_tables();
+  void release_tables();
+  void for_each_sample(std::function<bool(qt_sample_t const &)> const &worker) const;
   void apply_edit_list();
 
   void build_index();
@@ -385,8 +357,7 @@ private:
   void mark_key_frames_from_key_frame_table();
   void mark_open_gop_random_access_points_as_key_frames();
 
-  void calculate_timestamps_constant_sample_size();
-  void calculate_timestamps_variable_sample_size();
+  uint64_t get_constant_sample_size_frame_size(qt_chunk_t const &chunk);
 
   bool parse_esds_atom(mm_io_c &io, int level);
 };
@@ -466,6 +437,7 @@ private:
   uint64_t m_attachment_id{};
 
   int64_t m_bytes_to_process{}, m_bytes_processed{};
+  mtx::qtmp4::read_ahead_c m_read_ahead;
 
   debugging_option_c
       m_debug_chapters{    "qtmp4|qtmp4_full|qtmp4_chapters"}
@@ -473,7 +445,8 @@ private:
     , m_debug_tables{            "qtmp4_full|qtmp4_tables|qtmp4_tables_full"}
     , m_debug_tables_full{                               "qtmp4_tables_full"}
     , m_debug_interleaving{"qtmp4|qtmp4_full|qtmp4_interleaving"}
-    , m_debug_resync{      "qtmp4|qtmp4_full|qtmp4_resync"};
+    , m_debug_resync{      "qtmp4|qtmp4_full|qtmp4_resync"}
+    , m_debug_read_ahead{  "qtmp4_full|qtmp4_read_ahead"};
 
   friend class qtmp4_demuxer_c;
 
@@ -494,6 +467,8 @@ public:
 
 protected:
   virtual file_status_e read(generic_packetizer_c *ptzr, bool force = false) override;
+  virtual memory_cptr read_frame(std::size_t dmx_idx);
+  virtual void read_ahead(std::size_t dmx_idx);
 
   virtual void parse_headers();
   virtual void verify_track_parameters_and_update_indexes();
@@ -594,11 +594,11 @@ real_reader_c::assemble_video_packet(real_demuxer_cptr dmx,
     if (!dmx->rv_dimensions)
       set_dimensions(dmx, assembled->data, assembled->size);
 
-    auto packet = std::make_shared<packet_t>(memory_c::take_ownership(assembled->data, assembled->size),
-                                             (int64_t)assembled->timecode * 1000000,
-                                             0,
-                                             (assembled->flags & RMFF_FRAME_FLAG_KEYFRAME) == RMFF_FRAME_FLAG_KEYFRAME ? VFT_IFRAME : VFT_PFRAMEAUTOMATIC,
-                                             VFT_NOBFRAME);
+    auto packet = make_packet(memory_c::take_ownership(assembled->data, assembled->size),
+                              (int64_t)assembled->timecode * 1000000,
+                              0,
+                              (assembled->flags & RMFF_FRAME_FLAG_KEYFRAME) == RMFF_FRAME_FLAG_KEYFRAME ? VFT_IFRAME : VFT_PFRAMEAUTOMATIC,
+                              VFT_NOBFRAME);
     PTZR(dmx->ptzr)->process(packet);
 
     assembled->allocated_by_rmff = 0;
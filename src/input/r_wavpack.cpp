@@ -147,7 +147,7 @@ wavpack_reader_c::read(generic_packetizer_c *,
     data_size  -= truncate_bytes;
   }
 
-  packet_cptr packet(new packet_t(memory_c::take_ownership(chunk, data_size)));
+  auto packet = make_packet(memory_c::take_ownership(chunk, data_size));
 
   // find the if there is a correction file data corresponding
   if (!m_in_correc) {
@@ -34,7 +34,7 @@ subtitles_c::process(generic_packetizer_c *p) {
   if (empty() || (entries.end() == current))
     return;
 
-  packet_cptr packet(new packet_t(memory_c::borrow(current->subs), current->start, current->end - current->start));
+  auto packet = make_packet(memory_c::borrow(current->subs), current->start, current->end - current->start);
   packet->extensions.push_back(packet_extension_cptr(new subtitle_number_packet_extension_c(current->number)));
   p->process(packet);
   ++current;
@@ -17,6 +17,7 @@
 #include "common/at_scope_exit.h"
 #include "common/doc_type_version_handler.h"
 #include "common/ebml.h"
+#include "common/endian.h"
 #include "common/hacks.h"
 #include "common/strings/formatting.h"
 #include "common/tags/tags.h"
@@ -320,10 +321,20 @@ cluster_helper_c::set_duration(render_groups_c *rg) {
   if (rg->m_durations.empty())
     return;
 
-  kax_block_blob_c *group = rg->m_groups.back().get();
   int64_t def_duration    = rg->m_source->get_track_default_duration();
   int64_t block_duration  = 0;
 
+  auto set_block_duration = [this, rg](uint64_t duration) {
+    if (rg->m_direct_blocks.empty()) {
+      rg->m_groups.back()->set_block_duration(duration);
+      return;
+    }
+
+    auto &block = m->cluster_writer->get_blocks()[rg->m_direct_blocks.back()];
+    if (!block.is_simple_block)
+      block.duration = duration;
+  };
+
   size_t i;
   for (i = 0; rg->m_durations.size() > i; ++i)
     block_duration += rg->m_durations[i];
@@ -336,14 +347,14 @@ cluster_helper_c::set_duration(render_groups_c *rg) {
         || (   (0 < block_duration)
             && (ROUND_TIMESTAMP_SCALE(block_duration) != ROUND_TIMESTAMP_SCALE(static_cast<int64_t>(rg->m_durations.size()) * def_duration)))) {
       auto rounding_error = rg->m_source->get_track_type() == track_subtitle ? rg->m_first_timestamp_rounding_error.value_or(0) : 0;
-      group->set_block_duration(ROUND_TIMESTAMP_SCALE(block_duration + rounding_error));
+      set_block_duration(ROUND_TIMESTAMP_SCALE(block_duration + rounding_error));
     }
 
   } else if (   (   g_use_durations
                  || (0 < def_duration))
              && (0 < block_duration)
              && (ROUND_TIMESTAMP_SCALE(block_duration) != ROUND_TIMESTAMP_SCALE(rg->m_durations.size() * def_duration)))
-    group->set_block_duration(ROUND_TIMESTAMP_SCALE(block_duration));
+    set_block_duration(ROUND_TIMESTAMP_SCALE(block_duration));
 }
 
 bool
@@ -396,6 +407,10 @@ cluster_helper_c::must_duration_be_set(render_groups_c *rg,
 
 int
 cluster_helper_c::render() {
+  // Rendering accesses the state of the packets' packetizers, which
+  // the winner's reader may still be modifying on its own thread.
+  finish_pulling_ahead();
+
   std::vector<render_groups_cptr> render_groups;
   kax_cues_with_cleanup_c cues;
   cues.SetGlobalTimecodeScale(g_timestamp_scale);
@@ -404,6 +419,15 @@ cluster_helper_c::render() {
 
   LacingType lacing_type   = mtx::hacks::is_engaged(mtx::hacks::LACING_XIPH) ? LACING_XIPH : mtx::hacks::is_engaged(mtx::hacks::LACING_EBML) ? LACING_EBML : LACING_AUTO;
 
+  bool direct              = can_render_directly();
+  std::vector<std::size_t> direct_cue_blocks;
+
+  if (direct) {
+    if (!m->cluster_writer)
+      m->cluster_writer = std::make_unique<mtx::kax::cluster_writer_c>(static_cast<int64_t>(g_timestamp_scale));
+    m->cluster_writer->clear();
+  }
+
   int64_t min_cl_timestamp = std::numeric_limits<int64_t>::max();
   int64_t max_cl_timestamp = 0;
 
@@ -451,8 +475,6 @@ cluster_helper_c::render() {
     min_cl_timestamp                       = std::min(pack->assigned_timestamp, min_cl_timestamp);
     max_cl_timestamp                       = std::max(pack->assigned_timestamp, max_cl_timestamp);
 
-    DataBuffer *data_buffer                = new DataBuffer((binary *)pack->data->get_buffer(), pack->data->get_size());
-
     KaxTrackEntry &track_entry             = static_cast<KaxTrackEntry &>(*source->get_track_entry());
 
     kax_block_blob_c *previous_block_group = !render_group->m_groups.empty() ? render_group->m_groups.back().get() : nullptr;
@@ -481,10 +503,22 @@ cluster_helper_c::render() {
         : pack->has_discard_padding()              ? BLOCK_BLOB_NO_SIMPLE
         :                                            BLOCK_BLOB_ALWAYS_SIMPLE;
 
-      render_group->m_groups.push_back(kax_block_blob_cptr(new kax_block_blob_c(this_block_blob_type)));
-      new_block_group = render_group->m_groups.back().get();
-      m->cluster->AddBlockBlob(new_block_group);
-      new_block_group->SetParent(*m->cluster);
+      if (direct) {
+        auto &block           = m->cluster_writer->add_block();
+        block.is_simple_block = BLOCK_BLOB_ALWAYS_SIMPLE == this_block_blob_type;
+        block.track_number    = source->get_track_num();
+        block.lacing          = LACING_XIPH == lacing_type ? mtx::kax::cluster_writer_c::lacing_e::xiph
+                              : LACING_EBML == lacing_type ? mtx::kax::cluster_writer_c::lacing_e::ebml
+                              :                              mtx::kax::cluster_writer_c::lacing_e::automatic;
+
+        render_group->m_direct_blocks.push_back(m->cluster_writer->get_blocks().size() - 1);
+
+      } else {
+        render_group->m_groups.push_back(kax_block_blob_cptr(new kax_block_blob_c(this_block_blob_type)));
+        new_block_group = render_group->m_groups.back().get();
+        m->cluster->AddBlockBlob(new_block_group);
+        new_block_group->SetParent(*m->cluster);
+      }
 
       added_to_cues = false;
     }
@@ -497,16 +531,22 @@ cluster_helper_c::render() {
         static_cast<before_adding_to_cluster_cb_packet_extension_c *>(extension.get())->get_callback()(pack, timestamp_offset);
 
     // Now put the packet into the cluster.
-    render_group->m_more_data = new_block_group->add_frame_auto(track_entry, pack->assigned_timestamp - timestamp_offset, *data_buffer, lacing_type,
-                                                                pack->has_bref() ? pack->bref - timestamp_offset : -1,
-                                                                pack->has_fref() ? pack->fref - timestamp_offset : -1,
-                                                                pack->key_flag, pack->discardable_flag);
-
-    if (has_codec_state) {
-      KaxBlockGroup &bgroup = (KaxBlockGroup &)*new_block_group;
-      KaxCodecState *cstate = new KaxCodecState;
-      bgroup.PushElement(*cstate);
-      cstate->CopyBuffer(pack->codec_state->get_buffer(), pack->codec_state->get_size());
+    if (direct)
+      render_group->m_more_data = add_frame_directly(*render_group, *pack, timestamp_offset);
+
+    else {
+      DataBuffer *data_buffer   = new DataBuffer((binary *)pack->data->get_buffer(), pack->data->get_size());
+      render_group->m_more_data = new_block_group->add_frame_auto(track_entry, pack->assigned_timestamp - timestamp_offset, *data_buffer, lacing_type,
+                                                                  pack->has_bref() ? pack->bref - timestamp_offset : -1,
+                                                                  pack->has_fref() ? pack->fref - timestamp_offset : -1,
+                                                                  pack->key_flag, pack->discardable_flag);
+
+      if (has_codec_state) {
+        KaxBlockGroup &bgroup = (KaxBlockGroup &)*new_block_group;
+        KaxCodecState *cstate = new KaxCodecState;
+        bgroup.PushElement(*cstate);
+        cstate->CopyBuffer(pack->codec_state->get_buffer(), pack->codec_state->get_size());
+      }
     }
 
     if (-1 == m->first_timestamp_in_file)
@@ -528,7 +568,13 @@ cluster_helper_c::render() {
 
     cues_c::get().set_duration_for_id_timestamp(source->get_track_num(), pack->assigned_timestamp - timestamp_offset, pack->get_duration());
 
-    if (new_block_group) {
+    if (direct) {
+      if (pack->has_discard_padding()) {
+        m->cluster_writer->get_blocks()[render_group->m_direct_blocks.back()].discard_padding = pack->discard_padding.to_ns();
+        render_group->m_has_discard_padding = true;
+      }
+
+    } else if (new_block_group) {
       // Set the reference priority if it was wanted.
       if ((0 < pack->ref_priority) && new_block_group->replace_simple_by_group())
         GetChild<KaxReferencePriority>(*new_block_group).SetValue(pack->ref_priority);
@@ -553,7 +599,17 @@ cluster_helper_c::render() {
 
     elements_in_cluster++;
 
-    if (!new_block_group)
+    if (direct) {
+      // As with libmatroska a frame laced into an existing block may
+      // create the cue point for that block. Blocks listed more than
+      // once are only cued once by cues_c::postprocess_cues().
+      if (g_write_cues && (!added_to_cues || has_codec_state)) {
+        added_to_cues = add_to_cues_maybe(pack);
+        if (added_to_cues)
+          direct_cue_blocks.push_back(render_group->m_direct_blocks.back());
+      }
+
+    } else if (!new_block_group)
       new_block_group = previous_block_group;
 
     else if (g_write_cues && (!added_to_cues || has_codec_state)) {
@@ -578,20 +634,25 @@ cluster_helper_c::render() {
       for (auto &rg : render_groups)
         set_duration(rg.get());
 
-      m->cluster->SetPreviousTimecode(min_cl_timestamp - timestamp_offset - 1, (int64_t)g_timestamp_scale);
-      m->cluster->set_min_timestamp(min_cl_timestamp - timestamp_offset);
-      m->cluster->set_max_timestamp(max_cl_timestamp - timestamp_offset);
+      if (direct)
+        render_directly(min_cl_timestamp - timestamp_offset, direct_cue_blocks);
 
-      m->cluster->Render(*m->out, cues);
-      g_doc_type_version_handler->account(*m->cluster);
-      m->bytes_in_file += m->cluster->ElementSize();
+      else {
+        m->cluster->SetPreviousTimecode(min_cl_timestamp - timestamp_offset - 1, (int64_t)g_timestamp_scale);
+        m->cluster->set_min_timestamp(min_cl_timestamp - timestamp_offset);
+        m->cluster->set_max_timestamp(max_cl_timestamp - timestamp_offset);
 
-      if (g_kax_sh_cues)
-        g_kax_sh_cues->IndexThis(*m->cluster, *g_kax_segment);
+        m->cluster->Render(*m->out, cues);
+        g_doc_type_version_handler->account(*m->cluster);
+        m->bytes_in_file += m->cluster->ElementSize();
 
-      m->previous_cluster_ts = m->cluster->GlobalTimecode();
+        if (g_kax_sh_cues)
+          g_kax_sh_cues->IndexThis(*m->cluster, *g_kax_segment);
 
-      cues_c::get().postprocess_cues(cues, *m->cluster);
+        m->previous_cluster_ts = m->cluster->GlobalTimecode();
+
+        cues_c::get().postprocess_cues(cues, *m->cluster);
+      }
 
     } else
       m->previous_cluster_ts = -1;
@@ -603,6 +664,70 @@ cluster_helper_c::render() {
   return 1;
 }
 
+bool
+cluster_helper_c::can_render_directly()
+  const {
+  if (!mtx::hacks::is_engaged(mtx::hacks::DIRECT_CLUSTER_RENDERING))
+    return false;
+
+  // Leave everything the cluster writer doesn't handle the way
+  // libmatroska does to libmatroska: block additions, reference
+  // priorities, silent tracks and codec states in groups that may
+  // receive further frames with references after the codec state.
+  return std::none_of(m->packets.begin(), m->packets.end(), [](packet_cptr const &pack) {
+    return !pack->data_adds.empty()
+        || (0 < pack->ref_priority)
+        || pack->source->contains_gap()
+        || (pack->codec_state && static_cast<KaxTrackEntry &>(*pack->source->get_track_entry()).LacingEnabled());
+  });
+}
+
+bool
+cluster_helper_c::add_frame_directly(render_groups_c &rg,
+                                     packet_t &pack,
+                                     int64_t timestamp_offset) {
+  auto &block    = m->cluster_writer->get_blocks()[rg.m_direct_blocks.back()];
+  auto more_data = block.add_frame_auto(pack.data, pack.assigned_timestamp - timestamp_offset,
+                                        pack.has_bref() ? pack.bref - timestamp_offset : -1,
+                                        pack.has_fref() ? pack.fref - timestamp_offset : -1,
+                                        pack.key_flag, pack.discardable_flag);
+
+  if (pack.codec_state && !block.is_simple_block)
+    block.codec_state = pack.codec_state;
+
+  return more_data;
+}
+
+void
+cluster_helper_c::render_directly(int64_t cluster_timestamp,
+                                  std::vector<std::size_t> const &cue_blocks) {
+  auto &writer = *m->cluster_writer;
+
+  m->bytes_in_file += writer.render(*m->out, cluster_timestamp);
+
+  for (auto id : writer.get_element_ids_written())
+    g_doc_type_version_handler->account_id(id);
+
+  auto segment_data_start = g_kax_segment->GetElementPosition() + g_kax_segment->HeadSize();
+  auto cluster_position   = writer.get_position() - segment_data_start;
+
+  if (g_kax_sh_cues) {
+    // Same as KaxSeekHead::IndexThis().
+    unsigned char cluster_id[4];
+    put_uint32_be(cluster_id, EBML_ID(KaxCluster).GetValue());
+
+    auto &seek = AddNewChild<KaxSeek>(*g_kax_sh_cues);
+    GetChild<KaxSeekPosition>(seek).SetValue(cluster_position);
+    GetChild<KaxSeekID>(seek).CopyBuffer(cluster_id, 4);
+  }
+
+  m->previous_cluster_ts = cluster_timestamp;
+
+  cues_c::get().postprocess_cues(writer, cue_blocks, segment_data_start);
+
+  writer.clear();
+}
+
 bool
 cluster_helper_c::add_to_cues_maybe(packet_cptr &pack) {
   auto &source  = *pack->source;
@@ -96,6 +96,10 @@ private:
   void split(packet_cptr &packet);
 
   bool add_to_cues_maybe(packet_cptr &pack);
+
+  bool can_render_directly() const;
+  bool add_frame_directly(render_groups_c &rg, packet_t &pack, int64_t timestamp_offset);
+  void render_directly(int64_t cluster_timestamp, std::vector<std::size_t> const &cue_blocks);
 };
 
 extern std::unique_ptr<cluster_helper_c> g_cluster_helper;
@@ -13,11 +13,15 @@
 
 #include "common/common_pch.h"
 
+#include <queue>
+
 #include "common/debugging.h"
 #include "common/doc_type_version_handler.h"
 #include "common/ebml.h"
 #include "common/fs_sys_helpers.h"
 #include "common/hacks.h"
+#include "common/kax_cluster_writer.h"
+#include "common/mm_file_io.h"
 #include "merge/cluster_helper.h"
 #include "merge/cues.h"
 #include "merge/generic_packetizer.h"
@@ -26,17 +30,158 @@
 
 using namespace libmatroska;
 
+namespace {
+
+// About 36 MB of cue points are kept in memory before they're moved
+// to a temporary file.
+std::size_t constexpr s_max_points_in_memory = 1'000'000;
+std::size_t constexpr s_points_per_io        = 4096;
+std::size_t constexpr s_write_buffer_size    = 64 * 1024;
+
+class cue_point_source_c {
+public:
+  virtual ~cue_point_source_c() = default;
+  virtual bool next(cue_point_t &point) = 0;
+};
+
+// Returns the points of all tracks ordered by timestamp & track
+// number. Each track's points are sorted already.
+class memory_source_c: public cue_point_source_c {
+protected:
+  struct track_t {
+    uint32_t track_num;
+    cue_track_points_t const *points;
+    std::size_t idx;
+  };
+
+  std::vector<track_t> m_tracks;
+
+public:
+  memory_source_c(std::map<uint32_t, cue_track_points_t> const &track_points) {
+    for (auto const &track_points_itr : track_points)
+      m_tracks.push_back({ track_points_itr.first, &track_points_itr.second, 0 });
+  }
+
+  virtual bool next(cue_point_t &point) override {
+    track_t *next_track = nullptr;
+
+    // There are only a few tracks; the map is ordered by track
+    // number, so the first one wins if timestamps are equal.
+    for (auto &track : m_tracks)
+      if (   (track.idx < track.points->timestamps.size())
+          && (!next_track || (track.points->timestamps[track.idx] < next_track->points->timestamps[next_track->idx])))
+        next_track = &track;
+
+    if (!next_track)
+      return false;
+
+    auto const &points = *next_track->points;
+    auto idx           = next_track->idx++;
+
+    point = { points.timestamps[idx], points.durations[idx], points.cluster_positions[idx], next_track->track_num, points.relative_positions[idx], points.codec_state_positions[idx] };
+
+    return true;
+  }
+};
+
+class spilled_run_source_c: public cue_point_source_c {
+protected:
+  mm_io_c &m_file;
+  uint64_t m_position;
+  std::size_t m_num_remaining, m_idx{};
+  std::vector<cue_point_t> m_points;
+  std::vector<std::pair<uint64_t, uint64_t>>::const_iterator m_adjustments_begin, m_adjustments_end;
+
+public:
+  spilled_run_source_c(mm_io_c &file,
+                       uint64_t position,
+                       std::size_t num_points,
+                       std::vector<std::pair<uint64_t, uint64_t>>::const_iterator adjustments_begin,
+                       std::vector<std::pair<uint64_t, uint64_t>>::const_iterator adjustments_end)
+    : m_file{file}
+    , m_position{position}
+    , m_num_remaining{num_points}
+    , m_adjustments_begin{adjustments_begin}
+    , m_adjustments_end{adjustments_end}
+  {
+  }
+
+  virtual bool next(cue_point_t &point) override {
+    if ((m_idx >= m_points.size()) && !read_points())
+      return false;
+
+    point = m_points[m_idx++];
+
+    return true;
+  }
+
+protected:
+  bool read_points() {
+    if (!m_num_remaining)
+      return false;
+
+    auto num_points = std::min(m_num_remaining, s_points_per_io);
+    auto num_bytes  = num_points * sizeof(cue_point_t);
+
+    m_points.resize(num_points);
+    m_file.setFilePointer(m_position);
+    if (m_file.read(m_points.data(), num_bytes) != num_bytes)
+      throw mtx::mm_io::end_of_file_x{};
+
+    for (auto &point : m_points)
+      for (auto adjustment = m_adjustments_begin; adjustment != m_adjustments_end; ++adjustment) {
+        if (point.cluster_position >= adjustment->first)
+          point.cluster_position += adjustment->second;
+
+        if (point.codec_state_position && (point.codec_state_position >= adjustment->first))
+          point.codec_state_position += adjustment->second;
+      }
+
+    m_position      += num_bytes;
+    m_num_remaining -= num_points;
+    m_idx            = 0;
+
+    return true;
+  }
+};
+
+void
+put_element_head(std::vector<unsigned char> &buffer,
+                 libebml::EbmlId const &id,
+                 uint64_t content_size) {
+  auto value = id.GetValue();
+
+  for (int shift = (EBML_ID_LENGTH(id) - 1) * 8; shift >= 0; shift -= 8)
+    buffer.push_back((value >> shift) & 0xff);
+
+  // Cue points are always shorter than 127 bytes.
+  buffer.push_back(0x80 | content_size);
+}
+
+uint64_t
+get_element_size(libebml::EbmlId const &id,
+                 uint64_t content_size) {
+  return EBML_ID_LENGTH(id) + 1 + content_size;
+}
+
+}
+
 cues_cptr cues_c::s_cues;
 
 cues_c::cues_c()
-  : m_num_cue_points_postprocessed{}
+  : m_max_points_in_memory{s_max_points_in_memory}
   , m_no_cue_duration{mtx::hacks::is_engaged(mtx::hacks::NO_CUE_DURATION)}
   , m_no_cue_relative_position{mtx::hacks::is_engaged(mtx::hacks::NO_CUE_RELATIVE_POSITION)}
   , m_debug_cue_duration{         "cues|cues_cue_duration"}
   , m_debug_cue_relative_position{"cues|cues_cue_relative_position"}
+  , m_debug_spilling{             "cues|cues_spilling"}
 {
 }
 
+cues_c::~cues_c() {
+  remove_spill_file();
+}
+
 void
 cues_c::set_duration_for_id_timestamp(uint64_t id,
                                      uint64_t timestamp,
@@ -64,25 +209,174 @@ cues_c::add(KaxCuePoint &point) {
       continue;
 
     uint64_t track_num = FindChildValue<KaxCueTrack>(*positions);
-    assert(track_num <= static_cast<uint64_t>(std::numeric_limits<uint32_t>::max()));
+    add(timestamp, track_num, FindChildValue<KaxCueClusterPosition>(*positions), FindChildValue<KaxCueCodecState>(*positions));
+  }
+}
+
+void
+cues_c::add(uint64_t timestamp,
+            uint64_t track_num,
+            uint64_t cluster_position,
+            uint64_t codec_state_position) {
+  assert(track_num <= static_cast<uint64_t>(std::numeric_limits<uint32_t>::max()));
+
+  m_pending_points.push_back({ timestamp, 0, cluster_position, static_cast<uint32_t>(track_num), 0, codec_state_position });
+}
+
+void
+cues_c::store_pending_points() {
+  for (auto const &point : m_pending_points)
+    store_point(point);
+
+  m_pending_points.clear();
+}
+
+void
+cues_c::store_point(cue_point_t const &point) {
+  auto &track      = m_track_points[point.track_num];
+  auto &timestamps = track.timestamps;
+
+  // A track's cue points usually arrive in the order of their
+  // timestamps. Others are inserted after all points with the same
+  // timestamp.
+  auto idx = timestamps.size();
+  if (idx && (timestamps.back() > point.timestamp))
+    idx = std::upper_bound(timestamps.begin(), timestamps.end(), point.timestamp) - timestamps.begin();
+
+  timestamps.insert(timestamps.begin() + idx,                             point.timestamp);
+  track.durations.insert(track.durations.begin() + idx,                   point.duration);
+  track.cluster_positions.insert(track.cluster_positions.begin() + idx,   point.cluster_position);
+  track.relative_positions.insert(track.relative_positions.begin() + idx, point.relative_position);
+  track.codec_state_positions.insert(track.codec_state_positions.begin() + idx, point.codec_state_position);
+
+  ++m_num_points;
+  ++m_num_points_in_memory;
+
+  if (m_num_points_in_memory >= m_max_points_in_memory)
+    spill_points_in_memory();
+}
+
+void
+cues_c::spill_points_in_memory() {
+  if (m_spilling_failed)
+    return;
+
+  try {
+    if (!m_spill_file) {
+      m_spill_file_name = (bfs::temp_directory_path() / bfs::unique_path("mkvmerge-cues-%%%%-%%%%-%%%%.tmp")).string();
+      m_spill_file      = std::make_shared<mm_file_io_c>(m_spill_file_name, MODE_CREATE);
+    }
+
+    m_spill_file->setFilePointer(0, libebml::seek_end);
+    auto position = m_spill_file->getFilePointer();
+
+    memory_source_c source{m_track_points};
+    std::vector<cue_point_t> points;
+    cue_point_t point;
+
+    points.reserve(s_points_per_io);
+
+    while (source.next(point)) {
+      points.push_back(point);
+
+      if (points.size() < s_points_per_io)
+        continue;
+
+      m_spill_file->write(points.data(), points.size() * sizeof(cue_point_t));
+      points.clear();
+    }
+
+    m_spill_file->write(points.data(), points.size() * sizeof(cue_point_t));
 
-    m_points.push_back({ timestamp, 0, FindChildValue<KaxCueClusterPosition>(*positions), static_cast<uint32_t>(track_num), 0 });
+    mxdebug_if(m_debug_spilling, fmt::format("cues_spilling: wrote {0} points to {1} at {2}\n", m_num_points_in_memory, m_spill_file_name, position));
 
-    uint64_t codec_state_position = FindChildValue<KaxCueCodecState>(*positions);
-    if (codec_state_position)
-      m_codec_state_position_map[ id_timestamp_t{ track_num, timestamp } ] = codec_state_position;
+    m_spilled_runs.push_back({ position, m_num_points_in_memory, m_spilled_adjustments.size() });
+    m_track_points.clear();
+    m_num_points_in_memory = 0;
+
+  } catch (mtx::mm_io::exception &ex) {
+    mxdebug_if(m_debug_spilling, fmt::format("cues_spilling: writing to {0} failed; keeping all points in memory: {1}\n", m_spill_file_name, ex.what()));
+    m_spilling_failed = true;
+
+  } catch (bfs::filesystem_error &ex) {
+    mxdebug_if(m_debug_spilling, fmt::format("cues_spilling: no temporary file available; keeping all points in memory: {0}\n", ex.what()));
+    m_spilling_failed = true;
+  }
+}
+
+void
+cues_c::remove_spill_file() {
+  m_spill_file.reset();
+
+  if (m_spill_file_name.empty())
+    return;
+
+  boost::system::error_code ec;
+  bfs::remove(m_spill_file_name, ec);
+  m_spill_file_name.clear();
+}
+
+void
+cues_c::clear() {
+  m_pending_points.clear();
+  m_track_points.clear();
+  m_spilled_runs.clear();
+  m_spilled_adjustments.clear();
+
+  m_num_points           = 0;
+  m_num_points_in_memory = 0;
+
+  m_codec_state_written       = false;
+  m_relative_position_written = false;
+  m_duration_written          = false;
+
+  remove_spill_file();
+}
+
+// Calls "worker" for all points ordered by timestamp & track number
+// by merging the runs in the temporary file with the points in
+// memory.
+void
+cues_c::for_each_point(std::function<void(cue_point_t const &)> const &worker) {
+  std::vector<std::unique_ptr<cue_point_source_c>> sources;
+
+  for (auto const &run : m_spilled_runs)
+    sources.emplace_back(std::make_unique<spilled_run_source_c>(*m_spill_file, run.position, run.num_points, m_spilled_adjustments.cbegin() + run.first_adjustment, m_spilled_adjustments.cend()));
+
+  sources.emplace_back(std::make_unique<memory_source_c>(m_track_points));
+
+  using head_t = std::pair<cue_point_t, std::size_t>;
+  auto later   = [](head_t const &a, head_t const &b) {
+    return std::tie(a.first.timestamp, a.first.track_num, a.second) > std::tie(b.first.timestamp, b.first.track_num, b.second);
+  };
+
+  std::priority_queue<head_t, std::vector<head_t>, decltype(later)> heads{later};
+  cue_point_t point;
+
+  for (auto idx = 0u; idx < sources.size(); ++idx)
+    if (sources[idx]->next(point))
+      heads.push({ point, idx });
+
+  while (!heads.empty()) {
+    auto head = heads.top();
+    heads.pop();
+
+    worker(head.first);
+
+    if (sources[head.second]->next(point))
+      heads.push({ point, head.second });
   }
 }
 
 void
 cues_c::write(mm_io_c &out,
               KaxSeekHead &seek_head) {
-  if (!m_points.size() || !g_cue_writing_requested)
+  store_pending_points();
+
+  if (!m_num_points || !g_cue_writing_requested)
     return;
 
   // auto start = mtx::sys::get_current_time_millis();
-  sort();
-  // auto end_sort = mtx::sys::get_current_time_millis();
 
   // Need to write the (empty) cues element so that its position will
   // be set for indexing in g_kax_sh_main. Necessary because there's
@@ -97,54 +391,94 @@ cues_c::write(mm_io_c &out,
   // Write meta seek information if it is not disabled.
   seek_head.IndexThis(cues_dummy, *g_kax_segment);
 
-  // Forcefully write the correct head and copy its content from the
-  // temporary storage location.
+  // Forcefully write the correct head and render the cue points
+  // directly.
   auto total_size = calculate_total_size();
   write_ebml_element_head(out, EBML_ID(KaxCues), total_size);
 
-  for (auto &point : m_points) {
-    KaxCuePoint kc_point;
+  std::vector<unsigned char> buffer;
+  buffer.reserve(s_write_buffer_size + 128);
 
-    GetChild<KaxCueTime>(kc_point).SetValue(point.timestamp / g_timestamp_scale);
+  for_each_point([this, &out, &buffer](cue_point_t const &point) {
+    render_point(point, buffer);
 
-    auto &positions = GetChild<KaxCueTrackPositions>(kc_point);
-    GetChild<KaxCueTrack>(positions).SetValue(point.track_num);
-    GetChild<KaxCueClusterPosition>(positions).SetValue(point.cluster_position);
+    if (buffer.size() < s_write_buffer_size)
+      return;
 
-    auto codec_state_position = m_codec_state_position_map.find({ point.track_num, point.timestamp });
-    if (codec_state_position != m_codec_state_position_map.end())
-      GetChild<KaxCueCodecState>(positions).SetValue(codec_state_position->second);
+    out.write(buffer.data(), buffer.size());
+    buffer.clear();
+  });
 
-    if (point.relative_position)
-      GetChild<KaxCueRelativePosition>(positions).SetValue(point.relative_position);
+  out.write(buffer.data(), buffer.size());
 
-    if (point.duration)
-      GetChild<KaxCueDuration>(positions).SetValue(ROUND_TIMESTAMP_SCALE(point.duration) / g_timestamp_scale);
+  for (auto const &id : { EBML_ID(KaxCuePoint), EBML_ID(KaxCueTime), EBML_ID(KaxCueTrackPositions), EBML_ID(KaxCueTrack), EBML_ID(KaxCueClusterPosition) })
+    g_doc_type_version_handler->account_id(id.GetValue());
 
-    g_doc_type_version_handler->render(kc_point, out);
-  }
+  if (m_codec_state_written)
+    g_doc_type_version_handler->account_id(EBML_ID(KaxCueCodecState).GetValue());
+  if (m_relative_position_written)
+    g_doc_type_version_handler->account_id(EBML_ID(KaxCueRelativePosition).GetValue());
+  if (m_duration_written)
+    g_doc_type_version_handler->account_id(EBML_ID(KaxCueDuration).GetValue());
 
-  m_points.clear();
-  m_codec_state_position_map.clear();
-  m_num_cue_points_postprocessed = 0;
+  clear();
 
   // auto end_all = mtx::sys::get_current_time_millis();
-  // mxinfo(fmt::format("dur sort {0} write {1} total {2}\n", end_sort - start, end_all - end_sort, end_all - start));
+  // mxinfo(fmt::format("dur write {0}\n", end_all - start));
 }
 
+// Renders the same bytes libmatroska does for a KaxCuePoint with the
+// children CueTime, CueTrackPositions (CueTrack, CueClusterPosition,
+// CueCodecState, CueRelativePosition, CueDuration).
 void
-cues_c::sort() {
-  std::sort(m_points.begin(), m_points.end(), [](cue_point_t const &a, cue_point_t const &b) -> bool {
-      if (a.timestamp < b.timestamp)
-        return true;
-      if (a.timestamp > b.timestamp)
-        return false;
+cues_c::render_point(cue_point_t const &point,
+                     std::vector<unsigned char> &buffer) {
+  auto put_uint = [this, &buffer](libebml::EbmlId const &id, uint64_t value) {
+    auto size = calculate_bytes_for_uint(value);
 
-      if (a.track_num < b.track_num)
-        return true;
+    put_element_head(buffer, id, size);
 
-      return false;
-    });
+    for (int shift = (size - 1) * 8; shift >= 0; shift -= 8)
+      buffer.push_back((value >> shift) & 0xff);
+  };
+
+  uint64_t timestamp         = point.timestamp / g_timestamp_scale;
+  uint64_t duration          = point.duration ? ROUND_TIMESTAMP_SCALE(point.duration) / g_timestamp_scale : 0;
+
+  uint64_t positions_size    = get_element_size(EBML_ID(KaxCueTrack),           calculate_bytes_for_uint(point.track_num))
+                             + get_element_size(EBML_ID(KaxCueClusterPosition), calculate_bytes_for_uint(point.cluster_position));
+
+  if (point.codec_state_position)
+    positions_size          += get_element_size(EBML_ID(KaxCueCodecState),       calculate_bytes_for_uint(point.codec_state_position));
+  if (point.relative_position)
+    positions_size          += get_element_size(EBML_ID(KaxCueRelativePosition), calculate_bytes_for_uint(point.relative_position));
+  if (point.duration)
+    positions_size          += get_element_size(EBML_ID(KaxCueDuration),         calculate_bytes_for_uint(duration));
+
+  auto point_size            = get_element_size(EBML_ID(KaxCueTime),           calculate_bytes_for_uint(timestamp))
+                             + get_element_size(EBML_ID(KaxCueTrackPositions), positions_size);
+
+  put_element_head(buffer, EBML_ID(KaxCuePoint), point_size);
+  put_uint(EBML_ID(KaxCueTime), timestamp);
+
+  put_element_head(buffer, EBML_ID(KaxCueTrackPositions), positions_size);
+  put_uint(EBML_ID(KaxCueTrack),           point.track_num);
+  put_uint(EBML_ID(KaxCueClusterPosition), point.cluster_position);
+
+  if (point.codec_state_position) {
+    put_uint(EBML_ID(KaxCueCodecState), point.codec_state_position);
+    m_codec_state_written = true;
+  }
+
+  if (point.relative_position) {
+    put_uint(EBML_ID(KaxCueRelativePosition), point.relative_position);
+    m_relative_position_written = true;
+  }
+
+  if (point.duration) {
+    put_uint(EBML_ID(KaxCueDuration), duration);
+    m_duration_written = true;
+  }
 }
 
 std::multimap<id_timestamp_t, uint64_t>
@@ -181,22 +515,33 @@ cues_c::postprocess_cues(KaxCues &cues,
                          KaxCluster &cluster) {
   add(cues);
 
-  if (m_no_cue_duration && m_no_cue_relative_position)
+  if (m_no_cue_duration && m_no_cue_relative_position) {
+    store_pending_points();
+    return;
+  }
+
+  postprocess_cues(calculate_block_positions(cluster), cluster.GetElementPosition() + cluster.HeadSize());
+}
+
+void
+cues_c::postprocess_cues(std::multimap<id_timestamp_t, uint64_t> const &block_positions,
+                         uint64_t cluster_data_start_pos) {
+  if (m_no_cue_duration && m_no_cue_relative_position) {
+    store_pending_points();
     return;
+  }
 
-  auto cluster_data_start_pos = cluster.GetElementPosition() + cluster.HeadSize();
-  auto block_positions        = calculate_block_positions(cluster);
   std::map<id_timestamp_t, size_t> nblocks_processed; //# blocks processed so far with given track #/timestamp
 
-  for (auto point = m_points.begin() + m_num_cue_points_postprocessed, end = m_points.end(); point != end; ++point) {
-    nblocks_processed[id_timestamp_t{ point->track_num, point->timestamp }]++;
+  for (auto &point : m_pending_points) {
+    nblocks_processed[id_timestamp_t{ point.track_num, point.timestamp }]++;
 
     // Set CueRelativePosition for all cues.
     if (!m_no_cue_relative_position) {
-      auto pair          = block_positions.equal_range({ point->track_num, point->timestamp });
+      auto pair          = block_positions.equal_range({ point.track_num, point.timestamp });
       auto position_itr  = pair.first;
       auto pos_end       = pair.second;
-      auto num_processed = nblocks_processed[id_timestamp_t{ point->track_num, point->timestamp }];
+      auto num_processed = nblocks_processed[id_timestamp_t{ point.track_num, point.timestamp }];
 
       for (auto i = 0u; ((i + 1) < num_processed) && (position_itr != pos_end); ++i)
         position_itr++;
@@ -205,47 +550,76 @@ cues_c::postprocess_cues(KaxCues &cues,
 
       assert(relative_position <= static_cast<uint64_t>(std::numeric_limits<uint32_t>::max()));
 
-      point->relative_position = relative_position;
+      point.relative_position = relative_position;
 
       mxdebug_if(m_debug_cue_relative_position,
                  fmt::format("cue_relative_position: looking for <{0}:{1}>: cluster_data_start_pos {2} position {3}\n",
-                             point->track_num, point->timestamp, cluster_data_start_pos, relative_position));
+                             point.track_num, point.timestamp, cluster_data_start_pos, relative_position));
     }
 
     // Set CueDuration if the packetizer wants them.
     if (m_no_cue_duration)
       continue;
 
-    auto pair          = m_id_timestamp_duration_multimap.equal_range({ point->track_num, point->timestamp });
+    auto pair          = m_id_timestamp_duration_multimap.equal_range({ point.track_num, point.timestamp });
     auto duration_itr  = pair.first;
     auto dur_end       = pair.second;
-    auto num_processed = nblocks_processed[id_timestamp_t{ point->track_num, point->timestamp }];
+    auto num_processed = nblocks_processed[id_timestamp_t{ point.track_num, point.timestamp }];
 
     for (auto i = 0u; ((i + 1) < num_processed) && (duration_itr != dur_end); ++i)
       duration_itr++;
 
-    auto ptzr         = g_packetizers_by_track_num[point->track_num];
+    auto ptzr         = g_packetizers_by_track_num[point.track_num];
 
     if (!ptzr || !ptzr->wants_cue_duration())
       continue;
 
     if (m_id_timestamp_duration_multimap.end() != duration_itr)
-      point->duration = duration_itr->second;
+      point.duration = duration_itr->second;
 
     mxdebug_if(m_debug_cue_duration,
                fmt::format("cue_duration: looking for <{0}:{1}>: {2}\n",
-                           point->track_num, point->timestamp, duration_itr == m_id_timestamp_duration_multimap.end() ? static_cast<int64_t>(-1) : duration_itr->second));
+                           point.track_num, point.timestamp, duration_itr == m_id_timestamp_duration_multimap.end() ? static_cast<int64_t>(-1) : duration_itr->second));
   }
 
-  m_num_cue_points_postprocessed = m_points.size();
+  store_pending_points();
 
   m_id_timestamp_duration_multimap.clear();
 }
 
+// Same as postprocess_cues(KaxCues &, KaxCluster &) for a cluster
+// rendered by the cluster writer. libmatroska creates the cue points
+// in the order of the blocks, once per block.
+void
+cues_c::postprocess_cues(mtx::kax::cluster_writer_c &writer,
+                         std::vector<std::size_t> cue_blocks,
+                         uint64_t segment_data_start_pos) {
+  auto &blocks          = writer.get_blocks();
+  auto cluster_position = writer.get_position() - segment_data_start_pos;
+  auto scale            = static_cast<uint64_t>(g_timestamp_scale);
+
+  std::sort(cue_blocks.begin(), cue_blocks.end());
+  cue_blocks.erase(std::unique(cue_blocks.begin(), cue_blocks.end()), cue_blocks.end());
+
+  for (auto idx : cue_blocks) {
+    auto &block = blocks[idx];
+    add(block.timestamp / scale * g_timestamp_scale, block.track_number, cluster_position, block.codec_state ? block.codec_state_position - segment_data_start_pos : 0);
+  }
+
+  std::multimap<id_timestamp_t, uint64_t> block_positions;
+  for (auto const &block : blocks)
+    block_positions.insert({ id_timestamp_t{ block.track_number, block.timestamp }, block.position });
+
+  postprocess_cues(block_positions, writer.get_position() + writer.get_head_size());
+}
+
 uint64_t
-cues_c::calculate_total_size()
-  const {
-  return std::accumulate(m_points.begin(), m_points.end(), 0ull, [this](uint64_t sum, cue_point_t const &point) { return sum + calculate_point_size(point); });
+cues_c::calculate_total_size() {
+  uint64_t total_size = 0;
+
+  for_each_point([this, &total_size](cue_point_t const &point) { total_size += calculate_point_size(point); });
+
+  return total_size;
 }
 
 uint64_t
@@ -266,9 +640,8 @@ cues_c::calculate_point_size(cue_point_t const &point)
                       + EBML_ID_LENGTH(EBML_ID(KaxCueTrack))           + 1 + calculate_bytes_for_uint(point.track_num)
                       + EBML_ID_LENGTH(EBML_ID(KaxCueClusterPosition)) + 1 + calculate_bytes_for_uint(point.cluster_position);
 
-  auto codec_state_position = m_codec_state_position_map.find({ point.track_num, point.timestamp });
-  if (codec_state_position != m_codec_state_position_map.end())
-    point_size += EBML_ID_LENGTH(EBML_ID(KaxCueCodecState)) + 1 + calculate_bytes_for_uint(codec_state_position->second);
+  if (point.codec_state_position)
+    point_size += EBML_ID_LENGTH(EBML_ID(KaxCueCodecState)) + 1 + calculate_bytes_for_uint(point.codec_state_position);
 
   if (point.relative_position)
     point_size += EBML_ID_LENGTH(EBML_ID(KaxCueRelativePosition)) + 1 + calculate_bytes_for_uint(point.relative_position);
@@ -284,20 +657,34 @@ cues_c::adjust_positions(uint64_t old_position,
                          uint64_t delta) {
   auto s_debug_rerender_track_headers = debugging_option_c{"rerender|rerender_track_headers"};
 
-  if (!delta || (m_points.empty() && m_codec_state_position_map.empty()))
+  if (!delta || (!m_num_points && m_pending_points.empty()))
     return;
 
   mxdebug_if(s_debug_rerender_track_headers,
-             fmt::format("[rerender] cues_c::adjust_positions: old_position {0} delta {1} num_points {2} first point's position {3}\n",
-                         old_position, delta, m_points.size(), !m_points.empty() ? m_points[0].cluster_position : 0));
+             fmt::format("[rerender] cues_c::adjust_positions: old_position {0} delta {1} num_points {2} num_spilled_runs {3}\n",
+                         old_position, delta, m_num_points + m_pending_points.size(), m_spilled_runs.size()));
 
-  for (auto &point : m_points)
+  for (auto &point : m_pending_points) {
     if (point.cluster_position >= old_position)
       point.cluster_position += delta;
 
-  for (auto &element : m_codec_state_position_map)
-    if (element.second >= old_position)
-      element.second += delta;
+    if (point.codec_state_position && (point.codec_state_position >= old_position))
+      point.codec_state_position += delta;
+  }
+
+  for (auto &track_points : m_track_points) {
+    for (auto &cluster_position : track_points.second.cluster_positions)
+      if (cluster_position >= old_position)
+        cluster_position += delta;
+
+    for (auto &codec_state_position : track_points.second.codec_state_positions)
+      if (codec_state_position && (codec_state_position >= old_position))
+        codec_state_position += delta;
+  }
+
+  // Points in the temporary file are adjusted when they're read back.
+  if (!m_spilled_runs.empty())
+    m_spilled_adjustments.emplace_back(old_position, delta);
 }
 
 cues_c &
@@ -19,11 +19,23 @@
 #include <matroska/KaxCuesData.h>
 #include <matroska/KaxSeekHead.h>
 
+namespace mtx::kax {
+class cluster_writer_c;
+}
+
 using id_timestamp_t = std::pair<uint64_t, uint64_t>;
 
 struct cue_point_t {
   uint64_t timestamp, duration, cluster_position;
   uint32_t track_num, relative_position;
+  uint64_t codec_state_position;
+};
+
+// The cue points of one track ordered by their timestamps with one
+// array per field.
+struct cue_track_points_t {
+  std::vector<uint64_t> timestamps, durations, cluster_positions, codec_state_positions;
+  std::vector<uint32_t> relative_positions;
 };
 
 class cues_c;
@@ -31,24 +43,44 @@ using cues_cptr = std::shared_ptr<cues_c>;
 
 class cues_c {
 protected:
-  std::vector<cue_point_t> m_points;
+  // Sorted runs of cue points moved to a temporary file. Position
+  // adjustments made after a run was written are applied when it is
+  // read back.
+  struct spilled_run_t {
+    uint64_t position;
+    std::size_t num_points, first_adjustment;
+  };
+
+  std::vector<cue_point_t> m_pending_points;
+  std::map<uint32_t, cue_track_points_t> m_track_points;
+  std::size_t m_num_points{}, m_num_points_in_memory{}, m_max_points_in_memory;
+
+  std::string m_spill_file_name;
+  mm_io_cptr m_spill_file;
+  std::vector<spilled_run_t> m_spilled_runs;
+  std::vector<std::pair<uint64_t, uint64_t>> m_spilled_adjustments;
+  bool m_spilling_failed{};
+
   std::multimap<id_timestamp_t, uint64_t> m_id_timestamp_duration_multimap;
-  std::map<id_timestamp_t, uint64_t> m_codec_state_position_map;
 
-  size_t m_num_cue_points_postprocessed;
   bool m_no_cue_duration, m_no_cue_relative_position;
-  debugging_option_c m_debug_cue_duration, m_debug_cue_relative_position;
+  bool m_codec_state_written{}, m_relative_position_written{}, m_duration_written{};
+  debugging_option_c m_debug_cue_duration, m_debug_cue_relative_position, m_debug_spilling;
 
 protected:
   static cues_cptr s_cues;
 
 public:
   cues_c();
+  virtual ~cues_c();
 
   void add(libmatroska::KaxCues &cues);
   void add(libmatroska::KaxCuePoint &point);
+  void add(uint64_t timestamp, uint64_t track_num, uint64_t cluster_position, uint64_t codec_state_position);
   void write(mm_io_c &out, libmatroska::KaxSeekHead &seek_head);
   void postprocess_cues(libmatroska::KaxCues &cues, libmatroska::KaxCluster &cluster);
+  void postprocess_cues(std::multimap<id_timestamp_t, uint64_t> const &block_positions, uint64_t cluster_data_start_pos);
+  void postprocess_cues(mtx::kax::cluster_writer_c &writer, std::vector<std::size_t> cue_blocks, uint64_t segment_data_start_pos);
   void set_duration_for_id_timestamp(uint64_t id, uint64_t timestamp, uint64_t duration);
   void adjust_positions(uint64_t old_position, uint64_t delta);
 
@@ -56,9 +88,15 @@ public:
   static cues_c &get();
 
 protected:
-  void sort();
+  void store_pending_points();
+  void store_point(cue_point_t const &point);
+  void spill_points_in_memory();
+  void remove_spill_file();
+  void clear();
+  void for_each_point(std::function<void(cue_point_t const &)> const &worker);
+  void render_point(cue_point_t const &point, std::vector<unsigned char> &buffer);
   std::multimap<id_timestamp_t, uint64_t> calculate_block_positions(libmatroska::KaxCluster &cluster) const;
-  uint64_t calculate_total_size() const;
+  uint64_t calculate_total_size();
   uint64_t calculate_point_size(cue_point_t const &point) const;
   uint64_t calculate_bytes_for_uint(uint64_t value) const;
 };
@@ -35,6 +35,7 @@
 #include "merge/filelist.h"
 #include "merge/generic_packetizer.h"
 #include "merge/generic_reader.h"
+#include "merge/memory_budget.h"
 #include "merge/output_control.h"
 #include "merge/webm.h"
 
@@ -64,6 +65,7 @@ generic_packetizer_c::generic_packetizer_c(generic_reader_c *reader,
   , m_free_refs{-1}
   , m_next_free_refs{-1}
   , m_enqueued_bytes{}
+  , m_peak_enqueued_bytes{}
   , m_safety_last_timestamp{}
   , m_safety_last_duration{}
   , m_track_entry{}
@@ -357,6 +359,7 @@ generic_packetizer_c::generic_packetizer_c(generic_reader_c *reader,
 }
 
 generic_packetizer_c::~generic_packetizer_c() {
+  mtx::merge::memory_budget::account(-m_enqueued_bytes);
 }
 
 void
@@ -1351,7 +1354,11 @@ generic_packetizer_c::compress_packet(packet_t &packet) {
 void
 generic_packetizer_c::account_enqueued_bytes(packet_t &packet,
                                              int64_t factor) {
-  m_enqueued_bytes += packet.calculate_uncompressed_size() * factor;
+  auto num_bytes         = static_cast<int64_t>(packet.calculate_uncompressed_size()) * factor;
+  m_enqueued_bytes      += num_bytes;
+  m_peak_enqueued_bytes  = std::max(m_peak_enqueued_bytes, m_enqueued_bytes);
+
+  mtx::merge::memory_budget::account(num_bytes);
 }
 
 void
@@ -1401,8 +1408,10 @@ generic_packetizer_c::add_packet2(packet_cptr pack) {
       pack->duration -= std::min(pack->duration, pack->discard_padding.to_ns());
   }
 
-  if (0 > pack->timestamp)
+  if (0 > pack->timestamp) {
+    account_enqueued_bytes(*pack, -1);
     return;
+  }
 
   // 'timestamp < safety_last_timestamp' may only occur for B frames. In this
   // case we have the coding order, e.g. IPB1B2 and the timestamps
@@ -1542,26 +1551,8 @@ generic_packetizer_c::apply_factory_short_queueing(packet_cptr_di &p_start) {
   }
 }
 
-struct packet_sorter_t {
-  int m_index;
-  static std::deque<packet_cptr> *m_packet_queue;
-
-  packet_sorter_t(int index)
-    : m_index(index)
-  {
-  }
-
-  bool operator <(const packet_sorter_t &cmp) const {
-    return (*m_packet_queue)[m_index]->timestamp < (*m_packet_queue)[cmp.m_index]->timestamp;
-  }
-};
-
-std::deque<packet_cptr> *packet_sorter_t::m_packet_queue = nullptr;
-
 void
 generic_packetizer_c::apply_factory_full_queueing(packet_cptr_di &p_start) {
-  packet_sorter_t::m_packet_queue = &m_packet_queue;
-
   while (m_packet_queue.end() != p_start) {
     // Find the next I frame packet.
     packet_cptr_di p_end = p_start + 1;
@@ -1575,25 +1566,25 @@ generic_packetizer_c::apply_factory_full_queueing(packet_cptr_di &p_start) {
 
     // Now sort the frames by their timestamp as the factory has to be
     // applied to the packets in the same order as they're timestamped.
-    std::vector<packet_sorter_t> sorter;
+    std::vector<std::size_t> sorter;
     bool needs_sorting         = false;
     int64_t previous_timestamp = 0;
     size_t i                   = distance(m_packet_queue.begin(), p_start);
 
     packet_cptr_di p_current;
     for (p_current = p_start; p_current != p_end; ++i, ++p_current) {
-      sorter.push_back(packet_sorter_t(i));
+      sorter.push_back(i);
       if (m_packet_queue[i]->timestamp < previous_timestamp)
         needs_sorting = true;
       previous_timestamp = m_packet_queue[i]->timestamp;
     }
 
     if (needs_sorting)
-      std::sort(sorter.begin(), sorter.end());
+      std::sort(sorter.begin(), sorter.end(), [this](std::size_t a, std::size_t b) { return m_packet_queue[a]->timestamp < m_packet_queue[b]->timestamp; });
 
     // Finally apply the factory.
     for (i = 0; sorter.size() > i; ++i)
-      apply_factory_once(m_packet_queue[sorter[i].m_index]);
+      apply_factory_once(m_packet_queue[sorter[i]]);
 
     p_start = p_end;
   }
@@ -1689,6 +1680,7 @@ generic_packetizer_c::is_compatible_with(output_compatibility_e compatibility) {
 void
 generic_packetizer_c::discard_queued_packets() {
   m_packet_queue.clear();
+  mtx::merge::memory_budget::account(-m_enqueued_bytes);
   m_enqueued_bytes = 0;
 }
 
@@ -1765,6 +1757,12 @@ generic_packetizer_c::is_lacing_prevented()
   return m_prevent_lacing;
 }
 
+bool
+generic_packetizer_c::accepts_immutable_frames()
+  const {
+  return false;
+}
+
 void
 generic_packetizer_c::after_packet_timestamped(packet_t &) {
 }
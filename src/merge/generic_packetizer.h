@@ -63,7 +63,7 @@ protected:
   std::deque<packet_cptr> m_packet_queue, m_deferred_packets;
   int m_next_packet_wo_assigned_timestamp;
 
-  int64_t m_free_refs, m_next_free_refs, m_enqueued_bytes;
+  int64_t m_free_refs, m_next_free_refs, m_enqueued_bytes, m_peak_enqueued_bytes;
   int64_t m_safety_last_timestamp, m_safety_last_duration;
 
   libmatroska::KaxTrackEntry *m_track_entry;
@@ -124,7 +124,7 @@ public:
   virtual file_status_e read(bool force);
 
   inline void add_packet(packet_t *packet) {
-    add_packet(packet_cptr(packet));
+    add_packet(mtx::mem::make_pooled_shared(packet));
   }
   virtual void add_packet(packet_cptr packet);
   virtual void add_packet2(packet_cptr pack);
@@ -142,6 +142,9 @@ public:
   inline int64_t get_queued_bytes() const {
     return m_enqueued_bytes;
   }
+  inline int64_t get_peak_queued_bytes() const {
+    return m_peak_enqueued_bytes;
+  }
 
   inline void set_free_refs(int64_t free_refs) {
     m_free_refs      = m_next_free_refs;
@@ -153,7 +156,7 @@ public:
   virtual void set_headers();
   virtual void fix_headers();
   inline int process(packet_t *packet) {
-    return process(packet_cptr(packet));
+    return process(mtx::mem::make_pooled_shared(packet));
   }
   virtual int process(packet_cptr packet) = 0;
 
@@ -296,6 +299,10 @@ public:
   virtual void prevent_lacing();
   virtual bool is_lacing_prevented() const;
 
+  // Whether or not process() can be handed frames that must not be
+  // modified, e.g. slices of a read-only memory mapping.
+  virtual bool accepts_immutable_frames() const;
+
   virtual generic_packetizer_c *get_connected_successor() const;
 
   virtual void set_source_id(std::string const &source_id);
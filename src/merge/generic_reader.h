@@ -17,6 +17,7 @@
 
 #include "common/file_types.h"
 #include "common/chapters/chapters.h"
+#include "common/json.h"
 #include "common/math_fwd.h"
 #include "common/translation.h"
 #include "merge/file_status.h"
@@ -126,12 +127,14 @@ public:
   virtual attach_mode_e attachment_requested(int64_t id);
 
   virtual void display_identification_results();
+  virtual nlohmann::json get_identification_results_as_json();
 
   virtual int64_t calculate_probe_range(int64_t file_size, int64_t fixed_minimum) const;
   virtual bool probe_file() = 0;
 
 public:
   static void set_probe_range_percentage(int64_rational_c const &probe_range_percentage);
+  static int64_rational_c get_probe_range_percentage();
 
 protected:
   virtual bool demuxing_requested(char type, int64_t id, mtx::bcp47::language_c const &language = {}) const;
@@ -0,0 +1,110 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   process-wide budget for packets queued in packetizers
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <atomic>
+
+#include "merge/memory_budget.h"
+
+namespace mtx::merge::memory_budget {
+
+namespace {
+
+// Packetizers are filled by the reader threads, therefore the totals
+// are updated atomically.
+std::atomic<int64_t> s_queued_bytes{}, s_peak_queued_bytes{};
+int64_t s_limit{};
+std::size_t s_num_readers{1};
+
+int64_t
+get_share() {
+  return s_limit / static_cast<int64_t>(s_num_readers);
+}
+
+}
+
+void
+set_limit(int64_t limit) {
+  s_limit = std::max<int64_t>(limit, 0);
+}
+
+int64_t
+get_limit() {
+  return s_limit;
+}
+
+void
+set_num_readers(std::size_t num_readers) {
+  s_num_readers = std::max<std::size_t>(num_readers, 1);
+}
+
+void
+account(int64_t num_bytes) {
+  auto queued_bytes = s_queued_bytes.fetch_add(num_bytes, std::memory_order_relaxed) + num_bytes;
+  auto peak         = s_peak_queued_bytes.load(std::memory_order_relaxed);
+
+  while (   (queued_bytes > peak)
+         && !s_peak_queued_bytes.compare_exchange_weak(peak, queued_bytes, std::memory_order_relaxed))
+    ;
+}
+
+int64_t
+get_queued_bytes() {
+  return s_queued_bytes.load(std::memory_order_relaxed);
+}
+
+int64_t
+get_peak_queued_bytes() {
+  return s_peak_queued_bytes.load(std::memory_order_relaxed);
+}
+
+void
+reset() {
+  s_queued_bytes.store(0, std::memory_order_relaxed);
+  s_peak_queued_bytes.store(0, std::memory_order_relaxed);
+}
+
+int64_t
+get_soft_limit() {
+  // Readers can only hold tracks other than audio & video tracks
+  // between the soft and the hard limit. Leave them a quarter of
+  // their share.
+  return s_limit ? std::min(default_soft_limit, get_share() / 4) : default_soft_limit;
+}
+
+int64_t
+get_hard_limit(int64_t default_hard_limit) {
+  return s_limit ? std::min(default_hard_limit, get_share()) : default_hard_limit;
+}
+
+bool
+exceeds_soft_limit(int64_t num_queued_bytes) {
+  return num_queued_bytes > get_soft_limit();
+}
+
+bool
+exceeds_hard_limit(int64_t num_queued_bytes,
+                   int64_t default_hard_limit) {
+  if (num_queued_bytes > get_hard_limit(default_hard_limit))
+    return true;
+
+  // Other readers may be using more than their share. As long as the
+  // total is too high, every reader with more than its soft limit
+  // queued is held.
+  return s_limit
+      && (num_queued_bytes > get_soft_limit())
+      && (get_queued_bytes() > s_limit);
+}
+
+}
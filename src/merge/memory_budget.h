@@ -0,0 +1,49 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   process-wide budget for packets queued in packetizers
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+// Readers return FILE_STATUS_HOLDING instead of reading more data
+// once the packets queued in their packetizers exceed certain
+// limits. Without a memory limit those are fixed per reader. With a
+// memory limit (--memory-limit) each reader gets an equal share of
+// it, and readers with more than a few MiB queued are held as long as
+// the total number of bytes queued in all packetizers exceeds the
+// limit.
+//
+// Holding is only a request; if all tracks of a file are held, the
+// main loop forces reading anyway. The limit is therefore a target,
+// not a guarantee.
+
+namespace mtx::merge::memory_budget {
+
+int64_t constexpr default_soft_limit = 20 * 1024 * 1024;
+
+void set_limit(int64_t limit);
+int64_t get_limit();
+void set_num_readers(std::size_t num_readers);
+
+void account(int64_t num_bytes);
+int64_t get_queued_bytes();
+int64_t get_peak_queued_bytes();
+void reset();
+
+int64_t get_soft_limit();
+int64_t get_hard_limit(int64_t default_hard_limit);
+
+bool exceeds_soft_limit(int64_t num_queued_bytes);
+bool exceeds_hard_limit(int64_t num_queued_bytes, int64_t default_hard_limit);
+
+}
@@ -46,6 +46,8 @@
 #include "common/ebml.h"
 #include "common/file_types.h"
 #include "common/fs_sys_helpers.h"
+#include "common/hacks.h"
+#include "common/identification_cache.h"
 #include "common/iso639.h"
 #include "common/kax_analyzer.h"
 #include "common/list_utils.h"
@@ -66,6 +68,7 @@
 #include "merge/cluster_helper.h"
 #include "merge/filelist.h"
 #include "merge/generic_reader.h"
+#include "merge/memory_budget.h"
 #include "merge/output_control.h"
 #include "merge/reader_detection_and_creation.h"
 #include "merge/track_info.h"
@@ -73,6 +76,7 @@
 using namespace libmatroska;
 
 static std::string s_split_by_chapters_arg;
+static mtx::id::cache::mode_e s_identification_cache_mode{mtx::id::cache::mode_e::off};
 
 /** \brief Outputs usage information
 */
@@ -131,6 +135,9 @@ set_usage() {
                   "                           put at most n milliseconds of data into each\n"
                   "                           cluster.\n");
   usage_text += Y("  --clusters-in-meta-seek  Write meta seek data for clusters.\n");
+  usage_text += Y("  --memory-limit <d[K,M,G]>\n"
+                  "                           Try to keep at most d bytes (KB, MB, GB) of\n"
+                  "                           packets queued in memory for all tracks.\n");
   usage_text += Y("  --timestamp-scale <n>    Force the timestamp scale factor to n.\n");
   usage_text += Y("  --enable-durations       Enable block durations for all blocks.\n");
   usage_text += Y("  --no-cues                Do not write the cue data (the index).\n");
@@ -356,6 +363,12 @@ set_usage() {
   usage_text += Y("  -F, --identification-format <format>\n"
                   "                           Set the identification results format\n"
                   "                           ('text' or 'json'; default is 'text').\n");
+  usage_text += Y("  --identification-cache <mode>\n"
+                  "                           Use a persistent cache for JSON identification\n"
+                  "                           results ('use', 'refresh' or 'off'; default is\n"
+                  "                           'off').\n");
+  usage_text += Y("  --clear-identification-cache\n"
+                  "                           Removes all cached identification results.\n");
   usage_text += Y("  --probe-range-percentage <percent>\n"
                   "                           Sets maximum size to probe for tracks in percent\n"
                   "                           of the total file size for certain file types\n"
@@ -485,6 +498,35 @@ display_unsupported_file_type(filelist_t const &file) {
   mxerror(fmt::format(Y("The type of file '{0}' is not supported.\n"), file.name));
 }
 
+static std::string
+identification_cache_context(track_info_c const &ti) {
+  auto probe_range_percentage = generic_reader_c::get_probe_range_percentage();
+  auto engaged_hacks          = std::string{};
+
+  for (auto idx = 0u; idx <= mtx::hacks::MAX_IDX; ++idx)
+    engaged_hacks += mtx::hacks::is_engaged(idx) ? '1' : '0';
+
+  return fmt::format("{0}\n{1}\n{2}\n{3}/{4}\n{5}\n{6}",
+                     get_version_info("mkvmerge", vif_full), ID_JSON_FORMAT_VERSION, translation_c::get_active_translation().get_locale(),
+                     probe_range_percentage.numerator(), probe_range_percentage.denominator(), ti.m_disable_multi_file, engaged_hacks);
+}
+
+static bool
+display_cached_identification_results(std::string const &cache_key) {
+  auto content = mtx::id::cache::retrieve(mtx::id::cache::default_folder(), cache_key);
+  if (!content)
+    return false;
+
+  try {
+    display_json_output(mtx::json::parse(*content));
+    return true;
+
+  } catch (std::exception const &) {
+  }
+
+  return false;
+}
+
 /** \brief Identify a file type and its contents
 
    This function called for \c --identify. It sets up dummy track info
@@ -509,6 +551,14 @@ identify(std::string &filename) {
   file.name           = filename;
   file.all_names.push_back(filename);
 
+  auto use_cache = (identification_output_format_e::json == g_identification_output_format) && (mtx::id::cache::mode_e::off != s_identification_cache_mode);
+  auto cache_key = use_cache ? mtx::id::cache::create_key(filename, identification_cache_context(*file.ti)) : std::string{};
+
+  if (!cache_key.empty() && (mtx::id::cache::mode_e::use == s_identification_cache_mode) && display_cached_identification_results(cache_key)) {
+    g_files.clear();
+    return;
+  }
+
   file.reader = probe_file_format(file);
 
   if (!file.reader)
@@ -517,7 +567,24 @@ identify(std::string &filename) {
   read_file_headers();
 
   file.reader->identify();
-  file.reader->display_identification_results();
+
+  if (cache_key.empty()) {
+    file.reader->display_identification_results();
+    g_files.clear();
+    return;
+  }
+
+  auto json              = file.reader->get_identification_results_as_json();
+  auto const &properties = json["container"]["properties"];
+
+  // Results spanning several files depend on more than the file
+  // that the key was created for.
+  if (   !json_warnings_or_errors_emitted()
+      && !properties.contains(mtx::id::other_file)
+      && !properties.contains(mtx::id::playlist))
+    mtx::id::cache::store(mtx::id::cache::default_folder(), cache_key, mtx::json::dump(json));
+
+  display_json_output(json);
 
   g_files.clear();
 }
@@ -1786,6 +1853,32 @@ parse_arg_cluster_length(std::string arg) {
   }
 }
 
+static void
+parse_arg_memory_limit(std::string arg) {
+  auto err_msg = Y("Invalid memory limit in '--memory-limit {0}'.\n");
+
+  if (arg.empty())
+    mxerror(fmt::format(err_msg, arg));
+
+  // Size in bytes/KB/MB/GB
+  char mod         = tolower(arg[arg.length() - 1]);
+  int64_t modifier = 1;
+  if ('k' == mod)
+    modifier = 1024;
+  else if ('m' == mod)
+    modifier = 1024 * 1024;
+  else if ('g' == mod)
+    modifier = 1024 * 1024 * 1024;
+  else if (!isdigit(mod))
+    mxerror(fmt::format(err_msg, arg));
+
+  int64_t limit = 0;
+  if (!mtx::string::parse_number(1 != modifier ? arg.substr(0, arg.size() - 1) : arg, limit) || (0 > limit))
+    mxerror(fmt::format(err_msg, arg));
+
+  mtx::merge::memory_budget::set_limit(limit * modifier);
+}
+
 static void
 parse_arg_attach_file(attachment_cptr const &attachment,
                       const std::string &arg,
@@ -1980,6 +2073,17 @@ parse_arg_attachments(const std::string &param,
   }
 }
 
+static void
+handle_probing_result(filelist_t &file) {
+  if (!file.reader)
+    mxerror(fmt::format(Y("The type of file '{0}' could not be recognized.\n"), file.name));
+
+  if (file.is_playlist) {
+    file.name        = file.playlist_mpls_in->get_file_name();
+    file.ti->m_fname = file.name;
+  }
+}
+
 void
 handle_file_name_arg(const std::string &this_arg,
                      std::vector<std::string>::const_iterator &sit,
@@ -2076,18 +2180,15 @@ handle_file_name_arg(const std::string &this_arg,
 
   ti->m_fname = file.name;
 
-  file.reader = probe_file_format(file);
-
-  if (!file.reader)
-    mxerror(fmt::format(Y("The type of file '{0}' could not be recognized.\n"), file.name));
+  file.ti.swap(ti);
 
-  if (file.is_playlist) {
-    file.name   = file.playlist_mpls_in->get_file_name();
-    ti->m_fname = file.name;
+  // With parallel probing all files are probed once all arguments
+  // have been parsed.
+  if (!mtx::hacks::is_engaged(mtx::hacks::PARALLEL_PROBING)) {
+    file.reader = probe_file_format(file);
+    handle_probing_result(file);
   }
 
-  file.ti.swap(ti);
-
   g_files.push_back(file_p);
 
   g_chapter_charset.clear();
@@ -2137,6 +2238,29 @@ parse_arg_identification_format(std::vector<std::string>::const_iterator &sit,
   ++sit;
 }
 
+static void
+parse_arg_identification_cache(std::vector<std::string>::const_iterator &sit,
+                               std::vector<std::string>::const_iterator const &sit_end) {
+  if ((sit + 1) == sit_end)
+    mxerror(fmt::format(Y("'{0}' lacks its argument.\n"), *sit));
+
+  auto next_arg = balg::to_lower_copy(*(sit + 1));
+
+  if (next_arg == "use")
+    s_identification_cache_mode = mtx::id::cache::mode_e::use;
+
+  else if (next_arg == "refresh")
+    s_identification_cache_mode = mtx::id::cache::mode_e::refresh;
+
+  else if (next_arg == "off")
+    s_identification_cache_mode = mtx::id::cache::mode_e::off;
+
+  else
+    mxerror(fmt::format(Y("Invalid identification cache mode in '{0} {1}'.\n"), *sit, *(sit + 1)));
+
+  ++sit;
+}
+
 static void
 parse_arg_probe_range(std::optional<std::string> next_arg) {
   if (!next_arg)
@@ -2197,6 +2321,9 @@ handle_identification_args(std::vector<std::string> &args) {
     if (mtx::included_in(this_arg, "-F", "--identification-format"))
       parse_arg_identification_format(sit, sit_end);
 
+    else if (this_arg == "--identification-cache")
+      parse_arg_identification_cache(sit, sit_end);
+
     else if (file_to_identify)
       mxerror(fmt::format(Y("The argument '{0}' is not allowed in identification mode.\n"), this_arg));
 
@@ -2229,6 +2356,10 @@ parse_args(std::vector<std::string> args) {
       mtx::iso639::list_languages();
       mxexit();
 
+    } else if (this_arg == "--clear-identification-cache") {
+      mtx::id::cache::clear(mtx::id::cache::default_folder());
+      mxexit();
+
     } else if (mtx::included_in(this_arg, "-i", "--identify", "-J"))
       mxerror(fmt::format(Y("'{0}' can only be used with a file name. No further options are allowed if this option is used.\n"), this_arg));
 
@@ -2382,6 +2513,13 @@ parse_args(std::vector<std::string> args) {
       parse_arg_cluster_length(next_arg);
       sit++;
 
+    } else if (this_arg == "--memory-limit") {
+      if (no_next_arg)
+        mxerror(Y("'--memory-limit' lacks the size.\n"));
+
+      parse_arg_memory_limit(next_arg);
+      sit++;
+
     } else if (this_arg == "--no-cues")
       g_write_cues = false;
 
@@ -3130,6 +3268,7 @@ main(int argc,
   auto args = setup(argc, argv);
 
   parse_args(args);
+  probe_file_formats(handle_probing_result);
 
   int64_t start = mtx::sys::get_current_time_millis();
 
@@ -15,8 +15,10 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
 #include <cmath>
 #include <iostream>
+#include <set>
 #if defined(SYS_UNIX) || defined(SYS_APPLE)
 # include <signal.h>
 #endif
@@ -48,6 +50,7 @@
 #include <matroska/KaxTrackVideo.h>
 #include <matroska/KaxVersion.h>
 
+#include "common/at_scope_exit.h"
 #include "common/chapters/chapters.h"
 #include "common/command_line.h"
 #include "common/construct.h"
@@ -66,6 +69,7 @@
 #include "common/regex.h"
 #include "common/strings/formatting.h"
 #include "common/tags/tags.h"
+#include "common/tournament_tree.h"
 #include "common/translation.h"
 #include "common/unique_numbers.h"
 #include "common/version.h"
@@ -74,7 +78,9 @@
 #include "merge/filelist.h"
 #include "merge/generic_packetizer.h"
 #include "merge/generic_reader.h"
+#include "merge/memory_budget.h"
 #include "merge/output_control.h"
+#include "merge/reader_thread.h"
 #include "merge/webm.h"
 
 using namespace libmatroska;
@@ -161,6 +167,8 @@ bool s_appending_files                      = false;
 auto s_debug_appending                      = debugging_option_c{"append|appending"};
 auto s_debug_rerender_track_headers         = debugging_option_c{"rerender|rerender_track_headers"};
 auto s_debug_splitting_chapters             = debugging_option_c{"splitting_chapters"};
+auto s_debug_memory_pool                    = debugging_option_c{"memory_pool"};
+auto s_debug_queued_bytes                   = debugging_option_c{"queued_bytes|memory_limit"};
 
 mtx::bcp47::language_c g_default_language;
 
@@ -193,7 +201,18 @@ static std::string s_muxing_app, s_writing_app;
 static mtx::date_time::point_t s_writing_date;
 
 static std::optional<int64_t> s_maximum_progress;
-int64_t s_current_progress{};
+std::atomic<int64_t> s_current_progress{};
+
+static std::vector<reader_thread_cptr> s_reader_threads;
+static std::unordered_map<generic_reader_c *, reader_thread_c *> s_reader_threads_by_reader;
+static packetizer_t *s_ptzr_pulled_ahead{};
+static std::thread::id const s_main_thread_id{std::this_thread::get_id()};
+static std::atomic<bool> s_track_headers_rerendering_requested{};
+
+static mtx::tournament_tree_c<timestamp_c> s_winner_tree;
+static std::set<std::size_t> s_ptzrs_to_pull;
+static std::vector<bool> s_ptzr_holding;
+static std::size_t s_num_ptzrs_holding{};
 
 std::unique_ptr<mtx::doc_type_version_handler_c> g_doc_type_version_handler;
 
@@ -387,6 +406,11 @@ add_tags(KaxTag &tags) {
 */
 int64_t
 add_attachment(attachment_cptr const &attachment) {
+  // Attachments found while reading headers on several threads are
+  // added in the order of the source files.
+  if (mtx::output::capture_c::defer([attachment]() { add_attachment(attachment); }))
+    return attachment->id;
+
   // If the attachment is coming from an existing file then we should
   // check if we already have another attachment stored. This can happen
   // if we're concatenating files.
@@ -823,6 +847,14 @@ shrink_void_and_rerender_track_headers(int64_t new_void_size) {
 */
 void
 rerender_track_headers() {
+  // Rerendering seeks in the output file and moves data that's
+  // already been written. Reader threads therefore only request it,
+  // and the main thread carries it out once they're idle.
+  if (std::this_thread::get_id() != s_main_thread_id) {
+    s_track_headers_rerendering_requested = true;
+    return;
+  }
+
   g_kax_tracks->UpdateSize(false);
 
   auto position_before    = s_out->getFilePointer();
@@ -1355,9 +1387,14 @@ create_next_output_file() {
   auto this_outfile   = g_cluster_helper->split_mode_produces_many_files() ? create_output_name() : g_outfile;
   g_kax_segment       = std::make_unique<KaxSegment>();
 
-  // Open the output file.
+  // Open the output file. With asynchronous writing the same amount
+  // of memory is split into a ring of four buffers.
+  auto async_writing = mtx::hacks::is_engaged(mtx::hacks::ASYNC_WRITING);
+
   try {
-    s_out = !g_cluster_helper->discarding() ? mm_write_buffer_io_c::open(this_outfile, 20 * 1024 * 1024) : mm_io_cptr{ new mm_null_io_c{this_outfile} };
+    s_out = g_cluster_helper->discarding() ? mm_io_cptr{ new mm_null_io_c{this_outfile} }
+          : async_writing                  ? mm_write_buffer_io_c::open(this_outfile, 5 * 1024 * 1024, 4)
+          :                                  mm_write_buffer_io_c::open(this_outfile, 20 * 1024 * 1024);
   } catch (mtx::mm_io::exception &ex) {
     mxerror(fmt::format(Y("The file '{0}' could not be opened for writing: {1}.\n"), this_outfile, ex));
   }
@@ -2056,8 +2093,73 @@ check_and_handle_end_of_input_after_pulling(packetizer_t &ptzr) {
   file.old_num_unfinished_packetizers = file.num_unfinished_packetizers;
 }
 
+/** \brief Update the scheduling state of a single packetizer
+
+   The main loop only pulls those packetizers that actually need to be
+   pulled, and it determines the winning packet with a tournament tree
+   instead of scanning all packetizers for each packet. This function
+   must be called whenever a packetizer's packet or status changes.
+*/
+static void
+update_packetizer_scheduling(std::size_t idx) {
+  auto &ptzr   = g_packetizers[idx];
+  auto holding = FILE_STATUS_HOLDING == ptzr.status;
+
+  if (holding != s_ptzr_holding[idx]) {
+    s_ptzr_holding[idx] = holding;
+    if (holding)
+      ++s_num_ptzrs_holding;
+    else
+      --s_num_ptzrs_holding;
+  }
+
+  // Pulling a packetizer doesn't do anything if it still has a packet
+  // or if it is done and dry. Held packetizers must be pulled anyway
+  // as pulling resets their status.
+  if (holding || (!ptzr.pack && (FILE_STATUS_DONE_AND_DRY != ptzr.status)))
+    s_ptzrs_to_pull.insert(idx);
+  else
+    s_ptzrs_to_pull.erase(idx);
+
+  s_winner_tree.set(idx, ptzr.pack ? std::optional<timestamp_c>{ptzr.pack->output_order_timestamp} : std::nullopt);
+}
+
+static void
+reset_packetizer_scheduling() {
+  s_winner_tree.reset(g_packetizers.size());
+  s_ptzrs_to_pull.clear();
+  s_ptzr_holding.assign(g_packetizers.size(), false);
+  s_num_ptzrs_holding = 0;
+
+  for (auto idx = 0u; idx < g_packetizers.size(); ++idx)
+    update_packetizer_scheduling(idx);
+}
+
+static std::size_t
+get_packetizer_index(packetizer_t const &ptzr) {
+  return std::distance<packetizer_t const *>(&g_packetizers[0], &ptzr);
+}
+
+static std::vector<std::size_t>
+get_packetizers_to_pull() {
+  // When appending, finishing one file may establish deferred
+  // connections which change the status of other packetizers. Those
+  // must be pulled in the same pass, therefore all of them are
+  // visited.
+  if (!s_appending_files)
+    return std::vector<std::size_t>(s_ptzrs_to_pull.begin(), s_ptzrs_to_pull.end());
+
+  std::vector<std::size_t> all(g_packetizers.size());
+  std::iota(all.begin(), all.end(), 0);
+
+  return all;
+}
+
 static bool
 force_pull_packetizers_of_fully_held_files() {
+  if (!s_num_ptzrs_holding)
+    return false;
+
   std::unordered_map<generic_reader_c *, bool> fully_held_files;
 
   for (auto &ptzr : g_packetizers) {
@@ -2072,61 +2174,214 @@ force_pull_packetizers_of_fully_held_files() {
   }
 
   auto force_pulled = false;
-  for (auto &ptzr : g_packetizers)
-    if (fully_held_files[ptzr.packetizer->m_reader] && !ptzr.packetizer->packet_available()) {
-      ptzr.old_status = ptzr.status;
-      ptzr.status     = ptzr.packetizer->read(true);
-      force_pulled    = true;
+  for (auto idx = 0u; idx < g_packetizers.size(); ++idx) {
+    auto &ptzr = g_packetizers[idx];
 
-      if (!ptzr.pack)
-        ptzr.pack = ptzr.packetizer->get_packet();
+    if (!fully_held_files[ptzr.packetizer->m_reader] || ptzr.packetizer->packet_available())
+      continue;
 
-      check_and_handle_end_of_input_after_pulling(ptzr);
-    }
+    ptzr.old_status = ptzr.status;
+    ptzr.status     = ptzr.packetizer->read(true);
+    force_pulled    = true;
+
+    if (!ptzr.pack)
+      ptzr.pack = ptzr.packetizer->get_packet();
+
+    check_and_handle_end_of_input_after_pulling(ptzr);
+    update_packetizer_scheduling(idx);
+  }
 
   return force_pulled;
 }
 
 static void
-pull_packetizers_for_packets() {
+pull_packetizer(packetizer_t &ptzr) {
+  if (FILE_STATUS_HOLDING == ptzr.status)
+    ptzr.status = FILE_STATUS_MOREDATA;
+
+  ptzr.old_status = ptzr.status;
+
+  while (   !ptzr.pack
+         && (FILE_STATUS_MOREDATA == ptzr.status)
+         && !ptzr.packetizer->packet_available())
+    ptzr.status = ptzr.packetizer->read(false);
+
+  if (   (FILE_STATUS_MOREDATA != ptzr.status)
+      && (FILE_STATUS_MOREDATA == ptzr.old_status))
+    ptzr.packetizer->force_duration_on_last_packet();
+
+  if (!ptzr.pack)
+    ptzr.pack = ptzr.packetizer->get_packet();
+}
+
+static void
+start_reader_threads() {
+  // Appended tracks share packetizer state such as timestamp
+  // factories across readers. Therefore only independent readers can
+  // be run on their own threads.
+  if (!mtx::hacks::is_engaged(mtx::hacks::MULTI_THREADED_READING) || s_appending_files)
+    return;
+
   for (auto &ptzr : g_packetizers) {
-    if (FILE_STATUS_HOLDING == ptzr.status)
-      ptzr.status = FILE_STATUS_MOREDATA;
+    auto reader = ptzr.packetizer->m_reader;
+    if (s_reader_threads_by_reader[reader])
+      continue;
 
-    ptzr.old_status = ptzr.status;
+    s_reader_threads.emplace_back(std::make_shared<reader_thread_c>(*reader, pull_packetizer));
+    s_reader_threads_by_reader[reader] = s_reader_threads.back().get();
+  }
+}
 
-    while (   !ptzr.pack
-           && (FILE_STATUS_MOREDATA == ptzr.status)
-           && !ptzr.packetizer->packet_available())
-      ptzr.status = ptzr.packetizer->read(false);
+static void
+wait_for_reader_threads() {
+  for (auto const &thread : s_reader_threads)
+    thread->wait();
 
-    if (   (FILE_STATUS_MOREDATA != ptzr.status)
-        && (FILE_STATUS_MOREDATA == ptzr.old_status))
-      ptzr.packetizer->force_duration_on_last_packet();
+  if (s_track_headers_rerendering_requested.exchange(false))
+    rerender_track_headers();
 
-    if (!ptzr.pack)
-      ptzr.pack = ptzr.packetizer->get_packet();
+  if (!s_ptzr_pulled_ahead)
+    return;
+
+  check_and_handle_end_of_input_after_pulling(*s_ptzr_pulled_ahead);
+  update_packetizer_scheduling(get_packetizer_index(*s_ptzr_pulled_ahead));
+  s_ptzr_pulled_ahead = nullptr;
+}
+
+static void
+stop_reader_threads() {
+  s_ptzr_pulled_ahead = nullptr;
+  s_reader_threads_by_reader.clear();
+  s_reader_threads.clear();
+}
+
+/** \brief Start refilling the winning packetizer early
+
+   While the main thread hands the winning packet over to the cluster
+   helper, the winner's reader can already produce the next packet on
+   its own thread. This is only done when not splitting as creating a
+   new file calls hooks on all packetizers.
+
+   The worker may modify the state of all of that reader's packetizers
+   (default durations, track entries, timestamp factories, last cue
+   timestamps etc.). Until it is done the main thread must therefore
+   only use the packet itself and properties of its source that don't
+   change after the headers have been set: its track info, its track
+   type and whether or not it is \c g_video_packetizer. Everything else
+   happens in cluster_helper_c::render(), which calls
+   finish_pulling_ahead() first.
+*/
+static void
+pull_winner_ahead_maybe(packetizer_t &winner) {
+  if (s_reader_threads.empty() || g_cluster_helper->splitting())
+    return;
+
+  auto thread = s_reader_threads_by_reader[winner.packetizer->m_reader];
+
+  thread->schedule(winner);
+  thread->start();
+
+  s_ptzr_pulled_ahead = &winner;
+}
+
+/** \brief Wait for the winner's reader to finish pulling ahead
+
+   Must be called on the main thread before it accesses any packetizer
+   state beyond what pull_winner_ahead_maybe() documents. The rest of
+   the bookkeeping is left to wait_for_reader_threads() so that it
+   happens at the same point as in single-threaded mode.
+*/
+void
+finish_pulling_ahead() {
+  if (s_ptzr_pulled_ahead)
+    s_reader_threads_by_reader[s_ptzr_pulled_ahead->packetizer->m_reader]->wait();
+}
+
+static void
+pull_packetizers_for_packets_threaded() {
+  auto pulled_ahead = s_ptzr_pulled_ahead;
+
+  wait_for_reader_threads();
+
+  std::vector<std::size_t> to_pull;
+  for (auto idx : get_packetizers_to_pull())
+    if (&g_packetizers[idx] != pulled_ahead)
+      to_pull.push_back(idx);
+
+  // All packetizers of a reader must be pulled by the same thread in
+  // the same order as in single-threaded mode. Readers that don't
+  // have to read anything are handled on the main thread.
+  std::unordered_map<generic_reader_c *, bool> reader_needs_data;
+
+  for (auto idx : to_pull) {
+    auto &ptzr = g_packetizers[idx];
+
+    if (   !ptzr.pack
+        && mtx::included_in(ptzr.status, FILE_STATUS_MOREDATA, FILE_STATUS_HOLDING)
+        && !ptzr.packetizer->packet_available())
+      reader_needs_data[ptzr.packetizer->m_reader] = true;
+  }
+
+  auto use_threads = reader_needs_data.size() > 1;
+
+  for (auto idx : to_pull) {
+    auto &ptzr = g_packetizers[idx];
+
+    if (use_threads && reader_needs_data[ptzr.packetizer->m_reader])
+      s_reader_threads_by_reader[ptzr.packetizer->m_reader]->schedule(ptzr);
+    else
+      pull_packetizer(ptzr);
+  }
+
+  if (use_threads) {
+    for (auto const &thread : s_reader_threads)
+      thread->start();
+
+    wait_for_reader_threads();
+  }
+
+  for (auto idx : to_pull) {
+    check_and_handle_end_of_input_after_pulling(g_packetizers[idx]);
+    update_packetizer_scheduling(idx);
+  }
+}
 
+static void
+pull_packetizers_for_packets() {
+  if (g_packetizers.size() != s_winner_tree.size())
+    reset_packetizer_scheduling();
+
+  if (!s_reader_threads.empty()) {
+    pull_packetizers_for_packets_threaded();
+    return;
+  }
+
+  for (auto idx : get_packetizers_to_pull()) {
+    auto &ptzr = g_packetizers[idx];
+
+    pull_packetizer(ptzr);
     check_and_handle_end_of_input_after_pulling(ptzr);
+    update_packetizer_scheduling(idx);
   }
 }
 
 static packetizer_t *
 select_winning_packetizer() {
-  packetizer_t *winner = nullptr;
+  auto idx = s_winner_tree.top();
 
-  for (auto &ptzr : g_packetizers) {
-    if (!ptzr.pack)
-      continue;
+  return idx == s_winner_tree.npos ? nullptr : &g_packetizers[idx];
+}
 
-    if (!winner || !winner->pack)
-      winner = &ptzr;
+static void
+report_peak_queued_bytes() {
+  if (!s_debug_queued_bytes)
+    return;
 
-    else if (ptzr.pack && (ptzr.pack->output_order_timestamp < winner->pack->output_order_timestamp))
-      winner = &ptzr;
-  }
+  for (auto const &ptzr : g_packetizers)
+    mxdebug(fmt::format("peak queued bytes for track {0} of '{1}': {2}\n", ptzr.packetizer->m_ti.m_id, ptzr.packetizer->m_ti.m_fname, ptzr.packetizer->get_peak_queued_bytes()));
 
-  return winner;
+  mxdebug(fmt::format("peak queued bytes of all tracks: {0}; memory limit: {1}\n",
+                      mtx::merge::memory_budget::get_peak_queued_bytes(), mtx::merge::memory_budget::get_limit()));
 }
 
 static void
@@ -2145,6 +2400,14 @@ discard_queued_packets() {
 */
 void
 main_loop() {
+  // Appended files are read one after the other, not in parallel.
+  mtx::merge::memory_budget::set_num_readers(std::count_if(g_files.begin(), g_files.end(), [](auto const &file) { return !file->appending; }));
+
+  reset_packetizer_scheduling();
+  start_reader_threads();
+
+  mtx::at_scope_exit_c stop_threads{[]() { stop_reader_threads(); }};
+
   // Let's go!
   while (1) {
     // Step 1: Make sure a packet is available for each output
@@ -2162,17 +2425,21 @@ main_loop() {
     if (winner && winner->pack) {
       packet_cptr pack = winner->pack;
 
+      winner->pack.reset();
+      update_packetizer_scheduling(get_packetizer_index(*winner));
+
+      pull_winner_ahead_maybe(*winner);
+
       // Step 3: Add the winning packet to a cluster. Full clusters will be
       // rendered automatically.
       g_cluster_helper->add_packet(pack);
 
-      winner->pack.reset();
-
       add_split_points_from_remainig_chapter_numbers();
 
       // If splitting by parts is active and the last part has been
       // processed fully then we can finish up.
       if (g_cluster_helper->is_splitting_and_processed_fully()) {
+        wait_for_reader_threads();
         discard_queued_packets();
         break;
       }
@@ -2185,12 +2452,16 @@ main_loop() {
       break;
   }
 
+  wait_for_reader_threads();
+
   // Render all remaining packets (if there are any).
   if (g_cluster_helper && (0 < g_cluster_helper->get_packet_count()))
     g_cluster_helper->render();
 
   if (1 <= verbose)
     display_progress(true);
+
+  report_peak_queued_bytes();
 }
 
 /** \brief Deletes the file readers and other associated objects
@@ -2207,6 +2478,8 @@ destroy_readers() {
 */
 void
 cleanup() {
+  stop_reader_threads();
+
   if (s_out) {
     // If cleanup was called as a result of an exception during
     // writing due to the file system being full, the destructor would
@@ -2252,4 +2525,7 @@ cleanup() {
   g_seguid_link_previous.reset();
   g_seguid_link_next.reset();
   g_forced_seguids.clear();
+
+  if (s_debug_memory_pool)
+    mtx::mem::pool_c::get().dump_statistics();
 }
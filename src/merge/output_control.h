@@ -202,6 +202,7 @@ void create_next_output_file();
 void finish_file(bool last_file, bool create_new_file = false, bool previously_discarding = false);
 void force_close_output_file();
 void rerender_track_headers();
+void finish_pulling_ahead();
 std::string create_output_name();
 
 void add_to_progress(int64_t num_bytes_processed);
@@ -47,7 +47,7 @@ using packet_extension_cptr = std::shared_ptr<packet_extension_c>;
 
 struct packet_t {
   memory_cptr data;
-  std::vector<memory_cptr> data_adds;
+  mtx::mem::pooled_vector_t<memory_cptr> data_adds;
   memory_cptr codec_state;
 
   libmatroska::KaxBlockBlob *group;
@@ -63,7 +63,7 @@ struct packet_t {
   std::optional<bool> key_flag, discardable_flag;
   generic_packetizer_c *source;
 
-  std::vector<packet_extension_cptr> extensions;
+  mtx::mem::pooled_vector_t<packet_extension_cptr> extensions;
 
   packet_t()
     : group{}
@@ -121,7 +121,7 @@ struct packet_t {
            int64_t p_duration = -1,
            int64_t p_bref     = -1,
            int64_t p_fref     = -1)
-    : data(memory_cptr(n_memory))
+    : data(mtx::mem::make_pooled_shared(n_memory))
     , group{}
     , block{}
     , cluster{}
@@ -147,6 +147,16 @@ struct packet_t {
   ~packet_t() {
   }
 
+  // packet_t objects are created for each frame; take them from the
+  // pool instead of the heap.
+  static void *operator new(std::size_t size) {
+    return mtx::mem::pool_c::get().allocate(size);
+  }
+
+  static void operator delete(void *ptr, std::size_t size) {
+    mtx::mem::pool_c::get().release(ptr, size);
+  }
+
   bool
   has_timestamp()
     const {
@@ -232,3 +242,11 @@ struct packet_t {
   uint64_t calculate_uncompressed_size();
 };
 using packet_cptr = std::shared_ptr<packet_t>;
+
+// Like std::make_shared, but with the object and its control block
+// taken from the memory pool.
+template<typename... Targs>
+packet_cptr
+make_packet(Targs &&... args) {
+  return std::allocate_shared<packet_t>(mtx::mem::pool_allocator_c<packet_t>{}, std::forward<Targs>(args)...);
+}
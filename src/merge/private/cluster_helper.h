@@ -14,11 +14,13 @@
 
 #pragma once
 
+#include "common/kax_cluster_writer.h"
 #include "common/track_statistics.h"
 
 class render_groups_c {
 public:
   std::vector<kax_block_blob_cptr> m_groups;
+  std::vector<std::size_t> m_direct_blocks; // indexes into the cluster writer's blocks
   std::vector<int64_t> m_durations;
   generic_packetizer_c *m_source;
   bool m_more_data, m_duration_mandatory, m_has_discard_padding;
@@ -53,6 +55,7 @@ using render_groups_cptr = std::shared_ptr<render_groups_c>;
 struct cluster_helper_c::impl_t {
 public:
   std::shared_ptr<kax_cluster_c> cluster;
+  std::unique_ptr<mtx::kax::cluster_writer_c> cluster_writer;
   std::vector<packet_cptr> packets;
   int cluster_content_size{};
   int64_t max_timestamp_and_duration{}, max_video_timestamp_rendered{};
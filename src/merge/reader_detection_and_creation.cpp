@@ -12,9 +12,15 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
+#include <thread>
 #include <typeinfo>
 
+#include "common/at_scope_exit.h"
+#include "common/file_types.h"
+#include "common/hacks.h"
 #include "common/mm_file_io.h"
+#include "common/mm_mmap_io.h"
 #include "common/mm_mpls_multi_file_io.h"
 #include "common/mm_proxy_io.h"
 #include "common/mm_read_buffer_io.h"
@@ -73,13 +79,25 @@ file_names_to_paths(const std::vector<std::string> &file_names) {
 
 static mm_io_cptr
 open_input_file(filelist_t &file) {
+  // With read-ahead four 1 MiB blocks are kept in flight.
+  auto read_ahead             = mtx::hacks::is_engaged(mtx::hacks::READ_AHEAD);
+  auto buffer_size            = read_ahead ? std::size_t{1} << 20 : std::size_t{1} << 17;
+  auto num_read_ahead_buffers = read_ahead ? 4u : 0u;
+
   try {
+    if ((file.all_names.size() == 1) && mtx::hacks::is_engaged(mtx::hacks::MEMORY_MAPPED_INPUT)) {
+      // Falls back to regular reading if the file cannot be mapped.
+      auto mapped = mm_mmap_io_c::open(file.name);
+      if (mapped)
+        return mapped;
+    }
+
     if (file.all_names.size() == 1)
-      return std::make_shared<mm_read_buffer_io_c>(std::make_shared<mm_file_io_c>(file.name));
+      return std::make_shared<mm_read_buffer_io_c>(std::make_shared<mm_file_io_c>(file.name), buffer_size, num_read_ahead_buffers);
 
     else {
       std::vector<bfs::path> paths = file_names_to_paths(file.all_names);
-      return std::make_shared<mm_read_buffer_io_c>(std::make_shared<mm_multi_file_io_c>(paths, file.name));
+      return std::make_shared<mm_read_buffer_io_c>(std::make_shared<mm_multi_file_io_c>(paths, file.name), buffer_size, num_read_ahead_buffers);
     }
 
   } catch (mtx::mm_io::exception &ex) {
@@ -124,6 +142,8 @@ do_probe(mm_io_cptr const &io,
 
   try {
     probed_ok = reader->probe_file();
+  } catch (mtx::output::capture_c::error_x &) {
+    throw;
   } catch (mtx::exception &ex) {
     mxdebug_if(s_debug_probe, fmt::format("do_probe<{}>: mtx::exception caught: {}\n", typeid(Treader).name(), ex.what()));
   } catch (...) {
@@ -154,40 +174,176 @@ do_probe(mm_io_cptr const &io,
   return {};
 }
 
-using prober_t = std::function<std::unique_ptr<generic_reader_c>(mm_io_cptr const &, probe_range_info_t const &)>;
+// The start of a file must match these signatures for the container
+// readers' probe_file() functions to succeed. This allows skipping
+// most of the probes with a look at data that is already in
+// memory. Readers without a signature are always probed. A signature
+// must never be stricter than the reader's own probe.
+
+static std::size_t constexpr s_signature_size   = 16;
+static std::size_t constexpr s_probe_window_size = 1024 * 1024;
+
+static bool
+signature_at(memory_c const &head,
+             std::size_t offset,
+             std::string const &signature,
+             bool ignore_case = false) {
+  if (head.get_size() < (offset + signature.size()))
+    return false;
+
+  auto actual = std::string{reinterpret_cast<char const *>(head.get_buffer()) + offset, signature.size()};
+
+  return ignore_case ? balg::iequals(actual, signature) : (actual == signature);
+}
+
+template<typename Treader>
+bool
+signature_matches(memory_c const &) {
+  return true;
+}
+
+template<>
+bool
+signature_matches<avi_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, "riff", true) && signature_at(head, 8, "avi ", true);
+}
+
+template<>
+bool
+signature_matches<coreaudio_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, "caff", true);
+}
+
+template<>
+bool
+signature_matches<flac_reader_c>(memory_c const &head) {
+  // The reader skips ID3v2 tags.
+  return signature_at(head, 0, "fLaC") || signature_at(head, 0, "ID3");
+}
+
+template<>
+bool
+signature_matches<flv_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, "FLV");
+}
+
+template<>
+bool
+signature_matches<hdmv_pgs_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, "PG");
+}
+
+template<>
+bool
+signature_matches<hdmv_textst_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, "TextST");
+}
+
+template<>
+bool
+signature_matches<ivf_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, "DKIF");
+}
+
+template<>
+bool
+signature_matches<kax_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, "\x1a\x45\xdf\xa3");
+}
+
+template<>
+bool
+signature_matches<ogm_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, "OggS");
+}
+
+template<>
+bool
+signature_matches<qtmp4_reader_c>(memory_c const &head) {
+  // The first atom's type. Its size doesn't matter.
+  for (auto const &atom : { "moov", "ftyp", "mdat", "pnot", "wide", "skip" })
+    if (signature_at(head, 4, atom))
+      return true;
+
+  return false;
+}
+
+template<>
+bool
+signature_matches<real_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, ".RMF");
+}
+
+template<>
+bool
+signature_matches<tta_reader_c>(memory_c const &head) {
+  // The reader skips ID3v2 tags.
+  return signature_at(head, 0, "TTA1") || signature_at(head, 0, "ID3");
+}
+
+template<>
+bool
+signature_matches<wav_reader_c>(memory_c const &head) {
+  // RIFF WAVE, RF64 and Wave64 (GUID starting with "riff").
+  return signature_at(head, 0, "RIFF") || signature_at(head, 0, "RF64") || signature_at(head, 0, "riff");
+}
+
+template<>
+bool
+signature_matches<wavpack_reader_c>(memory_c const &head) {
+  return signature_at(head, 0, "wvpk");
+}
+
+template<typename Treader>
+std::unique_ptr<generic_reader_c>
+do_probe_if_signature_matches(mm_io_cptr const &io,
+                              memory_c const &head) {
+  if (!signature_matches<Treader>(head)) {
+    mxdebug_if(s_debug_probe, fmt::format("do_probe<{}>: skipped as the signature doesn't match\n", typeid(Treader).name()));
+    return {};
+  }
+
+  return do_probe<Treader>(io);
+}
+
+using prober_t = std::function<std::unique_ptr<generic_reader_c>(mm_io_cptr const &, memory_c const &)>;
 
 static prober_t
 prober_for_type(mtx::file_type_e type) {
-  static std::map<mtx::file_type_e, prober_t> type_probe_map;
-
-  if (type_probe_map.empty()) {
-    type_probe_map[mtx::file_type_e::avc_es]      = &do_probe<avc_es_reader_c>;
-    type_probe_map[mtx::file_type_e::avi]         = &do_probe<avi_reader_c>;
-    type_probe_map[mtx::file_type_e::coreaudio]   = &do_probe<coreaudio_reader_c>;
-    type_probe_map[mtx::file_type_e::dirac]       = &do_probe<dirac_es_reader_c>;
-    type_probe_map[mtx::file_type_e::dts]         = &do_probe<dts_reader_c>;
-    type_probe_map[mtx::file_type_e::dv]          = &do_probe<dv_reader_c>;
-    type_probe_map[mtx::file_type_e::flac]        = &do_probe<flac_reader_c>;
-    type_probe_map[mtx::file_type_e::flv]         = &do_probe<flv_reader_c>;
-    type_probe_map[mtx::file_type_e::hdmv_textst] = &do_probe<hdmv_textst_reader_c>;
-    type_probe_map[mtx::file_type_e::hevc_es]     = &do_probe<hevc_es_reader_c>;
-    type_probe_map[mtx::file_type_e::ivf]         = &do_probe<ivf_reader_c>;
-    type_probe_map[mtx::file_type_e::matroska]    = &do_probe<kax_reader_c>;
-    type_probe_map[mtx::file_type_e::mpeg_es]     = &do_probe<mpeg_es_reader_c>;
-    type_probe_map[mtx::file_type_e::mpeg_ps]     = &do_probe<mpeg_ps_reader_c>;
-    type_probe_map[mtx::file_type_e::mpeg_ts]     = &do_probe<mtx::mpeg_ts::reader_c>;
-    type_probe_map[mtx::file_type_e::obu]         = &do_probe<obu_reader_c>;
-    type_probe_map[mtx::file_type_e::ogm]         = &do_probe<ogm_reader_c>;
-    type_probe_map[mtx::file_type_e::pgssup]      = &do_probe<hdmv_pgs_reader_c>;
-    type_probe_map[mtx::file_type_e::qtmp4]       = &do_probe<qtmp4_reader_c>;
-    type_probe_map[mtx::file_type_e::real]        = &do_probe<real_reader_c>;
-    type_probe_map[mtx::file_type_e::truehd]      = &do_probe<truehd_reader_c>;
-    type_probe_map[mtx::file_type_e::tta]         = &do_probe<tta_reader_c>;
-    type_probe_map[mtx::file_type_e::vc1]         = &do_probe<vc1_es_reader_c>;
-    type_probe_map[mtx::file_type_e::vobbtn]      = &do_probe<vobbtn_reader_c>;
-    type_probe_map[mtx::file_type_e::wav]         = &do_probe<wav_reader_c>;
-    type_probe_map[mtx::file_type_e::wavpack4]    = &do_probe<wavpack_reader_c>;
-  }
+  // Initialized on first use in a thread-safe manner as files may be
+  // probed on several threads.
+  static auto const type_probe_map = []() {
+    std::map<mtx::file_type_e, prober_t> type_probe_map;
+
+    type_probe_map[mtx::file_type_e::avc_es]      = &do_probe_if_signature_matches<avc_es_reader_c>;
+    type_probe_map[mtx::file_type_e::avi]         = &do_probe_if_signature_matches<avi_reader_c>;
+    type_probe_map[mtx::file_type_e::coreaudio]   = &do_probe_if_signature_matches<coreaudio_reader_c>;
+    type_probe_map[mtx::file_type_e::dirac]       = &do_probe_if_signature_matches<dirac_es_reader_c>;
+    type_probe_map[mtx::file_type_e::dts]         = &do_probe_if_signature_matches<dts_reader_c>;
+    type_probe_map[mtx::file_type_e::dv]          = &do_probe_if_signature_matches<dv_reader_c>;
+    type_probe_map[mtx::file_type_e::flac]        = &do_probe_if_signature_matches<flac_reader_c>;
+    type_probe_map[mtx::file_type_e::flv]         = &do_probe_if_signature_matches<flv_reader_c>;
+    type_probe_map[mtx::file_type_e::hdmv_textst] = &do_probe_if_signature_matches<hdmv_textst_reader_c>;
+    type_probe_map[mtx::file_type_e::hevc_es]     = &do_probe_if_signature_matches<hevc_es_reader_c>;
+    type_probe_map[mtx::file_type_e::ivf]         = &do_probe_if_signature_matches<ivf_reader_c>;
+    type_probe_map[mtx::file_type_e::matroska]    = &do_probe_if_signature_matches<kax_reader_c>;
+    type_probe_map[mtx::file_type_e::mpeg_es]     = &do_probe_if_signature_matches<mpeg_es_reader_c>;
+    type_probe_map[mtx::file_type_e::mpeg_ps]     = &do_probe_if_signature_matches<mpeg_ps_reader_c>;
+    type_probe_map[mtx::file_type_e::mpeg_ts]     = &do_probe_if_signature_matches<mtx::mpeg_ts::reader_c>;
+    type_probe_map[mtx::file_type_e::obu]         = &do_probe_if_signature_matches<obu_reader_c>;
+    type_probe_map[mtx::file_type_e::ogm]         = &do_probe_if_signature_matches<ogm_reader_c>;
+    type_probe_map[mtx::file_type_e::pgssup]      = &do_probe_if_signature_matches<hdmv_pgs_reader_c>;
+    type_probe_map[mtx::file_type_e::qtmp4]       = &do_probe_if_signature_matches<qtmp4_reader_c>;
+    type_probe_map[mtx::file_type_e::real]        = &do_probe_if_signature_matches<real_reader_c>;
+    type_probe_map[mtx::file_type_e::truehd]      = &do_probe_if_signature_matches<truehd_reader_c>;
+    type_probe_map[mtx::file_type_e::tta]         = &do_probe_if_signature_matches<tta_reader_c>;
+    type_probe_map[mtx::file_type_e::vc1]         = &do_probe_if_signature_matches<vc1_es_reader_c>;
+    type_probe_map[mtx::file_type_e::vobbtn]      = &do_probe_if_signature_matches<vobbtn_reader_c>;
+    type_probe_map[mtx::file_type_e::wav]         = &do_probe_if_signature_matches<wav_reader_c>;
+    type_probe_map[mtx::file_type_e::wavpack4]    = &do_probe_if_signature_matches<wavpack_reader_c>;
+
+    return type_probe_map;
+  }();
 
   auto res = type_probe_map.find(type);
   if (res == type_probe_map.end()) {
@@ -241,12 +397,30 @@ probe_file_format(filelist_t &file) {
   if (is_playlist)
     io = std::make_shared<mm_read_buffer_io_c>(file.playlist_mpls_in);
 
+  // Keep the whole probe window in the read buffer while probing so
+  // that the probers going back to the start of the file over and
+  // over again don't have to read it again.
+  auto buffered_io = std::dynamic_pointer_cast<mm_read_buffer_io_c>(io);
+  auto buffer_size = buffered_io ? buffered_io->get_buffer_size() : 0;
+
+  if (buffered_io)
+    buffered_io->set_buffer_size(std::max(buffer_size, s_probe_window_size));
+
+  mtx::at_scope_exit_c restore_buffer_size{[buffered_io, buffer_size]() {
+    if (buffered_io)
+      buffered_io->set_buffer_size(buffer_size);
+  }};
+
+  auto head = memory_c::alloc(s_signature_size);
+  head->set_size(io->read(head->get_buffer(), s_signature_size));
+  io->setFilePointer(0);
+
   // Prefer types hinted by extension
   auto extension = boost::filesystem::extension(file.name);
   if (!extension.empty()) {
     for (auto type : mtx::file_type_t::by_extension(extension.substr(1))) {
       auto p = prober_for_type(type);
-      if (p && (reader = p(io, {})))
+      if (p && (reader = p(io, *head)))
         return reader;
     }
   }
@@ -255,38 +429,39 @@ probe_file_format(filelist_t &file) {
   // supported. The prober does not return if it detects the type.
   do_probe<unsupported_types_signature_prober_c>(io);
 
-  // File types that can be detected unambiguously
-  if ((reader = do_probe<avi_reader_c>(io)))
+  // File types that can be detected unambiguously. Only those whose
+  // signature matches are actually probed.
+  if ((reader = do_probe_if_signature_matches<avi_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<flv_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<flv_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<kax_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<kax_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<wav_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<wav_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<ogm_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<ogm_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<hdmv_textst_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<hdmv_textst_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<flac_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<flac_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<hdmv_pgs_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<hdmv_pgs_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<real_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<real_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<qtmp4_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<qtmp4_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<tta_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<tta_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<vc1_es_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<vc1_es_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<wavpack_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<wavpack_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<ivf_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<ivf_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<coreaudio_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<coreaudio_reader_c>(io, *head)))
     return reader;
-  if ((reader = do_probe<dirac_es_reader_c>(io)))
+  if ((reader = do_probe_if_signature_matches<dirac_es_reader_c>(io, *head)))
     return reader;
 
   // All text file types (subtitles).
@@ -372,41 +547,132 @@ probe_file_format(filelist_t &file) {
   return {};
 }
 
+// Runs the function for each index on a pool of threads. Each
+// function call's messages are captured and output in the order of
+// the indexes afterwards, followed by a call to finish() for that
+// index. Exceptions are re-thrown at the same point.
+static void
+run_on_thread_pool(std::size_t num_items,
+                   std::function<void(std::size_t)> const &work,
+                   std::function<void(std::size_t)> const &finish) {
+  struct job_t {
+    mtx::output::capture_c capture;
+    std::exception_ptr exception;
+  };
+
+  std::vector<job_t> jobs(num_items);
+  std::atomic<std::size_t> next_idx{0};
+
+  auto worker = [&]() {
+    for (auto idx = next_idx++; idx < num_items; idx = next_idx++) {
+      auto &job = jobs[idx];
+
+      job.capture.start();
+
+      try {
+        work(idx);
+      } catch (mtx::output::capture_c::error_x &) {
+        // Recorded by the capture already.
+      } catch (...) {
+        job.exception = std::current_exception();
+      }
+
+      job.capture.stop();
+    }
+  };
+
+  auto num_threads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), num_items);
+  std::vector<std::thread> threads;
+
+  for (auto idx = 1u; idx < num_threads; ++idx)
+    threads.emplace_back(worker);
+
+  worker();
+
+  for (auto &thread : threads)
+    thread.join();
+
+  for (auto idx = 0u; idx < num_items; ++idx) {
+    jobs[idx].capture.replay();
+
+    if (jobs[idx].exception)
+      std::rethrow_exception(jobs[idx].exception);
+
+    finish(idx);
+  }
+}
+
 void
-read_file_headers() {
-  static auto s_debug_timestamp_restrictions = debugging_option_c{"timestamp_restrictions"};
+probe_file_formats(std::function<void(filelist_t &)> const &handle_result) {
+  std::vector<filelist_t *> files;
 
-  g_file_sizes = 0;
+  for (auto const &file : g_files)
+    if (!file->reader)
+      files.push_back(file.get());
 
-  for (auto &file : g_files) {
-    try {
-      file->reader->m_appending = file->appending;
-      file->reader->set_track_info(*file->ti);
-      file->reader->set_timestamp_restrictions(file->restricted_timestamp_min, file->restricted_timestamp_max);
-      file->reader->read_headers();
+  if (files.empty())
+    return;
 
-      // Re-calculate file size because the reader might switch to a
-      // multi I/O reader in read_headers().
-      file->size    = file->reader->get_file_size();
-      g_file_sizes += file->size;
+  // Initialize the list of file types before several threads try
+  // to do it at the same time.
+  mtx::file_type_t::get_supported();
 
-      mxdebug_if(s_debug_timestamp_restrictions,
-                 fmt::format("Timestamp restrictions for {2}: min {0} max {1}\n", file->restricted_timestamp_min, file->restricted_timestamp_max, file->ti->m_fname));
+  run_on_thread_pool(files.size(),
+                     [&files](std::size_t idx) { files[idx]->reader = probe_file_format(*files[idx]); },
+                     [&files, &handle_result](std::size_t idx) { handle_result(*files[idx]); });
+}
 
-    } catch (mtx::mm_io::open_x &error) {
-      mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file->ti->m_fname, Y("The file could not be opened for reading, or there was not enough data to parse its headers.")));
+static void
+read_headers(filelist_t &file) {
+  try {
+    file.reader->m_appending = file.appending;
+    file.reader->set_track_info(*file.ti);
+    file.reader->set_timestamp_restrictions(file.restricted_timestamp_min, file.restricted_timestamp_max);
+    file.reader->read_headers();
 
-    } catch (mtx::input::open_x &error) {
-      mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file->ti->m_fname, Y("The file could not be opened for reading, or there was not enough data to parse its headers.")));
+    // Re-calculate file size because the reader might switch to a
+    // multi I/O reader in read_headers().
+    file.size = file.reader->get_file_size();
 
-    } catch (mtx::input::invalid_format_x &error) {
-      mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file->ti->m_fname, Y("The file content does not match its format type and was not recognized.")));
+  } catch (mtx::mm_io::open_x &error) {
+    mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file.ti->m_fname, Y("The file could not be opened for reading, or there was not enough data to parse its headers.")));
 
-    } catch (mtx::input::header_parsing_x &error) {
-      mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file->ti->m_fname, Y("The file headers could not be parsed, e.g. because they're incomplete, invalid or damaged.")));
+  } catch (mtx::input::open_x &error) {
+    mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file.ti->m_fname, Y("The file could not be opened for reading, or there was not enough data to parse its headers.")));
 
-    } catch (mtx::input::exception &error) {
-      mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file->ti->m_fname, error.error()));
-    }
+  } catch (mtx::input::invalid_format_x &error) {
+    mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file.ti->m_fname, Y("The file content does not match its format type and was not recognized.")));
+
+  } catch (mtx::input::header_parsing_x &error) {
+    mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file.ti->m_fname, Y("The file headers could not be parsed, e.g. because they're incomplete, invalid or damaged.")));
+
+  } catch (mtx::input::exception &error) {
+    mxerror(fmt::format(Y("The demultiplexer for the file '{0}' failed to initialize:\n{1}\n"), file.ti->m_fname, error.error()));
+  }
+}
+
+void
+read_file_headers() {
+  static auto s_debug_timestamp_restrictions = debugging_option_c{"timestamp_restrictions"};
+
+  g_file_sizes = 0;
+
+  auto finish = [](filelist_t &file) {
+    g_file_sizes += file.size;
+
+    mxdebug_if(s_debug_timestamp_restrictions,
+               fmt::format("Timestamp restrictions for {2}: min {0} max {1}\n", file.restricted_timestamp_min, file.restricted_timestamp_max, file.ti->m_fname));
+  };
+
+  if (mtx::hacks::is_engaged(mtx::hacks::PARALLEL_PROBING) && (g_files.size() > 1)) {
+    run_on_thread_pool(g_files.size(),
+                       [](std::size_t idx) { read_headers(*g_files[idx]); },
+                       [&finish](std::size_t idx) { finish(*g_files[idx]); });
+    return;
+  }
+
+  for (auto &file : g_files) {
+    read_headers(*file);
+    finish(*file);
   }
 }
@@ -19,4 +19,5 @@
 struct filelist_t;
 
 std::unique_ptr<generic_reader_c> probe_file_format(filelist_t &file);
+void probe_file_formats(std::function<void(filelist_t &)> const &handle_result);
 void read_file_headers();
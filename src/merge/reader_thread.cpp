@@ -0,0 +1,124 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   worker threads pulling packets from readers
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "merge/reader_thread.h"
+
+reader_thread_c::reader_thread_c(generic_reader_c &reader,
+                                 pull_function_t const &pull)
+  : m_reader(reader)
+  , m_pull{pull}
+{
+  m_thread = std::thread{[this]() { run(); }};
+}
+
+reader_thread_c::~reader_thread_c() {
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_quit = true;
+  }
+
+  m_condition.notify_all();
+
+  // mxerror() calls exit() which runs the destructors of static
+  // objects on the thread that caused the error.
+  if (std::this_thread::get_id() == m_thread.get_id())
+    m_thread.detach();
+  else
+    m_thread.join();
+}
+
+generic_reader_c &
+reader_thread_c::get_reader()
+  const {
+  return m_reader;
+}
+
+void
+reader_thread_c::schedule(packetizer_t &ptzr) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+
+  assert(!m_busy);
+
+  m_jobs.push_back(&ptzr);
+}
+
+void
+reader_thread_c::start() {
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    if (m_busy || m_jobs.empty())
+      return;
+
+    m_busy = true;
+  }
+
+  m_condition.notify_all();
+}
+
+bool
+reader_thread_c::is_busy() {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_busy;
+}
+
+void
+reader_thread_c::wait() {
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  m_condition.wait(lock, [this]() { return !m_busy; });
+
+  if (!m_exception)
+    return;
+
+  auto exception = m_exception;
+  m_exception    = nullptr;
+
+  std::rethrow_exception(exception);
+}
+
+void
+reader_thread_c::run() {
+  while (true) {
+    std::vector<packetizer_t *> jobs;
+
+    {
+      std::unique_lock<std::mutex> lock{m_mutex};
+
+      m_condition.wait(lock, [this]() { return m_quit || m_busy; });
+
+      if (m_quit)
+        return;
+
+      std::swap(jobs, m_jobs);
+    }
+
+    try {
+      for (auto ptzr : jobs)
+        m_pull(*ptzr);
+
+    } catch (...) {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_exception = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_busy = false;
+    }
+
+    m_condition.notify_all();
+  }
+}
@@ -0,0 +1,63 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+
+   worker threads pulling packets from readers
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#pragma once
+
+#include "common/common_pch.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class generic_reader_c;
+struct packetizer_t;
+
+// Each reader gets its own worker thread. The main loop hands it the
+// list of packetizers that need a new packet, and the worker runs the
+// exact same pulling logic the single-threaded main loop would run
+// for those packetizers. As readers don't share state with each other
+// the resulting packets and their order are identical to the
+// single-threaded mode; only the point in time at which they're
+// produced differs.
+class reader_thread_c {
+public:
+  using pull_function_t = std::function<void(packetizer_t &)>;
+
+protected:
+  generic_reader_c &m_reader;
+  pull_function_t m_pull;
+
+  std::vector<packetizer_t *> m_jobs;
+  std::exception_ptr m_exception;
+  bool m_busy{}, m_quit{};
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::thread m_thread;
+
+public:
+  reader_thread_c(generic_reader_c &reader, pull_function_t const &pull);
+  ~reader_thread_c();
+
+  generic_reader_c &get_reader() const;
+
+  void schedule(packetizer_t &ptzr);
+  void start();
+  void wait();
+  bool is_busy();
+
+protected:
+  void run();
+};
+
+using reader_thread_cptr = std::shared_ptr<reader_thread_c>;
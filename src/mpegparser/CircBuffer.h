@@ -108,4 +108,9 @@ public:
     return bytes_in_buf;
   }
 
+  //True if the stored bytes don't wrap around the end of the buffer
+  bool IsContiguous(){
+    return bytes_before_wrap_read() >= bytes_in_buf;
+  }
+
 };
@@ -22,6 +22,7 @@
 
 #include "common/common_pch.h"
 
+#include "common/mpeg.h"
 #include "MPEGVideoBuffer.h"
 #include <cstring>
 
@@ -37,6 +38,16 @@ MPEG2PictureHeader::MPEG2PictureHeader() {
   memset(this, 0, sizeof(*this));
 }
 
+static bool IsWantedStartCode(binary code){
+  switch(code){
+    case MPEG_VIDEO_SEQUENCE_START_CODE:
+    case MPEG_VIDEO_GOP_START_CODE:
+    case MPEG_VIDEO_PICTURE_START_CODE:
+      return true;
+  }
+  return false;
+}
+
 int32_t MPEGVideoBuffer::FindStartCode(uint32_t startPos){
   //How many bytes can we look through?
   uint32_t window = myBuffer->GetLength() - startPos;
@@ -44,23 +55,29 @@ int32_t MPEGVideoBuffer::FindStartCode(uint32_t startPos){
   if(window < 4) //Make sure we have enough bytes to search.
     return -1;
 
+  CircBuffer& buf = *myBuffer;
+
+  if(buf.IsContiguous()){
+    //The start code must be followed by the byte telling its type.
+    const binary* data = buf.GetReadPtr();
+    const binary* end = data + buf.GetLength() - 1;
+
+    for(const binary* pos = mtx::mpeg::find_start_code(data + startPos, end); pos != end; pos = mtx::mpeg::find_start_code(pos + 3, end))
+      if(IsWantedStartCode(pos[3]))
+        return pos - data;
+
+    return -1;
+  }
+
   for(int i = startPos, endPos = startPos + window - 3; i < endPos; i++){
-    CircBuffer& buf = *myBuffer;
     binary a,b,c,d;
     a = buf[i];
     b = buf[i+1];
     c = buf[i+2];
     d = buf[i+3];
-    if((a == 0x00) && (b == 0x00) && (c == 0x01)){
-      switch(d){
-        case MPEG_VIDEO_SEQUENCE_START_CODE:
-        case MPEG_VIDEO_GOP_START_CODE:
-        case MPEG_VIDEO_PICTURE_START_CODE:
-          return i;  //Return our position if we found
-          //one of the codes we want
-
-      }
-    }
+    if((a == 0x00) && (b == 0x00) && (c == 0x01) && IsWantedStartCode(d))
+      return i;  //Return our position if we found
+      //one of the codes we want
   }
 
   //If we get here we have no _wanted_ start code found.
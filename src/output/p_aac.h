@@ -41,6 +41,9 @@ public:
   virtual ~aac_packetizer_c();
 
   virtual int process(packet_cptr packet);
+  virtual bool accepts_immutable_frames() const {
+    return true;
+  }
   virtual void set_headers();
 
   virtual translatable_string_c get_format_name() const {
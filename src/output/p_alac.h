@@ -28,6 +28,9 @@ public:
   virtual ~alac_packetizer_c();
 
   virtual int process(packet_cptr packet);
+  virtual bool accepts_immutable_frames() const {
+    return true;
+  }
 
   virtual translatable_string_c get_format_name() const {
     return YT("ALAC");
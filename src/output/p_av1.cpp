@@ -131,7 +131,7 @@ av1_video_packetizer_c::flush_frames() {
     auto bref            = frame.is_keyframe ? -1 : m_previous_timestamp;
     m_previous_timestamp = frame.timestamp;
 
-    add_packet(std::make_shared<packet_t>(frame.mem, frame.timestamp, -1, bref));
+    add_packet(make_packet(frame.mem, frame.timestamp, -1, bref));
   }
 }
 
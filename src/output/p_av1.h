@@ -28,6 +28,9 @@ public:
   av1_video_packetizer_c(generic_reader_c *p_reader, track_info_c &p_ti);
 
   virtual int process(packet_cptr packet) override;
+  virtual bool accepts_immutable_frames() const override {
+    return true;
+  }
 
   virtual void set_is_unframed();
 
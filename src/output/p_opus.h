@@ -31,6 +31,9 @@ public:
   virtual ~opus_packetizer_c();
 
   virtual int process(packet_cptr packet);
+  virtual bool accepts_immutable_frames() const {
+    return true;
+  }
   virtual void set_headers();
 
   virtual translatable_string_c get_format_name() const {
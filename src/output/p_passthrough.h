@@ -22,6 +22,9 @@ public:
   passthrough_packetizer_c(generic_reader_c *p_reader, track_info_c &p_ti);
 
   virtual int process(packet_cptr packet);
+  virtual bool accepts_immutable_frames() const {
+    return true;
+  }
   virtual void set_headers();
 
   virtual translatable_string_c get_format_name() const {
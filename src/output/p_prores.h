@@ -23,6 +23,9 @@ public:
   prores_video_packetizer_c(generic_reader_c *reader, track_info_c &ti, double fps, int width, int height);
 
   virtual int process(packet_cptr packet) override;
+  virtual bool accepts_immutable_frames() const override {
+    return true;
+  }
 
   virtual translatable_string_c get_format_name() const override {
     return YT("ProRes video");
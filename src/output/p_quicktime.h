@@ -22,6 +22,10 @@ class quicktime_video_packetizer_c: public generic_video_packetizer_c {
 public:
   quicktime_video_packetizer_c(generic_reader_c *p_reader, track_info_c &p_ti, int width, int height);
 
+  virtual bool accepts_immutable_frames() const {
+    return true;
+  }
+
   virtual translatable_string_c get_format_name() const {
     return YT("QuickTime compatible video");
   }
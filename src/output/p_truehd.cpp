@@ -70,7 +70,7 @@ truehd_packetizer_c::process_framed(mtx::truehd::frame_cptr const &frame,
   auto samples            = 0 == frame->m_samples_per_frame ? m_current_samples_per_frame : frame->m_samples_per_frame;
   auto timestamp          = m_timestamp_calculator.get_next_timestamp(samples).to_ns();
   auto duration           = m_timestamp_calculator.get_duration(samples).to_ns();
-  auto packet             = std::make_shared<packet_t>(frame->m_data, timestamp, duration, frame->is_sync() ? -1 : m_ref_timestamp);
+  auto packet             = make_packet(frame->m_data, timestamp, duration, frame->is_sync() ? -1 : m_ref_timestamp);
   packet->discard_padding = m_discard_padding.get_next().value_or(timestamp_c{});
 
   if (frame->is_sync() && frame->is_truehd() && m_remove_dialog_normalization_gain)
@@ -31,6 +31,9 @@ public:
   video_for_windows_packetizer_c(generic_reader_c *p_reader, track_info_c &p_ti, double fps, int width, int height);
 
   virtual int process(packet_cptr packet) override;
+  virtual bool accepts_immutable_frames() const override {
+    return true;
+  }
   virtual void set_headers() override;
 
   virtual translatable_string_c get_format_name() const override {
@@ -11,6 +11,7 @@
 #include "common/common_pch.h"
 
 #include "common/bswap.h"
+#include "common/checksums/adler32.h"
 #include "common/checksums/crc.h"
 #include "common/command_line.h"
 #include "common/endian.h"
@@ -25,7 +26,7 @@ public:
   mtx::checksum::algorithm_e m_algorithm{mtx::checksum::algorithm_e::adler32};
   size_t m_chunk_size{4096};
   uint64_t m_initial_value{}, m_xor_result{};
-  bool m_result_in_le{};
+  bool m_result_in_le{}, m_benchmark{};
 };
 
 static void
@@ -46,6 +47,7 @@ setup_help_and_version_info() {
                              "      --crc8-atm         Use CRC-8 ATM\n"
                              "      --crc16-ansi       Use CRC-16 ANSI\n"
                              "      --crc16-ccitt      Use CRC-16 CCITT\n"
+                             "      --crc16-002d       Use CRC-16 with polynomial 0x002d\n"
                              "  -c, --crc32-ieee       Use CRC-32 IEEE\n"
                              "      --crc32-ieee-le    Use CRC-32 IEEE Little Endian\n"
                              "  -t, --matroska         Use Matroska's CRC (CRC-32 IEEE Little Endian,\n"
@@ -60,6 +62,9 @@ setup_help_and_version_info() {
                              "                         (default: 0)\n"
                              "  --result-in-le         Output the result in Little Endian (default:\n"
                              "                         Big Endian)\n"
+                             "  --benchmark            Read the whole file into memory and report the\n"
+                             "                         throughput of each implementation of the\n"
+                             "                         algorithm instead of the checksum\n"
                              "\n"
                              "General options:\n"
                              "\n"
@@ -88,6 +93,9 @@ parse_args(std::vector<std::string> &args) {
     else if (arg == "--crc16-ccitt")
       options.m_algorithm = mtx::checksum::algorithm_e::crc16_ccitt;
 
+    else if (arg == "--crc16-002d")
+      options.m_algorithm = mtx::checksum::algorithm_e::crc16_002d;
+
     else if ((arg == "-c") || (arg == "--crc32-ieee"))
       options.m_algorithm = mtx::checksum::algorithm_e::crc32_ieee;
 
@@ -133,6 +141,9 @@ parse_args(std::vector<std::string> &args) {
     } else if (arg == "--result-in-le")
       options.m_result_in_le = true;
 
+    else if (arg == "--benchmark")
+      options.m_benchmark = true;
+
     else if (!options.m_file_name.empty())
       mxerror("More than one source file was given.\n");
 
@@ -146,13 +157,8 @@ parse_args(std::vector<std::string> &args) {
   return options;
 }
 
-static void
-parse_file(cli_options_c const &options) {
-  mm_file_io_c in{options.m_file_name};
-  auto file_size  = in.get_size();
-  auto chunk_size = !options.m_chunk_size ? file_size : std::min<int64_t>(file_size, options.m_chunk_size);
-  auto total_read = 0ll;
-  auto buffer     = memory_c::alloc(chunk_size);
+static mtx::checksum::base_uptr
+create_worker(cli_options_c const &options) {
   auto worker     = mtx::checksum::for_algorithm(options.m_algorithm);
   auto crc_worker = dynamic_cast<mtx::checksum::crc_base_c *>(worker.get());
 
@@ -162,6 +168,99 @@ parse_file(cli_options_c const &options) {
     crc_worker->set_result_in_le(options.m_result_in_le);
   }
 
+  return worker;
+}
+
+static std::string
+format_result(mtx::checksum::base_c &worker) {
+  auto result   = worker.get_result();
+  auto ptr      = result->get_buffer();
+  auto res_size = result->get_size();
+  std::string output;
+
+  for (auto idx = 0u; idx < res_size; idx++)
+    output += fmt::format("{0:02x}", static_cast<unsigned int>(ptr[idx]));
+
+  return output;
+}
+
+static void
+benchmark_implementation(cli_options_c const &options,
+                         memory_c const &data,
+                         std::string const &name) {
+  auto chunk_size = !options.m_chunk_size ? data.get_size() : std::min<std::size_t>(data.get_size(), options.m_chunk_size);
+  auto start      = std::chrono::steady_clock::now();
+  auto elapsed    = std::chrono::steady_clock::duration{};
+  auto num_bytes  = uint64_t{};
+  std::string output;
+
+  // Repeat for at least a second in order to get halfway stable
+  // numbers.
+  do {
+    auto worker = create_worker(options);
+
+    for (auto offset = 0u; offset < data.get_size(); offset += chunk_size)
+      worker->add(data.get_buffer() + offset, std::min<std::size_t>(chunk_size, data.get_size() - offset));
+
+    worker->finish();
+
+    output     = format_result(*worker);
+    num_bytes += data.get_size();
+    elapsed    = std::chrono::steady_clock::now() - start;
+
+  } while (elapsed < std::chrono::seconds{1});
+
+  auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+
+  mxinfo(fmt::format("{0:<12} {1:>10.1f} MiB/s  {2}\n", name, num_bytes / seconds / 1024 / 1024, output));
+}
+
+static void
+benchmark_file(cli_options_c const &options) {
+  auto data = mm_file_io_c::slurp(options.m_file_name);
+
+  if (options.m_algorithm == mtx::checksum::algorithm_e::md5) {
+    benchmark_implementation(options, *data, "default");
+    return;
+  }
+
+  if (options.m_algorithm == mtx::checksum::algorithm_e::adler32) {
+    auto implementations = mtx::checksum::adler32_c::get_available_implementations();
+
+    for (auto implementation : implementations) {
+      mtx::checksum::adler32_c::set_implementation(implementation);
+      benchmark_implementation(options, *data,
+                                 implementation == mtx::checksum::adler32_c::implementation_e::scalar ? "scalar"
+                               : implementation == mtx::checksum::adler32_c::implementation_e::ssse3  ? "ssse3"
+                               :                                                                        "avx2");
+    }
+
+    mtx::checksum::adler32_c::set_implementation(implementations.back());
+    return;
+  }
+
+  auto implementations = mtx::checksum::crc_base_c::get_available_implementations();
+
+  for (auto implementation : implementations) {
+    mtx::checksum::crc_base_c::set_implementation(implementation);
+    benchmark_implementation(options, *data,
+                               implementation == mtx::checksum::crc_base_c::implementation_e::bytewise    ? "bytewise"
+                             : implementation == mtx::checksum::crc_base_c::implementation_e::slice_by_16 ? "slice-by-16"
+                             :                                                                               "hardware");
+  }
+
+  mtx::checksum::crc_base_c::set_implementation(implementations.back());
+}
+
+static void
+parse_file(cli_options_c const &options) {
+  mm_file_io_c in{options.m_file_name};
+  auto file_size  = in.get_size();
+  auto chunk_size = !options.m_chunk_size ? file_size : std::min<int64_t>(file_size, options.m_chunk_size);
+  auto total_read = 0ll;
+  auto buffer     = memory_c::alloc(chunk_size);
+  auto worker     = create_worker(options);
+
   while (total_read < file_size) {
     auto remaining = file_size - total_read;
     chunk_size     = std::min<int64_t>(chunk_size, remaining);
@@ -176,15 +275,7 @@ parse_file(cli_options_c const &options) {
 
   worker->finish();
 
-  auto result   = worker->get_result();
-  auto ptr      = result->get_buffer();
-  auto res_size = result->get_size();
-  std::string output;
-
-  for (auto idx = 0u; idx < res_size; idx++)
-    output += fmt::format("{0:02x}", static_cast<unsigned int>(ptr[idx]));
-
-  mxinfo(fmt::format("{0}  {1}\n", output, options.m_file_name));
+  mxinfo(fmt::format("{0}  {1}\n", format_result(*worker), options.m_file_name));
 }
 
 int
@@ -200,7 +291,10 @@ main(int argc,
   auto options = parse_args(args);
 
   try {
-    parse_file(options);
+    if (options.m_benchmark)
+      benchmark_file(options);
+    else
+      parse_file(options);
   } catch (mtx::mm_io::exception &) {
     mxerror("File not found\n");
   }
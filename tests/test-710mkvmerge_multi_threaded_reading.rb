@@ -0,0 +1,16 @@
+#!/usr/bin/ruby -w
+
+# T_710mkvmerge_multi_threaded_reading
+describe "mkvmerge / reading on several threads creates the same output as reading on one thread"
+
+[ [ "data/h264/progressive-23.976p.h264 data/aac/v.aac data/subtitles/srt/ven.srt", :warning ],
+  [ "data/dts/dts-hd.dts data/ac3/v.ac3 data/wav/v.wav",                            :success ],
+  [ "data/rm/rv4.rm data/simple/v.mp3 data/h264/interlaced-50i.h264",               :success ],
+].each do |args, exit_code|
+  test args do
+    merge args,                                      :output => "#{tmp}-1", :exit_code => exit_code
+    merge "--engage multi_threaded_reading #{args}", :output => "#{tmp}-2", :exit_code => exit_code
+
+    hash_file("#{tmp}-1") == hash_file("#{tmp}-2") ? "ok" : "different"
+  end
+end
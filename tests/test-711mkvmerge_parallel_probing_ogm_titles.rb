@@ -0,0 +1,17 @@
+#!/usr/bin/ruby -w
+
+# T_711mkvmerge_parallel_probing_ogm_titles
+describe "mkvmerge / the segment title is taken from the first OGM file when reading headers on several threads"
+
+[ %w{data/ogg/with_chapters.ogm data/ogg/with_chapters_ansi_encoded.ogm},
+  %w{data/ogg/with_chapters_ansi_encoded.ogm data/ogg/with_chapters.ogm},
+].each do |files|
+  args = files.map { |file| "--chapter-charset ISO-8859-15 #{file}" }.join(" ")
+
+  test files.join(" ") do
+    merge args,                                 :output => "#{tmp}-1"
+    merge "--engage parallel_probing #{args}", :output => "#{tmp}-2"
+
+    hash_file("#{tmp}-1") == hash_file("#{tmp}-2") ? "ok" : "different"
+  end
+end
@@ -0,0 +1,22 @@
+#!/usr/bin/ruby -w
+
+# T_712mkvmerge_direct_cluster_rendering
+describe "mkvmerge / rendering clusters directly creates the same output as rendering them with libmatroska"
+
+# Video with B frames, laced audio-only files with sparse cues & MPEG-2
+# with codec states
+[ [ "data/mp4/test_2000_inloop.mp4",               :success ],
+  [ "data/mpeg12/bug579/2ms.vob",                  :success ],
+  [ "data/simple/v.mp3",                           :success ],
+  [ "data/ac3/v.ac3",                              :success ],
+  [ "data/aac/v.aac",                              :warning ],
+  [ "data/simple/v.mp3 data/ac3/v.ac3",            :success ],
+  [ "data/mpeg12/changing_sequence_headers.m2v",   :warning ],
+].each do |args, exit_code|
+  test args do
+    merge args,                                        :output => "#{tmp}-1", :exit_code => exit_code
+    merge "--engage direct_cluster_rendering #{args}", :output => "#{tmp}-2", :exit_code => exit_code
+
+    hash_file("#{tmp}-1") == hash_file("#{tmp}-2") ? "ok" : "different"
+  end
+end
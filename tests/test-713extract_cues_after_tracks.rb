@@ -0,0 +1,19 @@
+#!/usr/bin/ruby -w
+
+# T_713extract_cues_after_tracks
+describe "mkvextract / cues extracted after tracks are the same as those extracted on their own"
+
+test_merge "data/avi/v-h264-aac.avi data/subtitles/srt/ven.srt", :keep_tmp => true
+
+[ "tracks 0:#{tmp}-t0 1:#{tmp}-t1 cues 0:#{tmp}-1-0 2:#{tmp}-1-2",
+  "cues 0:#{tmp}-1-0 2:#{tmp}-1-2 tracks 0:#{tmp}-t0 1:#{tmp}-t1",
+  "timestamps_v2 0:#{tmp}-t0 cues 0:#{tmp}-1-0 2:#{tmp}-1-2",
+  "tracks 0:#{tmp}-t0 --range 00:00:01-00:00:02 cues 0:#{tmp}-1-0 2:#{tmp}-1-2",
+].each do |args|
+  test args.gsub(tmp, 'tmp') do
+    extract tmp, :mode => :cues, 0 => "#{tmp}-2-0", 2 => "#{tmp}-2-2"
+    sys "../src/mkvextract --engage no_variable_data #{tmp} #{args}"
+
+    [0, 2].collect { |idx| hash_file("#{tmp}-1-#{idx}") == hash_file("#{tmp}-2-#{idx}") ? "ok" : "different" }.join('+')
+  end
+end
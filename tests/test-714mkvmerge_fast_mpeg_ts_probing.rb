@@ -0,0 +1,23 @@
+#!/usr/bin/ruby -w
+
+# T_714mkvmerge_fast_mpeg_ts_probing
+describe "mkvmerge / fast probing of MPEG transport streams finds the same tracks as probing them normally"
+
+# Blu-ray clips with & without clip information, PGS subtitles and
+# TrueHD with an AC-3 core
+%w{
+  data/ts/00000.m2ts
+  data/ts/hd_distributor_regency.m2ts
+  data/ts/h264_dts_hd_ma_pgsub.m2ts
+  data/truehd/truehd-atmos+ac3.m2ts
+  data/ts/hd_dolby_digital_plus_lossless_E-AC3_7.1.m2ts
+  data/pcm/bluray_pcm_1_channel.m2ts
+  data/subtitles/hdmv-textst/vanhelsing-00147.m2ts
+}.each do |file|
+  test file do
+    default = json_summarize_tracks(identify_json(file))
+    fast    = json_summarize_tracks(identify_json("--engage fast_mpeg_ts_probing #{file}"))
+
+    default == fast ? "ok: #{default}" : "different: #{default} vs #{fast}"
+  end
+end
@@ -0,0 +1,39 @@
+#!/usr/bin/ruby -w
+
+# T_715mkvmerge_mpeg_ts_batched_reading
+describe "mkvmerge / reading MPEG transport streams in batches identifies & creates the same as before"
+
+# Files for which the reader has to resync (CRC errors in PATs & PMTs,
+# broken PES packets, garbage) or seek (timestamp overflows, appending
+# & concatenating files). The expected hashes are the ones recorded for
+# T_361, T_369, T_418, T_457, T_501 and T_629 before packets were read
+# in batches.
+m2ts_files = (0..3).map { |i| "data/ts/0000#{i}.m2ts" }
+
+[ [ :identify, "data/ts/pat_pmt_crc_errors.m2ts",       :success, "970f12baaa2d6517d486c6894661360b" ],
+  [ :identify, m2ts_files[0],                            :success, "27ae35463faf84a1d4d4a6f5b98db788" ],
+  [ :merge,    "data/ts/pmt_crc_errors.ts",              :success, "00d4049ef398c6787de0dc84b3e79663" ],
+  [ :merge,    "data/ts/broken_pes_packets.ts",          :success, "6bb2ac6ad3722a03cd1e4b7c344e3f79" ],
+  [ :merge,    "data/ts/garbage-ac3-frame-size-0.ts",    :warning, "4cd058fc3af5025d192ce8c2db57d80a" ],
+  [ :merge,    "data/ts/timecode-overflow.m2ts",         :success, "08216e4ce763ed9962eebc0b7029e941" ],
+  [ :merge,    m2ts_files[0],                            :success, "97e5a6eea489e7f59278d4b3dafe531f" ],
+  [ :merge,    "'(' #{m2ts_files[0..1].join(' ')} ')'",  :success, "3b639e49563745ece68db9ecb67c89c3" ],
+  [ :merge,    "'(' #{m2ts_files[0..2].join(' ')} ')'",  :success, "47c2f7d416b902e322346fbd554fa6ab" ],
+  [ :merge,    "'(' #{m2ts_files.join(' ')} ')'",        :success, "68cf21fa4b712a0f06ccffb3a5407984" ],
+].each do |mode, args, exit_code, expected|
+  test "#{mode} #{args}" do
+    if mode == :identify
+      sys "../src/mkvmerge --identification-format json --identify #{args} --engage no_variable_data > #{tmp}", :exit_code => exit_code
+
+      text = IO.readlines(tmp).reject { |line| %r{^\s*"identification_format_version":\s*\d+}.match(line) }.join('')
+      File.open(tmp, 'w') { |tmp_file| tmp_file.puts text }
+
+    else
+      merge args, :exit_code => exit_code
+    end
+
+    actual = hash_tmp
+
+    actual == expected ? "ok" : "different: #{actual}"
+  end
+end
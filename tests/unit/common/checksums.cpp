@@ -2,7 +2,9 @@
 
 #include "gtest/gtest.h"
 
+#include "common/checksums/adler32.h"
 #include "common/checksums/base.h"
+#include "common/checksums/crc.h"
 #include "common/mm_file_io.h"
 #include "common/mm_proxy_io.h"
 #include "common/mm_text_io.h"
@@ -136,4 +138,101 @@ TEST_F(ChecksumTest, FileChunked1000) {
   EXPECT_EQ(*m_data_md5, *calculate_bin(mtx::checksum::algorithm_e::md5,                       1000));
 }
 
+TEST(ChecksumCrcImplementations, SameResultAsBytewise) {
+  std::vector<unsigned char> data(4096 + 64);
+  unsigned int state = 4711;
+
+  for (auto &byte : data) {
+    state = state * 1103515245 + 12345;
+    byte  = state >> 16;
+  }
+
+  auto calculate = [&data](mtx::checksum::algorithm_e algorithm, uint32_t initial_value, std::size_t offset, std::size_t size, std::size_t chunk_size) {
+    auto worker = mtx::checksum::for_algorithm(algorithm, initial_value);
+
+    for (auto done = 0u; done < size; done += chunk_size)
+      worker->add(&data[offset + done], std::min(chunk_size, size - done));
+
+    worker->finish();
+
+    return dynamic_cast<mtx::checksum::uint_result_c &>(*worker).get_result_as_uint();
+  };
+
+  auto algorithms = std::vector<mtx::checksum::algorithm_e>{
+    mtx::checksum::algorithm_e::crc8_atm,
+    mtx::checksum::algorithm_e::crc16_ansi,
+    mtx::checksum::algorithm_e::crc16_ccitt,
+    mtx::checksum::algorithm_e::crc16_002d,
+    mtx::checksum::algorithm_e::crc32_ieee,
+    mtx::checksum::algorithm_e::crc32_ieee_le,
+  };
+  auto implementations = mtx::checksum::crc_base_c::get_available_implementations();
+
+  for (auto algorithm : algorithms)
+    for (auto size : std::vector<std::size_t>{ 0, 1, 7, 15, 16, 17, 63, 64, 65, 127, 128, 200, 1000, 4096 })
+      for (auto offset : std::vector<std::size_t>{ 0, 1, 3, 13 })
+        for (auto chunk_size : std::vector<std::size_t>{ 1, 17, 64, 100000 }) {
+          mtx::checksum::crc_base_c::set_implementation(mtx::checksum::crc_base_c::implementation_e::bytewise);
+          auto expected = calculate(algorithm, 0xffffffff, offset, size, chunk_size);
+
+          for (auto implementation : implementations) {
+            mtx::checksum::crc_base_c::set_implementation(implementation);
+            ASSERT_EQ(expected, calculate(algorithm, 0xffffffff, offset, size, chunk_size))
+              << "algorithm " << static_cast<int>(algorithm) << " implementation " << static_cast<int>(implementation) << " size " << size << " offset " << offset << " chunk size " << chunk_size;
+          }
+        }
+
+  mtx::checksum::crc_base_c::set_implementation(implementations.back());
+}
+
+TEST(ChecksumAdler32Implementations, SameResultAsScalar) {
+  std::vector<unsigned char> data(3 * 5552 + 100);
+  unsigned int state = 4711;
+
+  for (auto &byte : data) {
+    state = state * 1103515245 + 12345;
+    byte  = state >> 16;
+  }
+
+  // Worst case for overflows.
+  std::vector<unsigned char> all_ff(3 * 5552 + 100, 0xff);
+
+  auto calculate = [](std::vector<unsigned char> const &buffer, std::size_t offset, std::size_t size, std::size_t chunk_size) {
+    mtx::checksum::adler32_c worker;
+
+    for (auto done = 0u; done < size; done += chunk_size)
+      worker.add(&buffer[offset + done], std::min(chunk_size, size - done));
+
+    return worker.get_result_as_uint();
+  };
+
+  auto implementations = mtx::checksum::adler32_c::get_available_implementations();
+
+  for (auto const &buffer : { data, all_ff })
+    for (auto size : std::vector<std::size_t>{ 0, 1, 31, 32, 63, 64, 65, 1000, 5552, 5553, 3 * 5552 + 64 })
+      for (auto offset : std::vector<std::size_t>{ 0, 1, 7, 31 })
+        for (auto chunk_size : std::vector<std::size_t>{ 1, 64, 100, 100000 }) {
+          mtx::checksum::adler32_c::set_implementation(mtx::checksum::adler32_c::implementation_e::scalar);
+          auto expected = calculate(buffer, offset, size, chunk_size);
+
+          for (auto implementation : implementations) {
+            mtx::checksum::adler32_c::set_implementation(implementation);
+            ASSERT_EQ(expected, calculate(buffer, offset, size, chunk_size))
+              << "implementation " << static_cast<int>(implementation) << " size " << size << " offset " << offset << " chunk size " << chunk_size;
+          }
+        }
+
+  mtx::checksum::adler32_c::set_implementation(implementations.back());
+}
+
+TEST(ChecksumAdler32Implementations, Reset) {
+  mtx::checksum::adler32_c worker;
+
+  worker.add("Wikipedia", 9);
+  EXPECT_EQ(0x11e60398u, worker.get_result_as_uint());
+
+  worker.reset().add("123456789", 9);
+  EXPECT_EQ(0x091e01deu, worker.get_result_as_uint());
+}
+
 }
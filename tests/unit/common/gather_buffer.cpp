@@ -0,0 +1,130 @@
+#include "common/common_pch.h"
+
+#include "common/gather_buffer.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+std::string
+to_string(unsigned char const *buffer,
+          std::size_t size) {
+  return { reinterpret_cast<char const *>(buffer), size };
+}
+
+TEST(GatherBuffer, AddCopies) {
+  mtx::bytes::gather_buffer_c b;
+
+  b.add(reinterpret_cast<unsigned char const *>("Hello"), 5);
+  b.add(reinterpret_cast<unsigned char const *>("world!"), 6);
+
+  ASSERT_EQ(11u, b.get_size());
+  EXPECT_EQ("Helloworld!"s, to_string(b.get_buffer(), b.get_size()));
+  EXPECT_EQ(11u, b.get_num_bytes_added());
+  EXPECT_EQ(11u, b.get_num_bytes_copied());
+}
+
+TEST(GatherBuffer, AddReferencesPieces) {
+  auto source = memory_c::clone("Hello world"s);
+  mtx::bytes::gather_buffer_c b;
+
+  b.add(source, source->get_buffer(),     6);
+  b.add(source, source->get_buffer() + 6, 5);
+
+  EXPECT_EQ(11u, b.get_size());
+  EXPECT_EQ(0u,  b.get_num_bytes_copied());
+
+  // The pieces must not be copied before they're needed.
+  std::memcpy(source->get_buffer(), "Jello", 5);
+
+  EXPECT_EQ("Jello world"s, to_string(b.get_buffer(), b.get_size()));
+  EXPECT_EQ(11u, b.get_num_bytes_copied());
+
+  // Gathering twice doesn't copy again.
+  b.get_buffer();
+  EXPECT_EQ(11u, b.get_num_bytes_copied());
+}
+
+TEST(GatherBuffer, MixedPieces) {
+  auto source = memory_c::clone("cruel world"s);
+  mtx::bytes::gather_buffer_c b;
+
+  b.add(reinterpret_cast<unsigned char const *>("Hello "), 6);
+  b.add(source, source->get_buffer() + 6, 5);
+  b.add(reinterpret_cast<unsigned char const *>("!"), 1);
+
+  EXPECT_EQ("Hello world!"s, to_string(b.get_buffer(), b.get_size()));
+}
+
+TEST(GatherBuffer, Remove) {
+  auto source = memory_c::clone("Hello world"s);
+  mtx::bytes::gather_buffer_c b;
+
+  b.add(source, source->get_buffer(), source->get_size());
+  b.remove(6);
+
+  ASSERT_EQ(5u, b.get_size());
+  EXPECT_EQ("world"s, to_string(b.get_buffer(), b.get_size()));
+
+  b.add(source, source->get_buffer() + 5, 1);
+  b.add(source, source->get_buffer(),     5);
+
+  EXPECT_EQ("world Hello"s, to_string(b.get_buffer(), b.get_size()));
+}
+
+TEST(GatherBuffer, Detach) {
+  auto source = memory_c::clone("PES header and payload"s);
+  mtx::bytes::gather_buffer_c b;
+
+  b.add(source, source->get_buffer(),      11);
+  b.add(source, source->get_buffer() + 11, 11);
+  b.remove(11);
+
+  auto data = b.detach();
+
+  EXPECT_EQ("and payload"s, to_string(data->get_buffer(), data->get_size()));
+  EXPECT_EQ(0u,  b.get_size());
+  EXPECT_EQ(22u, b.get_num_bytes_copied());
+
+  b.add(source, source->get_buffer(), 3);
+
+  EXPECT_EQ("PES"s,         to_string(b.get_buffer(),    b.get_size()));
+  EXPECT_EQ("and payload"s, to_string(data->get_buffer(), data->get_size()));
+
+  // Offsets set by users of the data are relative to its start.
+  data->set_offset(4);
+
+  EXPECT_EQ("payload"s, to_string(data->get_buffer(), data->get_size()));
+}
+
+TEST(GatherBuffer, DetachWithoutRemoving) {
+  auto source = memory_c::clone("Hello world"s);
+  mtx::bytes::gather_buffer_c b;
+
+  b.add(source, source->get_buffer(), 5);
+
+  auto data = b.detach();
+
+  EXPECT_EQ("Hello"s, to_string(data->get_buffer(), data->get_size()));
+
+  data->set_offset(1);
+
+  EXPECT_EQ("ello"s, to_string(data->get_buffer(), data->get_size()));
+}
+
+TEST(GatherBuffer, Clear) {
+  auto source = memory_c::clone("Hello world"s);
+  mtx::bytes::gather_buffer_c b;
+
+  b.add(reinterpret_cast<unsigned char const *>("Hello"), 5);
+  b.add(source, source->get_buffer(), 5);
+  b.clear();
+
+  EXPECT_EQ(0u, b.get_size());
+
+  b.add(source, source->get_buffer() + 6, 5);
+
+  EXPECT_EQ("world"s, to_string(b.get_buffer(), b.get_size()));
+}
+
+}
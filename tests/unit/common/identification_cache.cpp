@@ -0,0 +1,95 @@
+#include "common/common_pch.h"
+
+#include "common/identification_cache.h"
+#include "common/mm_file_io.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+class IdentificationCache: public ::testing::Test {
+protected:
+  bfs::path m_folder;
+  std::string m_file_name;
+
+  virtual void SetUp() override {
+    m_folder    = bfs::temp_directory_path() / bfs::unique_path("mkvtoolnix-identification-cache-%%%%-%%%%");
+    m_file_name = (bfs::temp_directory_path() / bfs::unique_path("mkvtoolnix-identification-cache-%%%%-%%%%.bin")).string();
+
+    write(0, std::string(3 * mtx::id::cache::num_bytes_hashed, 'x'));
+  }
+
+  virtual void TearDown() override {
+    bfs::remove(m_file_name);
+    bfs::remove_all(m_folder);
+  }
+
+  void write(uint64_t position, std::string const &content) {
+    auto mtime = bfs::exists(m_file_name) ? bfs::last_write_time(m_file_name) : std::time_t{};
+
+    {
+      mm_file_io_c out{m_file_name, bfs::exists(m_file_name) ? libebml::MODE_WRITE : libebml::MODE_CREATE};
+      out.setFilePointer(position);
+      out.write(content);
+    }
+
+    // Keep the modification time so that only the content influences
+    // the key.
+    if (mtime)
+      bfs::last_write_time(m_file_name, mtime);
+  }
+};
+
+TEST_F(IdentificationCache, KeyIsStable) {
+  auto key = mtx::id::cache::create_key(m_file_name, "context");
+
+  EXPECT_EQ(32u, key.length());
+  EXPECT_EQ(key, mtx::id::cache::create_key(m_file_name, "context"));
+  EXPECT_NE(key, mtx::id::cache::create_key(m_file_name, "other context"));
+}
+
+TEST_F(IdentificationCache, KeyDependsOnHeadAndTail) {
+  auto key = mtx::id::cache::create_key(m_file_name, "context");
+
+  write(10, "head");
+  auto key_head = mtx::id::cache::create_key(m_file_name, "context");
+
+  write(3 * mtx::id::cache::num_bytes_hashed - 10, "tail");
+  auto key_tail = mtx::id::cache::create_key(m_file_name, "context");
+
+  EXPECT_NE(key,      key_head);
+  EXPECT_NE(key_head, key_tail);
+
+  // Changes in the middle are only detected via the size or the
+  // modification time.
+  write(mtx::id::cache::num_bytes_hashed + 10, "middle");
+  EXPECT_EQ(key_tail, mtx::id::cache::create_key(m_file_name, "context"));
+
+  write(3 * mtx::id::cache::num_bytes_hashed, "more");
+  EXPECT_NE(key_tail, mtx::id::cache::create_key(m_file_name, "context"));
+}
+
+TEST_F(IdentificationCache, KeyForMissingFile) {
+  EXPECT_EQ(""s, mtx::id::cache::create_key(m_file_name + ".does-not-exist", "context"));
+}
+
+TEST_F(IdentificationCache, StoreRetrieveClear) {
+  auto key = mtx::id::cache::create_key(m_file_name, "context");
+
+  EXPECT_FALSE(mtx::id::cache::retrieve(m_folder, key));
+
+  mtx::id::cache::store(m_folder, key, "{\"tracks\":[]}");
+
+  auto content = mtx::id::cache::retrieve(m_folder, key);
+  ASSERT_TRUE(!!content);
+  EXPECT_EQ("{\"tracks\":[]}"s, *content);
+
+  mtx::id::cache::store(m_folder, key, "{}");
+  EXPECT_EQ("{}"s, *mtx::id::cache::retrieve(m_folder, key));
+
+  mtx::id::cache::clear(m_folder);
+  EXPECT_FALSE(mtx::id::cache::retrieve(m_folder, key));
+  EXPECT_FALSE(bfs::exists(m_folder));
+}
+
+}
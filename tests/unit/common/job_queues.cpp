@@ -0,0 +1,105 @@
+#include "common/common_pch.h"
+
+#include <atomic>
+#include <thread>
+
+#include "common/job_queues.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(JobQueues, OrderWithinQueue) {
+  std::vector<std::vector<int>> results(4);
+  mtx::job_queues_c queues{results.size(), 1024 * 1024, 3};
+
+  EXPECT_EQ(3u, queues.get_num_threads());
+
+  for (auto value = 0; value < 1000; ++value) {
+    auto idx = value % results.size();
+    queues.add(idx, [&results, idx, value]() { results[idx].push_back(value); }, 100);
+  }
+
+  queues.finish();
+
+  for (auto idx = 0u; idx < results.size(); ++idx) {
+    ASSERT_EQ(250u, results[idx].size());
+
+    for (auto value_idx = 0u; value_idx < results[idx].size(); ++value_idx)
+      EXPECT_EQ(static_cast<int>(value_idx * results.size() + idx), results[idx][value_idx]);
+  }
+}
+
+TEST(JobQueues, NumThreads) {
+  mtx::job_queues_c queues{1, 1024};
+
+  EXPECT_EQ(1u, queues.get_num_threads());
+}
+
+TEST(JobQueues, QueuedBytesAreLimited) {
+  std::atomic<int> num_done{0}, max_pending{0};
+  std::atomic<int> num_added{0};
+  mtx::job_queues_c queues{2, 1000, 2};
+
+  for (auto idx = 0; idx < 100; ++idx) {
+    ++num_added;
+    max_pending = std::max<int>(max_pending, num_added - num_done);
+
+    queues.add(idx % 2, [&num_done]() {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      ++num_done;
+    }, 400);
+  }
+
+  queues.finish();
+
+  EXPECT_EQ(100, num_done);
+  // Running jobs count until they're done, so at most two jobs can be
+  // pending while another one is added.
+  EXPECT_LE(max_pending, 3);
+}
+
+TEST(JobQueues, ExceptionsAreRethrown) {
+  auto num_run = 0;
+  mtx::job_queues_c queues{2, 1024 * 1024, 1};
+
+  // Jobs of other queues added before the failure are still run.
+  queues.add(1, [&num_run]() { ++num_run; });
+  queues.add(0, []() { throw std::runtime_error{"failed"}; });
+
+  EXPECT_THROW(queues.finish(), std::runtime_error);
+  EXPECT_EQ(1, num_run);
+}
+
+TEST(JobQueues, RemainingJobsOfFailedQueueAreDiscarded) {
+  auto num_run = 0;
+
+  try {
+    mtx::job_queues_c queues{1, 1024 * 1024, 1};
+
+    queues.add(0, []() { throw std::runtime_error{"failed"}; });
+    for (auto idx = 0; idx < 10; ++idx)
+      queues.add(0, [&num_run]() { ++num_run; });
+
+    queues.finish();
+
+  } catch (std::runtime_error &) {
+  }
+
+  EXPECT_LT(num_run, 10);
+}
+
+TEST(JobQueues, DestructionWithoutFinish) {
+  std::atomic<int> num_run{0};
+
+  {
+    mtx::job_queues_c queues{2, 1024 * 1024};
+
+    for (auto idx = 0; idx < 10; ++idx)
+      queues.add(idx % 2, [&num_run]() { ++num_run; });
+  }
+
+  EXPECT_LE(num_run, 10);
+}
+
+}
@@ -0,0 +1,263 @@
+#include "common/common_pch.h"
+
+#include "common/kax_cluster_writer.h"
+#include "common/mm_mem_io.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using bytes_t = std::vector<unsigned char>;
+using writer_c = mtx::kax::cluster_writer_c;
+
+bytes_t
+element(bytes_t const &id,
+        bytes_t const &content) {
+  // Only used for content shorter than 127 bytes.
+  auto result = id;
+
+  result.push_back(0x80 | content.size());
+  result.insert(result.end(), content.begin(), content.end());
+
+  return result;
+}
+
+bytes_t
+concat(std::vector<bytes_t> const &parts) {
+  bytes_t result;
+
+  for (auto const &part : parts)
+    result.insert(result.end(), part.begin(), part.end());
+
+  return result;
+}
+
+memory_cptr
+to_memory(std::string const &content) {
+  return memory_c::clone(content);
+}
+
+bytes_t
+render(writer_c &writer,
+       uint64_t timestamp,
+       std::size_t prefix_size = 0) {
+  mm_mem_io_c out{nullptr, 0, 1024};
+
+  for (auto idx = 0u; idx < prefix_size; ++idx)
+    out.write_uint8(0);
+
+  auto size = writer.render(out, timestamp);
+  auto data = out.get_and_lock_buffer();
+
+  EXPECT_EQ(prefix_size + size, out.getFilePointer());
+
+  return { data->get_buffer() + prefix_size, data->get_buffer() + data->get_size() };
+}
+
+TEST(KaxClusterWriter, CodedSizeLength) {
+  EXPECT_EQ(1u, writer_c::get_coded_size_length(0));
+  EXPECT_EQ(1u, writer_c::get_coded_size_length(126));
+  EXPECT_EQ(2u, writer_c::get_coded_size_length(127));
+  EXPECT_EQ(2u, writer_c::get_coded_size_length(16382));
+  EXPECT_EQ(3u, writer_c::get_coded_size_length(16383));
+  EXPECT_EQ(8u, writer_c::get_coded_size_length(1ull << 49));
+}
+
+TEST(KaxClusterWriter, IntegerSizes) {
+  EXPECT_EQ(1u, writer_c::get_uint_size(0));
+  EXPECT_EQ(1u, writer_c::get_uint_size(255));
+  EXPECT_EQ(2u, writer_c::get_uint_size(256));
+  EXPECT_EQ(8u, writer_c::get_uint_size(~0ull));
+
+  EXPECT_EQ(1u, writer_c::get_sint_size(0));
+  EXPECT_EQ(1u, writer_c::get_sint_size(127));
+  EXPECT_EQ(1u, writer_c::get_sint_size(-128));
+  EXPECT_EQ(2u, writer_c::get_sint_size(128));
+  EXPECT_EQ(2u, writer_c::get_sint_size(-129));
+  EXPECT_EQ(8u, writer_c::get_sint_size(std::numeric_limits<int64_t>::min()));
+}
+
+TEST(KaxClusterWriter, SimpleBlocks) {
+  writer_c writer{1000000};
+
+  auto &b0           = writer.add_block();
+  b0.is_simple_block = true;
+  b0.track_number    = 1;
+  b0.timestamp       = 1000000000;
+  b0.key_flag        = true;
+  b0.add_frame(to_memory("abc"));
+
+  auto &b1            = writer.add_block();
+  b1.is_simple_block  = true;
+  b1.track_number     = 2;
+  b1.timestamp        = 995000000;
+  b1.discardable_flag = true;
+  b1.add_frame(to_memory("de"));
+
+  auto expected = concat({
+    { 0x1f, 0x43, 0xb6, 0x75, 0x80 | 21 },
+    element({ 0xe7 }, { 0x03, 0xe8 }),
+    element({ 0xa3 }, { 0x81, 0x00, 0x00, 0x80, 'a', 'b', 'c' }),
+    element({ 0xa3 }, { 0x82, 0xff, 0xfb, 0x01, 'd', 'e' }),
+  });
+
+  EXPECT_EQ(expected, render(writer, 1000000000, 5));
+  EXPECT_EQ(5u,  writer.get_position());
+  EXPECT_EQ(5u,  writer.get_head_size());
+  EXPECT_EQ(14u, writer.get_blocks()[0].position);
+  EXPECT_EQ(23u, writer.get_blocks()[1].position);
+  EXPECT_EQ((std::vector<uint32_t>{ 0x1f43b675, 0xe7, 0xa3 }), writer.get_element_ids_written());
+}
+
+TEST(KaxClusterWriter, BlockGroups) {
+  writer_c writer{1000000};
+
+  auto &b0                = writer.add_block();
+  b0.track_number         = 1;
+  b0.timestamp            = 1040000000;
+  b0.references           = { 1000000000, 1080000000 };
+  b0.codec_state          = to_memory("cs");
+  b0.discard_padding      = -300;
+  b0.duration             = 40000000;
+  b0.add_frame(to_memory("xy"));
+
+  auto content = concat({
+    element({ 0xa1 }, { 0x81, 0x00, 0x28, 0x00, 'x', 'y' }),
+    element({ 0xfb }, { 0xd8 }),
+    element({ 0xfb }, { 0x28 }),
+    element({ 0xa4 }, { 'c', 's' }),
+    element({ 0x75, 0xa2 }, { 0xfe, 0xd4 }),
+    element({ 0x9b }, { 0x28 }),
+  });
+
+  auto expected = concat({
+    { 0x1f, 0x43, 0xb6, 0x75, static_cast<unsigned char>(0x80 | (6 + content.size())) },
+    element({ 0xe7 }, { 0x03, 0xe8 }),
+    element({ 0xa0 }, content),
+  });
+
+  EXPECT_EQ(expected, render(writer, 1000000000));
+  EXPECT_EQ(9u,  writer.get_blocks()[0].position);
+  EXPECT_EQ(25u, writer.get_blocks()[0].codec_state_position);
+  EXPECT_EQ((std::vector<uint32_t>{ 0x1f43b675, 0xe7, 0xa0, 0xa1, 0xfb, 0xa4, 0x75a2, 0x9b }), writer.get_element_ids_written());
+}
+
+TEST(KaxClusterWriter, Lacing) {
+  writer_c writer{1000000};
+
+  // Same sizes: fixed lacing.
+  auto &b0           = writer.add_block();
+  b0.is_simple_block = true;
+  b0.track_number    = 1;
+  b0.add_frame(to_memory("ab"));
+  b0.add_frame(to_memory("cd"));
+
+  // Small differences: EBML lacing is smaller.
+  auto &b1           = writer.add_block();
+  b1.is_simple_block = true;
+  b1.track_number    = 1;
+  b1.add_frame(to_memory("a"));
+  b1.add_frame(to_memory("bcd"));
+  b1.add_frame(to_memory("ef"));
+
+  // Forced Xiph lacing.
+  auto &b2           = writer.add_block();
+  b2.is_simple_block = true;
+  b2.track_number    = 1;
+  b2.lacing          = writer_c::lacing_e::xiph;
+  b2.add_frame(to_memory("a"));
+  b2.add_frame(to_memory("bcd"));
+  b2.add_frame(to_memory("ef"));
+
+  auto expected = concat({
+    { 0x1f, 0x43, 0xb6, 0x75, 0x80 | 44 },
+    element({ 0xe7 }, { 0x00 }),
+    element({ 0xa3 }, { 0x81, 0x00, 0x00, 0x04, 0x01, 'a', 'b', 'c', 'd' }),
+    element({ 0xa3 }, { 0x81, 0x00, 0x00, 0x06, 0x02, 0x81, 0xc1, 'a', 'b', 'c', 'd', 'e', 'f' }),
+    element({ 0xa3 }, { 0x81, 0x00, 0x00, 0x02, 0x02, 0x01, 0x03, 'a', 'b', 'c', 'd', 'e', 'f' }),
+  });
+
+  EXPECT_EQ(expected, render(writer, 0));
+}
+
+TEST(KaxClusterWriter, BestLacing) {
+  auto frames_of_sizes = [](std::vector<std::size_t> const &sizes) {
+    std::vector<memory_cptr> frames;
+    for (auto size : sizes)
+      frames.emplace_back(memory_c::alloc(size));
+    return frames;
+  };
+
+  EXPECT_EQ(writer_c::lacing_e::fixed, writer_c::determine_best_lacing(frames_of_sizes({ 300, 300, 300 })));
+  EXPECT_EQ(writer_c::lacing_e::ebml,  writer_c::determine_best_lacing(frames_of_sizes({ 300, 301, 300 })));
+  EXPECT_EQ(writer_c::lacing_e::xiph,  writer_c::determine_best_lacing(frames_of_sizes({ 10, 200, 30 })));
+}
+
+TEST(KaxClusterWriter, LongSizes) {
+  writer_c writer{1000000};
+
+  auto &b0           = writer.add_block();
+  b0.is_simple_block = true;
+  b0.track_number    = 200;
+  b0.add_frame(memory_c::alloc(122));
+
+  auto data = render(writer, 0);
+
+  // Track number 200 needs two bytes, making the block 127 bytes
+  // long, which requires a two-byte size field.
+  ASSERT_EQ(4u + 2 + 3 + 1 + 2 + 127, data.size());
+  EXPECT_EQ((bytes_t{ 0x1f, 0x43, 0xb6, 0x75, 0x40, 0x85, 0xe7, 0x81, 0x00, 0xa3, 0x40, 0x7f, 0x40, 0xc8 }), bytes_t(data.begin(), data.begin() + 14));
+}
+
+TEST(KaxClusterWriter, AddFrameAutoFlags) {
+  auto add_frame = [](int64_t past_block, int64_t forw_block, std::optional<bool> key_flag = {}, std::optional<bool> discardable_flag = {}) {
+    writer_c::block_t block;
+    block.is_simple_block = true;
+    block.add_frame_auto(memory_c::alloc(10), 1000, past_block, forw_block, key_flag, discardable_flag);
+    return std::make_pair(block.key_flag, block.discardable_flag);
+  };
+
+  EXPECT_EQ(std::make_pair(true,  false), add_frame(-1,   -1));
+  EXPECT_EQ(std::make_pair(false, false), add_frame(960,  -1));
+  EXPECT_EQ(std::make_pair(false, true),  add_frame(960,  1040));
+  EXPECT_EQ(std::make_pair(false, true),  add_frame(-1,   1040));
+  EXPECT_EQ(std::make_pair(false, false), add_frame(-1,   -1, false));
+  EXPECT_EQ(std::make_pair(true,  true),  add_frame(960,  1040, true, true));
+  EXPECT_EQ(std::make_pair(false, true),  add_frame(-1,   -1, std::nullopt, true));
+}
+
+TEST(KaxClusterWriter, AddFrameAutoReferences) {
+  writer_c::block_t block;
+
+  EXPECT_TRUE(block.add_frame_auto(memory_c::alloc(10), 1000, 960, 1080, {}, {}));
+  EXPECT_EQ(1000u,                              block.timestamp);
+  EXPECT_EQ((std::vector<int64_t>{ 960, 1080 }), block.references);
+
+  // Laced frames keep the block's timestamp and replace the first
+  // reference like kax_block_group_c::add_frame() does.
+  EXPECT_TRUE(block.add_frame_auto(memory_c::alloc(10), 1040, -1, 1120, {}, {}));
+  EXPECT_EQ(1000u,                              block.timestamp);
+  EXPECT_EQ((std::vector<int64_t>{ 1120, 1080 }), block.references);
+
+  block.add_frame_auto(memory_c::alloc(10), 1080, 900, -1, {}, {});
+  EXPECT_EQ((std::vector<int64_t>{ 900, 1080 }), block.references);
+  EXPECT_EQ(3u,                                 block.frames.size());
+}
+
+TEST(KaxClusterWriter, AddFrame) {
+  writer_c::block_t block;
+
+  for (auto idx = 0; idx < 7; ++idx)
+    EXPECT_TRUE(block.add_frame(memory_c::alloc(10)));
+  EXPECT_FALSE(block.add_frame(memory_c::alloc(10)));
+
+  writer_c::block_t unlaced;
+  unlaced.lacing = writer_c::lacing_e::none;
+  EXPECT_FALSE(unlaced.add_frame(memory_c::alloc(10)));
+
+  writer_c::block_t large;
+  EXPECT_TRUE(large.add_frame(memory_c::alloc(6 * 0xff - 1)));
+  EXPECT_FALSE(large.add_frame(memory_c::alloc(6 * 0xff)));
+}
+
+}
@@ -0,0 +1,197 @@
+#include "common/common_pch.h"
+
+#include <ebml/EbmlVoid.h>
+#include <matroska/KaxBlock.h>
+#include <matroska/KaxBlockData.h>
+#include <matroska/KaxCluster.h>
+
+#include "common/ebml.h"
+#include "common/kax_file.h"
+#include "common/mm_mem_io.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using namespace libmatroska;
+
+using bytes_t = std::vector<unsigned char>;
+
+bytes_t
+element(uint32_t id,
+        bytes_t const &content) {
+  bytes_t result;
+
+  for (auto shift = 24; shift >= 0; shift -= 8)
+    if ((id >> shift) || !result.empty())
+      result.push_back((id >> shift) & 0xff);
+
+  // Always use an eight-byte size field.
+  result.push_back(0x01);
+  for (auto shift = 48; shift >= 0; shift -= 8)
+    result.push_back((content.size() >> shift) & 0xff);
+
+  result.insert(result.end(), content.begin(), content.end());
+
+  return result;
+}
+
+bytes_t
+concat(std::vector<bytes_t> const &parts) {
+  bytes_t result;
+
+  for (auto const &part : parts)
+    result.insert(result.end(), part.begin(), part.end());
+
+  return result;
+}
+
+bytes_t
+block(unsigned char track_number,
+      int16_t relative_timestamp,
+      unsigned char flags,
+      bytes_t const &laced_content) {
+  return concat({ { static_cast<unsigned char>(0x80 | track_number), static_cast<unsigned char>(relative_timestamp >> 8), static_cast<unsigned char>(relative_timestamp & 0xff), flags }, laced_content });
+}
+
+bytes_t
+cluster(std::vector<bytes_t> const &children) {
+  return element(0x1f43b675, concat(children));
+}
+
+TEST(KaxFile, RawClusterAccounting) {
+  auto content = concat({
+    element(0xe7, { 0x00 }),
+    element(0xa3, block(1, 0, 0x80, bytes_t(1000, 'a'))),
+    element(0xa3, block(1, 0, 0x80, bytes_t(  10, 'b'))),
+  });
+  auto file    = concat({ element(0x1f43b675, content), cluster({ element(0xe7, { 0x01 }), element(0xaf, { 0x00 }) }) });
+
+  mm_mem_io_c in{file.data(), file.size()};
+  kax_file_c kax_file{in};
+  int64_t accounted{};
+
+  kax_file.set_raw_cluster_accounting([&accounted](int64_t num_bytes) { accounted += num_bytes; });
+
+  auto raw_cluster = kax_file.read_next_raw_cluster();
+
+  ASSERT_TRUE(!!raw_cluster);
+  ASSERT_EQ(2u, raw_cluster->blocks.size());
+  EXPECT_EQ(static_cast<int64_t>(content.size()), accounted);
+
+  // A single small frame keeps the whole cluster alive.
+  auto frame = raw_cluster->blocks[1].frames[0];
+  raw_cluster.reset();
+
+  EXPECT_EQ("bbbbbbbbbb",                         frame->to_string());
+  EXPECT_EQ(static_cast<int64_t>(content.size()), accounted);
+
+  frame.reset();
+
+  EXPECT_EQ(0, accounted);
+
+  // Clusters that cannot be parsed (here: encrypted blocks) aren't accounted for.
+  auto position = in.getFilePointer();
+
+  EXPECT_FALSE(kax_file.read_next_raw_cluster());
+  EXPECT_EQ(0,        accounted);
+  EXPECT_EQ(position, in.getFilePointer());
+}
+
+std::string
+frame(KaxInternalBlock &block) {
+  auto &data = block.GetBuffer(0);
+  return { reinterpret_cast<char const *>(data.Buffer()), data.Size() };
+}
+
+// Describes the children of a cluster in order.
+std::vector<std::string>
+describe(KaxCluster &cluster) {
+  std::vector<std::string> children;
+
+  for (auto child : cluster) {
+    if (auto timestamp = dynamic_cast<KaxClusterTimecode *>(child); timestamp)
+      children.emplace_back(fmt::format("timestamp {0}", timestamp->GetValue()));
+
+    else if (auto simple_block = dynamic_cast<KaxSimpleBlock *>(child); simple_block)
+      children.emplace_back(fmt::format("simple block track {0} frames {1} data {2}", simple_block->TrackNum(), simple_block->NumberFrames(), frame(*simple_block)));
+
+    else if (auto group = dynamic_cast<KaxBlockGroup *>(child); group) {
+      auto block = FindChild<KaxBlock>(*group);
+      children.emplace_back(fmt::format("block group track {0} duration {1} data {2}", block ? block->TrackNum() : 0, FindChildValue<KaxBlockDuration>(*group), block ? frame(*block) : ""s));
+
+    } else if (dynamic_cast<EbmlVoid *>(child))
+      children.emplace_back("void");
+
+    else
+      children.emplace_back("unknown");
+  }
+
+  return children;
+}
+
+TEST(KaxFile, SkippingBlocksOfTracks) {
+  auto file = concat({
+    cluster({
+      element(0xe7, { 0x00 }),
+      element(0xa3, block(1,  0, 0x80, bytes_t(100, 'a'))),
+      element(0xa3, block(2,  0, 0x80, bytes_t(200, 'b'))),
+      element(0xec, bytes_t(5, 0x00)),
+      element(0xa0, concat({ element(0xa1, block(2, 10, 0x00, bytes_t(50, 'c'))), element(0x9b, { 0x14 }) })),
+      element(0xa0, concat({ element(0xa1, block(1, 20, 0x00, bytes_t(60, 'd'))), element(0x9b, { 0x28 }) })),
+      element(0xa3, block(2, 30, 0x80, bytes_t(70, 'e'))),
+    }),
+    cluster({
+      element(0xe7, { 0x64 }),
+      element(0xa3, block(2, 0, 0x80, bytes_t(10, 'f'))),
+    }),
+  });
+
+  std::vector<std::vector<std::string>> expected{
+    {
+      "timestamp 0",
+      "simple block track 1 frames 1 data "s + std::string(100, 'a'),
+      "void",
+      "block group track 1 duration 40 data "s + std::string(60, 'd'),
+    },
+    {
+      "timestamp 100",
+    },
+  };
+
+  // Reading without skipping yields the same children for the tracks
+  // that are kept.
+  mm_mem_io_c all_in{file.data(), file.size()};
+  kax_file_c all_file{all_in};
+
+  auto all_first = all_file.read_next_cluster();
+  ASSERT_TRUE(!!all_first);
+  EXPECT_EQ(7u, all_first->ListSize());
+
+  auto kept = describe(*all_first);
+  kept.erase(std::remove_if(kept.begin(), kept.end(), [](std::string const &child) { return child.find("track 2 ") != std::string::npos; }), kept.end());
+  EXPECT_EQ(expected[0], kept);
+
+  mm_mem_io_c in{file.data(), file.size()};
+  kax_file_c kax_file{in};
+
+  kax_file.set_track_numbers_to_skip({ 2 });
+
+  auto first = kax_file.read_next_cluster();
+
+  ASSERT_TRUE(!!first);
+  EXPECT_EQ(expected[0], describe(*first));
+  EXPECT_EQ(0u,          kax_file.get_cluster_position());
+  EXPECT_EQ(12u,         kax_file.get_cluster_head_size());
+
+  auto second_position = in.getFilePointer();
+  auto second          = kax_file.read_next_cluster();
+
+  ASSERT_TRUE(!!second);
+  EXPECT_EQ(expected[1],     describe(*second));
+  EXPECT_EQ(second_position, kax_file.get_cluster_position());
+
+  EXPECT_FALSE(kax_file.read_next_cluster());
+}
+
+}
@@ -0,0 +1,191 @@
+#include "common/common_pch.h"
+
+#include "common/kax_raw_cluster.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using bytes_t = std::vector<unsigned char>;
+
+bytes_t
+element(uint32_t id,
+        bytes_t const &content) {
+  bytes_t result;
+
+  for (auto shift = 24; shift >= 0; shift -= 8)
+    if ((id >> shift) || !result.empty())
+      result.push_back((id >> shift) & 0xff);
+
+  // Always use an eight-byte size field.
+  result.push_back(0x01);
+  for (auto shift = 48; shift >= 0; shift -= 8)
+    result.push_back((content.size() >> shift) & 0xff);
+
+  result.insert(result.end(), content.begin(), content.end());
+
+  return result;
+}
+
+bytes_t
+concat(std::vector<bytes_t> const &parts) {
+  bytes_t result;
+
+  for (auto const &part : parts)
+    result.insert(result.end(), part.begin(), part.end());
+
+  return result;
+}
+
+bytes_t
+block(unsigned char track_number,
+      int16_t relative_timestamp,
+      unsigned char flags,
+      bytes_t const &laced_content) {
+  return concat({ { static_cast<unsigned char>(0x80 | track_number), static_cast<unsigned char>(relative_timestamp >> 8), static_cast<unsigned char>(relative_timestamp & 0xff), flags }, laced_content });
+}
+
+memory_cptr
+to_memory(bytes_t const &bytes) {
+  return memory_c::clone(bytes.data(), bytes.size());
+}
+
+std::string
+to_string(memory_cptr const &mem) {
+  return mem->to_string();
+}
+
+TEST(KaxRawCluster, SimpleBlocks) {
+  auto content = concat({
+    element(0xe7, { 0x03, 0xe8 }),
+    element(0xa3, block(1, 0,  0x80, { 'a', 'b', 'c' })),
+    element(0xa3, block(2, -5, 0x01, { 'd', 'e' })),
+    element(0xec, { 0x00, 0x00 }),
+    element(0xa3, block(1, 40, 0x00, { 'f' })),
+  });
+
+  auto cluster = mtx::kax::parse_raw_cluster(to_memory(content), 1000000);
+
+  ASSERT_TRUE(!!cluster);
+  EXPECT_EQ(1000u, cluster->timestamp);
+  ASSERT_EQ(3u, cluster->blocks.size());
+
+  auto &b0 = cluster->blocks[0];
+  EXPECT_TRUE(b0.is_simple_block);
+  EXPECT_EQ(1u, b0.track_number);
+  EXPECT_EQ(1000000000, b0.timestamp);
+  EXPECT_TRUE(b0.key_flag);
+  EXPECT_FALSE(b0.discardable_flag);
+  ASSERT_EQ(1u, b0.frames.size());
+  EXPECT_EQ("abc", to_string(b0.frames[0]));
+
+  auto &b1 = cluster->blocks[1];
+  EXPECT_EQ(2u, b1.track_number);
+  EXPECT_EQ(995000000, b1.timestamp);
+  EXPECT_FALSE(b1.key_flag);
+  EXPECT_TRUE(b1.discardable_flag);
+  EXPECT_EQ("de", to_string(b1.frames[0]));
+
+  EXPECT_EQ(1040000000, cluster->blocks[2].timestamp);
+  EXPECT_EQ("f",        to_string(cluster->blocks[2].frames[0]));
+}
+
+TEST(KaxRawCluster, SkippingTracks) {
+  auto content = concat({
+    element(0xe7, { 0x00 }),
+    element(0xa3, block(1, 0, 0x80, { 'a' })),
+    element(0xa3, block(2, 0, 0x80, { 'b' })),
+    element(0xa0, element(0xa1, block(2, 0, 0x00, { 'c' }))),
+    element(0xa3, block(3, 0, 0x80, { 'd' })),
+  });
+
+  auto cluster = mtx::kax::parse_raw_cluster(to_memory(content), 1000000, { 2 });
+
+  ASSERT_TRUE(!!cluster);
+  ASSERT_EQ(2u, cluster->blocks.size());
+  EXPECT_EQ(1u, cluster->blocks[0].track_number);
+  EXPECT_EQ(3u, cluster->blocks[1].track_number);
+}
+
+TEST(KaxRawCluster, Lacing) {
+  auto xiph  = block(1, 0, 0x82, { 0x02, 0xff, 0x01, 0x02, });
+  auto ebml  = block(1, 0, 0x86, { 0x02, 0x83, 0xbf + 2, });
+  auto fixed = block(1, 0, 0x84, { 0x02, 'x', 'x', 'y', 'y', 'z', 'z' });
+
+  xiph.insert(xiph.end(), 256 + 2 + 3, 'a');
+  ebml.insert(ebml.end(), 3 + 5 + 4, 'b');
+
+  auto cluster = mtx::kax::parse_raw_cluster(to_memory(concat({ element(0xa3, xiph), element(0xa3, ebml), element(0xa3, fixed) })), 1000000);
+
+  ASSERT_TRUE(!!cluster);
+  ASSERT_EQ(3u, cluster->blocks.size());
+
+  auto sizes = [](mtx::kax::raw_block_t const &b) {
+    std::vector<std::size_t> result;
+    for (auto const &frame : b.frames)
+      result.push_back(frame->get_size());
+    return result;
+  };
+
+  EXPECT_EQ((std::vector<std::size_t>{ 256, 2, 3 }), sizes(cluster->blocks[0]));
+  EXPECT_EQ((std::vector<std::size_t>{ 3, 5, 4 }),   sizes(cluster->blocks[1]));
+  EXPECT_EQ((std::vector<std::size_t>{ 2, 2, 2 }),   sizes(cluster->blocks[2]));
+  EXPECT_EQ("zz", to_string(cluster->blocks[2].frames[2]));
+}
+
+TEST(KaxRawCluster, BlockGroup) {
+  auto group = concat({
+    element(0xa1,   block(1, 10, 0x00, { 'a', 'b' })),
+    element(0x9b,   { 0x28 }),
+    element(0xfb,   { 0xd8 }),
+    element(0xfb,   { 0x14 }),
+    element(0xa4,   { 's' }),
+    element(0x75a2, { 0xff, 0x38 }),
+    element(0x75a1, concat({
+      element(0xa6, concat({ element(0xee, { 0x01 }), element(0xa5, { 'x', 'y' }) })),
+      element(0xa6, element(0xee, { 0x02 })),
+    })),
+  });
+
+  auto cluster = mtx::kax::parse_raw_cluster(to_memory(concat({ element(0xe7, { 0x64 }), element(0xa0, group) })), 1000000);
+
+  ASSERT_TRUE(!!cluster);
+  ASSERT_EQ(1u, cluster->blocks.size());
+
+  auto &b = cluster->blocks[0];
+  EXPECT_FALSE(b.is_simple_block);
+  EXPECT_EQ(110000000, b.timestamp);
+  EXPECT_EQ("ab", to_string(b.frames[0]));
+  ASSERT_TRUE(!!b.duration);
+  EXPECT_EQ(40u, *b.duration);
+  EXPECT_EQ((std::vector<int64_t>{ -40, 20 }), b.references);
+  ASSERT_TRUE(!!b.codec_state);
+  EXPECT_EQ("s", to_string(b.codec_state));
+  ASSERT_TRUE(!!b.discard_padding);
+  EXPECT_EQ(-200, *b.discard_padding);
+  ASSERT_EQ(2u, b.additions.size());
+  EXPECT_EQ("xy", to_string(b.additions[0]));
+  EXPECT_EQ(0u, b.additions[1]->get_size());
+}
+
+TEST(KaxRawCluster, Unsupported) {
+  auto simple_block = element(0xa3, block(1, 0, 0x80, { 'a' }));
+
+  // Unknown size
+  auto unknown_size = bytes_t{ 0xa3, 0xff, 0x81, 0x00, 0x00, 0x80, 'a' };
+  EXPECT_FALSE(mtx::kax::parse_raw_cluster(to_memory(unknown_size), 1000000));
+
+  // Truncated
+  auto truncated = simple_block;
+  truncated.pop_back();
+  EXPECT_FALSE(mtx::kax::parse_raw_cluster(to_memory(concat({ element(0xe7, { 0x00 }), truncated })), 1000000));
+
+  // Encrypted block
+  EXPECT_FALSE(mtx::kax::parse_raw_cluster(to_memory(concat({ simple_block, element(0xaf, { 0x00 }) })), 1000000));
+
+  // Invalid lacing
+  auto fixed = element(0xa3, block(1, 0, 0x84, { 0x01, 'x', 'x', 'y' }));
+  EXPECT_FALSE(mtx::kax::parse_raw_cluster(to_memory(fixed), 1000000));
+}
+
+}
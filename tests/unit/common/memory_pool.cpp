@@ -0,0 +1,119 @@
+#include "common/common_pch.h"
+
+#include "common/memory_pool.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(MemoryPool, BlockSizes) {
+  EXPECT_EQ(64u,              mtx::mem::pool_c::get_block_size(0));
+  EXPECT_EQ(64u,              mtx::mem::pool_c::get_block_size(1));
+  EXPECT_EQ(64u,              mtx::mem::pool_c::get_block_size(64));
+  EXPECT_EQ(80u,              mtx::mem::pool_c::get_block_size(65));
+  EXPECT_EQ(112u,             mtx::mem::pool_c::get_block_size(100));
+  EXPECT_EQ(128u,             mtx::mem::pool_c::get_block_size(128));
+  EXPECT_EQ(160u,             mtx::mem::pool_c::get_block_size(129));
+  EXPECT_EQ(1536u,            mtx::mem::pool_c::get_block_size(1500));
+  EXPECT_EQ(1024u * 1024,     mtx::mem::pool_c::get_block_size(1024 * 1024));
+  EXPECT_EQ(1024u * 1024 + 1, mtx::mem::pool_c::get_block_size(1024 * 1024 + 1));
+}
+
+TEST(MemoryPool, BlockSizesAreStable) {
+  for (auto size = 0u; size < 100000; size += 7) {
+    auto block_size = mtx::mem::pool_c::get_block_size(size);
+
+    ASSERT_GE(block_size, size);
+    ASSERT_LE(block_size, std::max<std::size_t>(64, size + size / 4));
+    ASSERT_EQ(block_size, mtx::mem::pool_c::get_block_size(block_size));
+  }
+}
+
+TEST(MemoryPool, ReleasedBlocksAreReused) {
+  mtx::mem::pool_c pool;
+
+  auto block1 = pool.allocate(1000);
+  pool.release(block1, 1000);
+
+  auto block2 = pool.allocate(1010);
+
+  EXPECT_EQ(block1, block2);
+
+  auto stats = pool.get_statistics();
+
+  EXPECT_EQ(2u, stats.num_allocations);
+  EXPECT_EQ(1u, stats.num_reused);
+  EXPECT_EQ(1u, stats.num_heap_allocations);
+  EXPECT_EQ(0u, stats.num_cached);
+
+  pool.release(block2, 1010);
+
+  stats = pool.get_statistics();
+
+  EXPECT_EQ(1u,    stats.num_cached);
+  EXPECT_EQ(1024u, stats.cached_bytes);
+}
+
+TEST(MemoryPool, LargeBlocksAreNotCached) {
+  mtx::mem::pool_c pool;
+
+  auto size  = mtx::mem::pool_c::max_block_size + 1;
+  auto block = pool.allocate(size);
+  pool.release(block, size);
+
+  auto stats = pool.get_statistics();
+
+  EXPECT_EQ(1u, stats.num_heap_allocations);
+  EXPECT_EQ(1u, stats.num_heap_releases);
+  EXPECT_EQ(0u, stats.num_cached);
+}
+
+TEST(MemoryPool, Trim) {
+  mtx::mem::pool_c pool;
+
+  pool.release(pool.allocate(10),   10);
+  pool.release(pool.allocate(1000), 1000);
+
+  EXPECT_EQ(2u, pool.get_statistics().num_cached);
+
+  pool.trim();
+
+  EXPECT_EQ(0u, pool.get_statistics().num_cached);
+  EXPECT_EQ(0u, pool.get_statistics().cached_bytes);
+}
+
+TEST(MemoryPool, MemoryResizeAcrossSizeClasses) {
+  auto mem = memory_c::clone("0123456789");
+
+  mem->set_offset(2);
+  mem->resize(1000);
+
+  ASSERT_EQ(1000u, mem->get_size());
+  EXPECT_EQ(0, std::memcmp(mem->get_buffer(), "23456789", 8));
+
+  mem->resize(2 * mtx::mem::pool_c::max_block_size);
+  ASSERT_EQ(2 * mtx::mem::pool_c::max_block_size, mem->get_size());
+  EXPECT_EQ(0, std::memcmp(mem->get_buffer(), "23456789", 8));
+
+  mem->resize(4);
+  EXPECT_EQ("2345"s, mem->to_string());
+}
+
+TEST(MemoryPool, MemoryTakeOwnershipAndLock) {
+  unsigned char buffer[] = "hello";
+  auto mem               = memory_c::borrow(buffer, 5);
+
+  mem->take_ownership();
+  buffer[0] = 'j';
+
+  EXPECT_EQ("hello"s, mem->to_string());
+
+  mem->lock();
+  auto ptr = mem->get_buffer();
+  mem.reset();
+
+  EXPECT_EQ(0, std::memcmp(ptr, "hello", 5));
+  free(ptr);
+}
+
+}
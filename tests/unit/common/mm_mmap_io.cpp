@@ -0,0 +1,120 @@
+#include "common/common_pch.h"
+
+#include "common/mm_file_io.h"
+#include "common/mm_io_x.h"
+#include "common/mm_mmap_io.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+class MmMmapIo: public ::testing::Test {
+protected:
+  std::string m_file_name, m_content;
+
+  virtual void SetUp() override {
+    m_file_name = (bfs::temp_directory_path() / bfs::unique_path("mkvtoolnix-mm-mmap-io-%%%%-%%%%.bin")).string();
+
+    for (auto idx = 0u; idx < 5000; ++idx)
+      m_content += static_cast<char>('a' + (idx * 7 + idx / 26) % 26);
+
+    mm_file_io_c out{m_file_name, libebml::MODE_CREATE};
+    out.write(m_content);
+  }
+
+  virtual void TearDown() override {
+    bfs::remove(m_file_name);
+  }
+};
+
+TEST_F(MmMmapIo, Reading) {
+  mm_mmap_io_c in{m_file_name};
+  std::string chunk;
+
+  EXPECT_EQ(5000, in.get_size());
+
+  in.setFilePointer(100);
+  ASSERT_EQ(10u, in.read(chunk, 10));
+  EXPECT_EQ(m_content.substr(100, 10), chunk);
+  EXPECT_EQ(110u, in.getFilePointer());
+
+  in.setFilePointer(-10, libebml::seek_end);
+  ASSERT_EQ(10u, in.read(chunk, 20));
+  EXPECT_EQ(m_content.substr(4990), chunk);
+  EXPECT_TRUE(in.eof());
+
+  in.setFilePointer(10000);
+  EXPECT_EQ(5000u, in.getFilePointer());
+  EXPECT_FALSE(in.eof());
+
+  EXPECT_THROW(in.setFilePointer(-1), mtx::mm_io::seek_x);
+}
+
+TEST_F(MmMmapIo, ZeroCopySlices) {
+  memory_cptr slice;
+
+  {
+    mm_mmap_io_c in{m_file_name};
+
+    in.setFilePointer(1000);
+    slice = in.read_immutable(500);
+
+    EXPECT_EQ(1500u, in.getFilePointer());
+    EXPECT_FALSE(slice->is_owned());
+    EXPECT_TRUE(slice->is_kept_alive());
+
+    EXPECT_THROW(in.read_immutable(4000), mtx::mm_io::end_of_file_x);
+  }
+
+  // The slice keeps the mapping alive after the file was closed and
+  // is not copied when the packetizer takes ownership.
+  auto buffer = slice->get_buffer();
+  slice->take_ownership();
+
+  EXPECT_EQ(buffer, slice->get_buffer());
+  EXPECT_EQ(m_content.substr(1000, 500), slice->to_string());
+}
+
+TEST_F(MmMmapIo, ModifiableCopies) {
+  mm_mmap_io_c in{m_file_name};
+
+  in.setFilePointer(1000);
+  auto copy = in.read(static_cast<size_t>(500));
+
+  EXPECT_TRUE(copy->is_owned());
+  EXPECT_FALSE(copy->is_kept_alive());
+  EXPECT_EQ(m_content.substr(1000, 500), copy->to_string());
+
+  // Modifying the copy changes neither the mapping nor the file.
+  copy->get_buffer()[0] = '!';
+
+  in.setFilePointer(1000);
+  EXPECT_EQ(m_content.substr(1000, 500), in.read_immutable(500)->to_string());
+
+  in.setFilePointer(1000);
+  EXPECT_EQ(m_content.substr(1000, 500), in.read(static_cast<size_t>(500))->to_string());
+
+  mm_file_io_c file{m_file_name};
+  std::string chunk;
+
+  file.setFilePointer(1000);
+  file.read(chunk, 1);
+
+  EXPECT_EQ(m_content.substr(1000, 1), chunk);
+}
+
+TEST_F(MmMmapIo, FallBackForUnsupportedFiles) {
+  EXPECT_FALSE(!!mm_mmap_io_c::open(m_file_name + ".does-not-exist"));
+  EXPECT_FALSE(!!mm_mmap_io_c::open(bfs::temp_directory_path().string()));
+
+  auto empty_file_name = m_file_name + ".empty";
+  mm_file_io_c{empty_file_name, libebml::MODE_CREATE};
+
+  EXPECT_FALSE(!!mm_mmap_io_c::open(empty_file_name));
+
+  bfs::remove(empty_file_name);
+
+  EXPECT_TRUE(!!mm_mmap_io_c::open(m_file_name));
+}
+
+}
@@ -0,0 +1,116 @@
+#include "common/common_pch.h"
+
+#include "common/mm_mem_io.h"
+#include "common/mm_proxy_io.h"
+#include "common/mm_read_buffer_io.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+std::string
+create_content(std::size_t size) {
+  std::string content;
+
+  for (auto idx = 0u; idx < size; ++idx)
+    content += static_cast<char>('a' + (idx * 7 + idx / 26) % 26);
+
+  return content;
+}
+
+TEST(MmReadBufferIo, ReadAheadSequential) {
+  auto content = create_content(10000);
+  auto mem     = std::make_shared<mm_mem_io_c>(reinterpret_cast<unsigned char const *>(content.c_str()), content.size());
+  mm_read_buffer_io_c in{mem, 64, 3};
+  std::string result, chunk;
+
+  EXPECT_EQ(10000, in.get_size());
+
+  while (in.read(chunk, 188) == 188)
+    result += chunk;
+
+  result += chunk;
+
+  EXPECT_TRUE(in.eof());
+  EXPECT_EQ(content, result);
+  EXPECT_EQ(10000u,  in.getFilePointer());
+}
+
+TEST(MmReadBufferIo, ReadAheadSeeking) {
+  auto content = create_content(5000);
+  auto mem     = std::make_shared<mm_mem_io_c>(reinterpret_cast<unsigned char const *>(content.c_str()), content.size());
+  mm_read_buffer_io_c in{mem, 100, 4};
+  std::string chunk;
+  unsigned int state = 4711;
+
+  for (auto round = 0; round < 2000; ++round) {
+    state         = state * 1103515245 + 12345;
+    auto position = (state >> 8) % 5100;
+    state         = state * 1103515245 + 12345;
+    auto size     = (state >> 8) % 300;
+
+    // Mostly small jumps forward like the MP4 reader does between
+    // chunks; sometimes jump anywhere.
+    if ((round % 4) != 0)
+      position = std::min<uint64_t>(in.getFilePointer() + position % 200, 5100);
+
+    in.setFilePointer(position);
+
+    auto expected_size = position >= content.size() ? 0 : std::min<std::size_t>(size, content.size() - position);
+
+    ASSERT_EQ(expected_size, in.read(chunk, size));
+    ASSERT_EQ(content.substr(std::min<std::size_t>(position, content.size()), expected_size), chunk.substr(0, expected_size));
+    ASSERT_EQ(std::min<uint64_t>(position, content.size()) + expected_size, in.getFilePointer());
+
+    in.clear_eof();
+  }
+}
+
+TEST(MmReadBufferIo, ReadAheadDisableBuffering) {
+  auto content = create_content(1000);
+  auto mem     = std::make_shared<mm_mem_io_c>(reinterpret_cast<unsigned char const *>(content.c_str()), content.size());
+  mm_read_buffer_io_c in{mem, 64, 2};
+  std::string chunk;
+
+  in.setFilePointer(100);
+  in.read(chunk, 10);
+  in.enable_buffering(false);
+
+  ASSERT_EQ(10u, in.read(chunk, 10));
+  EXPECT_EQ(content.substr(110, 10), chunk);
+}
+
+TEST(MmReadBufferIo, ReadAheadChangeBufferSize) {
+  auto content = create_content(1000);
+  auto mem     = std::make_shared<mm_mem_io_c>(reinterpret_cast<unsigned char const *>(content.c_str()), content.size());
+  mm_read_buffer_io_c in{mem, 64, 2};
+  std::string chunk;
+
+  in.setFilePointer(100);
+  in.read(chunk, 10);
+  in.set_buffer_size(16);
+
+  ASSERT_EQ(100u, in.read(chunk, 100));
+  EXPECT_EQ(content.substr(110, 100), chunk);
+}
+
+TEST(MmReadBufferIo, ChangeBufferSizeKeepsPosition) {
+  auto content = create_content(1000);
+  auto mem     = std::make_shared<mm_mem_io_c>(reinterpret_cast<unsigned char const *>(content.c_str()), content.size());
+  mm_read_buffer_io_c in{mem, 64};
+  std::string chunk;
+
+  EXPECT_EQ(64u, in.get_buffer_size());
+
+  in.setFilePointer(100);
+  in.read(chunk, 10);
+  in.set_buffer_size(512);
+
+  EXPECT_EQ(512u, in.get_buffer_size());
+  EXPECT_EQ(110u, in.getFilePointer());
+
+  ASSERT_EQ(100u, in.read(chunk, 100));
+  EXPECT_EQ(content.substr(110, 100), chunk);
+}
+
+}
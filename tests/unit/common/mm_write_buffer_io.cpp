@@ -0,0 +1,95 @@
+#include "common/common_pch.h"
+
+#include "common/mm_mem_io.h"
+#include "common/mm_proxy_io.h"
+#include "common/mm_write_buffer_io.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+std::string
+write_with_patches(std::size_t buffer_size,
+                   std::size_t num_async_buffers) {
+  auto mem = std::make_shared<mm_mem_io_c>(nullptr, 0, 1024);
+
+  {
+    mm_write_buffer_io_c out{mem, buffer_size, num_async_buffers};
+
+    for (auto idx = 0; idx < 200; ++idx) {
+      auto chunk = fmt::format("chunk {0:03}|", idx);
+      out.write(chunk.c_str(), chunk.length());
+      EXPECT_EQ(static_cast<uint64_t>((idx + 1) * chunk.length()), out.getFilePointer());
+    }
+
+    // Go back and patch something like a header would be patched.
+    auto end = out.getFilePointer();
+
+    out.setFilePointer(6);
+    out.write("XYZ", 3);
+    EXPECT_EQ(9u, out.getFilePointer());
+
+    out.setFilePointer(-10, libebml::seek_end);
+    out.write("END", 3);
+
+    EXPECT_EQ(end, static_cast<uint64_t>(out.get_size()));
+
+    out.setFilePointer(0, libebml::seek_end);
+    out.write("tail", 4);
+    out.flush();
+  }
+
+  return std::string{reinterpret_cast<char const *>(mem->get_buffer()), static_cast<std::string::size_type>(mem->get_size())};
+}
+
+TEST(MmWriteBufferIo, AsyncWritingSameResultAsSync) {
+  auto expected = write_with_patches(64, 0);
+
+  EXPECT_EQ("chunk XYZ|chunk 001|"s, expected.substr(0, 20));
+  EXPECT_EQ("ENDnk 199|tail"s,       expected.substr(expected.length() - 14));
+
+  EXPECT_EQ(expected, write_with_patches(64,   2));
+  EXPECT_EQ(expected, write_with_patches(7,    4));
+  EXPECT_EQ(expected, write_with_patches(4096, 3));
+}
+
+TEST(MmWriteBufferIo, AsyncWritingReadBack) {
+  auto mem = std::make_shared<mm_mem_io_c>(nullptr, 0, 1024);
+  mm_write_buffer_io_c out{mem, 16, 2};
+  std::string buffer;
+
+  out.write("0123456789abcdefghijklmnopqrstuvwxyz", 36);
+  out.setFilePointer(10);
+
+  ASSERT_EQ(6u, out.read(buffer, 6));
+  EXPECT_EQ("abcdef"s, buffer);
+  EXPECT_EQ(16u,       out.getFilePointer());
+}
+
+TEST(MmWriteBufferIo, DiscardingQueuedBuffersResetsPosition) {
+  auto mem = std::make_shared<mm_mem_io_c>(nullptr, 0, 1024);
+  mm_write_buffer_io_c out{mem, 8, 3};
+
+  out.write("01234567", 8);
+  out.write("89abcdef", 8);
+  out.write("ghij", 4);
+
+  out.discard_buffer();
+
+  auto position = out.getFilePointer();
+
+  // Nothing written after the discarded buffers must end up in the
+  // file, and the position must agree with the file's size.
+  EXPECT_EQ(0u, position % 8);
+  EXPECT_GE(16u, position);
+  EXPECT_EQ(static_cast<int64_t>(position), mem->get_size());
+
+  out.write("XY", 2);
+  out.flush();
+
+  EXPECT_EQ(position + 2,                                      out.getFilePointer());
+  EXPECT_EQ(static_cast<int64_t>(position + 2),                mem->get_size());
+  EXPECT_EQ("0123456789abcdef"s.substr(0, position) + "XY"s, std::string(reinterpret_cast<char const *>(mem->get_buffer()), mem->get_size()));
+}
+
+}
@@ -0,0 +1,91 @@
+#include "common/common_pch.h"
+
+#include "common/mpeg.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+unsigned char const *
+find_00_00_xx_reference(unsigned char const *begin,
+                        unsigned char const *end,
+                        unsigned char third_byte) {
+  for (auto p = begin; (end - p) >= 3; ++p)
+    if (!p[0] && !p[1] && (p[2] == third_byte))
+      return p;
+
+  return end;
+}
+
+std::vector<unsigned char>
+create_content(std::size_t size,
+               unsigned int seed) {
+  std::vector<unsigned char> content(size);
+
+  // Lots of zeros, ones and threes so that all kinds of partial
+  // matches occur, also across the boundaries of vector registers.
+  for (auto &byte : content) {
+    seed = seed * 1103515245 + 12345;
+    auto value = (seed >> 16) % 16;
+    byte       = value < 6 ? 0x00 : value < 8 ? 0x01 : value < 10 ? 0x03 : (seed >> 8) & 0xff;
+  }
+
+  return content;
+}
+
+class MpegScanner: public ::testing::Test {
+protected:
+  virtual void TearDown() override {
+    mtx::mpeg::set_scanner_implementation(mtx::mpeg::get_available_scanner_implementations().back());
+  }
+};
+
+TEST_F(MpegScanner, FindSameAsReference) {
+  for (auto implementation : mtx::mpeg::get_available_scanner_implementations()) {
+    mtx::mpeg::set_scanner_implementation(implementation);
+
+    for (auto seed = 0u; seed < 200; ++seed) {
+      auto content = create_content(seed * 3, seed);
+      auto end     = content.data() + content.size();
+
+      for (auto offset = 0u; offset < std::min<std::size_t>(content.size(), 40); ++offset)
+        for (auto third_byte : { 0x01, 0x03 }) {
+          auto begin = content.data() + offset;
+          ASSERT_EQ(find_00_00_xx_reference(begin, end, third_byte), mtx::mpeg::find_00_00_xx(begin, end, third_byte));
+        }
+    }
+  }
+}
+
+TEST_F(MpegScanner, FindStartCode) {
+  unsigned char data[] = { 0x00, 0x00, 0x00, 0x01, 0x65, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00 };
+  auto end             = data + sizeof(data);
+
+  for (auto implementation : mtx::mpeg::get_available_scanner_implementations()) {
+    mtx::mpeg::set_scanner_implementation(implementation);
+
+    EXPECT_EQ(data + 1, mtx::mpeg::find_start_code(data,     end));
+    EXPECT_EQ(end,      mtx::mpeg::find_start_code(data + 2, end));
+    EXPECT_EQ(data + 5, mtx::mpeg::find_00_00_xx(data,       end, 0x03));
+    EXPECT_EQ(data + 3, mtx::mpeg::find_start_code(data,     data + 3));
+  }
+}
+
+TEST_F(MpegScanner, NaluToRbsp) {
+  unsigned char nalu[] = { 0x65, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x03 };
+  unsigned char rbsp[] = { 0x65, 0x00, 0x00,       0x00, 0x00,       0x01, 0x00, 0x00       };
+
+  for (auto implementation : mtx::mpeg::get_available_scanner_implementations()) {
+    mtx::mpeg::set_scanner_implementation(implementation);
+
+    auto result = mtx::mpeg::nalu_to_rbsp(memory_c::clone(nalu, sizeof(nalu)));
+
+    ASSERT_EQ(sizeof(rbsp), result->get_size());
+    EXPECT_EQ(0, std::memcmp(rbsp, result->get_buffer(), sizeof(rbsp)));
+  }
+
+  auto unchanged = memory_c::clone("\x65\x00\x00\x01", 4);
+  EXPECT_EQ(unchanged.get(), mtx::mpeg::nalu_to_rbsp(unchanged).get());
+}
+
+}
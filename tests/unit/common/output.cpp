@@ -0,0 +1,67 @@
+#include "common/common_pch.h"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(OutputCapture, NothingDeferredWithoutCapturing) {
+  auto called = false;
+
+  EXPECT_FALSE(mtx::output::capture_c::defer([&called]() { called = true; }));
+  EXPECT_FALSE(called);
+}
+
+TEST(OutputCapture, ReplayInOrder) {
+  std::vector<int> order;
+  mtx::output::capture_c capture;
+
+  capture.start();
+
+  for (auto idx = 0; idx < 3; ++idx)
+    EXPECT_TRUE(mtx::output::capture_c::defer([&order, idx]() { order.push_back(idx); }));
+
+  capture.stop();
+
+  EXPECT_TRUE(order.empty());
+  EXPECT_FALSE(mtx::output::capture_c::defer([]() {}));
+
+  capture.replay();
+
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2 }), order);
+
+  capture.replay();
+
+  EXPECT_EQ(3u, order.size());
+}
+
+TEST(OutputCapture, ErrorsThrowWhileCapturing) {
+  mtx::output::capture_c capture;
+
+  capture.start();
+
+  EXPECT_THROW(mxerror("error\n"), mtx::output::capture_c::error_x);
+}
+
+TEST(OutputCapture, CapturingIsPerThread) {
+  std::vector<std::string> order;
+  mtx::output::capture_c capture;
+
+  std::thread thread{[&capture, &order]() {
+    capture.start();
+    mtx::output::capture_c::defer([&order]() { order.emplace_back("thread"); });
+    capture.stop();
+  }};
+
+  thread.join();
+
+  EXPECT_FALSE(mtx::output::capture_c::defer([]() {}));
+
+  order.emplace_back("main");
+  capture.replay();
+
+  EXPECT_EQ(std::vector<std::string>({ "main", "thread" }), order);
+}
+
+}
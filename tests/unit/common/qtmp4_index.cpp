@@ -0,0 +1,194 @@
+#include "common/common_pch.h"
+
+#include "common/qtmp4_index.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+auto constexpr s_block_size = qt_index_c::s_entries_per_block;
+
+// Frames following each other in the file & in time with a couple of
+// irregularities: B frames with timestamps going backwards, frames
+// stored before the previous one, changing durations and a jump
+// between two blocks.
+std::vector<qt_index_t>
+create_entries(std::size_t num_entries) {
+  std::vector<qt_index_t> entries;
+  int64_t file_pos = 1000, timestamp = 0;
+
+  for (auto idx = 0u; idx < num_entries; ++idx) {
+    auto size     = static_cast<int64_t>(100 + (idx * 37) % 5000);
+    auto duration = static_cast<int64_t>(idx % 7 ? 40'000'000 : 20'000'000);
+
+    if (!(idx % 5))
+      file_pos -= 3000;
+
+    else if (idx == (s_block_size + 10))
+      file_pos += 0x123456789ll;
+
+    entries.emplace_back(file_pos, size, (idx % 3) == 2 ? timestamp - 80'000'000 : timestamp, duration, false);
+
+    file_pos  += size + (idx % 11);
+    timestamp += duration;
+  }
+
+  return entries;
+}
+
+qt_index_c
+create_index(std::vector<qt_index_t> const &entries) {
+  qt_index_c index;
+
+  for (auto const &entry : entries)
+    index.push_back(entry);
+
+  return index;
+}
+
+void
+expect_entry(qt_index_t const &expected,
+             qt_index_t const &actual,
+             std::size_t idx) {
+  EXPECT_EQ(expected.file_pos,    actual.file_pos)    << "index " << idx;
+  EXPECT_EQ(expected.size,        actual.size)        << "index " << idx;
+  EXPECT_EQ(expected.timestamp,   actual.timestamp)   << "index " << idx;
+  EXPECT_EQ(expected.duration,    actual.duration)    << "index " << idx;
+  EXPECT_EQ(expected.is_keyframe, actual.is_keyframe) << "index " << idx;
+}
+
+TEST(Qtmp4Index, Empty) {
+  qt_index_c index;
+
+  EXPECT_TRUE(index.empty());
+  EXPECT_EQ(0u, index.size());
+}
+
+TEST(Qtmp4Index, SequentialAccessWithNegativeDeltas) {
+  auto entries = create_entries(3 * s_block_size + 17);
+  auto index   = create_index(entries);
+
+  ASSERT_EQ(entries.size(), index.size());
+  EXPECT_FALSE(index.empty());
+
+  for (auto idx = 0u; idx < entries.size(); ++idx)
+    expect_entry(entries[idx], index[idx], idx);
+}
+
+TEST(Qtmp4Index, NegativeValues) {
+  qt_index_c index;
+
+  index.push_back({  500, 10, -40'000'000, 40'000'000, false });
+  index.push_back({    0,  0, -80'000'000,          0, false });
+  index.push_back({ 1000, 20,           0, 20'000'000, false });
+
+  expect_entry({  500, 10, -40'000'000, 40'000'000, false }, index[0], 0);
+  expect_entry({    0,  0, -80'000'000,          0, false }, index[1], 1);
+  expect_entry({ 1000, 20,           0, 20'000'000, false }, index[2], 2);
+}
+
+TEST(Qtmp4Index, BlockBoundaries) {
+  auto entries = create_entries(2 * s_block_size + 1);
+  auto index   = create_index(entries);
+
+  for (auto idx : std::vector<std::size_t>{ s_block_size - 1, s_block_size, s_block_size + 1, 2 * s_block_size - 1, 2 * s_block_size, 0 })
+    expect_entry(entries[idx], index[idx], idx);
+}
+
+TEST(Qtmp4Index, RandomAccess) {
+  auto entries = create_entries(4 * s_block_size);
+  auto index   = create_index(entries);
+
+  for (auto idx : std::vector<std::size_t>{ 700, 3, 1000, 255, 256, 257, 100, 99, 1023, 0, 512 })
+    expect_entry(entries[idx], index[idx], idx);
+}
+
+TEST(Qtmp4Index, Keyframes) {
+  auto entries = create_entries(2 * s_block_size);
+  auto index   = create_index(entries);
+
+  for (auto idx = 0u; idx < entries.size(); idx += 30) {
+    index.set_keyframe(idx);
+    entries[idx].is_keyframe = true;
+  }
+
+  index.push_back({ 1, 2, 3, 4, true });
+  entries.emplace_back(1, 2, 3, 4, true);
+
+  for (auto idx = 0u; idx < entries.size(); ++idx)
+    EXPECT_EQ(entries[idx].is_keyframe, index[idx].is_keyframe) << "index " << idx;
+}
+
+TEST(Qtmp4Index, AdjustTimestamps) {
+  auto entries = create_entries(2 * s_block_size);
+  auto index   = create_index(entries);
+
+  index[s_block_size + 5];
+
+  // Affects all entries, including the one cached for sequential
+  // access and the ones added afterwards.
+  index.adjust_timestamps(-123'456);
+  index.adjust_timestamps(-1'000);
+  index.push_back({ 1, 2, 3, 4, false });
+  entries.emplace_back(1, 2, 3 + 124'456, 4, false);
+
+  for (auto &entry : entries)
+    entry.timestamp -= 124'456;
+
+  for (auto idx : std::vector<std::size_t>{ s_block_size + 5, 0, 1, s_block_size, 2 * s_block_size })
+    expect_entry(entries[idx], index[idx], idx);
+}
+
+TEST(Qtmp4Index, ReleaseThenSeek) {
+  auto entries = create_entries(3 * s_block_size + 5);
+  auto index   = create_index(entries);
+  auto usage   = index.get_memory_usage();
+
+  // Releasing in the middle of a block only releases the blocks
+  // before it.
+  index[s_block_size + 3];
+  index.release_before(2 * s_block_size - 1);
+
+  EXPECT_LT(index.get_memory_usage(), usage);
+  EXPECT_EQ(entries.size(), index.size());
+
+  for (auto idx : std::vector<std::size_t>{ 2 * s_block_size - 1, s_block_size, 3 * s_block_size + 4, s_block_size + 1 })
+    expect_entry(entries[idx], index[idx], idx);
+
+  // The cursor is inside a released block afterwards.
+  index.release_before(2 * s_block_size);
+
+  for (auto idx : std::vector<std::size_t>{ 3 * s_block_size, 2 * s_block_size, 2 * s_block_size + 1 })
+    expect_entry(entries[idx], index[idx], idx);
+
+  // Releasing everything keeps the block new entries are appended to.
+  index.release_before(entries.size() + 10);
+  index.push_back({ 1, 2, 3, 4, false });
+  entries.emplace_back(1, 2, 3, 4, false);
+
+  for (auto idx : std::vector<std::size_t>{ 3 * s_block_size, 3 * s_block_size + 5 })
+    expect_entry(entries[idx], index[idx], idx);
+}
+
+TEST(Qtmp4Index, Clear) {
+  auto entries = create_entries(s_block_size + 1);
+  auto index   = create_index(entries);
+
+  index.adjust_timestamps(1000);
+  index.release_before(s_block_size + 1);
+  index.clear();
+
+  EXPECT_TRUE(index.empty());
+
+  index.push_back(entries[5]);
+  expect_entry(entries[5], index[0], 0);
+}
+
+TEST(Qtmp4Index, CompactStorage) {
+  auto entries = create_entries(10 * s_block_size);
+  auto index   = create_index(entries);
+
+  EXPECT_LT(index.get_memory_usage(), entries.size() * 10);
+}
+
+}
@@ -0,0 +1,205 @@
+#include "common/common_pch.h"
+
+#include "common/qtmp4_read_ahead.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using read_ahead_c     = mtx::qtmp4::read_ahead_c;
+using frame_position_t = read_ahead_c::frame_position_t;
+
+// The frames of each track with the number of frames of each track
+// that have been handed out already
+class tracks_c {
+public:
+  std::vector<std::vector<frame_position_t>> m_frames;
+  std::vector<std::size_t> m_pos;
+  std::vector<bool> m_read;
+
+public:
+  void
+  add_track(std::vector<frame_position_t> const &frames,
+            bool read = true) {
+    m_frames.push_back(frames);
+    m_pos.push_back(0);
+    m_read.push_back(read);
+  }
+
+  read_ahead_c::frame_lookup_t
+  lookup() const {
+    return [this](std::size_t track, std::size_t num) -> std::optional<frame_position_t> {
+      auto idx = m_pos[track] + num;
+      if (!m_read[track] || (idx >= m_frames[track].size()))
+        return {};
+      return m_frames[track][idx];
+    };
+  }
+
+  read_ahead_c::plan_t
+  plan(read_ahead_c &read_ahead,
+       std::size_t track) const {
+    return read_ahead.plan(track, m_frames.size(), lookup());
+  }
+
+  memory_cptr
+  get(read_ahead_c &read_ahead,
+      std::size_t track) {
+    auto frame = read_ahead.get(track);
+    if (frame)
+      ++m_pos[track];
+    return frame;
+  }
+};
+
+memory_cptr
+create_file(std::size_t size) {
+  auto file = memory_c::alloc(size);
+
+  for (auto idx = 0u; idx < size; ++idx)
+    file->get_buffer()[idx] = idx % 251;
+
+  return file;
+}
+
+memory_cptr
+read_span(memory_cptr const &file,
+          read_ahead_c::plan_t const &plan) {
+  return memory_c::clone(file->get_buffer() + plan.start, plan.size);
+}
+
+TEST(Qtmp4ReadAhead, PlanFollowsFilePositions) {
+  tracks_c tracks;
+
+  // Video frames in the file's first half, audio frames interleaved
+  // with a track that isn't read
+  tracks.add_track({ { 0, 100 }, { 100, 50 }, { 150, 80 } });
+  tracks.add_track({ { 230, 10 }, { 260, 10 } });
+  tracks.add_track({ { 240, 20 } }, false);
+
+  read_ahead_c read_ahead{1000, 64, 10000};
+  auto plan = tracks.plan(read_ahead, 0);
+
+  EXPECT_EQ(0,   plan.start);
+  EXPECT_EQ(270, plan.size);
+  ASSERT_EQ(5u,  plan.frames.size());
+
+  std::vector<std::tuple<std::size_t, int64_t, int64_t>> expected{ { 0, 0, 100 }, { 0, 100, 50 }, { 0, 150, 80 }, { 1, 230, 10 }, { 1, 260, 10 } };
+  for (auto idx = 0u; idx < expected.size(); ++idx)
+    EXPECT_EQ(expected[idx], std::make_tuple(plan.frames[idx].track, plan.frames[idx].offset, plan.frames[idx].size));
+}
+
+TEST(Qtmp4ReadAhead, PlanLimits) {
+  tracks_c tracks;
+
+  tracks.add_track({ { 0, 100 }, { 100, 100 }, { 300, 100 }, { 400, 100 } });
+
+  // The gap before the third frame is too large.
+  read_ahead_c gap{1000, 99, 10000};
+  EXPECT_EQ(200, tracks.plan(gap, 0).size);
+
+  // The span would become larger than 250 bytes.
+  read_ahead_c span{250, 100, 10000};
+  EXPECT_EQ(200, tracks.plan(span, 0).size);
+
+  // Fewer than two frames: nothing to plan.
+  read_ahead_c tiny{100, 100, 10000};
+  EXPECT_TRUE(tracks.plan(tiny, 0).frames.empty());
+}
+
+TEST(Qtmp4ReadAhead, SlicesAndOrder) {
+  tracks_c tracks;
+
+  tracks.add_track({ {  0, 10 }, { 20, 10 }, { 200, 10 } });
+  tracks.add_track({ { 10, 10 }, { 30, 10 }, { 210, 10 } });
+
+  auto file = create_file(300);
+  read_ahead_c read_ahead{1000, 64, 10000};
+
+  auto plan = tracks.plan(read_ahead, 0);
+  ASSERT_EQ(4u, plan.frames.size());
+  EXPECT_EQ(0,  plan.start);
+  EXPECT_EQ(40, plan.size);
+
+  read_ahead.queue(plan, read_span(file, plan));
+
+  EXPECT_EQ(2u, read_ahead.get_num_queued(0));
+  EXPECT_EQ(2u, read_ahead.get_num_queued(1));
+  EXPECT_EQ(40, read_ahead.get_queued_size());
+
+  // Each track gets its own frames in order.
+  for (auto expected : std::vector<std::pair<std::size_t, unsigned char>>{ { 0, 0 }, { 1, 10 }, { 1, 30 }, { 0, 20 } }) {
+    auto frame = tracks.get(read_ahead, expected.first);
+
+    ASSERT_TRUE(!!frame);
+    EXPECT_EQ(10u,             frame->get_size());
+    EXPECT_EQ(expected.second, frame->get_buffer()[0]);
+  }
+
+  EXPECT_FALSE(read_ahead.get(0));
+  EXPECT_FALSE(read_ahead.get(1));
+  EXPECT_EQ(0, read_ahead.get_queued_size());
+
+  // The next plan starts after the frames handed out.
+  plan = tracks.plan(read_ahead, 0);
+  ASSERT_EQ(2u, plan.frames.size());
+  EXPECT_EQ(200, plan.start);
+  EXPECT_EQ(20,  plan.size);
+  EXPECT_EQ(0u,  plan.frames[0].track);
+  EXPECT_EQ(0,   plan.frames[0].offset);
+  EXPECT_EQ(1u,  plan.frames[1].track);
+  EXPECT_EQ(10,  plan.frames[1].offset);
+
+  // Frames before the start of the span aren't included.
+  EXPECT_TRUE(tracks.plan(read_ahead, 1).frames.empty());
+}
+
+TEST(Qtmp4ReadAhead, WholeSpansAreCharged) {
+  tracks_c tracks;
+
+  // Each span of 1000 bytes contains a large frame of track 0
+  // followed by a small frame of track 1.
+  std::vector<frame_position_t> track0, track1;
+  for (auto idx = 0; idx < 10; ++idx) {
+    track0.push_back({ idx * 1000,       990 });
+    track1.push_back({ idx * 1000 + 990,  10 });
+  }
+
+  tracks.add_track(track0);
+  tracks.add_track(track1);
+
+  auto file = create_file(10000);
+  read_ahead_c read_ahead{1000, 0, 3000};
+
+  // Track 0 is read while track 1 lags behind.
+  auto num_spans = 0;
+
+  for (auto idx = 0; idx < 10; ++idx) {
+    if (!read_ahead.get_num_queued(0)) {
+      auto plan = tracks.plan(read_ahead, 0);
+      if (plan.frames.empty())
+        break;
+
+      read_ahead.queue(plan, read_span(file, plan));
+      ++num_spans;
+    }
+
+    ASSERT_TRUE(!!tracks.get(read_ahead, 0));
+
+    EXPECT_LE(read_ahead.get_queued_size(), 3000);
+  }
+
+  // Only three spans fit although track 0's frames have been handed
+  // out as track 1's small slices keep them alive.
+  EXPECT_EQ(3,    num_spans);
+  EXPECT_EQ(3000, read_ahead.get_queued_size());
+  EXPECT_EQ(3u,   read_ahead.get_num_queued(1));
+
+  // Consuming the slices of track 1 releases the spans.
+  for (auto idx = 0; idx < 3; ++idx)
+    ASSERT_TRUE(!!tracks.get(read_ahead, 1));
+
+  EXPECT_EQ(0, read_ahead.get_queued_size());
+}
+
+}
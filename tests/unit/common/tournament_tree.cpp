@@ -0,0 +1,98 @@
+#include "common/common_pch.h"
+
+#include "common/tournament_tree.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+std::size_t
+linear_scan(std::vector<std::optional<int>> const &keys) {
+  auto winner = mtx::tournament_tree_c<int>::npos;
+
+  for (auto idx = 0u; idx < keys.size(); ++idx)
+    if (keys[idx] && ((winner == mtx::tournament_tree_c<int>::npos) || (*keys[idx] < *keys[winner])))
+      winner = idx;
+
+  return winner;
+}
+
+TEST(TournamentTree, Empty) {
+  mtx::tournament_tree_c<int> tree;
+
+  EXPECT_TRUE(tree.empty());
+  EXPECT_EQ(mtx::tournament_tree_c<int>::npos, tree.top());
+
+  tree.reset(5);
+
+  EXPECT_TRUE(tree.empty());
+  EXPECT_EQ(5u, tree.size());
+}
+
+TEST(TournamentTree, SingleSlot) {
+  mtx::tournament_tree_c<int> tree{1};
+
+  tree.set(0, 42);
+  EXPECT_EQ(0u, tree.top());
+
+  tree.clear(0);
+  EXPECT_TRUE(tree.empty());
+}
+
+TEST(TournamentTree, SmallestKeyWins) {
+  mtx::tournament_tree_c<int> tree{5};
+
+  tree.set(0, 50);
+  tree.set(1, 30);
+  tree.set(2, 40);
+  tree.set(4, 10);
+
+  EXPECT_EQ(4u, tree.top());
+
+  tree.clear(4);
+  EXPECT_EQ(1u, tree.top());
+
+  tree.set(1, 60);
+  EXPECT_EQ(2u, tree.top());
+}
+
+TEST(TournamentTree, TiesGoToLowestSlot) {
+  mtx::tournament_tree_c<int> tree{7};
+
+  tree.set(6, 10);
+  tree.set(3, 10);
+  tree.set(5, 10);
+
+  EXPECT_EQ(3u, tree.top());
+
+  tree.set(0, 10);
+  EXPECT_EQ(0u, tree.top());
+
+  tree.clear(0);
+  tree.clear(3);
+  EXPECT_EQ(5u, tree.top());
+}
+
+TEST(TournamentTree, SameResultAsLinearScan) {
+  std::vector<std::optional<int>> keys(37);
+  mtx::tournament_tree_c<int> tree{keys.size()};
+  unsigned int state = 4711;
+
+  for (auto round = 0; round < 10000; ++round) {
+    state     = state * 1103515245 + 12345;
+    auto slot = (state >> 8) % keys.size();
+    state     = state * 1103515245 + 12345;
+    auto key  = (state >> 8) % 100;
+
+    if (key < 10)
+      keys[slot].reset();
+    else
+      keys[slot] = key;
+
+    tree.set(slot, keys[slot]);
+
+    ASSERT_EQ(linear_scan(keys), tree.top());
+  }
+}
+
+}
@@ -0,0 +1,184 @@
+#include "common/common_pch.h"
+
+#include <matroska/KaxCluster.h>
+#include <matroska/KaxCues.h>
+#include <matroska/KaxCuesData.h>
+
+#include "common/construct.h"
+#include "common/kax_file.h"
+#include "common/mm_mem_io.h"
+#include "extract/extraction_range.h"
+
+#include "gtest/gtest.h"
+
+using namespace libmatroska;
+using namespace mtx::construct;
+
+namespace {
+
+using bytes_t = std::vector<unsigned char>;
+
+bytes_t
+element(uint32_t id,
+        bytes_t const &content) {
+  bytes_t result;
+
+  for (auto shift = 24; shift >= 0; shift -= 8)
+    if ((id >> shift) || !result.empty())
+      result.push_back((id >> shift) & 0xff);
+
+  // Always use an eight-byte size field.
+  result.push_back(0x01);
+  for (auto shift = 48; shift >= 0; shift -= 8)
+    result.push_back((content.size() >> shift) & 0xff);
+
+  result.insert(result.end(), content.begin(), content.end());
+
+  return result;
+}
+
+bytes_t
+simple_block(unsigned char track_number,
+             int16_t relative_timestamp) {
+  auto content = bytes_t{ static_cast<unsigned char>(0x80 | track_number), static_cast<unsigned char>(relative_timestamp >> 8), static_cast<unsigned char>(relative_timestamp & 0xff), 0x80, 0x42 };
+  return element(0xa3, content);
+}
+
+bytes_t
+block_group(unsigned char track_number,
+            int16_t relative_timestamp) {
+  auto content = bytes_t{ static_cast<unsigned char>(0x80 | track_number), static_cast<unsigned char>(relative_timestamp >> 8), static_cast<unsigned char>(relative_timestamp & 0xff), 0x00, 0x42 };
+  return element(0xa0, element(0xa1, content));
+}
+
+// Parses a cluster with a timestamp in milliseconds the same way
+// mkvextract reads them.
+std::shared_ptr<KaxCluster>
+cluster(uint16_t timestamp,
+        std::vector<bytes_t> const &blocks) {
+  auto content = element(0xe7, { static_cast<unsigned char>(timestamp >> 8), static_cast<unsigned char>(timestamp & 0xff) });
+  for (auto const &block : blocks)
+    content.insert(content.end(), block.begin(), block.end());
+
+  auto data = element(0x1f43b675, content);
+
+  mm_mem_io_c in{data.data(), data.size()};
+  kax_file_c file{in};
+
+  auto kcluster = file.read_next_cluster();
+  if (kcluster)
+    kcluster->InitTimecode(timestamp, 1'000'000);
+
+  return kcluster;
+}
+
+KaxCuePoint *
+cue_point(uint64_t time,
+          uint64_t position) {
+  return cons<KaxCuePoint>(new KaxCueTime, time,
+                           cons<KaxCueTrackPositions>(new KaxCueTrack,           1,
+                                                      new KaxCueClusterPosition, position));
+}
+
+TEST(ExtractionRange, EverythingIsInRangeWithoutRange) {
+  extraction_range_c range;
+
+  EXPECT_TRUE(range.is_in_range(1, 0,                      false));
+  EXPECT_TRUE(range.is_in_range(1, 3'600'000'000'000,      true));
+  EXPECT_TRUE(range.is_in_range(2, -1'000'000,             false));
+
+  auto c = cluster(10'000, { simple_block(1, 0) });
+  ASSERT_TRUE(!!c);
+  EXPECT_FALSE(range.is_past_range(*c));
+}
+
+TEST(ExtractionRange, IsInRangeStartsAndEndsWithKeyFrames) {
+  extraction_range_c range{timestamp_c::s(1), timestamp_c::s(3)};
+
+  // Key frames only
+  EXPECT_FALSE(range.is_in_range(1,   500'000'000, true));
+  EXPECT_TRUE(range.is_in_range( 1, 1'000'000'000, true));
+  EXPECT_TRUE(range.is_in_range( 1, 2'999'000'000, true));
+  EXPECT_FALSE(range.is_in_range(1, 3'000'000'000, true));
+  EXPECT_FALSE(range.is_in_range(1, 2'500'000'000, true));
+
+  // Starts with the first key frame in the range & ends before the
+  // first key frame after it.
+  EXPECT_FALSE(range.is_in_range(2,   900'000'000, true));
+  EXPECT_FALSE(range.is_in_range(2, 1'200'000'000, false));
+  EXPECT_TRUE(range.is_in_range( 2, 1'500'000'000, true));
+  EXPECT_TRUE(range.is_in_range( 2, 2'000'000'000, false));
+  EXPECT_TRUE(range.is_in_range( 2, 3'100'000'000, false));
+  EXPECT_FALSE(range.is_in_range(2, 3'200'000'000, true));
+  EXPECT_FALSE(range.is_in_range(2, 3'300'000'000, false));
+}
+
+TEST(ExtractionRange, OpenEndedRanges) {
+  extraction_range_c from{timestamp_c::s(1), timestamp_c{}};
+
+  EXPECT_FALSE(from.is_in_range(1,   999'999'999, true));
+  EXPECT_TRUE(from.is_in_range( 1, 1'000'000'000, true));
+  EXPECT_TRUE(from.is_in_range( 1, 3'600'000'000'000, true));
+
+  extraction_range_c until{timestamp_c{}, timestamp_c::s(1)};
+
+  EXPECT_TRUE(until.is_in_range( 1,             0, true));
+  EXPECT_TRUE(until.is_in_range( 1,   999'999'999, false));
+  EXPECT_FALSE(until.is_in_range(1, 1'000'000'000, true));
+}
+
+TEST(ExtractionRange, IsPastRangeComparesBlockTimestamps) {
+  extraction_range_c range{timestamp_c::s(1), timestamp_c::s(3)};
+
+  // Clusters starting before the range's end
+  auto before = cluster(2'000, { simple_block(1, 0), simple_block(1, 1'500) });
+  ASSERT_TRUE(!!before);
+  EXPECT_FALSE(range.is_past_range(*before));
+
+  // Clusters starting at the range's end with blocks inside the range
+  // due to negative relative timestamps
+  auto negative_simple_block = cluster(3'000, { simple_block(1, 0), simple_block(1, -100) });
+  auto negative_block_group  = cluster(3'000, { block_group(1, 10), block_group(1, -1) });
+  ASSERT_TRUE(!!negative_simple_block && !!negative_block_group);
+  EXPECT_FALSE(range.is_past_range(*negative_simple_block));
+  EXPECT_FALSE(range.is_past_range(*negative_block_group));
+
+  // Clusters with all blocks after the range's end
+  auto after = cluster(3'000, { simple_block(1, 0), block_group(1, 10) });
+  ASSERT_TRUE(!!after);
+  EXPECT_TRUE(range.is_past_range(*after));
+
+  // Not if a track with non-key frames hasn't completed its last group
+  // of pictures yet, though.
+  EXPECT_TRUE(range.is_in_range(2, 1'000'000'000, true));
+  EXPECT_TRUE(range.is_in_range(2, 1'040'000'000, false));
+  EXPECT_FALSE(range.is_past_range(*after));
+
+  EXPECT_FALSE(range.is_in_range(2, 3'000'000'000, true));
+  EXPECT_TRUE(range.is_past_range(*after));
+}
+
+TEST(ExtractionRange, FindStartPosition) {
+  auto cues = std::shared_ptr<KaxCues>{cons<KaxCues>(cue_point(   0, 100),
+                                                     cue_point(1000, 200),
+                                                     cue_point(2000, 300),
+                                                     cue_point(2000, 250),
+                                                     cue_point(4000, 400))};
+
+  EXPECT_EQ(std::optional<uint64_t>{250}, (extraction_range_c{timestamp_c::ms(2500), timestamp_c{}}.find_start_position(*cues, 1'000'000)));
+  EXPECT_EQ(std::optional<uint64_t>{250}, (extraction_range_c{timestamp_c::ms(2000), timestamp_c{}}.find_start_position(*cues, 1'000'000)));
+  EXPECT_EQ(std::optional<uint64_t>{200}, (extraction_range_c{timestamp_c::ms(1999), timestamp_c{}}.find_start_position(*cues, 1'000'000)));
+  EXPECT_EQ(std::optional<uint64_t>{100}, (extraction_range_c{timestamp_c::ms( 500), timestamp_c{}}.find_start_position(*cues, 1'000'000)));
+  EXPECT_EQ(std::optional<uint64_t>{400}, (extraction_range_c{timestamp_c::s(  100), timestamp_c{}}.find_start_position(*cues, 1'000'000)));
+
+  // The cue times are scaled by the timestamp scale.
+  EXPECT_EQ(std::optional<uint64_t>{200}, (extraction_range_c{timestamp_c::ms(  15), timestamp_c{}}.find_start_position(*cues,    10'000)));
+
+  // No start, or no cue point before the start
+  EXPECT_EQ(std::optional<uint64_t>{},    (extraction_range_c{timestamp_c{}, timestamp_c::s(1)}.find_start_position(*cues, 1'000'000)));
+
+  auto late_cues = std::shared_ptr<KaxCues>{cons<KaxCues>(cue_point(1000, 200))};
+  EXPECT_EQ(std::optional<uint64_t>{},    (extraction_range_c{timestamp_c::ms(500), timestamp_c{}}.find_start_position(*late_cues, 1'000'000)));
+}
+
+}
@@ -0,0 +1,261 @@
+#include "common/common_pch.h"
+
+#include <matroska/KaxCuesData.h>
+
+#include "common/ebml.h"
+#include "common/mm_mem_io.h"
+#include "merge/cues.h"
+#include "merge/output_control.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using namespace libmatroska;
+
+using bytes_t = std::vector<unsigned char>;
+using point_t = std::tuple<uint64_t, uint32_t, uint64_t>;
+
+class test_cues_c: public cues_c {
+public:
+  test_cues_c(std::size_t max_points_in_memory) {
+    m_max_points_in_memory = max_points_in_memory;
+  }
+
+  void
+  add_point(uint64_t timestamp,
+            uint32_t track_num,
+            uint64_t cluster_position,
+            uint64_t codec_state_position = 0) {
+    add(timestamp, track_num, cluster_position, codec_state_position);
+    store_pending_points();
+  }
+
+  void
+  store(cue_point_t point,
+        uint64_t codec_state_position = 0) {
+    point.codec_state_position = codec_state_position;
+    store_point(point);
+  }
+
+  std::vector<point_t>
+  get_points() {
+    std::vector<point_t> points;
+
+    for_each_point([&points](cue_point_t const &point) {
+      points.emplace_back(point.timestamp, point.track_num, point.cluster_position);
+    });
+
+    return points;
+  }
+
+  std::vector<bytes_t>
+  render_points() {
+    std::vector<bytes_t> rendered;
+
+    for_each_point([this, &rendered](cue_point_t const &point) {
+      rendered.emplace_back();
+      render_point(point, rendered.back());
+    });
+
+    return rendered;
+  }
+
+  uint64_t
+  get_total_size() {
+    return calculate_total_size();
+  }
+
+  std::vector<point_t>
+  get_codec_state_positions() {
+    std::vector<point_t> positions;
+
+    for_each_point([&positions](cue_point_t const &point) {
+      if (point.codec_state_position)
+        positions.emplace_back(point.timestamp, point.track_num, point.codec_state_position);
+    });
+
+    return positions;
+  }
+
+  std::size_t
+  get_num_spilled_runs()
+    const {
+    return m_spilled_runs.size();
+  }
+
+  std::size_t
+  get_num_points_in_memory()
+    const {
+    return m_num_points_in_memory;
+  }
+
+  std::vector<bool>
+  get_written_flags()
+    const {
+    return { m_codec_state_written, m_relative_position_written, m_duration_written };
+  }
+
+  void
+  clear() {
+    cues_c::clear();
+  }
+};
+
+bytes_t
+render_with_libmatroska(cue_point_t const &point,
+                        uint64_t codec_state_position) {
+  auto scale = static_cast<uint64_t>(g_timestamp_scale);
+  KaxCuePoint cue_point;
+
+  GetChild<KaxCueTime>(cue_point).SetValue(point.timestamp / scale);
+
+  auto &positions = GetChild<KaxCueTrackPositions>(cue_point);
+  GetChild<KaxCueTrack>(positions).SetValue(point.track_num);
+  GetChild<KaxCueClusterPosition>(positions).SetValue(point.cluster_position);
+
+  if (codec_state_position)
+    GetChild<KaxCueCodecState>(positions).SetValue(codec_state_position);
+
+  if (point.relative_position)
+    GetChild<KaxCueRelativePosition>(positions).SetValue(point.relative_position);
+
+  if (point.duration)
+    GetChild<KaxCueDuration>(positions).SetValue(point.duration / scale);
+
+  mm_mem_io_c out{nullptr, 0, 1024};
+  cue_point.Render(out);
+
+  auto data = out.get_and_lock_buffer();
+  return { data->get_buffer(), data->get_buffer() + data->get_size() };
+}
+
+TEST(Cues, SpilledRunsAreMergedInOrder) {
+  test_cues_c cues{3};
+  std::vector<point_t> expected;
+
+  // Several points share timestamps across & within tracks; the
+  // cluster positions record the order the points were added in.
+  for (auto idx = 0u; idx < 20; ++idx) {
+    auto timestamp = static_cast<uint64_t>((idx * 7) % 5) * 1'000'000;
+    auto track_num = (idx * 3) % 4 + 1;
+
+    cues.add_point(timestamp, track_num, idx);
+    expected.emplace_back(timestamp, track_num, idx);
+  }
+
+  std::stable_sort(expected.begin(), expected.end(), [](point_t const &a, point_t const &b) {
+    return std::tie(std::get<0>(a), std::get<1>(a)) < std::tie(std::get<0>(b), std::get<1>(b));
+  });
+
+  EXPECT_EQ(6u, cues.get_num_spilled_runs());
+  EXPECT_EQ(2u, cues.get_num_points_in_memory());
+  EXPECT_EQ(expected, cues.get_points());
+
+  // Reading the runs back doesn't change them.
+  EXPECT_EQ(expected, cues.get_points());
+}
+
+TEST(Cues, AdjustPositionsBeforeAndAfterSpilling) {
+  test_cues_c cues{3};
+
+  cues.add_point(300'000'000, 2, 100, 150);
+  cues.add_point(100'000'000, 1, 600);
+
+  // Only in memory so far
+  cues.adjust_positions(500, 10);
+
+  cues.add_point(200'000'000, 3, 700);
+  ASSERT_EQ(1u, cues.get_num_spilled_runs());
+
+  // Only in the temporary file
+  cues.adjust_positions(650, 20);
+
+  cues.add_point( 50'000'000, 1, 800);
+  cues.add_point(400'000'000, 2, 900, 860);
+
+  // Both in memory & in the temporary file
+  cues.adjust_positions(850, 5);
+
+  cues.add_point(150'000'000, 2, 1000);
+  ASSERT_EQ(2u, cues.get_num_spilled_runs());
+
+  // Applies to both runs but not to the points added afterwards.
+  cues.adjust_positions(0, 1);
+
+  cues.add_point(250'000'000, 1, 50);
+
+  auto expected = std::vector<point_t>{
+    {  50'000'000, 1,  801 },
+    { 100'000'000, 1,  611 },
+    { 150'000'000, 2, 1001 },
+    { 200'000'000, 3,  721 },
+    { 250'000'000, 1,   50 },
+    { 300'000'000, 2,  101 },
+    { 400'000'000, 2,  906 },
+  };
+
+  EXPECT_EQ(expected, cues.get_points());
+  EXPECT_EQ(expected, cues.get_points());
+
+  EXPECT_EQ(std::vector<point_t>({ { 300'000'000, 2, 151 }, { 400'000'000, 2, 866 } }), cues.get_codec_state_positions());
+}
+
+TEST(Cues, RenderingMatchesLibmatroska) {
+  test_cues_c cues{2};
+
+  // Points in the order they're rendered in with their codec state
+  // positions. Values of different sizes & optional children.
+  auto points = std::vector<std::pair<cue_point_t, uint64_t>>{
+    { {                 0,             0,          0,   1,      0 },        0 },
+    { {         1'000'000, 1'000'000'000,       1000,   1,      0 },        0 },
+    { {         2'000'000,             0,        200,   2,      0 },      180 },
+    { {     5'000'000'000,    40'000'000, 0x12345678, 300, 0x1234 }, 0x123456 },
+    { { 3'600'000'000'000,             0, 1ull << 40,   2,    255 },        0 },
+  };
+
+  for (auto idx : std::vector<std::size_t>{ 3, 0, 4, 1, 2 })
+    cues.store(points[idx].first, points[idx].second);
+
+  ASSERT_EQ(2u, cues.get_num_spilled_runs());
+
+  auto rendered   = cues.render_points();
+  auto total_size = 0ull;
+
+  ASSERT_EQ(points.size(), rendered.size());
+
+  for (auto idx = 0u; idx < points.size(); ++idx) {
+    EXPECT_EQ(render_with_libmatroska(points[idx].first, points[idx].second), rendered[idx]) << "point " << idx;
+    total_size += rendered[idx].size();
+  }
+
+  EXPECT_EQ(total_size, cues.get_total_size());
+}
+
+TEST(Cues, ClearResetsState) {
+  test_cues_c cues{2};
+
+  cues.store({ 5'000'000'000, 40'000'000, 1000, 1, 20 }, 500);
+  cues.store({ 1'000'000'000,          0, 2000, 2,  0 });
+  cues.render_points();
+
+  EXPECT_EQ(1u,                                      cues.get_num_spilled_runs());
+  EXPECT_EQ(std::vector<bool>({ true, true, true }), cues.get_written_flags());
+
+  cues.clear();
+
+  EXPECT_EQ(0u,                                         cues.get_num_spilled_runs());
+  EXPECT_TRUE(cues.get_points().empty());
+  EXPECT_TRUE(cues.get_codec_state_positions().empty());
+  EXPECT_EQ(std::vector<bool>({ false, false, false }), cues.get_written_flags());
+
+  // Spilling works again afterwards.
+  cues.add_point(3'000'000, 2, 30);
+  cues.add_point(1'000'000, 1, 10);
+  cues.add_point(2'000'000, 1, 20);
+
+  EXPECT_EQ(1u, cues.get_num_spilled_runs());
+  EXPECT_EQ(std::vector<point_t>({ { 1'000'000, 1, 10 }, { 2'000'000, 1, 20 }, { 3'000'000, 2, 30 } }), cues.get_points());
+}
+
+}
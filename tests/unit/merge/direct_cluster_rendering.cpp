@@ -0,0 +1,313 @@
+#include "common/common_pch.h"
+
+#include <matroska/KaxBlock.h>
+#include <matroska/KaxBlockData.h>
+#include <matroska/KaxCluster.h>
+#include <matroska/KaxCuesData.h>
+#include <matroska/KaxSegment.h>
+#include <matroska/KaxTrackEntryData.h>
+#include <matroska/KaxTracks.h>
+
+#include "common/ebml.h"
+#include "common/kax_cluster_writer.h"
+#include "common/mm_mem_io.h"
+#include "merge/cues.h"
+#include "merge/libmatroska_extensions.h"
+#include "merge/output_control.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using namespace libmatroska;
+
+using bytes_t  = std::vector<unsigned char>;
+using writer_c = mtx::kax::cluster_writer_c;
+
+// Everything cluster_helper_c passes to libmatroska or to the cluster
+// writer for one frame & block.
+struct frame_t {
+  int64_t timestamp{}, past_block{-1}, forw_block{-1};
+  std::size_t size{};
+  std::optional<bool> key_flag{}, discardable_flag{};
+};
+
+struct block_t {
+  bool simple{};
+  uint64_t track_num{};
+  std::vector<frame_t> frames;
+  std::string codec_state;
+  std::optional<int64_t> discard_padding, duration;
+  // Like cluster_helper_c the block is added to the cues after each
+  // of its frames, e.g. if only a frame laced into it later qualifies.
+  bool cue{};
+};
+
+class test_cues_c: public cues_c {
+public:
+  test_cues_c() {
+    // Cue durations are looked up in the packetizers.
+    m_no_cue_duration = true;
+  }
+
+  std::vector<bytes_t>
+  render_points() {
+    std::vector<bytes_t> rendered;
+
+    store_pending_points();
+    for_each_point([this, &rendered](cue_point_t const &point) {
+      rendered.emplace_back();
+      render_point(point, rendered.back());
+    });
+
+    return rendered;
+  }
+
+  std::vector<std::tuple<uint64_t, uint32_t, uint64_t, uint32_t>>
+  get_points() {
+    std::vector<std::tuple<uint64_t, uint32_t, uint64_t, uint32_t>> points;
+
+    store_pending_points();
+    for_each_point([&points](cue_point_t const &point) {
+      points.emplace_back(point.timestamp, point.track_num, point.cluster_position, point.relative_position);
+    });
+
+    return points;
+  }
+
+  std::map<id_timestamp_t, uint64_t> const &
+  get_codec_state_positions()
+    const {
+    return m_codec_state_position_map;
+  }
+};
+
+class DirectClusterRendering: public ::testing::Test {
+protected:
+  static constexpr std::size_t s_prefix_size = 100;
+
+  KaxSegment m_segment;
+  std::map<uint64_t, std::unique_ptr<KaxTrackEntry>> m_tracks;
+  std::vector<memory_cptr> m_frame_data;
+  uint64_t m_scale{};
+
+  virtual void SetUp() override {
+    m_scale = static_cast<uint64_t>(g_timestamp_scale);
+
+    for (auto track_num : { 1, 2 }) {
+      auto track = std::make_unique<KaxTrackEntry>();
+
+      track->SetGlobalTimecodeScale(m_scale);
+      track->EnableLacing(true);
+      GetChild<KaxTrackNumber>(*track).SetValue(track_num);
+
+      m_tracks[track_num] = std::move(track);
+    }
+  }
+
+  memory_cptr
+  get_frame_data(std::size_t idx) {
+    return m_frame_data[idx];
+  }
+
+  void
+  create_frame_data(std::vector<block_t> const &blocks) {
+    m_frame_data.clear();
+
+    for (auto const &block : blocks)
+      for (auto const &frame : block.frames) {
+        auto data = memory_c::alloc(frame.size);
+
+        for (auto idx = 0u; idx < frame.size; ++idx)
+          data->get_buffer()[idx] = (idx * 7 + m_frame_data.size()) & 0xff;
+
+        m_frame_data.push_back(data);
+      }
+  }
+
+  uint64_t
+  get_segment_data_start()
+    const {
+    return m_segment.GetElementPosition() + m_segment.HeadSize();
+  }
+
+  static void
+  write_prefix(mm_mem_io_c &out) {
+    for (auto idx = 0u; idx < s_prefix_size; ++idx)
+      out.write_uint8(0);
+  }
+
+  static bytes_t
+  get_data(mm_mem_io_c &out) {
+    auto data = out.get_and_lock_buffer();
+    return { data->get_buffer(), data->get_buffer() + data->get_size() };
+  }
+
+  static std::pair<int64_t, int64_t>
+  get_timestamp_range(std::vector<block_t> const &blocks) {
+    auto min = std::numeric_limits<int64_t>::max(), max = std::numeric_limits<int64_t>::min();
+
+    for (auto const &block : blocks)
+      for (auto const &frame : block.frames) {
+        min = std::min(min, frame.timestamp);
+        max = std::max(max, frame.timestamp);
+      }
+
+    return { min, max };
+  }
+
+  // The same calls cluster_helper_c::render() makes if direct
+  // rendering isn't possible.
+  bytes_t
+  render_with_libmatroska(std::vector<block_t> const &blocks,
+                          test_cues_c &cue_storage) {
+    std::vector<kax_block_blob_cptr> blobs;
+    kax_cues_with_cleanup_c cues;
+    mm_mem_io_c out{nullptr, 0, 4096};
+    auto cluster    = std::make_unique<kax_cluster_c>();
+    auto frame_idx  = 0u;
+    auto [min, max] = get_timestamp_range(blocks);
+
+    write_prefix(out);
+    cues.SetGlobalTimecodeScale(m_scale);
+    cluster->SetParent(m_segment);
+    cluster->SetPreviousTimecode(0, static_cast<int64_t>(m_scale));
+
+    for (auto const &block : blocks) {
+      auto &track = *m_tracks[block.track_num];
+
+      blobs.emplace_back(std::make_shared<kax_block_blob_c>(block.simple ? BLOCK_BLOB_ALWAYS_SIMPLE : BLOCK_BLOB_NO_SIMPLE));
+      auto &blob = *blobs.back();
+
+      cluster->AddBlockBlob(&blob);
+      blob.SetParent(*cluster);
+
+      for (auto const &frame : block.frames) {
+        auto data        = get_frame_data(frame_idx++);
+        auto data_buffer = new DataBuffer(static_cast<binary *>(data->get_buffer()), data->get_size());
+
+        blob.add_frame_auto(track, frame.timestamp, *data_buffer, LACING_AUTO, frame.past_block, frame.forw_block, frame.key_flag, frame.discardable_flag);
+
+        if (!block.codec_state.empty() && (&frame == &block.frames.front())) {
+          auto &group = static_cast<KaxBlockGroup &>(blob);
+          auto cstate = new KaxCodecState;
+          group.PushElement(*cstate);
+          cstate->CopyBuffer(reinterpret_cast<binary const *>(block.codec_state.c_str()), block.codec_state.size());
+        }
+
+        if (block.cue)
+          cues.AddBlockBlob(blob);
+      }
+
+      if (block.discard_padding)
+        GetChild<KaxDiscardPadding>(blob).SetValue(*block.discard_padding);
+
+      if (block.duration)
+        blob.set_block_duration(*block.duration);
+    }
+
+    cluster->SetPreviousTimecode(min - 1, static_cast<int64_t>(m_scale));
+    cluster->set_min_timestamp(min);
+    cluster->set_max_timestamp(max);
+
+    cluster->Render(out, cues);
+
+    cue_storage.postprocess_cues(cues, *cluster);
+
+    return get_data(out);
+  }
+
+  // The same calls cluster_helper_c::render() makes when rendering
+  // directly.
+  bytes_t
+  render_directly(std::vector<block_t> const &blocks,
+                  test_cues_c &cue_storage) {
+    writer_c writer{static_cast<int64_t>(m_scale)};
+    std::vector<std::size_t> cue_blocks;
+    mm_mem_io_c out{nullptr, 0, 4096};
+    auto frame_idx = 0u;
+    auto min       = get_timestamp_range(blocks).first;
+
+    write_prefix(out);
+
+    for (auto const &spec : blocks) {
+      auto &block           = writer.add_block();
+      block.is_simple_block = spec.simple;
+      block.track_number    = spec.track_num;
+      block.lacing          = writer_c::lacing_e::automatic;
+
+      for (auto const &frame : spec.frames) {
+        block.add_frame_auto(get_frame_data(frame_idx++), frame.timestamp, frame.past_block, frame.forw_block, frame.key_flag, frame.discardable_flag);
+
+        if (spec.cue)
+          cue_blocks.push_back(writer.get_blocks().size() - 1);
+      }
+
+      if (!spec.codec_state.empty())
+        block.codec_state = memory_c::clone(spec.codec_state);
+
+      block.discard_padding = spec.discard_padding;
+
+      if (spec.duration && !spec.simple)
+        block.duration = *spec.duration;
+    }
+
+    writer.render(out, min);
+
+    cue_storage.postprocess_cues(writer, cue_blocks, get_segment_data_start());
+
+    return get_data(out);
+  }
+
+  void
+  compare(std::vector<block_t> const &blocks) {
+    create_frame_data(blocks);
+
+    test_cues_c libmatroska_cues, direct_cues;
+
+    auto libmatroska_data = render_with_libmatroska(blocks, libmatroska_cues);
+    auto direct_data      = render_directly(blocks, direct_cues);
+
+    EXPECT_EQ(libmatroska_data, direct_data);
+
+    auto libmatroska_points = libmatroska_cues.get_points();
+
+    EXPECT_EQ(libmatroska_points,                              direct_cues.get_points());
+    EXPECT_EQ(libmatroska_cues.get_codec_state_positions(),    direct_cues.get_codec_state_positions());
+    EXPECT_EQ(libmatroska_cues.render_points(),                direct_cues.render_points());
+    EXPECT_EQ(static_cast<std::size_t>(std::count_if(blocks.begin(), blocks.end(), [](auto const &block) { return block.cue; })), libmatroska_points.size());
+  }
+};
+
+TEST_F(DirectClusterRendering, SimpleBlocks) {
+  compare({
+    { true, 1, { { 1'000'000'000, -1,            -1,            3000 } },                                 {}, {}, {}, true  },
+    { true, 2, { {   995'000'000, -1,            -1,             200, true, true } },                     {}, {}, {}, true  },
+    { true, 1, { { 1'080'000'000, 1'000'000'000, 1'160'000'000,  500 } },                                 {}, {}, {}, false },
+    { true, 1, { { 1'160'000'000, 1'000'000'000, -1,              50 } },                                 {}, {}, {}, false },
+    { true, 2, { { 1'100'500'000, -1,            -1,              20, false } },                          {}, {}, {}, true  },
+  });
+}
+
+TEST_F(DirectClusterRendering, LacedBlocks) {
+  compare({
+    // Equal sizes (fixed lacing), similar sizes (EBML lacing) &
+    // different sizes (Xiph lacing)
+    { true,  2, { { 2'000'000'000, -1, -1, 100 }, { 2'024'000'000, -1, -1, 100 }, { 2'048'000'000, -1, -1, 100 } }, {}, {}, {}, true },
+    { true,  2, { { 2'072'000'000, -1, -1, 300 }, { 2'096'000'000, -1, -1, 301 }, { 2'120'000'000, -1, -1, 299 } }, {}, {}, {}, true },
+    { true,  2, { { 2'144'000'000, -1, -1,  10 }, { 2'168'000'000, -1, -1, 700 }, { 2'192'000'000, -1, -1,  30 } }, {}, {}, {}, false },
+    { false, 1, { { 2'010'000'000, -1, -1,  64 }, { 2'050'000'000, -1, -1,  64 } },                                  {}, {}, 80'000'000, true },
+  });
+}
+
+TEST_F(DirectClusterRendering, BlockGroups) {
+  compare({
+    { false, 1, { { 3'000'000'000, -1,            -1,            4000 } },             "state", {},   40'000'000, true  },
+    { false, 1, { { 3'080'000'000, 3'000'000'000, -1,             900 } },             {},      {},   40'000'000, false },
+    { false, 1, { { 3'040'000'000, 3'000'000'000, 3'080'000'000,  300 } },             {},      {},   40'000'000, false },
+    { false, 2, { { 3'000'000'000, -1,            -1,             120 } },             {},      -300, 20'000'000, true  },
+    { false, 2, { { 3'020'000'000, -1,            -1,             120 } },             "s2",    {},   {},         true  },
+  });
+}
+
+}
@@ -0,0 +1,80 @@
+#include "common/common_pch.h"
+
+#include "merge/memory_budget.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+namespace mb = mtx::merge::memory_budget;
+
+int64_t constexpr MiB = 1024 * 1024;
+
+class MemoryBudget: public ::testing::Test {
+protected:
+  virtual void TearDown() override {
+    mb::set_limit(0);
+    mb::set_num_readers(1);
+    mb::reset();
+  }
+};
+
+TEST_F(MemoryBudget, NoLimit) {
+  mb::set_limit(0);
+  mb::set_num_readers(4);
+
+  EXPECT_EQ(20 * MiB,  mb::get_soft_limit());
+  EXPECT_EQ(128 * MiB, mb::get_hard_limit(128 * MiB));
+
+  mb::account(1024 * MiB);
+
+  EXPECT_FALSE(mb::exceeds_soft_limit(20 * MiB));
+  EXPECT_TRUE(mb::exceeds_soft_limit(20 * MiB + 1));
+  EXPECT_FALSE(mb::exceeds_hard_limit(128 * MiB, 128 * MiB));
+  EXPECT_TRUE(mb::exceeds_hard_limit(128 * MiB + 1, 128 * MiB));
+}
+
+TEST_F(MemoryBudget, SharePerReader) {
+  mb::set_limit(64 * MiB);
+  mb::set_num_readers(2);
+
+  EXPECT_EQ(8 * MiB,   mb::get_soft_limit());
+  EXPECT_EQ(32 * MiB,  mb::get_hard_limit(128 * MiB));
+  EXPECT_EQ(16 * MiB,  mb::get_hard_limit(16 * MiB));
+
+  mb::set_limit(4096 * MiB);
+
+  EXPECT_EQ(20 * MiB,  mb::get_soft_limit());
+  EXPECT_EQ(128 * MiB, mb::get_hard_limit(128 * MiB));
+}
+
+TEST_F(MemoryBudget, TotalExceeded) {
+  mb::set_limit(64 * MiB);
+  mb::set_num_readers(2);
+
+  mb::account(60 * MiB);
+
+  EXPECT_FALSE(mb::exceeds_hard_limit(10 * MiB, 128 * MiB));
+
+  mb::account(10 * MiB);
+
+  EXPECT_TRUE(mb::exceeds_hard_limit(10 * MiB, 128 * MiB));
+  EXPECT_FALSE(mb::exceeds_hard_limit(8 * MiB, 128 * MiB));
+}
+
+TEST_F(MemoryBudget, PeakQueuedBytes) {
+  mb::account(10);
+  mb::account(20);
+  mb::account(-25);
+  mb::account(5);
+
+  EXPECT_EQ(10, mb::get_queued_bytes());
+  EXPECT_EQ(30, mb::get_peak_queued_bytes());
+
+  mb::reset();
+
+  EXPECT_EQ(0, mb::get_queued_bytes());
+  EXPECT_EQ(0, mb::get_peak_queued_bytes());
+}
+
+}
@@ -0,0 +1,59 @@
+#include "common/common_pch.h"
+
+#include "merge/packet.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+class test_packet_extension_c: public packet_extension_c {
+public:
+  virtual packet_extension_type_e get_type() const override {
+    return SUBTITLE_NUMBER;
+  }
+};
+
+void
+create_and_release_packets() {
+  for (auto idx = 0; idx < 3; ++idx) {
+    auto packet = make_packet(memory_c::alloc(100), idx * 1000);
+    packet->data_adds.push_back(memory_c::alloc(10));
+    packet->data_adds.push_back(memory_c::alloc(20));
+    packet->extensions.push_back(std::make_shared<test_packet_extension_c>());
+
+    // The way generic_packetizer_c::process(packet_t *) wraps them
+    auto raw_packet = mtx::mem::make_pooled_shared(new packet_t(memory_c::alloc(50)));
+    raw_packet->data_adds.push_back(packet->data);
+  }
+}
+
+TEST(Packet, AllocationsComeFromThePool) {
+  auto &pool = mtx::mem::pool_c::get();
+
+  // The first round fills the pool's free lists.
+  create_and_release_packets();
+
+  auto before = pool.get_statistics();
+
+  create_and_release_packets();
+
+  auto after = pool.get_statistics();
+
+  EXPECT_GT(after.num_allocations, before.num_allocations);
+  EXPECT_EQ(after.num_allocations - before.num_allocations, after.num_reused - before.num_reused);
+  EXPECT_EQ(before.num_heap_allocations, after.num_heap_allocations);
+}
+
+TEST(Packet, VectorsUseThePool) {
+  auto &pool      = mtx::mem::pool_c::get();
+  auto packet     = make_packet(memory_c::alloc(100));
+  auto extension  = std::make_shared<test_packet_extension_c>();
+  auto num_before = pool.get_statistics().num_allocations;
+
+  packet->data_adds.push_back(packet->data);
+  packet->extensions.push_back(extension);
+
+  EXPECT_EQ(num_before + 2, pool.get_statistics().num_allocations);
+}
+
+}
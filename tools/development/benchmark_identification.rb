@@ -0,0 +1,81 @@
+#!/usr/bin/env ruby
+# coding: utf-8
+
+# Measures how long "mkvmerge -J" takes for each file in the test data
+# corpus and outputs the times per file followed by a summary.
+#
+# Usage: benchmark_identification.rb [options] [-- additional mkvmerge arguments]
+
+require "json"
+require "open3"
+require "optparse"
+require "pathname"
+
+$mtx_dir = File.absolute_path(File.dirname(__FILE__) + "/../..")
+
+module BenchmarkIdentification
+  def self.parse_options
+    options = {
+      :mkvmerge => "#{$mtx_dir}/src/mkvmerge",
+      :data_dir => "#{$mtx_dir}/tests/data",
+      :runs     => 3,
+      :slowest  => nil,
+    }
+
+    OptionParser.new do |opts|
+      opts.banner = "Usage: #{$0} [options] [-- additional mkvmerge arguments]"
+
+      opts.on("-m", "--mkvmerge PATH",  "mkvmerge executable to use (default: #{options[:mkvmerge]})")           { |value| options[:mkvmerge] = value }
+      opts.on("-d", "--data-dir PATH",  "directory with the files to identify (default: #{options[:data_dir]})") { |value| options[:data_dir] = value }
+      opts.on("-r", "--runs NUM",       Integer, "number of runs per file; the fastest one counts (default: 3)")  { |value| options[:runs]     = value }
+      opts.on("-s", "--slowest NUM",    Integer, "only list the NUM slowest files")                              { |value| options[:slowest]  = value }
+    end.parse!
+
+    fail "#{options[:data_dir]} is not a directory" unless FileTest.directory?(options[:data_dir])
+
+    options[:mkvmerge_args] = ARGV.dup
+
+    options
+  end
+
+  def self.identify options, file_name
+    command = [ options[:mkvmerge], "-J", *options[:mkvmerge_args], file_name ]
+    output  = nil
+    times   = (1..options[:runs]).map do
+      start      = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      output, _  = Open3.capture2(*command)
+      Process.clock_gettime(Process::CLOCK_MONOTONIC) - start
+    end
+
+    container = JSON.parse(output)["container"] rescue nil
+    type      = !container                ? "(invalid output)"
+              : !container["recognized"]  ? "(not recognized)"
+              : !container["supported"]   ? "(not supported)"
+              :                             container["type"]
+
+    { :file_name => file_name, :time => times.min, :type => type, :recognized => container && container["recognized"] }
+  end
+
+  def self.run
+    options  = self.parse_options
+    data_dir = Pathname.new(options[:data_dir])
+    files    = Dir.glob("#{options[:data_dir]}/**/*").select { |file_name| FileTest.file?(file_name) }.sort
+    results  = files.map { |file_name| self.identify(options, file_name) }
+    listed   = results.sort_by { |result| -result[:time] }
+    listed   = listed.first(options[:slowest]) if options[:slowest]
+
+    listed.each do |result|
+      puts sprintf("%10.2f ms  %-30s  %s", result[:time] * 1000, result[:type], Pathname.new(result[:file_name]).relative_path_from(data_dir))
+    end
+
+    total      = results.map { |result| result[:time] }.sum
+    recognized = results.select { |result| result[:recognized] }
+
+    puts
+    puts sprintf("%d files, %d recognized; total %.2f ms, average %.2f ms per file, average %.2f ms per recognized file",
+                 results.size, recognized.size, total * 1000, results.empty? ? 0 : total * 1000 / results.size,
+                 recognized.empty? ? 0 : recognized.map { |result| result[:time] }.sum * 1000 / recognized.size)
+  end
+end
+
+BenchmarkIdentification.run